@@ -0,0 +1,64 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <DPGO/Communicator.h>
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace DPGO;
+
+namespace {
+
+// Publish one message to all other agents and let every receiver drain its inbox
+void roundTrip(Communicator &comm, const std::vector<uint8_t> &message, size_t *received_bytes) {
+  comm.publish(0, message.data(), message.size());
+  for (unsigned robot = 1; robot < comm.numAgents(); ++robot) {
+    comm.receive(robot, [received_bytes](const uint8_t *data, size_t size) {
+      benchmark::DoNotOptimize(data);
+      *received_bytes += size;
+    });
+  }
+}
+
+void BM_InProcessCommunicator(benchmark::State &state) {
+  InProcessCommunicator comm(state.range(1));
+  std::vector<uint8_t> message(state.range(0), 1);
+  size_t received_bytes = 0;
+  for (auto _ : state) {
+    roundTrip(comm, message, &received_bytes);
+  }
+  state.SetBytesProcessed(received_bytes);
+}
+
+void BM_SharedMemoryCommunicator(benchmark::State &state) {
+  const std::string name = "/dpgo_bench_" + std::to_string(getpid());
+  SharedMemoryCommunicator comm(name, state.range(1), true, 16, state.range(0));
+  std::vector<uint8_t> message(state.range(0), 1);
+  size_t received_bytes = 0;
+  for (auto _ : state) {
+    roundTrip(comm, message, &received_bytes);
+  }
+  state.SetBytesProcessed(received_bytes);
+}
+
+// Message sizes correspond to roughly 10, 100 and 1000 public poses (r = 5, d = 3)
+void CommunicatorArgs(benchmark::internal::Benchmark *b) {
+  for (int num_agents : {2, 8}) {
+    for (int bytes : {1 << 11, 1 << 14, 1 << 17}) {
+      b->Args({bytes, num_agents});
+    }
+  }
+}
+
+}  // namespace
+
+BENCHMARK(BM_InProcessCommunicator)->Apply(CommunicatorArgs);
+BENCHMARK(BM_SharedMemoryCommunicator)->Apply(CommunicatorArgs);
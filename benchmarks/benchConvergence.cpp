@@ -0,0 +1,637 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+/**
+ * Convergence benchmark of distributed pose graph optimization.
+ *
+ * Sweeps over datasets, numbers of robots, partitioning strategies, update schedules,
+ * acceleration settings and robust cost settings. Each configuration is run from the lifted
+ * chordal initialization until the Riemannian gradient norm of the centralized problem (and,
+ * optionally, the optimality gap with respect to a centralized reference solution) falls below
+ * a target. The wall-clock time, number of iterations and communication volume of each run
+ * are written to a JSON report, and optionally to a CSV summary.
+ */
+
+#include <DPGO/Communicator.h>
+#include <DPGO/DPGO_partition.h>
+#include <DPGO/DPGO_solver.h>
+#include <DPGO/DPGO_utils.h>
+#include <DPGO/PGOAgent.h>
+#include <DPGO/PoseGraph.h>
+#include <DPGO/QuadraticProblem.h>
+
+#include "benchUtils.h"
+
+#include <glog/logging.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace DPGO;
+
+namespace {
+
+const unsigned kRank = 5;
+
+/**
+ * @brief Benchmark configuration (each list is swept over)
+ */
+struct SweepOptions {
+  vector<string> datasets;
+  vector<unsigned> robots{5};
+  vector<string> partitions{"contiguous"};
+  vector<string> schedules{"greedy"};
+  vector<bool> acceleration{true};
+  vector<unsigned> restartIntervals{30};
+  vector<RobustCostParameters::Type> robustCosts{RobustCostParameters::Type::L2};
+  vector<double> gncMuSteps{1.4};
+  vector<bool> gncAdaptive{false};
+  vector<int> robustInnerIters{30};
+  unsigned maxIters = 1000;
+  double gradNormTol = 0.1;
+  // Relative optimality gap tolerance (negative to disable)
+  double gapTol = -1;
+  // Number of iterations between evaluations of the centralized problem
+  unsigned evalInterval = 1;
+  unsigned seed = 0;
+  string output = "convergence_report.json";
+  string csvOutput;
+};
+
+struct RunConfig {
+  string dataset;
+  unsigned robots;
+  string partition;
+  string schedule;
+  bool acceleration;
+  unsigned restartInterval;
+  RobustCostParameters::Type robustCost;
+  double gncMuStep;
+  bool gncAdaptive;
+  int robustInnerIters;
+};
+
+struct RunResult {
+  size_t numPoses = 0;
+  size_t numMeasurements = 0;
+  size_t numSharedLoopClosures = 0;
+  bool converged = false;
+  unsigned iterations = 0;
+  double wallMs = 0;
+  // Time along the critical path, assuming that robots updating in the same iteration run concurrently
+  double parallelMs = 0;
+  uint64_t bytesSent = 0;
+  uint64_t bytesReceived = 0;
+  uint64_t messagesSent = 0;
+  unsigned weightUpdates = 0;
+  double cost = 0;
+  double gradNorm = 0;
+  double referenceCost = std::numeric_limits<double>::quiet_NaN();
+  bool referenceCertified = false;
+  double optimalityGap = std::numeric_limits<double>::quiet_NaN();
+};
+
+/**
+ * @brief Communicator that counts the messages and bytes exchanged through another communicator
+ */
+class CountingCommunicator : public Communicator {
+ public:
+  explicit CountingCommunicator(std::shared_ptr<Communicator> comm) : comm_(std::move(comm)) {}
+  unsigned numAgents() const override { return comm_->numAgents(); }
+  bool publish(unsigned sender, const uint8_t *data, size_t size) override {
+    if (!comm_->publish(sender, data, size)) return false;
+    messagesSent++;
+    bytesSent += size;
+    return true;
+  }
+  size_t receive(unsigned receiver, const MessageCallback &callback) override {
+    return comm_->receive(receiver, [this, &callback](const uint8_t *data, size_t size) {
+      bytesReceived += size;
+      callback(data, size);
+    });
+  }
+  uint64_t messagesSent = 0;
+  uint64_t bytesSent = 0;
+  uint64_t bytesReceived = 0;
+
+ private:
+  std::shared_ptr<Communicator> comm_;
+};
+
+/**
+ * @brief Agent that updates its measurement weights during robust optimization,
+ * and exposes the weights of its loop closures for evaluation
+ */
+class BenchmarkAgent : public PGOAgent {
+ public:
+  using PGOAgent::PGOAgent;
+  // Return true if weights were updated
+  bool updateWeightsIfNeeded() {
+    if (mState != PGOAgentState::INITIALIZED || !shouldUpdateMeasurementWeights()) return false;
+    updateMeasurementWeights();
+    return true;
+  }
+  unsigned numWeightUpdates() const { return mWeightUpdateCount; }
+  bool weightsSettled() const { return measurementWeightsSettled(); }
+  // Weights of the loop closures whose source pose is owned by this robot
+  void loopClosureWeights(map<EdgeID, double, CompareEdgeID> &weights) const {
+    for (const auto *m : mPoseGraph->allLoopClosures()) {
+      if (m->r1 == getID()) weights[EdgeID(PoseID(m->r1, m->p1), PoseID(m->r2, m->p2))] = m->weight;
+    }
+  }
+};
+
+template<typename T>
+vector<T> parseList(const string &value, T (*parse)(const string &)) {
+  vector<T> result;
+  stringstream ss(value);
+  string item;
+  while (getline(ss, item, ',')) {
+    if (!item.empty()) result.push_back(parse(item));
+  }
+  return result;
+}
+
+string parseString(const string &s) { return s; }
+unsigned parseUnsigned(const string &s) { return stoul(s); }
+int parseInt(const string &s) { return stoi(s); }
+double parseDouble(const string &s) { return stod(s); }
+bool parseBool(const string &s) { return s == "1" || s == "true" || s == "on"; }
+RobustCostParameters::Type parseRobustCost(const string &s) {
+  for (auto type : {RobustCostParameters::Type::L2, RobustCostParameters::Type::L1,
+                    RobustCostParameters::Type::TLS, RobustCostParameters::Type::Huber,
+                    RobustCostParameters::Type::GM, RobustCostParameters::Type::GNC_TLS}) {
+    if (RobustCostParameters::robustCostName(type) == s) return type;
+  }
+  LOG(FATAL) << "Unknown robust cost: " << s;
+  return RobustCostParameters::Type::L2;
+}
+
+void printUsage(const char *program) {
+  cout << "Distributed PGO convergence benchmark.\n"
+       << "Usage: " << program << " [options] [dataset names or .g2o files...]\n"
+       << "List options take comma-separated values, and all combinations are run.\n"
+       << "  --robots=LIST            number of robots (default 5)\n"
+       << "  --partition=LIST         contiguous (equal trajectory segments), balanced\n"
+       << "                           (segments with equal numbers of measurements), or bisection\n"
+       << "                           (segments with few inter-robot loop closures)\n"
+       << "  --schedule=LIST          robot update schedule: greedy (largest gradient norm),\n"
+       << "                           round-robin, random, or all (every robot updates)\n"
+       << "  --acceleration=LIST      Nesterov acceleration (0/1)\n"
+       << "  --restart-interval=LIST  fixed restart interval of accelerated iterations\n"
+       << "  --robust-cost=LIST       " << RobustCostParameters::robustCostName(RobustCostParameters::Type::L2)
+       << ", " << RobustCostParameters::robustCostName(RobustCostParameters::Type::GNC_TLS) << ", ...\n"
+       << "  --gnc-mu-step=LIST       GNC schedule: multiplicative update of the control parameter\n"
+       << "  --gnc-adaptive=LIST      GNC schedule: adaptive update that freezes settled weights (0/1)\n"
+       << "  --inner-iters=LIST       GNC schedule: iterations between weight updates\n"
+       << "  --max-iters=N            maximum number of iterations (default 1000)\n"
+       << "  --grad-norm-tol=X        target gradient norm of the centralized problem (default 0.1)\n"
+       << "  --gap-tol=X              target relative optimality gap (default: disabled)\n"
+       << "  --eval-interval=N        iterations between evaluations (default 1)\n"
+       << "  --seed=N                 seed of the random schedule (default 0)\n"
+       << "  --output=FILE            JSON report (default convergence_report.json)\n"
+       << "  --csv=FILE               optional CSV summary\n"
+       << "Datasets default to the files in " << bench::dataDirectory() << "." << endl;
+}
+
+bool parseArguments(int argc, char **argv, SweepOptions &options) {
+  for (int i = 1; i < argc; ++i) {
+    const string arg = argv[i];
+    if (arg == "-h" || arg == "--help") return false;
+    if (arg.rfind("--", 0) != 0) {
+      options.datasets.push_back(arg);
+      continue;
+    }
+    const size_t eq = arg.find('=');
+    if (eq == string::npos) {
+      cout << "Missing value for option " << arg << endl;
+      return false;
+    }
+    const string key = arg.substr(2, eq - 2);
+    const string value = arg.substr(eq + 1);
+    if (key == "robots") options.robots = parseList(value, parseUnsigned);
+    else if (key == "partition") options.partitions = parseList(value, parseString);
+    else if (key == "schedule") options.schedules = parseList(value, parseString);
+    else if (key == "acceleration") options.acceleration = parseList(value, parseBool);
+    else if (key == "restart-interval") options.restartIntervals = parseList(value, parseUnsigned);
+    else if (key == "robust-cost") options.robustCosts = parseList(value, parseRobustCost);
+    else if (key == "gnc-mu-step") options.gncMuSteps = parseList(value, parseDouble);
+    else if (key == "gnc-adaptive") options.gncAdaptive = parseList(value, parseBool);
+    else if (key == "inner-iters") options.robustInnerIters = parseList(value, parseInt);
+    else if (key == "max-iters") options.maxIters = parseUnsigned(value);
+    else if (key == "grad-norm-tol") options.gradNormTol = parseDouble(value);
+    else if (key == "gap-tol") options.gapTol = parseDouble(value);
+    else if (key == "eval-interval") options.evalInterval = std::max(1u, parseUnsigned(value));
+    else if (key == "seed") options.seed = parseUnsigned(value);
+    else if (key == "output") options.output = value;
+    else if (key == "csv") options.csvOutput = value;
+    else {
+      cout << "Unknown option " << arg << endl;
+      return false;
+    }
+  }
+  for (const auto &partition : options.partitions) {
+    if (partition != "contiguous" && partition != "balanced" && partition != "bisection") {
+      cout << "Unknown partitioning strategy " << partition << endl;
+      return false;
+    }
+  }
+  for (const auto &schedule : options.schedules) {
+    if (schedule != "greedy" && schedule != "round-robin" && schedule != "random" && schedule != "all") {
+      cout << "Unknown schedule " << schedule << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Contiguous segments containing (approximately) equal numbers of measurement endpoints
+ */
+vector<size_t> balancedSegments(const vector<RelativeSEMeasurement> &measurements, size_t numPoses,
+                                unsigned numRobots) {
+  vector<size_t> degree(numPoses, 0);
+  for (const auto &m : measurements) {
+    degree[m.p1]++;
+    degree[m.p2]++;
+  }
+  const double total = 2.0 * measurements.size();
+  vector<size_t> starts{0};
+  size_t cumulative = 0;
+  for (size_t index = 0; index < numPoses && starts.size() < numRobots; ++index) {
+    cumulative += degree[index];
+    // Every robot keeps at least two poses
+    const size_t remaining = numRobots - starts.size();
+    if (cumulative >= total * starts.size() / numRobots && index + 1 >= starts.back() + 2 &&
+        numPoses - (index + 1) >= 2 * remaining)
+      starts.push_back(index + 1);
+  }
+  while (starts.size() < numRobots) starts.push_back(starts.back() + 2);
+  starts.push_back(numPoses);
+  return starts;
+}
+
+/**
+ * @brief Dataset with its centralized reference solution
+ */
+struct Dataset {
+  string name;
+  G2OData data;
+  PoseArray TChordal;
+  double referenceCost = std::numeric_limits<double>::quiet_NaN();
+  bool referenceCertified = false;
+
+  explicit Dataset(const string &file)
+      : name(bench::datasetName(file)),
+        data(load(file)),
+        TChordal(chordalInitialization(data.measurements)) {
+    solveReference();
+  }
+
+  static G2OData load(const string &file) {
+    G2OData data;
+    CHECK(bench::loadDataset(file, data)) << "Failed to load " << file;
+    return data;
+  }
+
+  // Cost of the centralized (non-robust) solution of the relaxation, which is globally optimal if certified
+  void solveReference() {
+    solveCertifiedPGOParams params;
+    const CertifiedPGOResult result = solveCertifiedPGO(data.measurements, params, &TChordal);
+    referenceCost = 2 * result.fRelaxed;
+    referenceCertified = result.certified;
+    LOG_IF(WARNING, !referenceCertified) << "Reference solution of " << name << " is not certified.";
+  }
+};
+
+RunResult run(const Dataset &D, const RunConfig &config, const SweepOptions &options) {
+  RunResult result;
+  const unsigned d = D.data.dimension;
+  const size_t n = D.data.numPoses;
+  const unsigned num_robots = config.robots;
+  result.numPoses = n;
+  result.numMeasurements = D.data.measurements.size();
+
+  PoseGraphPartition partition;
+  if (config.partition == "balanced") {
+    CHECK(splitPoseGraph(D.data.measurements, balancedSegments(D.data.measurements, n, num_robots), partition))
+        << "Failed to partition " << D.name << " across " << num_robots << " robots.";
+  } else {
+    const PartitionParameters partition_params(config.partition == "bisection"
+                                                   ? PartitionParameters::Method::RecursiveBisection
+                                                   : PartitionParameters::Method::Contiguous);
+    CHECK(partitionPoseGraph(D.data.measurements, n, num_robots, partition_params, partition))
+        << "Failed to partition " << D.name << " across " << num_robots << " robots.";
+  }
+  result.numSharedLoopClosures = partition.numSharedLoopClosures;
+
+  // Agents
+  PGOAgentParameters params(d, kRank, num_robots);
+  params.multirobotInitialization = false;
+  params.acceleration = config.acceleration;
+  params.restartInterval = config.restartInterval;
+  params.robustCostParams.costType = config.robustCost;
+  params.robustCostParams.GNCMuStep = config.gncMuStep;
+  params.robustCostParams.GNCAdaptive = config.gncAdaptive;
+  params.robustOptInnerIters = config.robustInnerIters;
+  params.maxNumIters = options.maxIters;
+  auto comm = std::make_shared<CountingCommunicator>(std::make_shared<InProcessCommunicator>(num_robots));
+  vector<std::unique_ptr<BenchmarkAgent>> agents;
+  const Matrix XChordal = fixedStiefelVariable(d, kRank) * D.TChordal.getData();
+  Matrix M;
+  for (unsigned robot = 0; robot < num_robots; ++robot) {
+    agents.emplace_back(new BenchmarkAgent(robot, params));
+    if (robot == 0)
+      agents[0]->getLiftingMatrix(M);
+    else
+      agents[robot]->setLiftingMatrix(M);
+    agents[robot]->setCommunicator(comm);
+    agents[robot]->setMeasurements(partition.agents[robot].odometry,
+                                   partition.agents[robot].privateLoopClosures,
+                                   partition.agents[robot].sharedLoopClosures);
+    agents[robot]->initialize();
+    agents[robot]->setX(XChordal.middleCols(partition.starts[robot] * (d + 1),
+                                            partition.numPoses(robot) * (d + 1)));
+  }
+
+  // Centralized problem used for evaluation (rebuilt when measurement weights change)
+  const bool robust = config.robustCost != RobustCostParameters::Type::L2;
+  std::shared_ptr<PoseGraph> pose_graph;
+  std::unique_ptr<QuadraticProblem> problem;
+  auto buildProblem = [&]() {
+    vector<RelativeSEMeasurement> measurements = D.data.measurements;
+    if (robust) {
+      map<EdgeID, double, CompareEdgeID> weights;
+      for (const auto &agent : agents) agent->loopClosureWeights(weights);
+      for (auto &m : measurements) {
+        auto it = weights.find(EdgeID(partition.poseID(m.p1), partition.poseID(m.p2)));
+        if (it != weights.end()) m.weight = it->second;
+      }
+    }
+    problem.reset();
+    pose_graph = std::make_shared<PoseGraph>(0, kRank, d);
+    pose_graph->setMeasurements(measurements);
+    problem.reset(new QuadraticProblem(pose_graph));
+  };
+  buildProblem();
+  if (!robust) {
+    result.referenceCost = D.referenceCost;
+    result.referenceCertified = D.referenceCertified;
+  }
+
+  Matrix X = XChordal;
+  Matrix RGrad;
+  auto evaluate = [&]() {
+    for (unsigned robot = 0; robot < num_robots; ++robot) {
+      Matrix XRobot;
+      if (agents[robot]->getX(XRobot))
+        X.middleCols(partition.starts[robot] * (d + 1), partition.numPoses(robot) * (d + 1)) = XRobot;
+    }
+    RGrad = problem->RieGrad(X);
+    result.gradNorm = RGrad.norm();
+    result.cost = 2 * problem->f(X);
+    if (!robust) result.optimalityGap = (result.cost - result.referenceCost) / std::abs(result.referenceCost);
+  };
+  auto converged = [&]() {
+    if (result.gradNorm >= options.gradNormTol) return false;
+    if (options.gapTol >= 0 && !robust && result.optimalityGap >= options.gapTol) return false;
+    // Robust optimization only terminates after all weight updates
+    if (robust) {
+      for (const auto &agent : agents) {
+        if (agent->numWeightUpdates() < (unsigned) params.robustOptNumWeightUpdates &&
+            !agent->weightsSettled())
+          return false;
+      }
+    }
+    return true;
+  };
+
+  std::mt19937 rng(options.seed);
+  unsigned selected = 0;
+  for (unsigned iter = 0; iter < options.maxIters; ++iter) {
+    double max_ms = 0, selected_ms = 0;
+    for (auto &agent : agents) {
+      const bool optimize = config.schedule == "all" || agent->getID() == selected;
+      if (optimize && config.schedule != "all") continue;  // the selected robot updates last
+      const auto start = SimpleTimer::Tic();
+      agent->iterate(optimize);
+      const double ms = SimpleTimer::Toc(start);
+      result.wallMs += ms;
+      max_ms = std::max(max_ms, ms);
+    }
+    if (config.schedule != "all") {
+      const auto start = SimpleTimer::Tic();
+      agents[selected]->iterate(true);
+      selected_ms = SimpleTimer::Toc(start);
+      result.wallMs += selected_ms;
+    }
+    result.parallelMs += max_ms + selected_ms;
+    result.iterations = iter + 1;
+
+    bool weights_updated = false;
+    for (auto &agent : agents) weights_updated |= agent->updateWeightsIfNeeded();
+    if (weights_updated) buildProblem();
+
+    const bool last = iter + 1 == options.maxIters;
+    if (config.schedule == "greedy" || last || (iter + 1) % options.evalInterval == 0) {
+      evaluate();
+      if (converged()) {
+        result.converged = true;
+        break;
+      }
+    }
+
+    // Select the robot to update at the next iteration
+    if (config.schedule == "round-robin") {
+      selected = (selected + 1) % num_robots;
+    } else if (config.schedule == "random") {
+      selected = std::uniform_int_distribution<unsigned>(0, num_robots - 1)(rng);
+    } else if (config.schedule == "greedy") {
+      double max_norm = -1;
+      for (unsigned robot = 0; robot < num_robots; ++robot) {
+        const double norm = RGrad.middleCols(partition.starts[robot] * (d + 1),
+                                             partition.numPoses(robot) * (d + 1)).norm();
+        if (norm > max_norm) {
+          max_norm = norm;
+          selected = robot;
+        }
+      }
+    }
+  }
+
+  result.bytesSent = comm->bytesSent;
+  result.bytesReceived = comm->bytesReceived;
+  result.messagesSent = comm->messagesSent;
+  for (const auto &agent : agents) result.weightUpdates = std::max(result.weightUpdates, agent->numWeightUpdates());
+  return result;
+}
+
+// Fields of a run in output order, shared by the JSON and CSV writers
+template<typename Visitor>
+void visitFields(const RunConfig &c, const RunResult &r, Visitor &&visit) {
+  visit("dataset", c.dataset);
+  visit("num_poses", r.numPoses);
+  visit("num_measurements", r.numMeasurements);
+  visit("robots", c.robots);
+  visit("partition", c.partition);
+  visit("num_shared_loop_closures", r.numSharedLoopClosures);
+  visit("schedule", c.schedule);
+  visit("acceleration", static_cast<int>(c.acceleration));
+  visit("restart_interval", c.restartInterval);
+  visit("robust_cost", RobustCostParameters::robustCostName(c.robustCost));
+  visit("gnc_mu_step", c.gncMuStep);
+  visit("gnc_adaptive", static_cast<int>(c.gncAdaptive));
+  visit("robust_inner_iters", c.robustInnerIters);
+  visit("converged", static_cast<int>(r.converged));
+  visit("iterations", r.iterations);
+  visit("wall_ms", r.wallMs);
+  visit("parallel_ms", r.parallelMs);
+  visit("bytes_sent", r.bytesSent);
+  visit("bytes_received", r.bytesReceived);
+  visit("messages_sent", r.messagesSent);
+  visit("weight_updates", r.weightUpdates);
+  visit("cost", r.cost);
+  visit("grad_norm", r.gradNorm);
+  visit("reference_cost", r.referenceCost);
+  visit("reference_certified", static_cast<int>(r.referenceCertified));
+  visit("optimality_gap", r.optimalityGap);
+}
+
+bool writeJSON(const string &filename, const SweepOptions &options,
+               const vector<pair<RunConfig, RunResult>> &runs) {
+  ofstream file(filename);
+  if (!file.is_open()) {
+    LOG(WARNING) << "Cannot write to file " << filename << ".";
+    return false;
+  }
+  file << std::setprecision(std::numeric_limits<double>::max_digits10);
+  file << "{\n  \"max_iters\": " << options.maxIters
+       << ",\n  \"grad_norm_tol\": " << options.gradNormTol
+       << ",\n  \"gap_tol\": " << options.gapTol
+       << ",\n  \"rank\": " << kRank
+       << ",\n  \"runs\": [";
+  for (size_t k = 0; k < runs.size(); ++k) {
+    file << (k == 0 ? "\n    {" : ",\n    {");
+    const char *separator = "";
+    visitFields(runs[k].first, runs[k].second, [&](const char *name, auto value) {
+      file << separator << "\"" << name << "\": ";
+      separator = ", ";
+      if constexpr (std::is_same_v<decltype(value), string>) {
+        file << "\"" << value << "\"";
+      } else if constexpr (std::is_floating_point_v<decltype(value)>) {
+        // JSON has no representation of non-finite numbers
+        if (std::isfinite(value))
+          file << value;
+        else
+          file << "null";
+      } else {
+        file << value;
+      }
+    });
+    file << "}";
+  }
+  file << "\n  ]\n}\n";
+  return file.good();
+}
+
+bool writeCSV(const string &filename, const vector<pair<RunConfig, RunResult>> &runs) {
+  ofstream file(filename);
+  if (!file.is_open()) {
+    LOG(WARNING) << "Cannot write to file " << filename << ".";
+    return false;
+  }
+  file << std::setprecision(std::numeric_limits<double>::max_digits10);
+  const char *separator = "";
+  visitFields(RunConfig(), RunResult(), [&](const char *name, auto) {
+    file << separator << name;
+    separator = ",";
+  });
+  file << "\n";
+  for (const auto &[config, result] : runs) {
+    separator = "";
+    visitFields(config, result, [&](const char *, auto value) {
+      file << separator << value;
+      separator = ",";
+    });
+    file << "\n";
+  }
+  return file.good();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  SweepOptions options;
+  if (!parseArguments(argc, argv, options)) {
+    printUsage(argv[0]);
+    exit(1);
+  }
+
+  // Resolve dataset names to files
+  vector<string> files;
+  if (options.datasets.empty()) {
+    files = bench::datasetFiles();
+  } else {
+    for (const auto &dataset : options.datasets) {
+      if (dataset.size() > 4 && dataset.substr(dataset.size() - 4) == ".g2o")
+        files.push_back(dataset);
+      else
+        files.push_back(bench::dataDirectory() + "/" + dataset + ".g2o");
+    }
+  }
+
+  vector<pair<RunConfig, RunResult>> runs;
+  for (const auto &file : files) {
+    cout << "Loading dataset " << file << "..." << endl;
+    const Dataset D(file);
+    for (unsigned robots : options.robots) {
+      if (D.data.numPoses < 2 * robots) {
+        cout << "Skipping " << robots << " robots: too few poses." << endl;
+        continue;
+      }
+      for (const auto &partition : options.partitions)
+        for (const auto &schedule : options.schedules)
+          for (bool acceleration : options.acceleration)
+            for (unsigned restart_interval : options.restartIntervals)
+              for (auto robust_cost : options.robustCosts)
+                for (double mu_step : options.gncMuSteps)
+                  for (bool gnc_adaptive : options.gncAdaptive)
+                  for (int inner_iters : options.robustInnerIters) {
+                    // GNC schedule parameters have no effect on non-robust runs
+                    if (robust_cost == RobustCostParameters::Type::L2 &&
+                        (mu_step != options.gncMuSteps.front() || gnc_adaptive != options.gncAdaptive.front() ||
+                         inner_iters != options.robustInnerIters.front()))
+                      continue;
+                    RunConfig config{D.name, robots, partition, schedule, acceleration,
+                                     restart_interval, robust_cost, mu_step, gnc_adaptive, inner_iters};
+                    const RunResult result = run(D, config, options);
+                    cout << D.name << " | robots = " << robots << " | " << partition << " | " << schedule
+                         << " | acceleration = " << acceleration << " | "
+                         << RobustCostParameters::robustCostName(robust_cost) << " | "
+                         << (result.converged ? "converged" : "not converged") << " in "
+                         << result.iterations << " iterations, " << result.wallMs << " ms, "
+                         << result.bytesSent << " bytes sent" << endl;
+                    runs.emplace_back(config, result);
+                  }
+    }
+  }
+
+  bool success = writeJSON(options.output, options, runs);
+  if (!options.csvOutput.empty()) success &= writeCSV(options.csvOutput, runs);
+  if (success) cout << "Wrote report of " << runs.size() << " runs to " << options.output << "." << endl;
+  return success ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <DPGO/DPGO_io.h>
+#include <DPGO/DPGO_utils.h>
+
+#include "benchUtils.h"
+
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace DPGO;
+
+namespace {
+
+void BM_ReadG2OLegacy(benchmark::State &state, const std::string &filename) {
+  size_t num_poses = 0;
+  for (auto _ : state) {
+    auto measurements = read_g2o_file(filename, num_poses);
+    benchmark::DoNotOptimize(measurements.data());
+  }
+  state.SetBytesProcessed(state.iterations() * std::filesystem::file_size(filename));
+}
+
+void BM_ReadG2OMapped(benchmark::State &state, const std::string &filename) {
+  G2OReaderOptions options(state.range(0));
+  G2OData data;
+  for (auto _ : state) {
+    readG2OFile(filename, data, options);
+    benchmark::DoNotOptimize(data.measurements.data());
+  }
+  state.SetBytesProcessed(state.iterations() * std::filesystem::file_size(filename));
+}
+
+// Map a snapshot and decode all measurements
+void BM_LoadSnapshot(benchmark::State &state, const std::string &filename) {
+  for (auto _ : state) {
+    PoseGraphSnapshot snapshot;
+    readSnapshot(filename, snapshot);
+    benchmark::DoNotOptimize(snapshot.measurements.data());
+  }
+  state.SetBytesProcessed(state.iterations() * std::filesystem::file_size(filename));
+}
+
+// Register one benchmark per file in the data directory
+// (which can be overridden with the DPGO_DATA_DIR environment variable)
+int registerG2OBenchmarks() {
+  for (const auto &file : bench::datasetFiles()) {
+    const std::string name = bench::datasetName(file);
+    // The legacy reader aborts on unknown types, hence is only benchmarked on supported files
+    G2OData data;
+    if (readG2OFile(file, data) && data.numSkippedLines == 0) {
+      benchmark::RegisterBenchmark(("BM_ReadG2OLegacy/" + name).c_str(), BM_ReadG2OLegacy, file)
+          ->Unit(benchmark::kMillisecond);
+    }
+    benchmark::RegisterBenchmark(("BM_ReadG2OMapped/" + name).c_str(), BM_ReadG2OMapped, file)
+        ->ArgName("threads")->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond);
+    const std::string snapshot = (std::filesystem::temp_directory_path() / (name + ".dpgs")).string();
+    if (convertG2OToSnapshot(file, snapshot)) {
+      benchmark::RegisterBenchmark(("BM_LoadSnapshot/" + name).c_str(), BM_LoadSnapshot, snapshot)
+          ->Unit(benchmark::kMillisecond);
+    }
+  }
+  return 0;
+}
+
+const int kG2OBenchmarks = registerG2OBenchmarks();
+
+}  // namespace
@@ -0,0 +1,239 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <DPGO/Communicator.h>
+#include <DPGO/DPGO_partition.h>
+#include <DPGO/DPGO_solver.h>
+#include <DPGO/DPGO_utils.h>
+#include <DPGO/PGOAgent.h>
+#include <DPGO/PoseGraph.h>
+#include <DPGO/QuadraticProblem.h>
+
+#include "benchUtils.h"
+
+#include <benchmark/benchmark.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace DPGO;
+
+/**
+ * End-to-end benchmarks of centralized and distributed pose graph optimization. By default, these
+ * only run on small and medium datasets (see bench::selectedDatasetFiles to change the selection).
+ */
+
+namespace {
+
+const std::vector<std::string> kDefaultDatasets{
+    "tinyGrid3D", "smallGrid3D", "input_INTEL_g2o", "input_MITb_g2o", "input_M3500_g2o",
+    "CSAIL", "cubicle", "sphere2500", "torus3D", "parking-garage"};
+// Chordal initialization also runs on large datasets, to compare sparse QR against the normal equations
+const std::vector<std::string> kChordalDatasets = [] {
+  std::vector<std::string> names = kDefaultDatasets;
+  names.insert(names.end(), {"city10000", "kitti_00"});
+  return names;
+}();
+const unsigned kRank = 5;
+// Number of rounds of distributed optimization, in each of which every robot updates once
+const unsigned kNumRounds = 100;
+
+struct Dataset {
+  G2OData data;
+  PoseArray TChordal;
+
+  explicit Dataset(const std::string &file)
+      : data(load(file)), TChordal(chordalInitialization(data.measurements)) {}
+
+  static G2OData load(const std::string &file) {
+    G2OData data;
+    CHECK(bench::loadDataset(file, data)) << "Failed to load " << file;
+    return data;
+  }
+
+  void setCounters(benchmark::State &state) const {
+    state.counters["poses"] = data.numPoses;
+    state.counters["measurements"] = data.measurements.size();
+  }
+
+  // Centralized cost and Riemannian gradient norm at the given (lifted) estimate
+  void setSolutionCounters(benchmark::State &state, const Matrix &X, unsigned r) const {
+    auto pose_graph = std::make_shared<PoseGraph>(0, r, data.dimension);
+    pose_graph->setMeasurements(data.measurements);
+    QuadraticProblem problem(pose_graph);
+    state.counters["cost"] = 2 * problem.f(X);
+    state.counters["grad_norm"] = problem.RieGradNorm(X);
+  }
+};
+
+Dataset &dataset(const std::string &file) {
+  static std::map<std::string, std::unique_ptr<Dataset>> datasets;
+  auto &dataset = datasets[file];
+  if (!dataset) dataset.reset(new Dataset(file));
+  return *dataset;
+}
+
+ROptParameters solverParameters() {
+  ROptParameters params;
+  params.method = ROptParameters::ROptMethod::RTR;
+  params.RTR_iterations = 50;
+  params.gradnorm_tol = 1e-1;
+  return params;
+}
+
+void BM_ChordalInitialization(benchmark::State &state, const std::string &file, InitializationMethod method) {
+  G2OData data;
+  CHECK(bench::loadDataset(file, data)) << "Failed to load " << file;
+  // Peak memory above the resident memory before the first iteration
+  const bool track_memory = bench::resetPeakMemory();
+  const long base_memory = bench::processMemoryKB("VmRSS");
+  PoseArray T(data.dimension, data.numPoses);
+  for (auto _ : state) {
+    T = chordalInitialization(data.measurements, method);
+    benchmark::DoNotOptimize(T.getData().data());
+  }
+  if (track_memory) state.counters["peak_memory_mb"] = (bench::processMemoryKB("VmHWM") - base_memory) / 1024.0;
+  state.counters["poses"] = data.numPoses;
+  state.counters["measurements"] = data.measurements.size();
+  // Chordal relaxation cost of the (unlifted) estimate
+  auto pose_graph = std::make_shared<PoseGraph>(0, data.dimension, data.dimension);
+  pose_graph->setMeasurements(data.measurements);
+  QuadraticProblem problem(pose_graph);
+  state.counters["cost"] = 2 * problem.f(T.getData());
+}
+
+void BM_SpanningTreeInitialization(benchmark::State &state, const std::string &file) {
+  const Dataset &D = dataset(file);
+  PoseArray T(D.data.dimension, D.data.numPoses);
+  for (auto _ : state) {
+    T = spanningTreeInitialization(D.data.measurements);
+    benchmark::DoNotOptimize(T.getData().data());
+  }
+  D.setCounters(state);
+  D.setSolutionCounters(state, T.getData(), D.data.dimension);
+}
+
+void BM_SolvePGO(benchmark::State &state, const std::string &file) {
+  const Dataset &D = dataset(file);
+  const ROptParameters params = solverParameters();
+  PoseArray T = D.TChordal;
+  for (auto _ : state) {
+    T = solvePGO(D.data.measurements, params, &D.TChordal);
+  }
+  D.setCounters(state);
+  D.setSolutionCounters(state, T.getData(), D.data.dimension);
+}
+
+void BM_SolveRobustPGO(benchmark::State &state, const std::string &file) {
+  const Dataset &D = dataset(file);
+  solveRobustPGOParams params;
+  params.opt_params = solverParameters();
+  params.verbose = false;
+  std::vector<RelativeSEMeasurement> measurements;
+  for (auto _ : state) {
+    state.PauseTiming();
+    // Measurement weights are updated in place
+    measurements = D.data.measurements;
+    state.ResumeTiming();
+    PoseArray T = solveRobustPGO(measurements, params, &D.TChordal);
+    benchmark::DoNotOptimize(T.getData().data());
+  }
+  D.setCounters(state);
+}
+
+// Synchronous distributed optimization from the lifted chordal initialization,
+// with agents exchanging messages through an in-process communicator
+void BM_MultiRobotPGO(benchmark::State &state, const std::string &file) {
+  const Dataset &D = dataset(file);
+  const unsigned num_robots = state.range(0);
+  const unsigned d = D.data.dimension;
+  const size_t n = D.data.numPoses;
+  PoseGraphPartition partition;
+  if (!partitionPoseGraph(D.data.measurements, n, num_robots,
+                          PartitionParameters(PartitionParameters::Method::Contiguous), partition)) {
+    state.SkipWithError("Too few poses for the number of robots");
+    return;
+  }
+  const Matrix XChordal = fixedStiefelVariable(d, kRank) * D.TChordal.getData();
+  auto blockOf = [&](unsigned robot) {
+    return std::make_pair(partition.starts[robot] * (d + 1), partition.numPoses(robot) * (d + 1));
+  };
+
+  Matrix X(kRank, n * (d + 1));
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto comm = std::make_shared<InProcessCommunicator>(num_robots);
+    std::vector<std::unique_ptr<PGOAgent>> agents;
+    Matrix M;
+    for (unsigned robot = 0; robot < num_robots; ++robot) {
+      PGOAgentParameters options(d, kRank, num_robots);
+      options.multirobotInitialization = false;
+      options.acceleration = true;
+      agents.emplace_back(new PGOAgent(robot, options));
+      if (robot == 0)
+        agents[0]->getLiftingMatrix(M);
+      else
+        agents[robot]->setLiftingMatrix(M);
+      agents[robot]->setCommunicator(comm);
+      agents[robot]->setMeasurements(partition.agents[robot].odometry,
+                                     partition.agents[robot].privateLoopClosures,
+                                     partition.agents[robot].sharedLoopClosures);
+      agents[robot]->initialize();
+      const auto block = blockOf(robot);
+      agents[robot]->setX(XChordal.middleCols(block.first, block.second));
+    }
+    state.ResumeTiming();
+
+    for (unsigned round = 0; round < kNumRounds; ++round) {
+      for (auto &agent : agents) agent->iterate(true);
+    }
+
+    state.PauseTiming();
+    for (unsigned robot = 0; robot < num_robots; ++robot) {
+      Matrix XRobot;
+      const auto block = blockOf(robot);
+      if (agents[robot]->getX(XRobot)) X.middleCols(block.first, block.second) = XRobot;
+    }
+    agents.clear();
+    state.ResumeTiming();
+  }
+  D.setCounters(state);
+  state.counters["rounds"] = kNumRounds;
+  D.setSolutionCounters(state, X, kRank);
+}
+
+int registerPGOBenchmarks() {
+  for (const auto &file : bench::selectedDatasetFiles(kChordalDatasets)) {
+    const std::string name = bench::datasetName(file);
+    for (auto method : {InitializationMethod::Chordal,
+                        InitializationMethod::ChordalCholesky,
+                        InitializationMethod::ChordalCG}) {
+      benchmark::RegisterBenchmark(
+          ("BM_ChordalInitialization/" + name + "/" + InitializationMethodToString(method)).c_str(),
+          BM_ChordalInitialization, file, method)
+          ->Unit(benchmark::kMillisecond);
+    }
+    benchmark::RegisterBenchmark(("BM_SpanningTreeInitialization/" + name).c_str(),
+                                 BM_SpanningTreeInitialization, file)
+        ->Unit(benchmark::kMillisecond);
+  }
+  for (const auto &file : bench::selectedDatasetFiles(kDefaultDatasets)) {
+    const std::string name = bench::datasetName(file);
+    benchmark::RegisterBenchmark(("BM_SolvePGO/" + name).c_str(), BM_SolvePGO, file)
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark(("BM_SolveRobustPGO/" + name).c_str(), BM_SolveRobustPGO, file)
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark(("BM_MultiRobotPGO/" + name).c_str(), BM_MultiRobotPGO, file)
+        ->ArgName("robots")->Arg(5)->Arg(10)->Unit(benchmark::kMillisecond);
+  }
+  return 0;
+}
+
+const int kPGOBenchmarks = registerPGOBenchmarks();
+
+}  // namespace
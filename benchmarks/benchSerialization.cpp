@@ -0,0 +1,139 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <DPGO/DPGO_serialization.h>
+#include <DPGO/DPGO_utils.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace DPGO;
+
+namespace {
+
+const unsigned kRank = 5;
+const unsigned kDim = 3;
+
+PoseDict randomPoseDict(unsigned num_poses) {
+  PoseDict poses;
+  for (unsigned i = 0; i < num_poses; ++i) {
+    LiftedPose Xi(kRank, kDim);
+    Xi.rotation() = randomStiefelVariable(kDim, kRank);
+    Xi.translation() = Vector::Random(kRank);
+    poses.emplace(PoseID(1, i), Xi);
+  }
+  return poses;
+}
+
+void BM_EncodePoseDict(benchmark::State &state) {
+  const auto encoding = static_cast<PoseEncoding>(state.range(1));
+  PoseDict poses = randomPoseDict(state.range(0));
+  std::vector<uint8_t> buffer(poseMessageSize(poses.size(), kRank, kDim, encoding));
+  size_t bytes = 0;
+  for (auto _ : state) {
+    bytes = encodePoseDict(poses, 1, buffer.data(), buffer.size(), encoding);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetBytesProcessed(state.iterations() * bytes);
+  state.SetItemsProcessed(state.iterations() * poses.size());
+  state.SetLabel(PoseEncodingToString(encoding));
+}
+
+void BM_DecodePoseDict(benchmark::State &state) {
+  const auto encoding = static_cast<PoseEncoding>(state.range(1));
+  PoseDict poses = randomPoseDict(state.range(0));
+  std::vector<uint8_t> buffer;
+  size_t bytes = encodePoseDict(poses, 1, buffer, encoding);
+  PoseDict decoded;
+  for (auto _ : state) {
+    decodePoseDict(buffer.data(), bytes, decoded);
+    benchmark::DoNotOptimize(decoded);
+  }
+  state.SetBytesProcessed(state.iterations() * bytes);
+  state.SetItemsProcessed(state.iterations() * poses.size());
+  state.SetLabel(PoseEncodingToString(encoding));
+}
+
+// Decode into preallocated storage without constructing a PoseDict
+void BM_DecodePoseView(benchmark::State &state) {
+  const auto encoding = static_cast<PoseEncoding>(state.range(1));
+  PoseDict poses = randomPoseDict(state.range(0));
+  std::vector<uint8_t> buffer;
+  size_t bytes = encodePoseDict(poses, 1, buffer, encoding);
+  LiftedPoseArray output(kRank, kDim, poses.size());
+  for (auto _ : state) {
+    PoseMessageView view;
+    view.parse(buffer.data(), bytes);
+    for (size_t i = 0; i < view.size(); ++i) {
+      view.copyPose(i, output.poseData(i));
+    }
+    benchmark::DoNotOptimize(output.poseData(0));
+  }
+  state.SetBytesProcessed(state.iterations() * bytes);
+  state.SetItemsProcessed(state.iterations() * poses.size());
+  state.SetLabel(PoseEncodingToString(encoding));
+}
+
+// Error-bounded encoding with the rounded representation of rank-deficient poses
+void BM_EncodePosesRounded(benchmark::State &state) {
+  const auto encoding = static_cast<PoseEncoding>(state.range(1));
+  Matrix U = randomStiefelVariable(kDim, kRank);
+  std::vector<LiftedPose> storage;
+  std::vector<PoseID> pose_ids;
+  std::vector<const double *> poses;
+  for (int i = 0; i < state.range(0); ++i) {
+    Matrix Ti(kDim, kDim + 1);
+    Ti.block(0, 0, kDim, kDim) = randomStiefelVariable(kDim, kDim);
+    Ti.col(kDim) = Vector::Random(kDim);
+    storage.emplace_back(U * Ti);
+    pose_ids.emplace_back(1, i);
+  }
+  for (const auto &pose : storage) poses.push_back(pose.poseData(0));
+  PoseEncodingParameters params(encoding, true, 1e-2);
+  std::vector<uint8_t> buffer;
+  size_t bytes = 0;
+  for (auto _ : state) {
+    bytes = encodePoses(pose_ids, poses, 1, kRank, kDim, params, buffer);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetBytesProcessed(state.iterations() * bytes);
+  state.SetItemsProcessed(state.iterations() * poses.size());
+  state.counters["message_bytes"] = bytes;
+  state.SetLabel(PoseEncodingToString(encoding));
+}
+
+void BM_EncodeMeasurements(benchmark::State &state) {
+  std::vector<RelativeSEMeasurement> measurements;
+  for (int i = 0; i < state.range(0); ++i) {
+    measurements.emplace_back(0, 1, i, i, randomStiefelVariable(kDim, kDim), Vector::Random(kDim), 1.0, 1.0);
+  }
+  std::vector<uint8_t> buffer(measurementsMessageSize(measurements.size(), kDim));
+  size_t bytes = 0;
+  for (auto _ : state) {
+    bytes = encodeMeasurements(measurements, 0, buffer.data(), buffer.size());
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetBytesProcessed(state.iterations() * bytes);
+  state.SetItemsProcessed(state.iterations() * measurements.size());
+}
+
+void PoseMessageArgs(benchmark::internal::Benchmark *b) {
+  for (int encoding : {static_cast<int>(PoseEncoding::Float64),
+                       static_cast<int>(PoseEncoding::Float32),
+                       static_cast<int>(PoseEncoding::Float16)}) {
+    for (int num_poses : {10, 100, 1000}) {
+      b->Args({num_poses, encoding});
+    }
+  }
+}
+
+}  // namespace
+
+BENCHMARK(BM_EncodePoseDict)->Apply(PoseMessageArgs);
+BENCHMARK(BM_DecodePoseDict)->Apply(PoseMessageArgs);
+BENCHMARK(BM_DecodePoseView)->Apply(PoseMessageArgs);
+BENCHMARK(BM_EncodePosesRounded)->Apply(PoseMessageArgs);
+BENCHMARK(BM_EncodeMeasurements)->Arg(100)->Arg(1000);
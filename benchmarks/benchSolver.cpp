@@ -0,0 +1,252 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <DPGO/DPGO_partition.h>
+#include <DPGO/DPGO_solver.h>
+#include <DPGO/DPGO_utils.h>
+#include <DPGO/PoseGraph.h>
+#include <DPGO/QuadraticProblem.h>
+#include <DPGO/manifold/LiftedSEVariable.h>
+#include <DPGO/manifold/LiftedSEVector.h>
+
+#include "benchUtils.h"
+
+#include <benchmark/benchmark.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace DPGO;
+
+/**
+ * Micro-benchmarks of the data matrix construction and cost evaluation kernels used in every
+ * local update. Each kernel is benchmarked on every dataset in the data directory.
+ */
+
+namespace {
+
+const unsigned kRank = 5;
+// Number of robots and robot whose local problem is used for the linear cost matrix
+const unsigned kNumRobots = 4;
+const unsigned kRobot = 1;
+
+/**
+ * @brief Centralized problem of a dataset with a lifted chordal initial estimate, and the local
+ * problem of one robot after splitting the dataset (with neighbor poses taken from the estimate)
+ */
+struct Problem {
+  G2OData data;
+  Matrix Y;
+  std::shared_ptr<PoseGraph> graph;
+  std::shared_ptr<PoseGraph> localGraph;
+
+  explicit Problem(const std::string &file) {
+    CHECK(bench::loadDataset(file, data)) << "Failed to load " << file;
+    const unsigned d = data.dimension;
+    Y = fixedStiefelVariable(d, kRank) * chordalInitialization(data.measurements).getData();
+    graph = std::make_shared<PoseGraph>(0, kRank, d);
+    graph->setMeasurements(data.measurements);
+
+    PoseGraphPartition partition;
+    CHECK(partitionPoseGraph(data.measurements, data.numPoses, kNumRobots,
+                             PartitionParameters(PartitionParameters::Method::Contiguous), partition))
+        << "Failed to partition " << file;
+    const AgentMeasurements &robot = partition.agents[kRobot];
+    std::vector<RelativeSEMeasurement> measurements = robot.odometry;
+    measurements.insert(measurements.end(), robot.privateLoopClosures.begin(), robot.privateLoopClosures.end());
+    measurements.insert(measurements.end(), robot.sharedLoopClosures.begin(), robot.sharedLoopClosures.end());
+    localGraph = std::make_shared<PoseGraph>(kRobot, kRank, d);
+    localGraph->setMeasurements(measurements);
+    PoseDict neighbor_poses;
+    for (const auto &pose_id : localGraph->neighborPublicPoseIDs()) {
+      const size_t index = partition.globalIndex(pose_id);
+      neighbor_poses.emplace(pose_id, LiftedPose(Matrix(Y.block(0, index * (d + 1), kRank, d + 1))));
+    }
+    localGraph->setNeighborPoses(neighbor_poses);
+  }
+
+  void setCounters(benchmark::State &state) const {
+    state.counters["poses"] = data.numPoses;
+    state.counters["measurements"] = data.measurements.size();
+  }
+};
+
+// Problems are constructed on first use, so that only the selected benchmarks load their datasets
+Problem &problem(const std::string &file) {
+  static std::map<std::string, std::unique_ptr<Problem>> problems;
+  auto &problem = problems[file];
+  if (!problem) problem.reset(new Problem(file));
+  return *problem;
+}
+
+void BM_ConstructConnectionLaplacian(benchmark::State &state, const std::string &file) {
+  const Problem &p = problem(file);
+  for (auto _ : state) {
+    SparseMatrix L = constructConnectionLaplacianSE(p.data.measurements);
+    benchmark::DoNotOptimize(L.valuePtr());
+  }
+  p.setCounters(state);
+  state.SetItemsProcessed(state.iterations() * p.data.measurements.size());
+}
+
+void BM_ConstructQ(benchmark::State &state, const std::string &file) {
+  Problem &p = problem(file);
+  for (auto _ : state) {
+    p.graph->clearQuadraticMatrix();
+    benchmark::DoNotOptimize(p.graph->quadraticMatrix().valuePtr());
+  }
+  p.setCounters(state);
+  state.SetItemsProcessed(state.iterations() * p.data.measurements.size());
+}
+
+void BM_ConstructG(benchmark::State &state, const std::string &file) {
+  Problem &p = problem(file);
+  for (auto _ : state) {
+    p.localGraph->clearLinearMatrix();
+    benchmark::DoNotOptimize(p.localGraph->linearMatrix().data());
+  }
+  p.setCounters(state);
+  state.counters["neighbor_poses"] = p.localGraph->neighborPublicPoseIDs().size();
+}
+
+// Sparse Cholesky factorization of the (regularized) quadratic cost matrix
+void BM_ConstructPreconditioner(benchmark::State &state, const std::string &file) {
+  Problem &p = problem(file);
+  for (auto _ : state) {
+    state.PauseTiming();
+    p.graph->clearQuadraticMatrix();
+    p.graph->quadraticMatrix();
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(p.graph->preconditioner().get());
+  }
+  p.setCounters(state);
+}
+
+void BM_EucGrad(benchmark::State &state, const std::string &file) {
+  Problem &p = problem(file);
+  QuadraticProblem quadratic_problem(p.graph);
+  const unsigned d = p.data.dimension, n = p.graph->n();
+  LiftedSEVariable x(kRank, d, n);
+  LiftedSEVector g(kRank, d, n);
+  x.setData(p.Y);
+  // Construct the data matrices outside of the timed region
+  p.graph->constructDataMatrices();
+  for (auto _ : state) {
+    quadratic_problem.EucGrad(x.var(), g.vec());
+    benchmark::ClobberMemory();
+  }
+  p.setCounters(state);
+}
+
+void BM_EucHessianEta(benchmark::State &state, const std::string &file) {
+  Problem &p = problem(file);
+  QuadraticProblem quadratic_problem(p.graph);
+  const unsigned d = p.data.dimension, n = p.graph->n();
+  LiftedSEVariable x(kRank, d, n);
+  LiftedSEVector v(kRank, d, n);
+  LiftedSEVector Hv(kRank, d, n);
+  x.setData(p.Y);
+  v.setData(p.Y);
+  p.graph->constructDataMatrices();
+  for (auto _ : state) {
+    quadratic_problem.EucHessianEta(x.var(), v.vec(), Hv.vec());
+    benchmark::ClobberMemory();
+  }
+  p.setCounters(state);
+}
+
+void BM_ProjectToRotationGroup(benchmark::State &state) {
+  const int d = state.range(0);
+  const Matrix M = Matrix::Random(d, d);
+  for (auto _ : state) {
+    Matrix R = projectToRotationGroup(M);
+    benchmark::DoNotOptimize(R.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_RobustCostWeights(benchmark::State &state) {
+  const auto type = static_cast<RobustCostParameters::Type>(state.range(0));
+  const int n = state.range(1);
+  RobustCostParameters params(type);
+  params.GNCInitMu = 0.1;
+  const RobustCost cost(params);
+  const Vector residuals = 10 * (Vector::Random(n).array() + 1);
+  Vector weights(n);
+  for (auto _ : state) {
+    cost.weights(residuals, weights);
+    benchmark::DoNotOptimize(weights.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+  state.SetLabel(RobustCostParameters::robustCostName(type));
+}
+
+void RobustCostWeightsArgs(benchmark::internal::Benchmark *b) {
+  for (auto type : {RobustCostParameters::Type::L1, RobustCostParameters::Type::Huber,
+                    RobustCostParameters::Type::TLS, RobustCostParameters::Type::GM,
+                    RobustCostParameters::Type::GNC_TLS}) {
+    b->Args({static_cast<int>(type), 1 << 16});
+  }
+}
+
+void BM_RobustSinglePoseAveraging(benchmark::State &state) {
+  // One in five candidate alignments is an inlier
+  const int n = state.range(0);
+  const double barc = RobustCost::computeErrorThresholdAtQuantile(0.9, 3);
+  const Matrix RTrue = Eigen::Quaterniond::UnitRandom().toRotationMatrix();
+  const Vector tTrue = Vector::Zero(3);
+  std::vector<Matrix> RVec;
+  std::vector<Vector> tVec;
+  for (int i = 0; i < n; ++i) {
+    if (i % 5 == 0) {
+      RVec.emplace_back(RTrue);
+      tVec.emplace_back(tTrue);
+    } else {
+      RVec.emplace_back(Eigen::Quaterniond::UnitRandom().toRotationMatrix());
+      tVec.emplace_back(10 * Vector::Random(3));
+    }
+  }
+  const Vector kappa = 1.82 * Vector::Ones(n);
+  const Vector tau = 0.01 * Vector::Ones(n);
+  Matrix ROpt;
+  Vector tOpt;
+  std::vector<size_t> inlierIndices;
+  for (auto _ : state) {
+    robustSinglePoseAveraging(ROpt, tOpt, inlierIndices, RVec, tVec, kappa, tau, barc);
+    benchmark::DoNotOptimize(ROpt.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+int registerSolverBenchmarks() {
+  for (const auto &file : bench::datasetFiles()) {
+    const std::string name = bench::datasetName(file);
+    benchmark::RegisterBenchmark(("BM_ConstructConnectionLaplacian/" + name).c_str(),
+                                 BM_ConstructConnectionLaplacian, file)->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark(("BM_ConstructQ/" + name).c_str(), BM_ConstructQ, file)
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark(("BM_ConstructG/" + name).c_str(), BM_ConstructG, file)
+        ->Unit(benchmark::kMicrosecond);
+    benchmark::RegisterBenchmark(("BM_ConstructPreconditioner/" + name).c_str(), BM_ConstructPreconditioner, file)
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark(("BM_EucGrad/" + name).c_str(), BM_EucGrad, file)
+        ->Unit(benchmark::kMicrosecond);
+    benchmark::RegisterBenchmark(("BM_EucHessianEta/" + name).c_str(), BM_EucHessianEta, file)
+        ->Unit(benchmark::kMicrosecond);
+  }
+  return 0;
+}
+
+const int kSolverBenchmarks = registerSolverBenchmarks();
+
+}  // namespace
+
+BENCHMARK(BM_ProjectToRotationGroup)->ArgName("d")->Arg(2)->Arg(3)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_RobustSinglePoseAveraging)->Arg(50)->Arg(500)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RobustCostWeights)->Apply(RobustCostWeightsArgs)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,153 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <DPGO/DPGO_partition.h>
+#include <DPGO/DPGO_solver.h>
+#include <DPGO/DPGO_utils.h>
+#include <DPGO/PGOAgent.h>
+#include <DPGO/PoseGraph.h>
+
+#include "benchUtils.h"
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace DPGO;
+
+namespace {
+
+const unsigned kNumRobots = 20;
+const unsigned kRank = 5;
+
+/**
+ * @brief Agents obtained by splitting kitti_00 into contiguous trajectory segments,
+ * initialized from the centralized chordal relaxation and with all public poses exchanged.
+ * The dataset location can be overridden with the DPGO_DATA_DIR environment variable.
+ */
+struct KittiTeam {
+  unsigned d = 0;
+  std::vector<std::unique_ptr<PGOAgent>> agents;
+  PoseGraphPartition partition;
+  // Index of the agent with the most shared loop closures
+  unsigned busiest = 0;
+
+  KittiTeam() {
+    const std::string file = bench::dataDirectory() + "/kitti_00.g2o";
+    size_t num_poses;
+    std::vector<RelativeSEMeasurement> dataset = read_g2o_file(file, num_poses);
+    CHECK(!dataset.empty()) << "Failed to load " << file;
+    d = dataset[0].t.size();
+    CHECK(partitionPoseGraph(dataset, num_poses, kNumRobots,
+                             PartitionParameters(PartitionParameters::Method::Contiguous), partition));
+
+    const Matrix XChordal = fixedStiefelVariable(d, kRank) * chordalInitialization(dataset).getData();
+    Matrix M;
+    for (unsigned robot = 0; robot < kNumRobots; ++robot) {
+      PGOAgentParameters options(d, kRank, kNumRobots);
+      options.multirobotInitialization = false;
+      agents.emplace_back(new PGOAgent(robot, options));
+      if (robot == 0)
+        agents[0]->getLiftingMatrix(M);
+      else
+        agents[robot]->setLiftingMatrix(M);
+      const AgentMeasurements &measurements = partition.agents[robot];
+      agents[robot]->setMeasurements(measurements.odometry, measurements.privateLoopClosures,
+                                     measurements.sharedLoopClosures);
+      agents[robot]->initialize();
+      agents[robot]->setX(XChordal.block(0, partition.starts[robot] * (d + 1), kRank,
+                                         partition.numPoses(robot) * (d + 1)));
+      if (measurements.sharedLoopClosures.size() > partition.agents[busiest].sharedLoopClosures.size())
+        busiest = robot;
+    }
+    for (auto &agent : agents) {
+      for (auto &neighbor : agents) {
+        if (agent->getID() != neighbor->getID()) agent->setNeighborStatus(neighbor->getStatus());
+      }
+    }
+    for (auto &agent : agents) {
+      PoseDict shared_poses;
+      CHECK(agent->getSharedPoseDict(shared_poses));
+      for (auto &neighbor : agents) {
+        if (agent->getID() != neighbor->getID()) neighbor->updateNeighborPoses(agent->getID(), shared_poses);
+      }
+    }
+  }
+};
+
+KittiTeam &kittiTeam() {
+  static KittiTeam team;
+  return team;
+}
+
+// Pose graph of the busiest agent
+std::shared_ptr<PoseGraph> busiestPoseGraph(const KittiTeam &team) {
+  const AgentMeasurements &busiest = team.partition.agents[team.busiest];
+  std::vector<RelativeSEMeasurement> measurements = busiest.odometry;
+  measurements.insert(measurements.end(), busiest.privateLoopClosures.begin(), busiest.privateLoopClosures.end());
+  measurements.insert(measurements.end(), busiest.sharedLoopClosures.begin(), busiest.sharedLoopClosures.end());
+  auto graph = std::make_shared<PoseGraph>(team.busiest, kRank, team.d);
+  graph->setMeasurements(measurements);
+  return graph;
+}
+
+// Public poses required by the pose graph, as a PoseDict and as a flat store
+void neighborPoses(const KittiTeam &team, const PoseGraph &graph, PoseDict *dict, LiftedPoseStore *store) {
+  PoseDict all;
+  for (const auto &agent : team.agents) {
+    PoseDict shared_poses;
+    agent->getSharedPoseDict(shared_poses);
+    all.insert(shared_poses.begin(), shared_poses.end());
+  }
+  for (const auto &pose_id : graph.neighborPublicPoseIDs()) {
+    dict->emplace(pose_id, all.at(pose_id));
+  }
+  store->reset(kRank, team.d);
+  store->assign(*dict);
+}
+
+// Local update of the agent with the most shared loop closures, including data matrix construction
+void BM_UpdateX(benchmark::State &state) {
+  PGOAgent &agent = *kittiTeam().agents[kittiTeam().busiest];
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(agent.iterate(true));
+  }
+}
+
+// Hand neighbor poses to the pose graph and rebuild the linear cost matrix
+void BM_SetNeighborPosesDict(benchmark::State &state) {
+  KittiTeam &team = kittiTeam();
+  auto graph = busiestPoseGraph(team);
+  PoseDict dict;
+  LiftedPoseStore store;
+  neighborPoses(team, *graph, &dict, &store);
+  for (auto _ : state) {
+    graph->setNeighborPoses(dict);
+    benchmark::DoNotOptimize(graph->linearMatrix().data());
+  }
+  state.counters["neighbor_poses"] = dict.size();
+}
+
+void BM_SetNeighborPosesStore(benchmark::State &state) {
+  KittiTeam &team = kittiTeam();
+  auto graph = busiestPoseGraph(team);
+  PoseDict dict;
+  LiftedPoseStore store;
+  neighborPoses(team, *graph, &dict, &store);
+  for (auto _ : state) {
+    graph->setNeighborPoses(store);
+    benchmark::DoNotOptimize(graph->linearMatrix().data());
+  }
+  state.counters["neighbor_poses"] = store.size();
+}
+
+}  // namespace
+
+BENCHMARK(BM_UpdateX)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SetNeighborPosesDict)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SetNeighborPosesStore)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,119 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#ifndef DPGO_BENCHMARKS_BENCHUTILS_H_
+#define DPGO_BENCHMARKS_BENCHUTILS_H_
+
+#include <DPGO/DPGO_io.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#ifndef DPGO_DATA_DIR
+#define DPGO_DATA_DIR "data/"
+#endif
+
+namespace DPGO::bench {
+
+/**
+ * @brief Directory containing the benchmark datasets
+ * (DPGO_DATA_DIR environment variable if set, otherwise the data directory of the source tree)
+ */
+inline std::string dataDirectory() {
+  const char *dir = std::getenv("DPGO_DATA_DIR");
+  return dir ? dir : DPGO_DATA_DIR;
+}
+
+/**
+ * @brief Sorted paths of all .g2o files in the data directory
+ */
+inline std::vector<std::string> datasetFiles() {
+  std::vector<std::string> files;
+  std::error_code ec;
+  for (const auto &entry : std::filesystem::directory_iterator(dataDirectory(), ec)) {
+    if (entry.path().extension() == ".g2o") files.push_back(entry.path().string());
+  }
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+/**
+ * @brief Name of a dataset (file name without extension)
+ */
+inline std::string datasetName(const std::string &file) {
+  return std::filesystem::path(file).stem().string();
+}
+
+/**
+ * @brief Paths of the datasets used by long-running benchmarks.
+ * The DPGO_BENCH_DATASETS environment variable overrides the default selection with a
+ * comma-separated list of dataset names, or "all" to select every file in the data directory.
+ * @param defaultNames names of the datasets selected by default
+ */
+inline std::vector<std::string> selectedDatasetFiles(const std::vector<std::string> &defaultNames) {
+  std::vector<std::string> names = defaultNames;
+  const char *selection = std::getenv("DPGO_BENCH_DATASETS");
+  if (selection) {
+    if (std::string(selection) == "all") return datasetFiles();
+    names.clear();
+    std::string name;
+    for (const char *c = selection;; ++c) {
+      if (*c == ',' || *c == '\0') {
+        if (!name.empty()) names.push_back(name);
+        name.clear();
+        if (*c == '\0') break;
+      } else {
+        name += *c;
+      }
+    }
+  }
+  std::vector<std::string> files;
+  for (const auto &file : datasetFiles()) {
+    if (std::find(names.begin(), names.end(), datasetName(file)) != names.end()) files.push_back(file);
+  }
+  return files;
+}
+
+/**
+ * @brief Read a dataset with the memory-mapped reader, skipping unsupported entries
+ * @return false if the file cannot be read or contains no measurement
+ */
+inline bool loadDataset(const std::string &file, G2OData &data) {
+  return readG2OFile(file, data) && !data.measurements.empty();
+}
+
+/**
+ * @brief Value in kB of the given field of /proc/self/status (e.g. VmRSS), or -1 if unavailable
+ */
+inline long processMemoryKB(const std::string &field) {
+  std::ifstream status("/proc/self/status");
+  std::string key;
+  long value;
+  while (status >> key) {
+    if (key == field + ":" && status >> value) return value;
+    status.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  }
+  return -1;
+}
+
+/**
+ * @brief Reset the peak resident memory (VmHWM) of the process to its current resident memory
+ * @return false if not supported (Linux only)
+ */
+inline bool resetPeakMemory() {
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  return clear_refs << "5" << std::flush && processMemoryKB("VmHWM") >= 0;
+}
+
+}  // namespace DPGO::bench
+
+#endif  // DPGO_BENCHMARKS_BENCHUTILS_H_
@@ -6,6 +6,7 @@
  * See LICENSE for the license information
  * -------------------------------------------------------------------------- */
 
+#include <DPGO/DPGO_partition.h>
 #include <DPGO/DPGO_types.h>
 #include <DPGO/DPGO_solver.h>
 #include <DPGO/PGOAgent.h>
@@ -13,6 +14,7 @@
 
 #include <cstdlib>
 #include <cassert>
+#include <iomanip>
 #include <iostream>
 
 using namespace std;
@@ -68,55 +70,12 @@ int main(int argc, char **argv) {
   Partition dataset into robots
   ###########################################
   */
-  unsigned int num_poses_per_robot = num_poses / num_robots;
-  if (num_poses_per_robot <= 0) {
-    cout << "More robots than total number of poses! Decrease the number of robots" << endl;
+  PoseGraphPartition partition;
+  if (!partitionPoseGraph(dataset, num_poses, num_robots, PartitionParameters(), partition)) {
+    cout << "Too few poses for the number of robots! Decrease the number of robots" << endl;
     exit(1);
   }
-
-  // create mapping from global pose index to local pose index
-  map<unsigned, PoseID> PoseMap;
-  for (unsigned robot = 0; robot < (unsigned) num_robots; ++robot) {
-    unsigned startIdx = robot * num_poses_per_robot;
-    unsigned endIdx = (robot + 1) * num_poses_per_robot;  // non-inclusive
-    if (robot == (unsigned) num_robots - 1) endIdx = n;
-    for (unsigned idx = startIdx; idx < endIdx; ++idx) {
-      unsigned localIdx = idx - startIdx;  // this is the local ID of this pose
-      PoseID pose(robot, localIdx);
-      PoseMap[idx] = pose;
-    }
-  }
-
-  vector<vector<RelativeSEMeasurement>> odometry(num_robots);
-  vector<vector<RelativeSEMeasurement>> private_loop_closures(num_robots);
-  vector<vector<RelativeSEMeasurement>> shared_loop_closure(num_robots);
-  for (auto mIn : dataset) {
-    PoseID src = PoseMap[mIn.p1];
-    PoseID dst = PoseMap[mIn.p2];
-
-    unsigned srcRobot = src.robot_id;
-    unsigned srcIdx = src.frame_id;
-    unsigned dstRobot = dst.robot_id;
-    unsigned dstIdx = dst.frame_id;
-
-    RelativeSEMeasurement m(srcRobot, dstRobot, srcIdx, dstIdx, mIn.R, mIn.t,
-                            mIn.kappa, mIn.tau);
-
-    if (srcRobot == dstRobot) {
-      // private measurement
-      if (srcIdx + 1 == dstIdx) {
-        // Odometry
-        odometry[srcRobot].push_back(m);
-      } else {
-        // private loop closure
-        private_loop_closures[srcRobot].push_back(m);
-      }
-    } else {
-      // shared measurement
-      shared_loop_closure[srcRobot].push_back(m);
-      shared_loop_closure[dstRobot].push_back(m);
-    }
-  }
+  cout << "Partitioned dataset with " << partition.numSharedLoopClosures << " inter-robot loop closures." << endl;
 
   /**
   ###########################################
@@ -138,9 +97,9 @@ int main(int argc, char **argv) {
       agent->setLiftingMatrix(M);
     }
 
-    agent->setMeasurements(odometry[robot],
-                           private_loop_closures[robot],
-                           shared_loop_closure[robot]);
+    agent->setMeasurements(partition.agents[robot].odometry,
+                           partition.agents[robot].privateLoopClosures,
+                           partition.agents[robot].sharedLoopClosures);
     agent->initialize();
     agents.push_back(agent);
   }
@@ -153,10 +112,7 @@ int main(int argc, char **argv) {
   auto TChordal = chordalInitialization(dataset);
   Matrix XChordal = fixedStiefelVariable(d, r) * TChordal.getData(); // Lift estimate to the correct relaxation rank
   for (unsigned robot = 0; robot < (unsigned) num_robots; ++robot) {
-    unsigned startIdx = robot * num_poses_per_robot;
-    unsigned endIdx = (robot + 1) * num_poses_per_robot;  // non-inclusive
-    if (robot == (unsigned) num_robots - 1) endIdx = n;
-    agents[robot]->setX(XChordal.block(0, startIdx * (d + 1), r, (endIdx - startIdx) * (d + 1)));
+    agents[robot]->setX(XChordal.block(0, partition.starts[robot] * (d + 1), r, partition.numPoses(robot) * (d + 1)));
   }
 
   /**
@@ -208,13 +164,9 @@ int main(int argc, char **argv) {
 
     // Form centralized solution
     for (unsigned robot = 0; robot < (unsigned) num_robots; ++robot) {
-      unsigned startIdx = robot * num_poses_per_robot;
-      unsigned endIdx = (robot + 1) * num_poses_per_robot;  // non-inclusive
-      if (robot == (unsigned) num_robots - 1) endIdx = n;
-
       Matrix XRobot;
       if (agents[robot]->getX(XRobot)) {
-        Xopt.block(0, startIdx * (d + 1), r, (endIdx - startIdx) * (d + 1)) = XRobot;
+        Xopt.block(0, partition.starts[robot] * (d + 1), r, partition.numPoses(robot) * (d + 1)) = XRobot;
       }
     }
     Matrix RGrad = problemCentral.RieGrad(Xopt);
@@ -237,10 +189,7 @@ int main(int argc, char **argv) {
     } else {
       std::vector<double> gradNorms;
       for (size_t robot = 0; robot < (unsigned) num_robots; ++robot) {
-        unsigned startIdx = robot * num_poses_per_robot;
-        unsigned endIdx = (robot + 1) * num_poses_per_robot;  // non-inclusive
-        if (robot == (unsigned) num_robots - 1) endIdx = n;
-        Matrix RGradRobot = RGrad.block(0, startIdx * (d + 1), r, (endIdx - startIdx) * (d + 1));
+        Matrix RGradRobot = RGrad.block(0, partition.starts[robot] * (d + 1), r, partition.numPoses(robot) * (d + 1));
         gradNorms.push_back(RGradRobot.norm());
       }
       selectedRobot = std::max_element(gradNorms.begin(), gradNorms.end()) - gradNorms.begin();
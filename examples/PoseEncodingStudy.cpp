@@ -0,0 +1,230 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <DPGO/DPGO_types.h>
+#include <DPGO/DPGO_serialization.h>
+#include <DPGO/DPGO_solver.h>
+#include <DPGO/PGOAgent.h>
+#include <DPGO/QuadraticProblem.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+using namespace DPGO;
+
+/**
+ * @brief Result of a single distributed optimization run
+ */
+struct StudyResult {
+  unsigned iterations = 0;
+  double cost = 0;
+  double gradnorm = 0;
+  size_t bytes = 0;
+};
+
+/**
+ * @brief Run the distributed PGO loop of MultiRobotExample, where public poses are exchanged as
+ * binary messages encoded with the specified parameters.
+ */
+StudyResult runDistributedPGO(const vector<RelativeSEMeasurement> &dataset,
+                              size_t num_poses,
+                              unsigned num_robots,
+                              const PoseEncodingParameters &encoding,
+                              unsigned numIters,
+                              double gradnormTol) {
+  unsigned int n, d, r;
+  d = (!dataset.empty() ? dataset[0].t.size() : 0);
+  n = num_poses;
+  r = 5;
+  bool acceleration = true;
+
+  std::shared_ptr<PoseGraph> pose_graph = std::make_shared<PoseGraph>(0, r, d);
+  pose_graph->setMeasurements(dataset);
+  QuadraticProblem problemCentral(pose_graph);
+
+  // Partition dataset into robots with contiguous trajectories
+  unsigned int num_poses_per_robot = num_poses / num_robots;
+  map<unsigned, PoseID> PoseMap;
+  for (unsigned robot = 0; robot < num_robots; ++robot) {
+    unsigned startIdx = robot * num_poses_per_robot;
+    unsigned endIdx = (robot + 1) * num_poses_per_robot;  // non-inclusive
+    if (robot == num_robots - 1) endIdx = n;
+    for (unsigned idx = startIdx; idx < endIdx; ++idx) {
+      PoseMap[idx] = PoseID(robot, idx - startIdx);
+    }
+  }
+  vector<vector<RelativeSEMeasurement>> odometry(num_robots);
+  vector<vector<RelativeSEMeasurement>> private_loop_closures(num_robots);
+  vector<vector<RelativeSEMeasurement>> shared_loop_closure(num_robots);
+  for (const auto &mIn : dataset) {
+    PoseID src = PoseMap[mIn.p1];
+    PoseID dst = PoseMap[mIn.p2];
+    RelativeSEMeasurement m(src.robot_id, dst.robot_id, src.frame_id, dst.frame_id, mIn.R, mIn.t,
+                            mIn.kappa, mIn.tau);
+    if (src.robot_id == dst.robot_id) {
+      if (src.frame_id + 1 == dst.frame_id) {
+        odometry[src.robot_id].push_back(m);
+      } else {
+        private_loop_closures[src.robot_id].push_back(m);
+      }
+    } else {
+      shared_loop_closure[src.robot_id].push_back(m);
+      shared_loop_closure[dst.robot_id].push_back(m);
+    }
+  }
+
+  vector<std::unique_ptr<PGOAgent>> agents;
+  for (unsigned robot = 0; robot < num_robots; ++robot) {
+    PGOAgentParameters options(d, r, num_robots);
+    options.acceleration = acceleration;
+    options.sharedPoseEncoding = encoding;
+    auto agent = std::make_unique<PGOAgent>(robot, options);
+    if (robot > 0) {
+      Matrix M;
+      agents[0]->getLiftingMatrix(M);
+      agent->setLiftingMatrix(M);
+    }
+    agent->setMeasurements(odometry[robot],
+                           private_loop_closures[robot],
+                           shared_loop_closure[robot]);
+    agent->initialize();
+    agents.push_back(std::move(agent));
+  }
+
+  // Initialize from the centralized chordal relaxation
+  auto TChordal = chordalInitialization(dataset);
+  Matrix XChordal = fixedStiefelVariable(d, r) * TChordal.getData();
+  for (unsigned robot = 0; robot < num_robots; ++robot) {
+    unsigned startIdx = robot * num_poses_per_robot;
+    unsigned endIdx = (robot + 1) * num_poses_per_robot;  // non-inclusive
+    if (robot == num_robots - 1) endIdx = n;
+    agents[robot]->setX(XChordal.block(0, startIdx * (d + 1), r, (endIdx - startIdx) * (d + 1)));
+  }
+
+  StudyResult result;
+  Matrix Xopt(r, n * (d + 1));
+  std::vector<uint8_t> buffer;
+  unsigned selectedRobot = 0;
+  for (unsigned iter = 0; iter < numIters; ++iter) {
+    PGOAgent *selectedRobotPtr = agents[selectedRobot].get();
+    for (auto &robotPtr : agents) {
+      if (robotPtr->getID() != selectedRobot) robotPtr->iterate(false);
+    }
+    // Selected robot receives encoded public (and auxiliary) poses from others
+    for (auto &robotPtr : agents) {
+      if (robotPtr->getID() == selectedRobot) continue;
+      selectedRobotPtr->setNeighborStatus(robotPtr->getStatus());
+      size_t bytes = robotPtr->encodeSharedPoses(buffer);
+      if (bytes == 0) continue;
+      result.bytes += bytes;
+      selectedRobotPtr->updateNeighborPosesFromBuffer(buffer.data(), bytes);
+      if (acceleration) {
+        bytes = robotPtr->encodeSharedPoses(buffer, true);
+        result.bytes += bytes;
+        selectedRobotPtr->updateNeighborPosesFromBuffer(buffer.data(), bytes);
+      }
+    }
+    selectedRobotPtr->iterate(true);
+
+    // Evaluate centralized solution
+    for (unsigned robot = 0; robot < num_robots; ++robot) {
+      unsigned startIdx = robot * num_poses_per_robot;
+      unsigned endIdx = (robot + 1) * num_poses_per_robot;  // non-inclusive
+      if (robot == num_robots - 1) endIdx = n;
+      Matrix XRobot;
+      if (agents[robot]->getX(XRobot)) {
+        Xopt.block(0, startIdx * (d + 1), r, (endIdx - startIdx) * (d + 1)) = XRobot;
+      }
+    }
+    Matrix RGrad = problemCentral.RieGrad(Xopt);
+    result.iterations = iter + 1;
+    result.cost = 2 * problemCentral.f(Xopt);
+    result.gradnorm = RGrad.norm();
+    if (result.gradnorm < gradnormTol) break;
+
+    // Select next robot with largest gradient norm
+    std::vector<double> gradNorms;
+    for (unsigned robot = 0; robot < num_robots; ++robot) {
+      unsigned startIdx = robot * num_poses_per_robot;
+      unsigned endIdx = (robot + 1) * num_poses_per_robot;  // non-inclusive
+      if (robot == num_robots - 1) endIdx = n;
+      gradNorms.push_back(RGrad.block(0, startIdx * (d + 1), r, (endIdx - startIdx) * (d + 1)).norm());
+    }
+    selectedRobot = std::max_element(gradNorms.begin(), gradNorms.end()) - gradNorms.begin();
+
+    // Share global anchor for rounding
+    Matrix M;
+    agents[0]->getSharedPose(0, M);
+    for (auto &agentPtr : agents) {
+      agentPtr->setGlobalAnchor(M);
+    }
+  }
+  return result;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    cout << "Study the impact of lossy public pose encodings on distributed PGO. " << endl;
+    cout << "Usage: " << argv[0] << " [# robots] [input .g2o file] [max error (default 1e-3)] [output .csv file]"
+         << endl;
+    exit(1);
+  }
+
+  int num_robots = atoi(argv[1]);
+  if (num_robots <= 0) {
+    cout << "Number of robots must be positive!" << endl;
+    exit(1);
+  }
+  size_t num_poses;
+  vector<RelativeSEMeasurement> dataset = read_g2o_file(argv[2], num_poses);
+  cout << "Loaded dataset from file " << argv[2] << "." << endl;
+  if (num_poses / num_robots == 0) {
+    cout << "More robots than total number of poses! Decrease the number of robots" << endl;
+    exit(1);
+  }
+  double maxError = 1e-3;
+  if (argc > 3) maxError = atof(argv[3]);
+
+  const unsigned numIters = 1000;
+  const double gradnormTol = 0.1;
+  vector<PoseEncodingParameters> configs = {
+      PoseEncodingParameters(PoseEncoding::Float64, false, maxError),
+      PoseEncodingParameters(PoseEncoding::Float32, false, maxError),
+      PoseEncodingParameters(PoseEncoding::Float16, false, maxError),
+      PoseEncodingParameters(PoseEncoding::Float64, true, maxError),
+      PoseEncodingParameters(PoseEncoding::Float32, true, maxError),
+      PoseEncodingParameters(PoseEncoding::Float16, true, maxError)};
+
+  std::ofstream csv;
+  if (argc > 4) {
+    csv.open(argv[4]);
+    csv << "encoding,rounded,max_error,iterations,cost,gradnorm,bytes\n";
+  }
+  cout << std::setw(10) << "encoding" << std::setw(9) << "rounded"
+       << std::setw(8) << "iters" << std::setw(16) << "cost"
+       << std::setw(12) << "gradnorm" << std::setw(14) << "bytes" << endl;
+  for (const auto &config : configs) {
+    StudyResult result = runDistributedPGO(dataset, num_poses, num_robots, config, numIters, gradnormTol);
+    cout << std::setw(10) << PoseEncodingToString(config.encoding)
+         << std::setw(9) << config.rounded
+         << std::setw(8) << result.iterations
+         << std::setw(16) << std::setprecision(8) << result.cost
+         << std::setw(12) << std::setprecision(4) << result.gradnorm
+         << std::setw(14) << result.bytes << endl;
+    if (csv.is_open()) {
+      csv << PoseEncodingToString(config.encoding) << "," << config.rounded << ","
+          << config.maxError << "," << result.iterations << ","
+          << std::setprecision(12) << result.cost << "," << result.gradnorm << ","
+          << result.bytes << "\n";
+    }
+  }
+  exit(0);
+}
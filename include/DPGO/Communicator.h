@@ -0,0 +1,147 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#ifndef DPGO_INCLUDE_DPGO_COMMUNICATOR_H_
+#define DPGO_INCLUDE_DPGO_COMMUNICATOR_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace DPGO {
+
+/**
+ * @brief Callback invoked on each received message.
+ * The message buffer is only valid for the duration of the callback.
+ */
+typedef std::function<void(const uint8_t *data, size_t size)> MessageCallback;
+
+/**
+ * @brief Abstract transport used by PGOAgent to exchange binary messages (see DPGO_serialization.h)
+ * with other agents. Messages are broadcast to all other agents; each agent drains its own inbox.
+ * Implementations must be safe to use from multiple threads.
+ */
+class Communicator {
+ public:
+  virtual ~Communicator() = default;
+  /**
+   * @brief Return the number of agents connected by this communicator
+   */
+  virtual unsigned numAgents() const = 0;
+  /**
+   * @brief Broadcast a message to all agents except the sender
+   * @param sender ID of the sending agent
+   * @param data
+   * @param size size of message in bytes
+   * @return false if the message could not be sent
+   */
+  virtual bool publish(unsigned sender, const uint8_t *data, size_t size) = 0;
+  /**
+   * @brief Process all pending messages addressed to the receiver, in the order they were published
+   * @param receiver ID of the receiving agent
+   * @param callback function invoked on each message
+   * @return number of messages processed
+   */
+  virtual size_t receive(unsigned receiver, const MessageCallback &callback) = 0;
+};
+
+/**
+ * @brief Communicator for agents that live in the same process.
+ * A published message is copied once into a reference-counted buffer that is shared by
+ * the inboxes of all receivers, which decode it in place.
+ */
+class InProcessCommunicator : public Communicator {
+ public:
+  /**
+   * @brief Constructor
+   * @param num_agents number of agents
+   * @param max_queue_size maximum number of pending messages per receiver (oldest messages are dropped first)
+   */
+  explicit InProcessCommunicator(unsigned num_agents, size_t max_queue_size = 1024);
+  unsigned numAgents() const override { return num_agents_; }
+  bool publish(unsigned sender, const uint8_t *data, size_t size) override;
+  size_t receive(unsigned receiver, const MessageCallback &callback) override;
+  /**
+   * @brief Return the number of messages dropped because an inbox was full
+   */
+  size_t numDropped() const;
+
+ private:
+  typedef std::shared_ptr<const std::vector<uint8_t>> MessagePtr;
+  struct Inbox {
+    std::mutex mutex;
+    std::deque<MessagePtr> messages;
+  };
+  const unsigned num_agents_;
+  const size_t max_queue_size_;
+  std::vector<std::unique_ptr<Inbox>> inboxes_;
+  mutable std::mutex dropped_mutex_;
+  size_t num_dropped_;
+};
+
+/**
+ * @brief Communicator for agents in different processes on the same host, based on a
+ * POSIX shared memory segment containing one ring buffer of fixed-size slots per receiver.
+ * Each ring is protected by a process-shared mutex. When a ring is full, the oldest message is
+ * overwritten, since newer poses supersede older ones in distributed PGO.
+ *
+ * Exactly one process should create the segment; the remaining processes open it by name.
+ * Processes that open the segment ignore stale segments whose creator has exited, and wait
+ * for the creator to replace them.
+ */
+class SharedMemoryCommunicator : public Communicator {
+ public:
+  /**
+   * @brief Constructor
+   * @param name name of the shared memory object (e.g., "/dpgo")
+   * @param num_agents number of agents
+   * @param create if true, create (or replace) the segment; otherwise, open an existing segment
+   * @param num_slots number of messages each ring buffer can hold
+   * @param slot_size maximum size of a single message in bytes
+   * @param timeout_ms when opening, time to wait for the segment to be created and initialized
+   */
+  SharedMemoryCommunicator(const std::string &name,
+                           unsigned num_agents,
+                           bool create,
+                           unsigned num_slots = 64,
+                           size_t slot_size = 1 << 20,
+                           unsigned timeout_ms = 5000);
+  /**
+   * @brief Destructor. Unmap the segment, and unlink it if this instance created it.
+   */
+  ~SharedMemoryCommunicator() override;
+  SharedMemoryCommunicator(const SharedMemoryCommunicator &) = delete;
+  SharedMemoryCommunicator &operator=(const SharedMemoryCommunicator &) = delete;
+  unsigned numAgents() const override { return num_agents_; }
+  /**
+   * @brief Return the maximum size of a single message in bytes
+   */
+  size_t slotSize() const { return slot_size_; }
+  bool publish(unsigned sender, const uint8_t *data, size_t size) override;
+  size_t receive(unsigned receiver, const MessageCallback &callback) override;
+
+ private:
+  struct SegmentHeader;
+  struct RingHeader;
+  RingHeader *ring(unsigned receiver) const;
+  uint8_t *slot(unsigned receiver, uint64_t index) const;
+  std::string name_;
+  unsigned num_agents_;
+  unsigned num_slots_;
+  size_t slot_size_;
+  bool owner_;
+  size_t segment_size_;
+  uint8_t *segment_;
+};
+
+}  // namespace DPGO
+
+#endif  // DPGO_INCLUDE_DPGO_COMMUNICATOR_H_
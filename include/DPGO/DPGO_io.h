@@ -0,0 +1,338 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#ifndef DPGO_INCLUDE_DPGO_IO_H_
+#define DPGO_INCLUDE_DPGO_IO_H_
+
+#include <DPGO/DPGO_types.h>
+#include <DPGO/RelativeSEMeasurement.h>
+#include <DPGO/manifold/Poses.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace DPGO {
+
+/**
+ * @brief Options for readG2OFile
+ */
+struct G2OReaderOptions {
+  // Number of threads used for parsing (0 means use all hardware threads)
+  unsigned numThreads;
+
+  // If true, keep VERTEX_SE2 / VERTEX_SE3:QUAT entries as initial guess
+  bool readVertices;
+
+  // If true, skip lines with unknown tokens (e.g., other vertex and edge types);
+  // otherwise, reading fails on the first unknown token
+  bool skipUnknown;
+
+  explicit G2OReaderOptions(unsigned numThreadsIn = 0,
+                            bool readVerticesIn = false,
+                            bool skipUnknownIn = true)
+      : numThreads(numThreadsIn), readVertices(readVerticesIn), skipUnknown(skipUnknownIn) {}
+};
+
+/**
+ * @brief Content of a g2o file
+ */
+struct G2OData {
+  // Dimension (2 or 3)
+  unsigned dimension = 0;
+
+  // Number of poses (one plus the largest pose index referenced by a measurement,
+  // or by a vertex if vertices are read)
+  size_t numPoses = 0;
+
+  // Relative pose measurements, in the order they appear in the file
+  std::vector<RelativeSEMeasurement> measurements;
+
+  // Initial guess assembled from vertex entries (only if requested and present).
+  // Poses without a vertex entry are set to identity.
+  std::optional<PoseArray> initialGuess;
+
+  // Number of lines skipped due to unknown tokens
+  size_t numSkippedLines = 0;
+};
+
+/**
+ * @brief Read a dataset in .g2o format.
+ * The file is memory mapped and split into chunks at line boundaries, which are parsed in
+ * parallel. Measurements are identical to those produced by read_g2o_file.
+ * @param filename
+ * @param data output
+ * @param options
+ * @return false if the file cannot be read or contains malformed entries
+ */
+bool readG2OFile(const std::string &filename, G2OData &data,
+                 const G2OReaderOptions &options = G2OReaderOptions());
+
+/**
+ * @brief Binary pose graph snapshot format.
+ *
+ * A snapshot file consists of a fixed-size SnapshotHeader followed by 8-byte aligned sections:
+ * - measurements: packed fixed-size records (SnapshotMeasurementRecord followed by the
+ *   d-by-d rotation and d-dimensional translation in column-major order)
+ * - trajectory (optional): d-by-(d+1)n matrix in column-major order
+ * - iterate (optional): lifted iterate X as r-by-(d+1)n matrix in column-major order
+ * - lifting matrix (optional): r-by-d matrix in column-major order
+ * All fields are stored in host byte order, so that a memory-mapped snapshot can be
+ * accessed in place without parsing.
+ */
+const uint32_t kSnapshotMagic = 0x53475044;  // "DPGS"
+const uint16_t kSnapshotVersion = 1;
+
+struct SnapshotHeader {
+  uint32_t magic;             // Always kSnapshotMagic
+  uint16_t version;           // Snapshot format version
+  uint8_t d;                  // Dimension
+  uint8_t reserved;
+  uint32_t agentID;           // ID of the agent that owns the pose graph
+  uint32_t r;                 // Relaxation rank of the lifted iterate (0 if absent)
+  uint64_t numPoses;          // Number of poses
+  uint64_t numMeasurements;   // Number of measurements
+  uint64_t measurementsOffset;
+  uint64_t trajectoryOffset;  // Offsets in bytes from the start of file (0 if absent)
+  uint64_t iterateOffset;
+  uint64_t liftingMatrixOffset;
+  uint64_t fileSize;          // Total size of the snapshot in bytes
+};
+static_assert(sizeof(SnapshotHeader) == 72, "Unexpected padding in SnapshotHeader");
+
+struct SnapshotMeasurementRecord {
+  uint32_t r1, p1, r2, p2;
+  double kappa, tau, weight;
+  uint8_t fixedWeight;
+  uint8_t padding[7];
+};
+static_assert(sizeof(SnapshotMeasurementRecord) == 48, "Unexpected padding in SnapshotMeasurementRecord");
+
+/**
+ * @brief In-memory content of a pose graph snapshot
+ */
+struct PoseGraphSnapshot {
+  // ID of the agent that owns the pose graph
+  unsigned agentID = 0;
+
+  // Dimension
+  unsigned d = 0;
+
+  // Number of poses
+  size_t numPoses = 0;
+
+  // Measurements, including the current weights
+  std::vector<RelativeSEMeasurement> measurements;
+
+  // Trajectory estimate as d-by-(d+1)n matrix
+  std::optional<Matrix> trajectory;
+
+  // Lifted iterate as r-by-(d+1)n matrix
+  std::optional<Matrix> X;
+
+  // Lifting matrix shared by all agents (r-by-d)
+  std::optional<Matrix> liftingMatrix;
+};
+
+/**
+ * @brief Write a pose graph snapshot to file
+ * @param filename
+ * @param snapshot
+ * @return false if the snapshot is inconsistent or the file cannot be written
+ */
+bool writeSnapshot(const std::string &filename, const PoseGraphSnapshot &snapshot);
+
+/**
+ * @brief Read-only, memory-mapped view of a snapshot file.
+ * Trajectory and iterate are mapped in place; measurements are decoded on access.
+ */
+class SnapshotView {
+ public:
+  typedef Eigen::Map<const Matrix> ConstMatrixMap;
+  SnapshotView() = default;
+  ~SnapshotView();
+  SnapshotView(const SnapshotView &) = delete;
+  SnapshotView &operator=(const SnapshotView &) = delete;
+  /**
+   * @brief Map and validate a snapshot file
+   * @return false if the file cannot be mapped or is not a valid snapshot
+   */
+  bool open(const std::string &filename);
+  /**
+   * @brief Attach this view to a snapshot stored in memory (8-byte aligned), which must outlive the view
+   * @return false if the buffer does not contain a valid snapshot
+   */
+  bool parse(const uint8_t *data, size_t size);
+  /**
+   * @brief Detach this view, unmapping the file if needed
+   */
+  void close();
+  const SnapshotHeader &header() const { return *reinterpret_cast<const SnapshotHeader *>(data_); }
+  unsigned d() const { return header().d; }
+  size_t numPoses() const { return header().numPoses; }
+  size_t numMeasurements() const { return header().numMeasurements; }
+  /**
+   * @brief Decode the measurement at the specified index
+   */
+  RelativeSEMeasurement measurement(size_t index) const;
+  bool hasTrajectory() const { return header().trajectoryOffset != 0; }
+  bool hasIterate() const { return header().iterateOffset != 0; }
+  bool hasLiftingMatrix() const { return header().liftingMatrixOffset != 0; }
+  /**
+   * @brief Map the trajectory (d-by-(d+1)n), iterate (r-by-(d+1)n) and lifting matrix (r-by-d)
+   * in place. Only valid if the corresponding section is present.
+   */
+  ConstMatrixMap trajectory() const;
+  ConstMatrixMap iterate() const;
+  ConstMatrixMap liftingMatrix() const;
+  /**
+   * @brief Copy the complete snapshot into memory
+   */
+  PoseGraphSnapshot toSnapshot() const;
+
+ private:
+  bool validate() const;
+  const double *section(uint64_t offset) const { return reinterpret_cast<const double *>(data_ + offset); }
+  const uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+  bool owned_ = false;
+};
+
+/**
+ * @brief Read a pose graph snapshot from file
+ * @return false if the file is not a valid snapshot
+ */
+bool readSnapshot(const std::string &filename, PoseGraphSnapshot &snapshot);
+
+/**
+ * @brief Convert a g2o file to a snapshot. Vertices (if any) are stored as trajectory.
+ * @return false if conversion fails
+ */
+bool convertG2OToSnapshot(const std::string &g2o_file, const std::string &snapshot_file);
+
+/**
+ * @brief Convert measurements (and optionally trajectory) logged by PGOLogger to a snapshot
+ * @param measurements_file CSV file written by PGOLogger::logMeasurements
+ * @param trajectory_file CSV file written by PGOLogger::logTrajectory (ignored if empty)
+ * @param snapshot_file
+ * @param agent_id
+ * @return false if conversion fails
+ */
+bool convertLogToSnapshot(const std::string &measurements_file,
+                          const std::string &trajectory_file,
+                          const std::string &snapshot_file,
+                          unsigned agent_id = 0);
+
+/**
+ * @brief Binary agent checkpoint format.
+ *
+ * A checkpoint file consists of a fixed-size CheckpointHeader followed by 8-byte aligned sections:
+ * - snapshot: an embedded pose graph snapshot (see SnapshotHeader) holding the measurements with
+ *   their current weights, the local initial trajectory, the lifted iterate and the lifting matrix
+ * - auxiliary matrices: the optional matrices flagged in CheckpointHeader::flags, in the order of
+ *   the flags below, in column-major order. XInit, XPrev, Y and V are r-by-(d+1)n matrices and
+ *   the global anchor is a r-by-(d+1) matrix.
+ * - GNC loop closures (if kCheckpointHasGNCLoopClosures is set): the settled loop closures
+ *   followed by the undecided loop closures of adaptive GNC, as CheckpointEdgeRecord
+ */
+const uint32_t kCheckpointMagic = 0x43475044;  // "DPGC"
+const uint16_t kCheckpointVersion = 2;
+const uint8_t kCheckpointHasXInit = 1 << 0;
+const uint8_t kCheckpointHasXPrev = 1 << 1;
+const uint8_t kCheckpointHasAcceleration = 1 << 2;  // Y and V
+const uint8_t kCheckpointHasGlobalAnchor = 1 << 3;
+const uint8_t kCheckpointHasGNCLoopClosures = 1 << 4;
+
+struct CheckpointHeader {
+  uint32_t magic;                        // Always kCheckpointMagic
+  uint16_t version;                      // Checkpoint format version
+  uint8_t state;                         // Agent state (PGOAgentState)
+  uint8_t flags;                         // Auxiliary matrices present in the checkpoint
+  uint32_t instanceNumber;
+  uint32_t iterationNumber;
+  uint32_t latestWeightUpdateIteration;
+  int32_t robustOptInnerIter;
+  int32_t weightUpdateCount;
+  int32_t trajectoryResetCount;
+  uint64_t gncIteration;                 // Internal GNC state
+  double gncMu;
+  double gamma;                          // Acceleration parameters
+  double alpha;
+  uint32_t r;                            // Relaxation rank of the auxiliary matrices
+  uint32_t reserved;
+  uint64_t snapshotOffset;               // Offsets in bytes from the start of file
+  uint64_t snapshotSize;
+  uint64_t auxiliaryOffset;
+  uint64_t fileSize;                     // Total size of the checkpoint in bytes
+  uint64_t numGNCSettledLoopClosures;    // Loop closures of adaptive GNC
+  uint64_t numGNCUndecidedLoopClosures;
+};
+static_assert(sizeof(CheckpointHeader) == 120, "Unexpected padding in CheckpointHeader");
+
+struct CheckpointEdgeRecord {
+  uint32_t r1, p1, r2, p2;
+};
+static_assert(sizeof(CheckpointEdgeRecord) == 16, "Unexpected padding in CheckpointEdgeRecord");
+
+/**
+ * @brief In-memory content of an agent checkpoint
+ */
+struct AgentCheckpoint {
+  // Pose graph with current weights, local initial trajectory, iterate and lifting matrix
+  PoseGraphSnapshot snapshot;
+
+  // Agent state (PGOAgentState)
+  unsigned state = 0;
+
+  // Counters
+  unsigned instanceNumber = 0;
+  unsigned iterationNumber = 0;
+  unsigned latestWeightUpdateIteration = 0;
+  int robustOptInnerIter = 0;
+  int weightUpdateCount = 0;
+  int trajectoryResetCount = 0;
+
+  // Internal GNC state
+  size_t gncIteration = 0;
+  double gncMu = 0;
+
+  // Acceleration state
+  double gamma = 0;
+  double alpha = 0;
+  std::optional<Matrix> Y;
+  std::optional<Matrix> V;
+
+  // Previous and initial iterates
+  std::optional<Matrix> XPrev;
+  std::optional<Matrix> XInit;
+
+  // Anchor shared by all agents
+  std::optional<Matrix> globalAnchor;
+
+  // Loop closures whose weights are settled or undecided in adaptive GNC
+  std::vector<EdgeID> gncSettledLoopClosures;
+  std::vector<EdgeID> gncUndecidedLoopClosures;
+};
+
+/**
+ * @brief Write an agent checkpoint to file
+ * @param filename
+ * @param checkpoint
+ * @return false if the checkpoint is inconsistent or the file cannot be written
+ */
+bool writeCheckpoint(const std::string &filename, const AgentCheckpoint &checkpoint);
+
+/**
+ * @brief Read an agent checkpoint from file
+ * @return false if the file is not a valid checkpoint
+ */
+bool readCheckpoint(const std::string &filename, AgentCheckpoint &checkpoint);
+
+}  // namespace DPGO
+
+#endif  // DPGO_INCLUDE_DPGO_IO_H_
@@ -0,0 +1,116 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#ifndef DPGO_INCLUDE_DPGO_PARTITION_H_
+#define DPGO_INCLUDE_DPGO_PARTITION_H_
+
+#include <DPGO/DPGO_types.h>
+#include <DPGO/RelativeSEMeasurement.h>
+
+#include <string>
+#include <vector>
+
+namespace DPGO {
+
+/**
+ * @brief Parameter settings for splitting a single-robot pose graph across robots
+ */
+class PartitionParameters {
+ public:
+  enum class Method {
+    // Trajectory segments with equal numbers of poses
+    Contiguous,
+    // Recursive bisection of the trajectory at cut points that minimize the number of
+    // inter-robot loop closures, subject to the load balance constraint
+    RecursiveBisection
+  };
+
+  // Partitioning method
+  Method method;
+
+  // Maximum relative excess of the load of any robot over its share of the total load.
+  // The load of a pose is one plus half of its number of incident measurements, such that the
+  // load of a robot approximates its number of poses plus measurements.
+  double imbalanceTol;
+
+  // Number of passes that move each cut point to the best position within the balance constraint
+  unsigned refinementPasses;
+
+  explicit PartitionParameters(Method methodIn = Method::RecursiveBisection,
+                               double imbalanceTolIn = 0.1,
+                               unsigned refinementPassesIn = 4)
+      : method(methodIn), imbalanceTol(imbalanceTolIn), refinementPasses(refinementPassesIn) {}
+
+  static std::string MethodToString(Method method);
+};
+
+/**
+ * @brief Measurements of one robot, ready to be passed to PGOAgent::setMeasurements
+ */
+struct AgentMeasurements {
+  std::vector<RelativeSEMeasurement> odometry;
+  std::vector<RelativeSEMeasurement> privateLoopClosures;
+  std::vector<RelativeSEMeasurement> sharedLoopClosures;
+};
+
+/**
+ * @brief Split of a single-robot pose graph into contiguous trajectory segments, one per robot.
+ * Robot i owns the poses with global indices in [starts[i], starts[i+1]), with frame IDs starting
+ * from zero, such that the odometry of each robot forms a chain as required by PGOAgent.
+ */
+struct PoseGraphPartition {
+  // Global index of the first pose of each robot, followed by the total number of poses
+  std::vector<size_t> starts;
+
+  // Measurements of each robot (inter-robot loop closures are given to both robots)
+  std::vector<AgentMeasurements> agents;
+
+  // Number of inter-robot loop closures
+  size_t numSharedLoopClosures = 0;
+
+  // Load of each robot (see PartitionParameters::imbalanceTol)
+  std::vector<double> loads;
+
+  unsigned numRobots() const { return agents.size(); }
+  size_t numPoses(unsigned robot) const { return starts[robot + 1] - starts[robot]; }
+  /**
+   * @brief Convert between global pose indices and (robot, frame) IDs
+   */
+  PoseID poseID(size_t globalIndex) const;
+  size_t globalIndex(const PoseID &poseID) const;
+};
+
+/**
+ * @brief Split a single-robot pose graph across robots.
+ * Each robot receives a contiguous segment of the trajectory with at least two poses.
+ * @param measurements measurements with global pose indices (robot IDs are ignored)
+ * @param numPoses number of poses
+ * @param numRobots number of robots
+ * @param params
+ * @param partition output
+ * @return false if there are fewer than two poses per robot
+ */
+bool partitionPoseGraph(const std::vector<RelativeSEMeasurement> &measurements,
+                        size_t numPoses,
+                        unsigned numRobots,
+                        const PartitionParameters &params,
+                        PoseGraphPartition &partition);
+
+/**
+ * @brief Split a single-robot pose graph at the given segment boundaries
+ * @param measurements measurements with global pose indices (robot IDs are ignored)
+ * @param starts global index of the first pose of each robot, followed by the total number of poses
+ * @param partition output
+ * @return false if the segment boundaries are invalid
+ */
+bool splitPoseGraph(const std::vector<RelativeSEMeasurement> &measurements,
+                    const std::vector<size_t> &starts,
+                    PoseGraphPartition &partition);
+
+}  // namespace DPGO
+
+#endif  // DPGO_INCLUDE_DPGO_PARTITION_H_
@@ -39,6 +39,14 @@ class RobustCostParameters {
   double GNCMuStep;
   double GNCInitMu;
 
+  // Adaptive GNC: the mu step grows from GNCMuStep up to GNCMaxMuStep as the fraction of
+  // undecided weights decreases, and measurements whose weights settled to 0 or 1 are frozen
+  bool GNCAdaptive;
+  double GNCMaxMuStep;
+
+  // Weights within this tolerance of 0 or 1 are considered settled
+  double GNCWeightTol;
+
   // Huber parameters
   double HuberThreshold;
 
@@ -52,8 +60,12 @@ class RobustCostParameters {
                                 double gncMuStep = 1.4,
                                 double gncInitMu = 1e-4,
                                 double huberThresh = 3,
-                                double TLSThresh = 10)
+                                double TLSThresh = 10,
+                                bool gncAdaptive = false,
+                                double gncMaxMuStep = 4.0,
+                                double gncWeightTol = 1e-8)
       : costType(type), GNCMaxNumIters(gncMaxIters), GNCBarc(gncBarc), GNCMuStep(gncMuStep), GNCInitMu(gncInitMu),
+        GNCAdaptive(gncAdaptive), GNCMaxMuStep(gncMaxMuStep), GNCWeightTol(gncWeightTol),
         HuberThreshold(huberThresh), TLSThreshold(TLSThresh) {}
 
   inline friend std::ostream &operator<<(
@@ -63,6 +75,9 @@ class RobustCostParameters {
     os << "GNC maximum iterations: " << params.GNCMaxNumIters << std::endl;
     os << "GNC mu step: " << params.GNCMuStep << std::endl;
     os << "GNC initial mu: " << params.GNCInitMu << std::endl;
+    os << "GNC adaptive: " << params.GNCAdaptive << std::endl;
+    os << "GNC max mu step: " << params.GNCMaxMuStep << std::endl;
+    os << "GNC weight tolerance: " << params.GNCWeightTol << std::endl;
     os << "GNC threshold (barc): " << params.GNCBarc << std::endl;
     os << "Huber threshold: " << params.HuberThreshold << std::endl;
     os << "TLS threshold: " << params.TLSThreshold << std::endl;
@@ -97,6 +112,15 @@ class RobustCost {
    */
   double weight(double r) const;
 
+  /**
+   * @brief Compute the weights of a batch of measurements given their current residuals.
+   * Equivalent to calling weight() on each residual, but implemented with branch-free
+   * Eigen array expressions that are vectorized by the compiler.
+   * @param residuals residuals (unsquared)
+   * @param weights output weights (resized to match residuals)
+   */
+  void weights(const Eigen::Ref<const Vector> &residuals, Vector &weights) const;
+
   /**
    * @brief Reset the mu parameter in GNC
    */
@@ -104,8 +128,38 @@ class RobustCost {
 
   /**
    * @brief perform some auxiliary operations (e.g., update the mu parameter when GNC is used)
+   * @param undecidedRatio fraction of measurements whose weights have not settled to 0 or 1
+   * (only used by adaptive GNC, where mu grows faster when fewer weights are undecided)
+   */
+  void update(double undecidedRatio = 1.0);
+
+  /**
+   * @brief Return true if the weight has settled to 0 or 1
+   * @param w weight
+   */
+  bool isSettled(double w) const {
+    return w < mParams.GNCWeightTol || w > 1 - mParams.GNCWeightTol;
+  }
+
+  /**
+   * @brief Return true if adaptive GNC is used
+   */
+  bool isAdaptiveGNC() const {
+    return mParams.costType == RobustCostParameters::Type::GNC_TLS && mParams.GNCAdaptive;
+  }
+
+  /**
+   * @brief Return the internal GNC state (number of updates and mu parameter)
+   */
+  size_t GNCIteration() const { return mGNCIteration; }
+  double GNCMu() const { return mu; }
+
+  /**
+   * @brief Restore the internal GNC state, e.g., when resuming from a checkpoint
+   * @param iteration number of updates performed so far
+   * @param muIn mu parameter
    */
-  void update();
+  void setGNCState(size_t iteration, double muIn);
 
   /**
    * @brief Set error threshold based on the quantile of chi-squared distribution. This function only works for 3D measurements.
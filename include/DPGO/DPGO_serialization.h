@@ -0,0 +1,350 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#ifndef DPGO_INCLUDE_DPGO_SERIALIZATION_H_
+#define DPGO_INCLUDE_DPGO_SERIALIZATION_H_
+
+#include <DPGO/DPGO_types.h>
+#include <DPGO/RelativeSEMeasurement.h>
+#include <DPGO/manifold/Poses.h>
+
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace DPGO {
+
+struct PGOAgentStatus;
+
+/**
+ * @brief Binary wire format for messages exchanged between agents.
+ *
+ * Every message starts with a fixed-size MessageHeader, followed by a payload of
+ * packed fixed-size records. All fields are stored in host byte order (all
+ * supported platforms are little-endian), so that encoding and decoding reduce
+ * to memory copies into caller-provided buffers.
+ *
+ * PoseDict payload: for each pose, robot_id (uint32), frame_id (uint32), followed
+ * by the r-by-(d+1) pose in column-major order, stored with the scalar type
+ * specified by the header encoding.
+ *
+ * If the kMessageFlagRounded flag is set, the payload starts with an r-by-d
+ * basis U with orthonormal columns (column-major, always double precision), and
+ * each pose record only stores the d-by-(d+1) coefficients U^T Xi. This is exact
+ * when the iterate is rank-deficient, i.e., all poses lie in a common
+ * d-dimensional subspace.
+ */
+const uint32_t kMessageMagic = 0x4F475044;  // "DPGO"
+// Version 2 split the 16-bit dimension field into d and flags
+const uint16_t kMessageVersion = 2;
+const uint8_t kMessageFlagRounded = 0x01;
+
+/**
+ * @brief Numeric encoding of the pose entries in a message
+ */
+enum class PoseEncoding : uint8_t {
+  Float64 = 0,  // full precision
+  Float32 = 1,  // single precision quantization
+  Float16 = 2,  // half precision quantization
+};
+
+std::string PoseEncodingToString(PoseEncoding encoding);
+
+/**
+ * @brief Parameters that control the (possibly lossy) encoding of poses
+ */
+struct PoseEncodingParameters {
+  // Preferred numeric encoding of the pose entries
+  PoseEncoding encoding;
+
+  // If true, transmit the d-by-(d+1) projection of each pose onto a shared basis
+  bool rounded;
+
+  // Maximum absolute error allowed on any reconstructed pose entry.
+  // If the preferred encoding violates this bound, fall back to a more precise encoding.
+  double maxError;
+
+  PoseEncodingParameters(PoseEncoding encodingIn = PoseEncoding::Float64,
+                         bool roundedIn = false,
+                         double maxErrorIn = 1e-4)
+      : encoding(encodingIn), rounded(roundedIn), maxError(maxErrorIn) {}
+
+  inline friend std::ostream &operator<<(
+      std::ostream &os, const PoseEncodingParameters &params) {
+    os << "Pose encoding parameters: " << std::endl;
+    os << "Encoding: " << PoseEncodingToString(params.encoding) << std::endl;
+    os << "Rounded: " << params.rounded << std::endl;
+    os << "Max error: " << params.maxError << std::endl;
+    return os;
+  }
+};
+
+/**
+ * @brief Types of messages supported by the wire format
+ */
+enum class MessageType : uint8_t {
+  PoseDict = 1,      // public poses
+  AuxPoseDict = 2,   // auxiliary public poses (used in acceleration)
+  AgentStatus = 3,   // PGOAgentStatus
+  Measurements = 4,  // relative pose measurements
+};
+
+/**
+ * @brief Fixed-size header that precedes every message
+ */
+struct MessageHeader {
+  uint32_t magic;         // Always kMessageMagic
+  uint16_t version;       // Wire format version
+  uint8_t type;           // MessageType
+  uint8_t encoding;       // PoseEncoding of the payload
+  uint32_t sender;        // ID of the sending agent
+  uint32_t count;         // Number of records in the payload
+  uint16_t r;             // Relaxation rank (only used by pose messages)
+  uint8_t d;              // Dimension
+  uint8_t flags;          // Bitwise OR of kMessageFlag* values
+  uint32_t payloadBytes;  // Size of payload in bytes
+};
+static_assert(sizeof(MessageHeader) == 24, "Unexpected padding in MessageHeader");
+
+/**
+ * @brief Size of a single scalar under the given encoding
+ * @param encoding
+ * @return number of bytes
+ */
+size_t scalarSize(PoseEncoding encoding);
+
+/**
+ * @brief Size of the complete message containing the specified number of poses
+ * @param num_poses
+ * @param r relaxation rank
+ * @param d dimension
+ * @param encoding
+ * @return number of bytes
+ */
+size_t poseMessageSize(size_t num_poses, unsigned r, unsigned d,
+                       PoseEncoding encoding = PoseEncoding::Float64,
+                       bool rounded = false);
+
+/**
+ * @brief Convert between single and half precision floating point (IEEE 754 binary16)
+ */
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);
+
+/**
+ * @brief Compute an r-by-d basis with orthonormal columns that best spans the input poses
+ * (in the least squares sense), to be used with the rounded pose encoding
+ * @param poses pointers to r-by-(d+1) poses in column-major order
+ * @param r
+ * @param d
+ * @return r-by-d basis
+ */
+Matrix computePoseBasis(const std::vector<const double *> &poses, unsigned r, unsigned d);
+
+/**
+ * @brief Parse and validate the header of a message
+ * @param buffer
+ * @param size size of buffer in bytes
+ * @param header output header
+ * @return false if the buffer does not contain a valid message
+ */
+bool readMessageHeader(const uint8_t *buffer, size_t size, MessageHeader &header);
+
+/**
+ * @brief Incrementally write lifted poses into a caller-provided buffer.
+ * The buffer must be large enough to hold poseMessageSize(num_poses, r, d, encoding) bytes.
+ */
+class PoseMessageWriter {
+ public:
+  /**
+   * @brief Constructor
+   * @param buffer output buffer
+   * @param capacity capacity of output buffer in bytes
+   * @param type either MessageType::PoseDict or MessageType::AuxPoseDict
+   * @param sender ID of the sending agent
+   * @param r relaxation rank
+   * @param d dimension
+   * @param encoding
+   * @param basis if provided, use the rounded encoding with this r-by-d basis
+   */
+  PoseMessageWriter(uint8_t *buffer, size_t capacity, MessageType type,
+                    unsigned sender, unsigned r, unsigned d,
+                    PoseEncoding encoding = PoseEncoding::Float64,
+                    const Matrix *basis = nullptr);
+  /**
+   * @brief Append a single pose
+   * @param pose_id
+   * @param pose pointer to r-by-(d+1) pose in column-major order
+   * @return false if the buffer is full
+   */
+  bool add(const PoseID &pose_id, const double *pose);
+  /**
+   * @brief Finalize the header
+   * @return total number of bytes written
+   */
+  size_t finish();
+  /**
+   * @brief Number of poses written so far
+   */
+  size_t count() const { return count_; }
+
+ private:
+  uint8_t *buffer_;
+  size_t capacity_;
+  size_t offset_;
+  size_t count_;
+  MessageHeader header_;
+  std::optional<Matrix> basis_;
+};
+
+/**
+ * @brief Read-only view of a pose message that decodes poses directly from the underlying buffer.
+ * The view does not own the buffer, which must outlive it.
+ */
+class PoseMessageView {
+ public:
+  PoseMessageView() : buffer_(nullptr), header_() {}
+  /**
+   * @brief Attach this view to a buffer
+   * @param buffer
+   * @param size
+   * @return false if the buffer does not contain a valid pose message
+   */
+  bool parse(const uint8_t *buffer, size_t size);
+  /**
+   * @brief Return the message header
+   */
+  const MessageHeader &header() const { return header_; }
+  /**
+   * @brief Return true if this message contains auxiliary poses
+   */
+  bool isAuxiliary() const { return header_.type == static_cast<uint8_t>(MessageType::AuxPoseDict); }
+  /**
+   * @brief Return true if this message uses the rounded encoding
+   */
+  bool isRounded() const { return header_.flags & kMessageFlagRounded; }
+  /**
+   * @brief Return the number of poses in this message
+   */
+  size_t size() const { return header_.count; }
+  /**
+   * @brief Return the ID of the pose at the specified index
+   */
+  PoseID poseID(size_t index) const;
+  /**
+   * @brief Decode the pose at the specified index
+   * @param index
+   * @param pose output pointer to r*(d+1) doubles (column-major)
+   */
+  void copyPose(size_t index, double *pose) const;
+
+ private:
+  const uint8_t *record(size_t index) const;
+  const uint8_t *buffer_;
+  MessageHeader header_;
+  std::optional<Matrix> basis_;
+};
+
+/**
+ * @brief Encode a PoseDict
+ * @param poses input poses (all poses must have the same dimensions)
+ * @param sender ID of the sending agent
+ * @param buffer output buffer
+ * @param capacity capacity of output buffer in bytes
+ * @param encoding
+ * @param type either MessageType::PoseDict or MessageType::AuxPoseDict
+ * @return number of bytes written (zero if encoding fails)
+ */
+size_t encodePoseDict(const PoseDict &poses, unsigned sender,
+                      uint8_t *buffer, size_t capacity,
+                      PoseEncoding encoding = PoseEncoding::Float64,
+                      MessageType type = MessageType::PoseDict);
+
+/**
+ * @brief Encode a PoseDict into a vector, which is resized as needed.
+ * See encodePoses for the handling of lossy encodings.
+ */
+size_t encodePoseDict(const PoseDict &poses, unsigned sender,
+                      std::vector<uint8_t> &buffer,
+                      const PoseEncodingParameters &params = PoseEncodingParameters(),
+                      MessageType type = MessageType::PoseDict);
+
+/**
+ * @brief Encode poses with the most compact encoding that satisfies the error bound in params.
+ * Candidate encodings are tried from the preferred one towards full precision; the
+ * full precision, unrounded encoding is always accepted.
+ * @param pose_ids
+ * @param poses pointers to r-by-(d+1) poses in column-major order
+ * @param sender ID of the sending agent
+ * @param r relaxation rank
+ * @param d dimension
+ * @param params encoding parameters
+ * @param buffer output buffer, resized to fit the message
+ * @param type either MessageType::PoseDict or MessageType::AuxPoseDict
+ * @param max_error if not null, output the max absolute error of the selected encoding
+ * @return number of bytes written
+ */
+size_t encodePoses(const std::vector<PoseID> &pose_ids,
+                   const std::vector<const double *> &poses,
+                   unsigned sender, unsigned r, unsigned d,
+                   const PoseEncodingParameters &params,
+                   std::vector<uint8_t> &buffer,
+                   MessageType type = MessageType::PoseDict,
+                   double *max_error = nullptr);
+
+/**
+ * @brief Decode a PoseDict
+ * @param buffer
+ * @param size
+ * @param poses output poses (existing content is cleared)
+ * @return false if the buffer does not contain a valid pose message
+ */
+bool decodePoseDict(const uint8_t *buffer, size_t size, PoseDict &poses);
+
+/**
+ * @brief Size of an encoded PGOAgentStatus message
+ */
+size_t statusMessageSize();
+
+/**
+ * @brief Encode the status of an agent
+ * @return number of bytes written (zero if encoding fails)
+ */
+size_t encodeStatus(const PGOAgentStatus &status, uint8_t *buffer, size_t capacity);
+
+/**
+ * @brief Decode the status of an agent
+ * @return false if the buffer does not contain a valid status message
+ */
+bool decodeStatus(const uint8_t *buffer, size_t size, PGOAgentStatus &status);
+
+/**
+ * @brief Size of the message containing the specified number of measurements
+ * @param num_measurements
+ * @param d dimension
+ */
+size_t measurementsMessageSize(size_t num_measurements, unsigned d);
+
+/**
+ * @brief Encode a vector of measurements (always in full precision)
+ * @return number of bytes written (zero if encoding fails)
+ */
+size_t encodeMeasurements(const std::vector<RelativeSEMeasurement> &measurements, unsigned sender,
+                          uint8_t *buffer, size_t capacity);
+
+/**
+ * @brief Decode a vector of measurements
+ * @return false if the buffer does not contain a valid measurements message
+ */
+bool decodeMeasurements(const uint8_t *buffer, size_t size,
+                        std::vector<RelativeSEMeasurement> &measurements);
+
+}  // namespace DPGO
+
+#endif  // DPGO_INCLUDE_DPGO_SERIALIZATION_H_
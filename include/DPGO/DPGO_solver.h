@@ -84,9 +84,13 @@ void robustSinglePoseAveraging(Matrix &ROpt, Vector &tOpt,
 /**
  * @brief Initialize local trajectory estimate from chordal relaxation
  * @param measurements
+ * @param method Chordal solves the least squares problems with sparse QR; ChordalCholesky and
+ * ChordalCG solve their (smaller) normal equations with sparse Cholesky or preconditioned
+ * conjugate gradient, and fall back to sparse QR on failure
  * @return trajectory estimate in matrix form T = [R1 t1 ... Rn tn] in an arbitrary frame
  */
-PoseArray chordalInitialization(const std::vector<RelativeSEMeasurement> &measurements);
+PoseArray chordalInitialization(const std::vector<RelativeSEMeasurement> &measurements,
+                                InitializationMethod method = InitializationMethod::Chordal);
 
 /**
  * @brief Initialize local trajectory estimate from odometry,
@@ -100,6 +104,20 @@ PoseArray odometryInitialization(
     const std::vector<RelativeSEMeasurement> &odometry,
     const PoseArray *partial_trajectory = nullptr);
 
+/**
+ * @brief Initialize local trajectory estimate by composing relative transforms along a spanning
+ * tree of the measurement graph. The tree is a minimum spanning tree with respect to the
+ * measurement variance 1/kappa + 1/tau (scaled by the inverse measurement weight), such that
+ * the most precise measurements are preferred. Unlike odometry initialization, this works on
+ * any connected graph; each connected component is rooted at its first pose.
+ * @param measurements
+ * @param numThreads number of threads composing the transforms of wide BFS levels
+ * (0 means use all hardware threads)
+ * @return trajectory estimate in matrix form T = [R1 t1 ... Rn tn] in an arbitrary frame
+ */
+PoseArray spanningTreeInitialization(const std::vector<RelativeSEMeasurement> &measurements,
+                                     unsigned numThreads = 0);
+
 /**
  * @brief Perform single-robot pose graph optimization using the L2 cost function
  * @param measurements
@@ -111,6 +129,78 @@ PoseArray solvePGO(const std::vector<RelativeSEMeasurement> &measurements,
                    const ROptParameters &params,
                    const PoseArray *T0 = nullptr);
 
+struct solveCertifiedPGOParams {
+ public:
+  ROptParameters opt_params;
+  // Relaxation rank at the first level of the Riemannian staircase (raised to the dimension if smaller)
+  unsigned r_min;
+  // Maximum relaxation rank
+  unsigned r_max;
+  // A solution is certified if S + eig_tol * I is positive definite, where S is the certificate matrix
+  double eig_tol;
+  // Minimum step size of the line search that escapes a saddle point along a direction of negative curvature
+  double min_escape_stepsize;
+  // Number of initializations: the given initial guess (or chordal initialization), spanning tree
+  // initialization, and random initializations for the remaining ones
+  unsigned num_starts;
+  // Maximum number of initializations solved in parallel (0 to use the number of hardware threads)
+  unsigned num_threads;
+  // Seed of the random initializations
+  unsigned seed;
+  bool verbose;
+  solveCertifiedPGOParams() :
+      opt_params(),
+      r_min(0),
+      r_max(10),
+      eig_tol(1e-5),
+      min_escape_stepsize(1e-6),
+      num_starts(1),
+      num_threads(0),
+      seed(0),
+      verbose(false) {
+    opt_params.RTR_iterations = 500;
+    opt_params.gradnorm_tol = 1e-6;
+  }
+};
+
+/**
+ * @brief Output of certified pose graph optimization
+ */
+struct CertifiedPGOResult {
+  // Rounded trajectory estimate
+  PoseArray T;
+  // Solution of the rank-relaxation at the final rank
+  Matrix Y;
+  unsigned rank;
+  // Cost 0.5 * tr(Y Q Y') of the relaxation, which is the optimal cost of the relaxation if certified
+  double fRelaxed;
+  // Cost of the rounded trajectory estimate
+  double fRounded;
+  // True if Y is certified to be a global minimizer of the relaxation
+  bool certified;
+  // If not certified, the curvature of the certificate matrix along the direction of negative curvature
+  double curvature;
+  // Index of the initialization that produced this solution
+  unsigned start;
+  explicit CertifiedPGOResult(unsigned d = 3, unsigned n = 0) :
+      T(d, n), rank(0), fRelaxed(0), fRounded(0), certified(false), curvature(0), start(0) {}
+};
+
+/**
+ * @brief Perform single-robot pose graph optimization with the Riemannian staircase. The relaxation is solved
+ * at increasing ranks until its solution is certified to be globally optimal by the certificate matrix, escaping
+ * each uncertified saddle point along a direction of negative curvature at the next rank. Multiple initializations
+ * are solved in parallel threads, and the best solution is returned (certified solutions first, then the lowest
+ * rounded cost).
+ * @param measurements
+ * @param params
+ * @param T0 optional initial guess of the first initialization
+ * @return
+ */
+CertifiedPGOResult solveCertifiedPGO(const std::vector<RelativeSEMeasurement> &measurements,
+                                     const solveCertifiedPGOParams &params,
+                                     const PoseArray *T0 = nullptr);
+
 struct solveRobustPGOParams {
  public:
   ROptParameters opt_params;
@@ -0,0 +1,133 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#ifndef DPGO_INCLUDE_DPGO_TELEMETRY_H_
+#define DPGO_INCLUDE_DPGO_TELEMETRY_H_
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace DPGO {
+
+/**
+ * @brief Telemetry record of a single PGOAgent iteration
+ */
+struct IterationTelemetry {
+  // Global iteration number
+  unsigned iteration = 0;
+
+  // Wall clock time at the end of the iteration (microseconds since epoch)
+  int64_t timestampUs = 0;
+
+  // True if this agent performed local optimization at this iteration
+  bool optimized = false;
+
+  // Total time spent in the iteration (milliseconds)
+  double iterationMs = 0;
+
+  // Time spent in local optimization, excluding data matrix construction (milliseconds)
+  double solveMs = 0;
+
+  // Time spent constructing the quadratic and linear cost matrices and the preconditioner (milliseconds)
+  double constructQMs = 0;
+  double constructGMs = 0;
+  double constructPreconMs = 0;
+
+  // Time spent waiting for locks on poses, measurements and neighbor poses (milliseconds)
+  double lockWaitMs = 0;
+
+  // Trust region statistics (tCG status is -1 if no trust region step was performed)
+  int RTRIterations = 0;
+  int tCGIterations = 0;
+  int tCGStatus = -1;
+
+  // Cost and Riemannian gradient norm after local optimization
+  double cost = 0;
+  double gradNorm = 0;
+
+  // Maximum translation change of the iterate
+  double relativeChange = 0;
+
+  // Bytes published and received through the communicator during the iteration
+  uint64_t bytesSent = 0;
+  uint64_t bytesReceived = 0;
+};
+
+/**
+ * @brief Fixed-capacity ring buffer of telemetry records.
+ * The ring supports a single writer and any number of concurrent readers without locks: each slot is
+ * protected by a sequence number, and readers skip records that are overwritten while being copied.
+ */
+class TelemetryRing {
+ public:
+  /**
+   * @brief Constructor
+   * @param capacity maximum number of records kept (rounded up to a power of two)
+   */
+  explicit TelemetryRing(size_t capacity = 1024);
+  TelemetryRing(const TelemetryRing &) = delete;
+  TelemetryRing &operator=(const TelemetryRing &) = delete;
+
+  /**
+   * @brief Append a record, overwriting the oldest one if the ring is full. Must not be called concurrently.
+   */
+  void push(const IterationTelemetry &record);
+
+  /**
+   * @brief Return the number of records that can be kept
+   */
+  size_t capacity() const { return mask_ + 1; }
+
+  /**
+   * @brief Return the total number of records pushed so far
+   */
+  uint64_t numRecorded() const { return head_.load(std::memory_order_acquire); }
+
+  /**
+   * @brief Copy the most recent records, from oldest to newest
+   * @param maxRecords maximum number of records returned
+   */
+  std::vector<IterationTelemetry> records(size_t maxRecords = std::numeric_limits<size_t>::max()) const;
+
+  /**
+   * @brief Copy the most recent record
+   * @return false if no record is available
+   */
+  bool latest(IterationTelemetry &record) const;
+
+  /**
+   * @brief Write records to file in CSV format (one row per record) or JSON format (array of objects)
+   * @return false if the file cannot be written
+   */
+  static bool writeCSV(const std::string &filename, const std::vector<IterationTelemetry> &records);
+  static bool writeJSON(const std::string &filename, const std::vector<IterationTelemetry> &records);
+
+ private:
+  struct Slot {
+    // 2k+1 while record k is being written, 2k+2 once it is complete
+    std::atomic<uint64_t> sequence{0};
+    IterationTelemetry record;
+  };
+
+  /**
+   * @brief Copy record with the given index
+   * @return false if the record is not (or no longer) available
+   */
+  bool read(uint64_t index, IterationTelemetry &record) const;
+
+  const size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<uint64_t> head_{0};
+};
+
+}  // namespace DPGO
+
+#endif  // DPGO_INCLUDE_DPGO_TELEMETRY_H_
@@ -0,0 +1,133 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#ifndef DPGO_INCLUDE_DPGO_TRACE_H_
+#define DPGO_INCLUDE_DPGO_TRACE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace DPGO {
+
+/**
+ * @brief A completed trace zone
+ */
+struct TraceEvent {
+  const char *name;    // Zone name (must have static storage duration, e.g., a string literal)
+  int64_t startNs;     // Start time in nanoseconds since the tracer epoch
+  int64_t durationNs;  // Duration in nanoseconds
+};
+
+/**
+ * @brief Process-wide collector of trace zones.
+ *
+ * Each thread records into its own fixed-capacity buffer, which is registered once (under a mutex)
+ * on the first zone recorded by that thread; afterwards, recording is lock-free. When a buffer is
+ * full, further events of that thread are dropped. Buffers outlive their threads, so that zones of
+ * finished threads can still be exported. The collected events can be exported in the Chrome
+ * trace-event format, to be viewed in chrome://tracing or Perfetto.
+ *
+ * Zones are only compiled when DPGO_ENABLE_TRACING is defined (CMake option ENABLE_TRACING);
+ * otherwise, DPGO_TRACE_ZONE expands to a no-op.
+ */
+class Tracer {
+ public:
+  /**
+   * @brief Enable or disable recording at runtime (enabled by default)
+   */
+  static void setEnabled(bool enabled);
+  static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Set the capacity (in events) of buffers registered afterwards
+   */
+  static void setBufferCapacity(size_t capacity);
+
+  /**
+   * @brief Name the calling thread in exported traces
+   */
+  static void setThreadName(const std::string &name);
+
+  /**
+   * @brief Record a completed zone for the calling thread
+   */
+  static void record(const char *name, int64_t startNs, int64_t endNs);
+
+  /**
+   * @brief Nanoseconds elapsed since the tracer epoch
+   */
+  static int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch_).count();
+  }
+
+  /**
+   * @brief Copy all recorded events, grouped by thread
+   * @return pairs of thread index and event
+   */
+  static std::vector<std::pair<unsigned, TraceEvent>> events();
+
+  /**
+   * @brief Return the number of events dropped because a buffer was full
+   */
+  static size_t numDropped();
+
+  /**
+   * @brief Discard all recorded events. Should not be called while zones are being recorded.
+   */
+  static void clear();
+
+  /**
+   * @brief Write all recorded events to file in Chrome trace-event JSON format
+   * @return false if the file cannot be written
+   */
+  static bool writeChromeTrace(const std::string &filename);
+
+ private:
+  struct Buffer;
+  struct Registry;
+  static Registry &registry();
+  static Buffer &threadBuffer();
+  static std::atomic<bool> enabled_;
+  static const std::chrono::steady_clock::time_point epoch_;
+};
+
+/**
+ * @brief RAII trace zone, recorded when the object goes out of scope
+ */
+class TraceZone {
+ public:
+  explicit TraceZone(const char *name) : name_(Tracer::enabled() ? name : nullptr),
+                                         startNs_(name_ ? Tracer::now() : 0) {}
+  ~TraceZone() {
+    if (name_) Tracer::record(name_, startNs_, Tracer::now());
+  }
+  TraceZone(const TraceZone &) = delete;
+  TraceZone &operator=(const TraceZone &) = delete;
+
+ private:
+  const char *name_;
+  int64_t startNs_;
+};
+
+}  // namespace DPGO
+
+#define DPGO_TRACE_CONCAT_IMPL(a, b) a##b
+#define DPGO_TRACE_CONCAT(a, b) DPGO_TRACE_CONCAT_IMPL(a, b)
+
+#ifdef DPGO_ENABLE_TRACING
+// Record the enclosing scope as a zone with the given name (a string literal)
+#define DPGO_TRACE_ZONE(name) ::DPGO::TraceZone DPGO_TRACE_CONCAT(dpgo_trace_zone_, __LINE__)(name)
+#else
+#define DPGO_TRACE_ZONE(name) static_cast<void>(0)
+#endif
+
+#endif  // DPGO_INCLUDE_DPGO_TRACE_H_
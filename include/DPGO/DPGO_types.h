@@ -13,6 +13,7 @@
 #include <Eigen/CholmodSupport>
 #include <SolversTR.h>
 #include <RTRNewton.h>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <tuple>
@@ -32,8 +33,15 @@ typedef std::shared_ptr<CholmodSolver> CholmodSolverPtr;
  */
 enum class InitializationMethod {
   Odometry,
+  // Chordal relaxation solved with sparse QR
   Chordal,
-  GNC_TLS
+  GNC_TLS,
+  // Chordal relaxation solved with sparse Cholesky factorization of the normal equations
+  ChordalCholesky,
+  // Chordal relaxation solved with preconditioned conjugate gradient on the normal equations
+  ChordalCG,
+  // Composition of relative transforms along a maximum-precision spanning tree
+  SpanningTree
 };
 
 std::string InitializationMethodToString(InitializationMethod method);
@@ -104,6 +112,8 @@ struct ROPTResult {
   double gradNormOpt;     // Gradient norm after optimization
   double elapsedMs;       // elapsed time in milliseconds
   ROPTLIB::tCGstatusSet tCGStatus;  // status of truncated conjugate gradient (only used by trust region solver)
+  int numIterations = 0;       // number of outer iterations (only used by trust region solver)
+  int numInnerIterations = 0;  // number of Hessian-vector products in tCG (only used by trust region solver)
 };
 
 // Each pose is uniquely determined by the robot ID and frame ID
@@ -117,6 +127,16 @@ class PoseID {
   { return (robot_id == other.robot_id
             && frame_id == other.frame_id);
   }
+  /**
+   * @brief Pack this ID into a 64-bit key, which preserves the ordering of ComparePoseID
+   */
+  uint64_t key() const { return (static_cast<uint64_t>(robot_id) << 32) | frame_id; }
+  /**
+   * @brief Recover the ID from a packed 64-bit key
+   */
+  static PoseID fromKey(uint64_t key) {
+    return PoseID(static_cast<unsigned>(key >> 32), static_cast<unsigned>(key & 0xFFFFFFFF));
+  }
 };
 // Comparator for PoseID
 struct ComparePoseID {
@@ -104,6 +104,27 @@ translation estimates
 Matrix recoverTranslations(const SparseMatrix &B1, const SparseMatrix &B2,
                            const Matrix &R);
 
+/**
+Given a vector of relative pose measurements, this function computes the normal
+equations LR * Y = BR of the chordal relaxation of rotation synchronization with
+the first rotation fixed to identity. The unknown Y = [R2'; ...; Rn'] stacks the
+transposes of the remaining rotations, such that LR is the (reduced) rotation
+connection Laplacian of size d(n-1) x d(n-1) and BR has d columns.
+*/
+void constructRotationNormalEquations(const std::vector<RelativeSEMeasurement> &measurements,
+                                      size_t num_poses, SparseMatrix &LR, Matrix &BR);
+
+/**
+Given a vector of relative pose measurements and a matrix R = [R1 ... Rn] of
+rotational state estimates, this function computes the normal equations
+LT * T = BT for the translations with the first translation fixed to zero.
+The unknown T = [t2'; ...; tn'] stacks the transposes of the remaining
+translations, such that LT is the (reduced) weighted graph Laplacian of size
+(n-1) x (n-1) and BT has d columns.
+*/
+void constructTranslationNormalEquations(const std::vector<RelativeSEMeasurement> &measurements,
+                                         const Matrix &R, SparseMatrix &LT, Matrix &BT);
+
 /**
 Project a given matrix to the rotation group
 */
@@ -143,6 +164,56 @@ double computeMeasurementError(const RelativeSEMeasurement &m,
                                const Matrix &R1, const Matrix &t1,
                                const Matrix &R2, const Matrix &t2);
 
+/**
+ * @brief Compute the residuals (square roots of the error terms) of a batch of measurements.
+ * The poses of the i-th measurement are read in place from the r-by-(d+1) poses [Y p], stored
+ * contiguously in column-major order at poses1[i] and poses2[i]. Large batches are split among threads.
+ * @param measurements
+ * @param poses1 first pose of each measurement
+ * @param poses2 second pose of each measurement
+ * @param r rank of the poses (d for poses in SE(d))
+ * @param residuals output residual of each measurement
+ * @param numThreads maximum number of threads (0 to use the number of hardware threads)
+ */
+void computeMeasurementResiduals(const std::vector<RelativeSEMeasurement *> &measurements,
+                                 const std::vector<const double *> &poses1,
+                                 const std::vector<const double *> &poses2,
+                                 unsigned r, Vector &residuals, unsigned numThreads = 0);
+
+/**
+ * @brief Construct the certificate matrix S = Q - Lambda(Y) of a first-order critical point
+ * Y = [Y1 p1 ... Yn pn] of the rank-r relaxation min 0.5 * tr(Y Q Y'), where Lambda(Y) is block
+ * diagonal with the Lagrange multipliers Sym(Yi' (YQ)_i) of the rotations and zero blocks for the
+ * translations. Y is a global minimizer of the relaxation if S is positive semidefinite.
+ * @param Q quadratic cost matrix of size (d+1)n x (d+1)n
+ * @param Y r-by-(d+1)n solution
+ * @param d dimension
+ * @return certificate matrix
+ */
+SparseMatrix constructCertificateMatrix(const SparseMatrix &Q, const Matrix &Y, unsigned d);
+
+/**
+ * @brief Verify that S + eta * I is positive definite with a sparse LDL' factorization.
+ * Otherwise, the most negative pivot of the factorization gives a direction of negative curvature,
+ * which is refined towards the eigenvector of the minimum eigenvalue of S by power iteration.
+ * @param S symmetric certificate matrix
+ * @param eta numerical tolerance
+ * @param v output unit vector with v' (S + eta * I) v < 0 if verification fails
+ * @param curvature output v' S v if verification fails (an upper bound on the minimum eigenvalue of S)
+ * @return true if S + eta * I is positive definite
+ */
+bool verifyCertificateMatrix(const SparseMatrix &S, double eta, Vector &v, double &curvature);
+
+/**
+ * @brief Round a solution Y of the rank-r relaxation to SE(d). The rows of Y are projected onto its
+ * dominant d-dimensional row space, the reflection with the most rotations of positive determinant
+ * is chosen, and each rotation block is projected to SO(d).
+ * @param Y r-by-(d+1)n solution
+ * @param d dimension
+ * @return d-by-(d+1)n trajectory [R1 t1 ... Rn tn]
+ */
+Matrix roundSolution(const Matrix &Y, unsigned d);
+
 /**
  * @brief Quantile of chi-squared distribution with given degrees of freedom at probability alpha.
  * Equivalent to chi2inv in Matlab.
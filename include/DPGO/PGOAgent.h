@@ -9,8 +9,12 @@
 #define PGOAGENT_H
 
 #include <DPGO/DPGO_types.h>
+#include <DPGO/Communicator.h>
 #include <DPGO/PGOLogger.h>
 #include <DPGO/DPGO_robust.h>
+#include <DPGO/DPGO_telemetry.h>
+#include <DPGO/DPGO_io.h>
+#include <DPGO/DPGO_serialization.h>
 #include <DPGO/QuadraticProblem.h>
 #include <DPGO/RelativeSEMeasurement.h>
 #include <DPGO/manifold/Poses.h>
@@ -76,6 +80,11 @@ class PGOAgentParameters {
   // Interval for fixed (periodic) restart
   unsigned restartInterval;
 
+  // Number of most recent poses optimized in the local problem (0 to optimize all poses).
+  // Older poses are frozen at their current estimates, such that the cost of local optimization
+  // stays bounded as the trajectory grows.
+  unsigned slidingWindowSize;
+
   // Parameter settings over robust cost functions
   RobustCostParameters robustCostParams;
 
@@ -94,6 +103,9 @@ class PGOAgentParameters {
   // Minimum number of inliers for robust distributed initialization
   unsigned robustInitMinInliers;
 
+  // Encoding of public poses produced by encodeSharedPoses
+  PoseEncodingParameters sharedPoseEncoding;
+
   // Maximum number of global iterations
   unsigned maxNumIters;
 
@@ -109,6 +121,12 @@ class PGOAgentParameters {
   // Directory to log data
   std::string logDirectory;
 
+  // Number of iterations between logged trajectory snapshots (0 to disable)
+  unsigned logTrajectoryInterval;
+
+  // Number of per-iteration telemetry records kept in memory
+  unsigned telemetryCapacity;
+
   // Default constructor
   PGOAgentParameters(unsigned dIn,
                      unsigned rIn,
@@ -135,17 +153,21 @@ class PGOAgentParameters {
         multirobotInitialization(true),
         acceleration(accel),
         restartInterval(restartInt),
+        slidingWindowSize(0),
         robustCostParams(costParams),
         robustOptNumWeightUpdates(robust_opt_num_weight_updates),
         robustOptNumResets(robust_opt_num_resets),
         robustOptInnerIters(robust_opt_inner_iters),
         robustOptMinConvergenceRatio(robust_opt_min_convergence_ratio),
         robustInitMinInliers(robust_init_min_inliers),
+        sharedPoseEncoding(),
         maxNumIters(maxIters),
         relChangeTol(changeTol),
         verbose(v),
         logData(log),
-        logDirectory(std::move(logDir)) {}
+        logDirectory(std::move(logDir)),
+        logTrajectoryInterval(0),
+        telemetryCapacity(1024) {}
 
   inline friend std::ostream &operator<<(
       std::ostream &os, const PGOAgentParameters &params) {
@@ -160,16 +182,22 @@ class PGOAgentParameters {
     os << "Use multi-robot initialization: " << params.multirobotInitialization << std::endl;
     os << "Use Nesterov acceleration: " << params.acceleration << std::endl;
     os << "Fixed restart interval: " << params.restartInterval << std::endl;
+    os << "Sliding window size: " << params.slidingWindowSize << std::endl;
     os << "Robust optimization num weight updates: " << params.robustOptNumWeightUpdates << std::endl;
     os << "Robust optimization num resets: " << params.robustOptNumResets << std::endl;
     os << "Robust optimization inner iterations: " << params.robustOptInnerIters << std::endl;
     os << "Robust optimization weight convergence min ratio: " << params.robustOptMinConvergenceRatio << std::endl;
     os << "Robust initialization minimum inliers: " << params.robustInitMinInliers << std::endl;
+    os << "Shared pose encoding: " << PoseEncodingToString(params.sharedPoseEncoding.encoding)
+       << (params.sharedPoseEncoding.rounded ? " (rounded)" : "")
+       << ", max error " << params.sharedPoseEncoding.maxError << std::endl;
     os << "Max iterations: " << params.maxNumIters << std::endl;
     os << "Relative change tol: " << params.relChangeTol << std::endl;
     os << "Verbose: " << params.verbose << std::endl;
     os << "Log data: " << params.logData << std::endl;
     os << "Log directory: " << params.logDirectory << std::endl;
+    os << "Log trajectory interval: " << params.logTrajectoryInterval << std::endl;
+    os << "Telemetry capacity: " << params.telemetryCapacity << std::endl;
     os << std::endl;
     os << params.localOptimizationParams << std::endl;
     os << std::endl;
@@ -266,10 +294,21 @@ class PGOAgent {
 
   /**
    * @brief Add a single measurement to this agent's pose graph. Do nothing if the input factor already exists.
+   * After initialization, only odometry that appends a new pose is accepted (see addOdometry).
    * @param factor
    */
   void addMeasurement(const RelativeSEMeasurement &factor);
 
+  /**
+   * @brief Append new poses to the trajectory of this robot after initialization, without resetting it.
+   * The k-th measurement must connect pose num_poses()-1+k to pose num_poses()+k. The new poses are
+   * initialized by composing the odometry from the latest estimate, and the iterate, initial guess and
+   * acceleration variables are extended accordingly. Data matrices are resized in place.
+   * @param odometry
+   * @return false if the robot is not initialized or the measurements do not extend the trajectory
+   */
+  bool addOdometry(const std::vector<RelativeSEMeasurement> &odometry);
+
   /**
    * @brief Perform local initialization for this robot.
    * After this function call, the robot is initialized in its LOCAL frame 
@@ -293,6 +332,42 @@ class PGOAgent {
    */
   void initializeInGlobalFrame(const Pose &T_world_robot);
 
+  /**
+   * @brief Save the pose graph of this robot (including current measurement weights),
+   * its trajectory and lifted iterate (if initialized) and the lifting matrix to a snapshot file
+   * @param filename
+   * @return true if the snapshot is written successfully
+   */
+  bool saveSnapshot(const std::string &filename);
+
+  /**
+   * @brief Resume from a snapshot file written by saveSnapshot (or a converter in DPGO_io.h).
+   * This function must be called before setMeasurements(). If the snapshot contains a lifted iterate,
+   * the robot is directly initialized in the global frame; otherwise, if it contains a trajectory,
+   * it is used as local initialization.
+   * @param filename
+   * @return true if the snapshot is loaded successfully
+   */
+  bool loadSnapshot(const std::string &filename);
+
+  /**
+   * @brief Save the complete optimization state of this robot to a checkpoint file. In addition to
+   * the snapshot content, this includes the initial iterate, acceleration and GNC states, and all counters.
+   * Cached neighbor poses and team status are not saved, as they are received again after restart.
+   * @param filename
+   * @return true if the checkpoint is written successfully
+   */
+  bool saveCheckpoint(const std::string &filename);
+
+  /**
+   * @brief Warm restart from a checkpoint file written by saveCheckpoint, such that this robot continues
+   * at the saved iteration with the saved iterate and measurement weights.
+   * This function must be called before setMeasurements().
+   * @param filename
+   * @return true if the checkpoint is loaded successfully
+   */
+  bool loadCheckpoint(const std::string &filename);
+
   /**
    * @brief perform a single iteration
    * @param doOptimization: if true, this robot is selected to perform local optimization at this iteration
@@ -335,6 +410,12 @@ class PGOAgent {
    */
   inline unsigned iteration_number() const { return mIterationNumber; }
 
+  /**
+   * @brief Get per-iteration telemetry of this agent. The ring can be queried from any thread
+   * while the agent is running.
+   */
+  const TelemetryRing &telemetry() const { return mTelemetry; }
+
   /**
    * @brief get the current status of this agent
    * @return
@@ -346,6 +427,11 @@ class PGOAgent {
     mStatus.iterationNumber = iteration_number();
     return mStatus;
   }
+  /**
+   * @brief Get the loop closures whose weights were neither 0 nor 1 after the latest weight update
+   * @return
+   */
+  std::vector<EdgeID> getUndecidedLoopClosures();
   /**
    * @brief return true if the status of a neighbor robot is available locally
    * @return
@@ -446,6 +532,24 @@ class PGOAgent {
    */
   bool getSharedPoseDictWithNeighbor(PoseDict &map, unsigned neighborID);
 
+  /**
+   * @brief Get the public poses of this robot for all neighbors at once.
+   * For each neighbor, the corresponding buffer is an r-by-(d+1)k matrix that stores the k poses
+   * shared with that neighbor contiguously, in the order of getPublicFrameIDsWithNeighbor.
+   * Existing buffers are reused.
+   * @param buffers map from neighbor ID to pose buffer
+   * @param auxiliary if true, get auxiliary variables instead (requires acceleration)
+   * @return true if the agent is initialized
+   */
+  bool getSharedPosesWithNeighbors(std::map<unsigned, Matrix> &buffers, bool auxiliary = false);
+
+  /**
+   * @brief Get the sorted frame IDs of public poses of this robot that are shared with the specified neighbor
+   */
+  const std::vector<unsigned> &getPublicFrameIDsWithNeighbor(unsigned neighborID) const {
+    return mPoseGraph->myPublicFrameIDsWithNeighbor(neighborID);
+  }
+
   /**
    * @brief Get a map of all auxiliary variables associated with public poses of this robot
    * @param map
@@ -453,6 +557,17 @@ class PGOAgent {
    */
   bool getAuxSharedPoseDict(PoseDict &map);
 
+  /**
+   * @brief Encode all public poses (or their auxiliary variables) of this robot
+   * directly into a binary message, without constructing an intermediate PoseDict.
+   * See DPGO_serialization.h for the message format.
+   * Poses are encoded according to PGOAgentParameters::sharedPoseEncoding.
+   * @param buffer output buffer, resized to fit the message
+   * @param auxiliary if true, encode auxiliary variables instead (requires acceleration)
+   * @return number of bytes written (zero if the agent is not initialized)
+   */
+  size_t encodeSharedPoses(std::vector<uint8_t> &buffer, bool auxiliary = false);
+
   /**
    * Get a map of all auxiliary public poses of this robot with the specified neighbor
    */
@@ -537,6 +652,24 @@ class PGOAgent {
    */
   void updateAuxNeighborPoses(unsigned neighborID, const PoseDict &poseDict);
 
+  /**
+   * @brief Update local copy of a neighbor's public poses (or auxiliary poses) from a binary message
+   * produced by encodeSharedPoses. The sender of the message is used as the neighbor ID.
+   * @param buffer
+   * @param size size of buffer in bytes
+   * @return false if the message is invalid
+   */
+  bool updateNeighborPosesFromBuffer(const uint8_t *buffer, size_t size);
+
+  /**
+   * @brief Set the transport used to exchange messages with other agents.
+   * When set, each call to iterate() first processes all received messages (neighbor status,
+   * public and auxiliary poses), and afterwards publishes the status and public poses of this agent.
+   * This function should be called before starting the optimization loop.
+   * @param communicator shared communicator (nullptr to disable automatic communication)
+   */
+  void setCommunicator(std::shared_ptr<Communicator> communicator);
+
   /**
    * @brief Clear local caches of all neighbors' poses
    */
@@ -602,6 +735,12 @@ class PGOAgent {
   // Latest local optimization result
   ROPTResult mLocalOptResult;
 
+  // Per-iteration telemetry
+  TelemetryRing mTelemetry;
+
+  // Telemetry of the current iteration (only accessed by the thread that runs iterate)
+  IterationTelemetry mIterationTelemetry;
+
   // Logging
   PGOLogger mLogger;
 
@@ -632,8 +771,8 @@ class PGOAgent {
   // Anchor matrix shared by all agents
   std::optional<LiftedPose> globalAnchor;
 
-  // This dictionary stores poses owned by other robots that is connected to this robot by loop closure
-  PoseDict neighborPoseDict;
+  // This store holds poses owned by other robots that is connected to this robot by loop closure
+  LiftedPoseStore neighborPoseStore;
 
   // Implement locking to synchronize read & write of trajectory estimate
   mutex mPosesMutex;
@@ -647,32 +786,56 @@ class PGOAgent {
   // Thread that runs optimization loop in asynchronous mode
   std::unique_ptr<thread> mOptimizationThread;
 
+  // Transport used to exchange messages with other agents (optional)
+  std::shared_ptr<Communicator> mCommunicator;
+
+  // Buffer used to encode outgoing messages
+  std::vector<uint8_t> mMessageBuffer;
+
   /**
    * @brief Reset variables used in Nesterov acceleration
    */
   void initializeAcceleration();
   /**
-   * @brief Compute a robust relative transform estimate between this robot and neighbor robot, using a two-stage method
-   * which first perform robust single rotation averaging, and then performs translation averaging on the inlier set.
+   * @brief Update the cached candidate transforms to the world frame (one per inter-robot loop closure)
+   * with the public poses of an initialized neighbor. A candidate is only recomputed if the neighbor
+   * pose it was computed from has changed.
    * @param neighborID
    * @param poseDict
+   * @return true if any candidate was added or changed
+   */
+  bool updateNeighborTransformCandidates(unsigned neighborID, const PoseDict &poseDict);
+  /**
+   * @brief Clear the cached candidate transforms
+   */
+  void clearNeighborTransformCandidates();
+  /**
+   * @brief Compute a robust transform estimate from this robot to the world frame from the cached candidates of
+   * all neighbors, using a two-stage method which first perform robust single rotation averaging, and then performs
+   * translation averaging on the inlier set.
    * @param T_world_robot output transformation from current local (robot) frame to world frame
    * @return true if transformation is computed successfully
    */
-  bool computeRobustNeighborTransformTwoStage(unsigned neighborID, const PoseDict &poseDict, Pose *T_world_robot);
+  bool computeRobustNeighborTransformTwoStage(Pose *T_world_robot);
   /**
-   * @brief Compute a robust relative transform estimate between this robot and neighbor robot, by solving a robust single
-   * pose averaging problem using GNC.
-   * @param neighborID
-   * @param poseDict
+   * @brief Compute a robust transform estimate from this robot to the world frame from the cached candidates of
+   * all neighbors, by solving a robust single pose averaging problem using GNC.
    * @param T_world_robot output transformation from current local (robot) frame to world frame
    * @return true if transformation is computed successfully
    */
-  bool computeRobustNeighborTransform(unsigned neighborID, const PoseDict &poseDict, Pose *T_world_robot);
+  bool computeRobustNeighborTransform(Pose *T_world_robot);
   /**
    * @brief Spawn a separate thread that optimizes the local pose graph in a loop
    */
   void runOptimizationLoop();
+  /**
+   * @brief Process all messages received by the communicator
+   */
+  void receiveMessages();
+  /**
+   * @brief Publish status and (if requested) public poses through the communicator
+   */
+  void publishMessages();
   /**
    * @brief Initialize robust optimization.
    * This function sets all active loop closure weights to one
@@ -684,10 +847,18 @@ class PGOAgent {
    * @return bool
    */
   bool shouldUpdateMeasurementWeights() const;
+  /**
+   * @brief Return true if adaptive GNC is used and the weights of all loop closures have settled
+   */
+  bool measurementWeightsSettled() const;
   /**
    * @brief Update loop closure weights.
    */
   void updateMeasurementWeights();
+  /**
+   * @brief Add statistics of the latest local optimization to the telemetry of the current iteration
+   */
+  void recordOptimizationTelemetry();
   /**
    * @brief Compute the residual of a measurement (square root of weighted square error)
    * @param measurement The measurement to evaluate
@@ -730,7 +901,7 @@ class PGOAgent {
 
  private:
   // Stores the auxiliary variables from neighbors (only used in acceleration)
-  PoseDict neighborAuxPoseDict;
+  LiftedPoseStore neighborAuxPoseStore;
 
   // Auxiliary scalar used in acceleration
   double gamma;
@@ -747,6 +918,27 @@ class PGOAgent {
   // Save previous iteration (for restarting)
   LiftedPoseArray XPrev;
 
+  // Loop closures and their poses evaluated in batch during weight updates (reused across updates)
+  std::vector<RelativeSEMeasurement *> mWeightUpdateMeasurements;
+  std::vector<const double *> mWeightUpdatePoses1;
+  std::vector<const double *> mWeightUpdatePoses2;
+  Vector mWeightUpdateResiduals;
+  Vector mWeightUpdateWeights;
+
+  // Loop closures whose weights settled to 0 or 1 under adaptive GNC, and are no longer updated
+  std::unordered_set<EdgeID, HashEdgeID> mGNCSettledLoopClosures;
+
+  // Loop closures whose weights were undecided after the latest weight update
+  std::vector<EdgeID> mGNCUndecidedLoopClosures;
+
+  // Candidate transforms to the world frame while waiting for initialization, each computed from an
+  // inter-robot loop closure and the public pose of an initialized neighbor (protected by mNeighborPosesMutex)
+  struct NeighborTransformCandidate {
+    Matrix neighborPose;
+    Pose T_world_robot;
+  };
+  std::map<EdgeID, NeighborTransformCandidate, CompareEdgeID> mNeighborTransformCandidates;
+
   void updateGamma();
 
   void updateAlpha();
@@ -759,9 +951,23 @@ class PGOAgent {
    */
   bool updateX(bool doOptimization = false, bool acceleration = false);
 
+  /**
+   * @brief Advance the active window of the pose graph to the latest poses (see
+   * PGOAgentParameters::slidingWindowSize), and freeze older poses at their current estimates
+   */
+  void updateSlidingWindow();
+
   void updateY();
 
   void updateV();
+
+  /**
+   * @brief Set measurements from a single list, e.g., restored from a snapshot or checkpoint,
+   * by splitting it into odometry, private and shared loop closures
+   * @param measurements
+   */
+  void setMeasurements(const std::vector<RelativeSEMeasurement> &measurements);
+
   /**
    * @brief Compute the relative transformation to a neighboring robot using a single inter-robot loop closure
    * @param measurement
@@ -12,23 +12,43 @@
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <DPGO/DPGO_types.h>
 #include <DPGO/RelativeSEMeasurement.h>
 
 namespace DPGO {
 
+/**
+ * @brief Data logger.
+ * All log functions copy their input and return immediately; files are formatted and written by a
+ * background thread, which is started on first use. Pending entries are held in a bounded queue:
+ * final results (trajectories, measurements, matrices) wait for space in the queue, whereas
+ * per-iteration entries are dropped when the queue is full, so that logging never stalls the caller
+ * for longer than it takes to copy the data.
+ */
 class PGOLogger {
  public:
   /*!
    * @brief Constructor
    * @param logDir directory to store all log files
+   * @param queueCapacity maximum number of pending log entries
    */
-  explicit PGOLogger(std::string logDir);
+  explicit PGOLogger(std::string logDir, size_t queueCapacity = 16);
 
+  /*!
+   * @brief Destructor. Waits until all pending entries are written.
+   */
   ~PGOLogger();
 
+  PGOLogger(const PGOLogger &) = delete;
+  PGOLogger &operator=(const PGOLogger &) = delete;
+
   /*!
-   * @brief log trajectory to file (currently only work for 3D data)
+   * @brief log trajectory to file
    * @param d dimension (2 or 3)
    * @param n number of poses
    * @param T d-by-(d+1)*n matrix where each d-by-(d+1) block represents a pose
@@ -37,16 +57,46 @@ class PGOLogger {
   void logTrajectory(unsigned d, unsigned n, const Matrix &T, const std::string &filename);
 
   /*!
-   * @brief log measurements to file (currently only work for 3D data)
+   * @brief log the trajectory obtained by rounding a lifted iterate (per-iteration snapshot).
+   * Rounding is performed by the logging thread. The entry is dropped if the queue is full.
+   * @param d dimension (2 or 3)
+   * @param n number of poses
+   * @param X r-by-(d+1)*n lifted iterate
+   * @param anchor r-by-(d+1) lifted pose that defines the reference frame
+   * @param filename filename
+   * @return false if the entry is dropped
+   */
+  bool logLiftedTrajectory(unsigned d, unsigned n, const Matrix &X, const Matrix &anchor, const std::string &filename);
+
+  /*!
+   * @brief log measurements to file
    * @param measurements a vector of relative pose measurements
    * @param filename
    */
-  void logMeasurements(std::vector<RelativeSEMeasurement> &measurements, const std::string &filename);
+  void logMeasurements(const std::vector<RelativeSEMeasurement> &measurements, const std::string &filename);
+
+  /*!
+   * @brief log a matrix to file in binary format (number of rows and columns as uint64,
+   * followed by the entries in column-major order)
+   * @param M
+   * @param filename
+   */
+  void logMatrix(const Matrix &M, const std::string &filename);
+
+  /*!
+   * @brief Block until all pending entries are written
+   */
+  void flush();
+
+  /*!
+   * @brief Number of entries dropped because the queue was full
+   */
+  size_t numDroppedEntries() const;
 
   /**
    * @brief load trajectory from file
    * @param filename
-   * @return
+   * @return empty matrix if the file cannot be read or is malformed
    */
   Matrix loadTrajectory(const std::string &filename);
 
@@ -54,12 +104,42 @@ class PGOLogger {
    * @brief read a list of measurements from file
    * @param filename
    * @param load_weight
-   * @return
+   * @return empty list if the file cannot be read or is malformed
    */
   static std::vector<RelativeSEMeasurement> loadMeasurements(const std::string &filename, bool load_weight = false);
 
+  /**
+   * @brief read a matrix written by logMatrix
+   * @param filename
+   * @return empty matrix if the file cannot be read
+   */
+  static Matrix loadMatrix(const std::string &filename);
+
  private:
+  typedef std::function<void()> Task;
+
+  /**
+   * @brief Add a task to the queue
+   * @param task
+   * @param dropIfFull if true, drop the task if the queue is full, otherwise wait for space
+   * @return false if the task is dropped
+   */
+  bool enqueue(Task task, bool dropIfFull);
+
+  /**
+   * @brief Main loop of the logging thread
+   */
+  void run();
+
   std::string logDirectory;
+  const size_t mQueueCapacity;
+  std::deque<Task> mQueue;
+  mutable std::mutex mQueueMutex;
+  std::condition_variable mQueueCondition;
+  bool mBusy = false;
+  bool mStopRequested = false;
+  size_t mNumDropped = 0;
+  std::thread mThread;
 };
 
 } // end namespace DPGO
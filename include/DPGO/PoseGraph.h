@@ -67,6 +67,16 @@ class PoseGraph {
    * @return
    */
   unsigned int n() const { return n_; }
+  /**
+   * @brief Get number of poses in the active window, i.e., the poses optimized in the local problem
+   * @return
+   */
+  unsigned int numActivePoses() const { return n_ - window_start_; }
+  /**
+   * @brief Get index of the first pose in the active window
+   * @return
+   */
+  unsigned int windowStart() const { return window_start_; }
   /**
    * @brief Return number of odometry edges
    * @return
@@ -109,6 +119,14 @@ class PoseGraph {
    * @param m
    */
   void addMeasurement(const RelativeSEMeasurement &m);
+  /**
+   * @brief Append new poses to the trajectory with odometry measurements, where the k-th measurement
+   * connects pose n()-1+k to pose n()+k. Data matrices that are already constructed are resized and
+   * updated in place (the new poses only contribute to the quadratic cost); the preconditioner is cleared.
+   * @param odometry
+   * @return false if the measurements do not extend the trajectory
+   */
+  bool appendOdometry(const std::vector<RelativeSEMeasurement> &odometry);
   /**
    * @brief Return a copy of the list of odometry edges
    * @return
@@ -155,6 +173,21 @@ class PoseGraph {
    * @param pose_dict
    */
   void setNeighborPoses(const PoseDict &pose_dict);
+  /**
+   * @brief Set neighbor poses from a flat pose store.
+   * Copying the store reuses the existing storage and does not allocate in steady state.
+   * @param pose_store
+   */
+  void setNeighborPoses(const LiftedPoseStore &pose_store);
+  /**
+   * @brief Freeze the poses before the given index at their values in X, such that only the poses
+   * in the active window are optimized. Measurements between the window and frozen poses are treated
+   * like measurements with fixed neighbor poses, i.e., they only contribute to the diagonal blocks of Q
+   * and to G. Data matrices are indexed by the poses in the window, and are cleared if the window changes.
+   * @param start index of the first pose in the active window (zero to optimize all poses)
+   * @param X current estimates of all poses
+   */
+  void setWindow(unsigned start, const LiftedPoseArray &X);
   /**
    * @brief Get quadratic cost matrix.
    * @return
@@ -182,6 +215,14 @@ class PoseGraph {
    * @brief Clear data matrices
    */
   void clearDataMatrices();
+  /**
+   * @brief Apply the changes of measurement weights since the quadratic matrix was constructed.
+   * Only the blocks of Q affected by the changed weights are updated in place, and the linear matrix is
+   * cleared. If the sparsity pattern of Q is unchanged, the preconditioner is later refactorized
+   * numerically, reusing its symbolic analysis.
+   * @return number of measurements whose weights changed
+   */
+  size_t applyWeightChanges();
   /**
    * @brief Return true if preconditioner is available.
    * @return
@@ -192,16 +233,37 @@ class PoseGraph {
    * @return
    */
   const CholmodSolverPtr &preconditioner();
+  /**
+   * @brief Get the time in milliseconds spent on the latest construction of the quadratic matrix,
+   * linear matrix and preconditioner (zero if not constructed since clearTimingStatistics was called)
+   */
+  double constructQMs() const { return ms_construct_Q_; }
+  double constructGMs() const { return ms_construct_G_; }
+  double constructPreconMs() const { return ms_construct_precon_; }
+  /**
+   * @brief Reset construction timing statistics
+   */
+  void clearTimingStatistics() {
+    ms_construct_Q_ = 0;
+    ms_construct_G_ = 0;
+    ms_construct_precon_ = 0;
+  }
   /**
    * @brief Get the set of my pose IDs that are shared with other robots
    * @return
    */
-  PoseSet myPublicPoseIDs() const { return local_shared_pose_ids_; }
+  const PoseSet &myPublicPoseIDs() const { return local_shared_pose_ids_; }
+  /**
+   * @brief Get the sorted frame IDs of my public poses that are shared with the specified neighbor
+   * @param neighbor_id
+   * @return reference to the internal index (empty if the input robot is not a neighbor)
+   */
+  const std::vector<unsigned> &myPublicFrameIDsWithNeighbor(unsigned neighbor_id) const;
   /**
    * @brief Get the set of Pose IDs that ALL neighbors need to share with me
    * @return
    */
-  PoseSet neighborPublicPoseIDs() const { return nbr_shared_pose_ids_; }
+  const PoseSet &neighborPublicPoseIDs() const { return nbr_shared_pose_ids_; }
   /**
    * @brief Get the set of Pose IDs that active neighbors need to share with me.
    * A neighbor is active if it is actively participating in distributed
@@ -315,11 +377,14 @@ class PoseGraph {
   // Store the set of neighboring agents
   std::set<unsigned> nbr_robot_ids_;
 
+  // For each neighbor, store the sorted frame IDs of my public poses shared with that neighbor
+  std::map<unsigned, std::vector<unsigned>> nbr_public_frame_ids_;
+
   // Store the set of deactivated neighbors
   std::map<unsigned, bool> neighbor_active_;
 
   // Store public poses from neighbors
-  PoseDict neighbor_poses_;
+  LiftedPoseStore neighbor_poses_;
 
   // Quadratic matrix in cost function
   std::optional<SparseMatrix> Q_;
@@ -330,6 +395,25 @@ class PoseGraph {
   // Preconditioner
   std::optional<CholmodSolverPtr> precon_;
 
+  // Set if the values (but not the sparsity pattern) of Q changed since the preconditioner was factorized
+  bool precon_outdated_;
+
+  // Weights of odometry, private loop closures and shared loop closures in Q (NaN if not included in Q)
+  std::vector<double> Q_odometry_weights_;
+  std::vector<double> Q_private_lc_weights_;
+  std::vector<double> Q_shared_lc_weights_;
+
+  // Index of the first pose in the active window (poses before are frozen)
+  unsigned int window_start_;
+
+  // Indices of odometry and private loop closures with at least one pose in the active window
+  // (only maintained if the window does not start at the first pose)
+  std::vector<size_t> window_odometry_;
+  std::vector<size_t> window_lcs_;
+
+  // Store frozen poses connected to the active window
+  LiftedPoseStore frozen_poses_;
+
   // Timing
   SimpleTimer timer_;
   double ms_construct_Q_{};
@@ -371,6 +455,23 @@ class PoseGraph {
    * and my neighbors.
   */ 
   void updatePublicPoseIDs();
+  /**
+   * @brief Record that my pose with the given frame ID is shared with the given neighbor
+   * @param neighbor_id
+   * @param frame_id
+   */
+  void addPublicFrameID(unsigned neighbor_id, unsigned frame_id);
+  /**
+   * @brief Optimize all poses
+   */
+  void clearWindow();
+  /**
+   * @brief Collect the private measurements relevant to the active window
+   * @param active if not null, output measurements within the window, with pose indices relative to the window
+   * @param boundary output measurements between the window and frozen poses
+   */
+  void windowMeasurements(std::vector<RelativeSEMeasurement> *active,
+                          std::vector<const RelativeSEMeasurement *> &boundary) const;
 
  private:
   // Mapping Edge ID to the corresponding index in the vector of measurements
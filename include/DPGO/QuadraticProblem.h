@@ -40,8 +40,8 @@ class QuadraticProblem : public ROPTLIB::Problem {
 
   ~QuadraticProblem() override;
 
-  /** Number of pose variables */
-  unsigned int num_poses() const { return pose_graph_->n(); }
+  /** Number of pose variables (poses in the active window of the pose graph) */
+  unsigned int num_poses() const { return pose_graph_->numActivePoses(); }
 
   /** Dimension (2 or 3) of estimation problem */
   unsigned int dimension() const { return pose_graph_->d(); }
@@ -8,7 +8,11 @@
 #ifndef DPGO_INCLUDE_DPGO_MANIFOLD_POSES_H_
 #define DPGO_INCLUDE_DPGO_MANIFOLD_POSES_H_
 
+#include <cstdint>
+#include <iterator>
+#include <map>
 #include <set>
+#include <vector>
 #include "DPGO/DPGO_types.h"
 
 namespace DPGO {
@@ -92,6 +96,20 @@ class LiftedPoseArray {
    * @return
    */
   Vector translation(unsigned int index) const;
+  /**
+   * @brief Obtain a writable pointer to the pose at the specified index.
+   * The r-by-(d+1) pose block is stored contiguously in column-major order.
+   * @param index
+   * @return
+   */
+  double *poseData(unsigned int index);
+  /**
+   * @brief Obtain a read-only pointer to the pose at the specified index.
+   * The r-by-(d+1) pose block is stored contiguously in column-major order.
+   * @param index
+   * @return
+   */
+  const double *poseData(unsigned int index) const;
   /**
    * @brief Compute the average translation distance between two lifted pose arrays
    * Internally check that both arrays should have same dimension and number of poses
@@ -216,8 +234,140 @@ class Pose : public LiftedPose {
 
 // Ordered map of PoseID to LiftedPose object
 typedef std::map<PoseID, LiftedPose, ComparePoseID> PoseDict;
-// Ordered set of PoseID
-typedef std::set<PoseID, ComparePoseID> PoseSet;
+
+/**
+ * @brief Ordered set of PoseID, stored as a sorted vector of packed 64-bit keys.
+ * Lookups are binary searches over contiguous memory; insertions and removals are
+ * linear, which is acceptable since the sets of public poses change rarely.
+ */
+class PoseSet {
+ public:
+  class const_iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef PoseID value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const PoseID *pointer;
+    typedef PoseID reference;
+    explicit const_iterator(std::vector<uint64_t>::const_iterator it) : it_(it) {}
+    PoseID operator*() const { return PoseID::fromKey(*it_); }
+    const_iterator &operator++() {
+      ++it_;
+      return *this;
+    }
+    bool operator==(const const_iterator &other) const { return it_ == other.it_; }
+    bool operator!=(const const_iterator &other) const { return it_ != other.it_; }
+   private:
+    std::vector<uint64_t>::const_iterator it_;
+  };
+  typedef const_iterator iterator;
+  const_iterator begin() const { return const_iterator(keys_.begin()); }
+  const_iterator end() const { return const_iterator(keys_.end()); }
+  size_t size() const { return keys_.size(); }
+  bool empty() const { return keys_.empty(); }
+  void clear() { keys_.clear(); }
+  void reserve(size_t n) { keys_.reserve(n); }
+  /**
+   * @brief Insert a pose ID
+   * @return false if the pose ID is already present
+   */
+  bool insert(const PoseID &pose_id);
+  bool emplace(unsigned robot_id, unsigned frame_id) { return insert(PoseID(robot_id, frame_id)); }
+  /**
+   * @brief Remove a pose ID
+   * @return false if the pose ID is not present
+   */
+  bool erase(const PoseID &pose_id);
+  const_iterator find(const PoseID &pose_id) const;
+  size_t count(const PoseID &pose_id) const { return find(pose_id) != end(); }
+
+ private:
+  std::vector<uint64_t> keys_;
+};
+
+/**
+ * @brief Flat map from PoseID to lifted poses of a fixed size r-by-(d+1).
+ * Keys are kept as a sorted vector of packed 64-bit PoseIDs, and the poses are stored
+ * inline in a single contiguous buffer in the same order, so that copying the entire
+ * map reduces to two memory copies and iterating over it is cache friendly.
+ */
+class LiftedPoseStore {
+ public:
+  typedef Eigen::Map<const Matrix> ConstPoseMap;
+  typedef Eigen::Map<Matrix> PoseMap;
+  static constexpr size_t npos = static_cast<size_t>(-1);
+  /**
+   * @brief Constructor
+   * @param r relaxation rank
+   * @param d dimension
+   */
+  explicit LiftedPoseStore(unsigned int r = 3, unsigned int d = 3) : r_(r), d_(d) {}
+  unsigned int r() const { return r_; }
+  unsigned int d() const { return d_; }
+  size_t size() const { return keys_.size(); }
+  bool empty() const { return keys_.empty(); }
+  /**
+   * @brief Remove all poses
+   */
+  void clear();
+  /**
+   * @brief Remove all poses and change the pose dimensions
+   */
+  void reset(unsigned int r, unsigned int d);
+  /**
+   * @brief Reserve storage for the specified number of poses
+   */
+  void reserve(size_t n);
+  /**
+   * @brief Return the index of a pose, or npos if not found
+   */
+  size_t find(const PoseID &pose_id) const;
+  bool contains(const PoseID &pose_id) const { return find(pose_id) != npos; }
+  /**
+   * @brief Return the index of a pose, inserting a zero pose if not found.
+   * Insertion invalidates the indices and pointers of all poses after the inserted one.
+   */
+  size_t insert(const PoseID &pose_id);
+  /**
+   * @brief Insert or overwrite a pose
+   * @param pose_id
+   * @param pose r-by-(d+1) lifted pose
+   */
+  void set(const PoseID &pose_id, const LiftedPose &pose);
+  /**
+   * @brief Remove a pose
+   * @return false if the pose is not present
+   */
+  bool erase(const PoseID &pose_id);
+  /**
+   * @brief Return the ID of the pose at the specified index
+   */
+  PoseID poseID(size_t index) const { return PoseID::fromKey(keys_[index]); }
+  /**
+   * @brief Pointer to the r-by-(d+1) pose at the specified index (column-major)
+   */
+  double *poseData(size_t index) { return data_.data() + index * stride(); }
+  const double *poseData(size_t index) const { return data_.data() + index * stride(); }
+  /**
+   * @brief Map the pose at the specified index as an r-by-(d+1) matrix, without copying
+   */
+  PoseMap pose(size_t index) { return PoseMap(poseData(index), r_, d_ + 1); }
+  ConstPoseMap pose(size_t index) const { return ConstPoseMap(poseData(index), r_, d_ + 1); }
+  /**
+   * @brief Replace the content of this store with the given PoseDict
+   */
+  void assign(const PoseDict &pose_dict);
+  /**
+   * @brief Convert to a PoseDict
+   */
+  PoseDict toPoseDict() const;
+
+ private:
+  size_t stride() const { return r_ * (d_ + 1); }
+  unsigned int r_, d_;
+  std::vector<uint64_t> keys_;
+  std::vector<double> data_;
+};
 
 }
 #endif //DPGO_INCLUDE_DPGO_MANIFOLD_POSES_H_
@@ -0,0 +1,316 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <DPGO/Communicator.h>
+#include <DPGO/DPGO_trace.h>
+#include <glog/logging.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace DPGO {
+
+InProcessCommunicator::InProcessCommunicator(unsigned num_agents, size_t max_queue_size)
+    : num_agents_(num_agents), max_queue_size_(max_queue_size), num_dropped_(0) {
+  CHECK_GT(num_agents_, 0);
+  CHECK_GT(max_queue_size_, 0);
+  for (unsigned i = 0; i < num_agents_; ++i) {
+    inboxes_.emplace_back(new Inbox());
+  }
+}
+
+bool InProcessCommunicator::publish(unsigned sender, const uint8_t *data, size_t size) {
+  DPGO_TRACE_ZONE("InProcessCommunicator::publish");
+  CHECK_LT(sender, num_agents_);
+  // A single copy of the message is shared by all receivers
+  auto message = std::make_shared<const std::vector<uint8_t>>(data, data + size);
+  size_t dropped = 0;
+  for (unsigned receiver = 0; receiver < num_agents_; ++receiver) {
+    if (receiver == sender) continue;
+    Inbox &inbox = *inboxes_[receiver];
+    std::lock_guard<std::mutex> lock(inbox.mutex);
+    if (inbox.messages.size() >= max_queue_size_) {
+      inbox.messages.pop_front();
+      dropped++;
+    }
+    inbox.messages.push_back(message);
+  }
+  if (dropped > 0) {
+    std::lock_guard<std::mutex> lock(dropped_mutex_);
+    num_dropped_ += dropped;
+  }
+  return true;
+}
+
+size_t InProcessCommunicator::receive(unsigned receiver, const MessageCallback &callback) {
+  DPGO_TRACE_ZONE("InProcessCommunicator::receive");
+  CHECK_LT(receiver, num_agents_);
+  std::deque<MessagePtr> messages;
+  {
+    Inbox &inbox = *inboxes_[receiver];
+    std::lock_guard<std::mutex> lock(inbox.mutex);
+    messages.swap(inbox.messages);
+  }
+  // Invoke callbacks without holding the lock, so that they may publish
+  for (const auto &message : messages) {
+    callback(message->data(), message->size());
+  }
+  return messages.size();
+}
+
+size_t InProcessCommunicator::numDropped() const {
+  std::lock_guard<std::mutex> lock(dropped_mutex_);
+  return num_dropped_;
+}
+
+namespace {
+const uint32_t kSegmentMagic = 0x4D485344;  // "DSHM"
+const size_t kCacheLine = 64;
+
+size_t alignUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+struct SharedMemoryCommunicator::SegmentHeader {
+  std::atomic<uint32_t> magic;  // Set last, once the segment is fully initialized
+  uint32_t num_agents;
+  uint32_t num_slots;
+  uint32_t padding;
+  uint64_t slot_size;
+  int64_t creator_pid;  // Process that created the segment
+};
+
+struct SharedMemoryCommunicator::RingHeader {
+  pthread_mutex_t mutex;
+  uint64_t head;  // Total number of messages written
+  uint64_t tail;  // Total number of messages read (or dropped)
+};
+
+namespace {
+// Each slot stores the message size (uint64_t) followed by the message
+size_t slotStride(size_t slot_size) {
+  return alignUp(sizeof(uint64_t) + slot_size, sizeof(uint64_t));
+}
+
+// Return true if the process with the given ID exists
+bool processAlive(pid_t pid) {
+  return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+// Return true if the shared memory object currently linked under name is the one open as fd,
+// i.e., it has not been unlinked and replaced by a new creator
+bool sameSharedMemory(const std::string &name, int fd) {
+  struct stat mapped{}, linked{};
+  if (fstat(fd, &mapped) != 0) return false;
+  int linked_fd = shm_open(name.c_str(), O_RDONLY, 0600);
+  if (linked_fd < 0) return false;
+  const bool ok = fstat(linked_fd, &linked) == 0;
+  close(linked_fd);
+  return ok && mapped.st_dev == linked.st_dev && mapped.st_ino == linked.st_ino;
+}
+
+// Lock a process-shared mutex, recovering it if the previous owner died
+void lockRobust(pthread_mutex_t *mutex) {
+  int ret = pthread_mutex_lock(mutex);
+  if (ret == EOWNERDEAD) {
+    LOG(WARNING) << "Recovering shared memory ring buffer after a process died.";
+    pthread_mutex_consistent(mutex);
+  } else {
+    CHECK_EQ(ret, 0) << "Failed to lock shared memory mutex: " << std::strerror(ret);
+  }
+}
+}  // namespace
+
+SharedMemoryCommunicator::SharedMemoryCommunicator(const std::string &name,
+                                                   unsigned num_agents,
+                                                   bool create,
+                                                   unsigned num_slots,
+                                                   size_t slot_size,
+                                                   unsigned timeout_ms)
+    : name_(name),
+      num_agents_(num_agents),
+      num_slots_(num_slots),
+      slot_size_(slot_size),
+      owner_(create),
+      segment_size_(0),
+      segment_(nullptr) {
+  CHECK_GT(num_agents_, 0);
+  CHECK_GT(num_slots_, 0);
+  CHECK_GT(slot_size_, 0);
+  segment_size_ = alignUp(sizeof(SegmentHeader), kCacheLine) +
+      num_agents_ * alignUp(sizeof(RingHeader), kCacheLine) +
+      num_agents_ * num_slots_ * slotStride(slot_size_);
+
+  if (create) {
+    // Remove stale segment left over by a previous run
+    shm_unlink(name_.c_str());
+    int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    CHECK_GE(fd, 0) << "Failed to create shared memory " << name_ << ": " << std::strerror(errno);
+    CHECK_EQ(ftruncate(fd, segment_size_), 0) << "Failed to resize shared memory: " << std::strerror(errno);
+    void *ptr = mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    CHECK(ptr != MAP_FAILED) << "Failed to map shared memory: " << std::strerror(errno);
+    segment_ = static_cast<uint8_t *>(ptr);
+
+    auto *header = reinterpret_cast<SegmentHeader *>(segment_);
+    header->num_agents = num_agents_;
+    header->num_slots = num_slots_;
+    header->slot_size = slot_size_;
+    header->creator_pid = getpid();
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    for (unsigned i = 0; i < num_agents_; ++i) {
+      RingHeader *rh = ring(i);
+      CHECK_EQ(pthread_mutex_init(&rh->mutex, &attr), 0);
+      rh->head = 0;
+      rh->tail = 0;
+    }
+    pthread_mutexattr_destroy(&attr);
+    header->magic.store(kSegmentMagic, std::memory_order_release);
+    return;
+  }
+
+  // Wait for the segment to be created and initialized. A segment whose creator has exited is stale
+  // (it is about to be replaced by the next creator), and a segment that is no longer linked under
+  // the name has already been replaced; in both cases, wait for the new segment instead.
+  const auto start = std::chrono::steady_clock::now();
+  auto checkTimeout = [&](const char *what) {
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    if (elapsed > timeout_ms) {
+      LOG(FATAL) << "Timed out waiting for shared memory " << name_ << " to be " << what << ".";
+    }
+  };
+  while (true) {
+    int fd = shm_open(name_.c_str(), O_RDWR, 0600);
+    struct stat st{};
+    if (fd < 0 || fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < segment_size_) {
+      if (fd >= 0) close(fd);
+      checkTimeout("created");
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      continue;
+    }
+    void *ptr = mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+      const int error = errno;
+      close(fd);
+      LOG(FATAL) << "Failed to map shared memory: " << std::strerror(error);
+    }
+    auto *header = reinterpret_cast<SegmentHeader *>(ptr);
+    while (header->magic.load(std::memory_order_acquire) != kSegmentMagic &&
+           sameSharedMemory(name_, fd)) {
+      checkTimeout("initialized");
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (header->magic.load(std::memory_order_acquire) == kSegmentMagic &&
+        processAlive(static_cast<pid_t>(header->creator_pid)) && sameSharedMemory(name_, fd)) {
+      close(fd);
+      segment_ = static_cast<uint8_t *>(ptr);
+      CHECK_EQ(header->num_agents, num_agents_) << "Shared memory layout mismatch.";
+      CHECK_EQ(header->num_slots, num_slots_) << "Shared memory layout mismatch.";
+      CHECK_EQ(header->slot_size, slot_size_) << "Shared memory layout mismatch.";
+      return;
+    }
+    munmap(ptr, segment_size_);
+    close(fd);
+    checkTimeout("initialized");
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+SharedMemoryCommunicator::~SharedMemoryCommunicator() {
+  if (segment_) {
+    if (owner_) {
+      // Processes that open the name from now on must not attach to this segment
+      reinterpret_cast<SegmentHeader *>(segment_)->magic.store(0, std::memory_order_release);
+      for (unsigned i = 0; i < num_agents_; ++i) {
+        pthread_mutex_destroy(&ring(i)->mutex);
+      }
+    }
+    munmap(segment_, segment_size_);
+  }
+  if (owner_) shm_unlink(name_.c_str());
+}
+
+SharedMemoryCommunicator::RingHeader *SharedMemoryCommunicator::ring(unsigned receiver) const {
+  return reinterpret_cast<RingHeader *>(segment_ + alignUp(sizeof(SegmentHeader), kCacheLine) +
+      receiver * alignUp(sizeof(RingHeader), kCacheLine));
+}
+
+uint8_t *SharedMemoryCommunicator::slot(unsigned receiver, uint64_t index) const {
+  const size_t slots_offset = alignUp(sizeof(SegmentHeader), kCacheLine) +
+      num_agents_ * alignUp(sizeof(RingHeader), kCacheLine);
+  return segment_ + slots_offset +
+      (receiver * num_slots_ + index % num_slots_) * slotStride(slot_size_);
+}
+
+bool SharedMemoryCommunicator::publish(unsigned sender, const uint8_t *data, size_t size) {
+  DPGO_TRACE_ZONE("SharedMemoryCommunicator::publish");
+  CHECK_LT(sender, num_agents_);
+  if (size > slot_size_) {
+    LOG(WARNING) << "Message of " << size << " bytes exceeds slot size of " << slot_size_ << " bytes.";
+    return false;
+  }
+  for (unsigned receiver = 0; receiver < num_agents_; ++receiver) {
+    if (receiver == sender) continue;
+    RingHeader *rh = ring(receiver);
+    lockRobust(&rh->mutex);
+    // Overwrite the oldest message if the ring is full
+    if (rh->head - rh->tail >= num_slots_) rh->tail++;
+    uint8_t *dst = slot(receiver, rh->head);
+    const uint64_t message_size = size;
+    std::memcpy(dst, &message_size, sizeof(uint64_t));
+    std::memcpy(dst + sizeof(uint64_t), data, size);
+    rh->head++;
+    pthread_mutex_unlock(&rh->mutex);
+  }
+  return true;
+}
+
+size_t SharedMemoryCommunicator::receive(unsigned receiver, const MessageCallback &callback) {
+  DPGO_TRACE_ZONE("SharedMemoryCommunicator::receive");
+  CHECK_LT(receiver, num_agents_);
+  // Copy pending messages out of the ring, so that callbacks run without holding the lock
+  std::vector<uint8_t> messages;
+  std::vector<std::pair<size_t, size_t>> ranges;
+  RingHeader *rh = ring(receiver);
+  lockRobust(&rh->mutex);
+  while (rh->tail < rh->head) {
+    const uint8_t *src = slot(receiver, rh->tail);
+    uint64_t message_size;
+    std::memcpy(&message_size, src, sizeof(uint64_t));
+    rh->tail++;
+    // Drop corrupted slots instead of reading past the end of the slot
+    if (message_size > slot_size_) {
+      LOG(WARNING) << "Dropping message of " << message_size << " bytes that exceeds slot size of "
+                   << slot_size_ << " bytes.";
+      continue;
+    }
+    ranges.emplace_back(messages.size(), message_size);
+    messages.insert(messages.end(), src + sizeof(uint64_t), src + sizeof(uint64_t) + message_size);
+  }
+  pthread_mutex_unlock(&rh->mutex);
+  for (const auto &range : ranges) {
+    callback(messages.data() + range.first, range.second);
+  }
+  return ranges.size();
+}
+
+}  // namespace DPGO
@@ -0,0 +1,753 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <DPGO/DPGO_io.h>
+#include <DPGO/PGOLogger.h>
+#include <Eigen/Geometry>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <string_view>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace DPGO {
+
+namespace {
+
+// Read-only memory mapping of an entire file
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string &filename) : data_(nullptr), size_(0) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      LOG(WARNING) << "Failed to open " << filename << ": " << std::strerror(errno);
+      return;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void *ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (ptr != MAP_FAILED) {
+        madvise(ptr, st.st_size, MADV_WILLNEED);
+        data_ = static_cast<const char *>(ptr);
+        size_ = st.st_size;
+      } else {
+        LOG(WARNING) << "Failed to map " << filename << ": " << std::strerror(errno);
+      }
+    }
+    valid_ = (data_ != nullptr) || (st.st_size == 0);
+    close(fd);
+  }
+  ~MappedFile() {
+    if (data_) munmap(const_cast<char *>(data_), size_);
+  }
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  bool valid() const { return valid_; }
+  const char *data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  const char *data_;
+  size_t size_;
+  bool valid_ = false;
+};
+
+// Tokenizer over a single line
+class LineParser {
+ public:
+  LineParser(const char *begin, const char *end) : ptr_(begin), end_(end) {}
+
+  // Return the next whitespace-delimited token (empty at end of line)
+  std::string_view token() {
+    skipSpace();
+    const char *start = ptr_;
+    while (ptr_ < end_ && !isSpace(*ptr_)) ++ptr_;
+    return std::string_view(start, ptr_ - start);
+  }
+
+  template<typename T>
+  bool read(T &value) {
+    skipSpace();
+    // from_chars does not accept a leading plus sign
+    if (ptr_ < end_ && *ptr_ == '+') ++ptr_;
+    auto result = std::from_chars(ptr_, end_, value);
+    if (result.ec != std::errc()) return false;
+    ptr_ = result.ptr;
+    return true;
+  }
+
+  template<typename T, typename... Rest>
+  bool read(T &value, Rest &... rest) {
+    return read(value) && read(rest...);
+  }
+
+ private:
+  static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+  void skipSpace() {
+    while (ptr_ < end_ && isSpace(*ptr_)) ++ptr_;
+  }
+  const char *ptr_;
+  const char *end_;
+};
+
+struct VertexEntry {
+  size_t id;
+  Matrix T;
+};
+
+// Result of parsing one chunk of the file
+struct ChunkResult {
+  std::vector<RelativeSEMeasurement> measurements;
+  std::vector<VertexEntry> vertices;
+  size_t numPoses = 0;
+  size_t numSkippedLines = 0;
+  bool has2D = false;
+  bool has3D = false;
+  bool ok = true;
+  std::string error;
+};
+
+void parseChunk(const char *begin, const char *end, const G2OReaderOptions &options, ChunkResult &result) {
+  // Preallocate assuming the shortest edge entries (EDGE_SE2 lines are about 80 bytes)
+  result.measurements.reserve((end - begin) / 80 + 1);
+  size_t i, j;
+  double dx, dy, dz, dtheta, dqx, dqy, dqz, dqw, I11, I12, I13, I14, I15, I16,
+      I22, I23, I24, I25, I26, I33, I34, I35, I36, I44, I45, I46, I55, I56, I66;
+  const char *line = begin;
+  while (line < end) {
+    const char *line_end = static_cast<const char *>(std::memchr(line, '\n', end - line));
+    if (!line_end) line_end = end;
+    LineParser parser(line, line_end);
+    const std::string_view token = parser.token();
+    line = line_end + 1;
+
+    if (token.empty() || token[0] == '#') continue;
+
+    if (token == "EDGE_SE2") {
+      if (!parser.read(i, j, dx, dy, dtheta, I11, I12, I13, I22, I23, I33)) {
+        result.ok = false;
+        result.error = "Malformed EDGE_SE2 entry";
+        return;
+      }
+      Eigen::Matrix2d TranCov;
+      TranCov << I11, I12, I12, I22;
+      RelativeSEMeasurement m(0, 0, i, j,
+                              Eigen::Rotation2Dd(dtheta).toRotationMatrix(),
+                              Eigen::Matrix<double, 2, 1>(dx, dy),
+                              I33, 2 / TranCov.inverse().trace());
+      m.fixedWeight = (i + 1 == j);
+      result.measurements.push_back(std::move(m));
+      result.has2D = true;
+    } else if (token == "EDGE_SE3:QUAT") {
+      if (!parser.read(i, j, dx, dy, dz, dqx, dqy, dqz, dqw, I11,
+                       I12, I13, I14, I15, I16, I22, I23, I24, I25, I26,
+                       I33, I34, I35, I36, I44, I45, I46, I55, I56, I66)) {
+        result.ok = false;
+        result.error = "Malformed EDGE_SE3:QUAT entry";
+        return;
+      }
+      Eigen::Matrix3d TranCov;
+      TranCov << I11, I12, I13, I12, I22, I23, I13, I23, I33;
+      Eigen::Matrix3d RotCov;
+      RotCov << I44, I45, I46, I45, I55, I56, I46, I56, I66;
+      RelativeSEMeasurement m(0, 0, i, j,
+                              Eigen::Quaterniond(dqw, dqx, dqy, dqz).toRotationMatrix(),
+                              Eigen::Matrix<double, 3, 1>(dx, dy, dz),
+                              3 / (2 * RotCov.inverse().trace()),
+                              3 / TranCov.inverse().trace());
+      m.fixedWeight = (i + 1 == j);
+      result.measurements.push_back(std::move(m));
+      result.has3D = true;
+    } else if (token == "VERTEX_SE2") {
+      if (options.readVertices) {
+        if (!parser.read(i, dx, dy, dtheta)) {
+          result.ok = false;
+          result.error = "Malformed VERTEX_SE2 entry";
+          return;
+        }
+        Matrix T(2, 3);
+        T.block(0, 0, 2, 2) = Eigen::Rotation2Dd(dtheta).toRotationMatrix();
+        T.col(2) << dx, dy;
+        result.vertices.push_back({i, T});
+        result.numPoses = std::max(result.numPoses, i + 1);
+        result.has2D = true;
+      }
+      continue;
+    } else if (token == "VERTEX_SE3:QUAT") {
+      if (options.readVertices) {
+        if (!parser.read(i, dx, dy, dz, dqx, dqy, dqz, dqw)) {
+          result.ok = false;
+          result.error = "Malformed VERTEX_SE3:QUAT entry";
+          return;
+        }
+        Matrix T(3, 4);
+        T.block(0, 0, 3, 3) = Eigen::Quaterniond(dqw, dqx, dqy, dqz).normalized().toRotationMatrix();
+        T.col(3) << dx, dy, dz;
+        result.vertices.push_back({i, T});
+        result.numPoses = std::max(result.numPoses, i + 1);
+        result.has3D = true;
+      }
+      continue;
+    } else {
+      if (!options.skipUnknown) {
+        result.ok = false;
+        result.error = "Unrecognized type " + std::string(token);
+        return;
+      }
+      result.numSkippedLines++;
+      continue;
+    }
+    result.numPoses = std::max(result.numPoses, std::max(i, j) + 1);
+  }
+}
+
+}  // namespace
+
+bool readG2OFile(const std::string &filename, G2OData &data, const G2OReaderOptions &options) {
+  data = G2OData();
+  MappedFile file(filename);
+  if (!file.valid())
+    return false;
+
+  // Split the file into chunks that end at line boundaries
+  unsigned num_threads = options.numThreads > 0 ? options.numThreads : std::thread::hardware_concurrency();
+  const size_t kMinChunkBytes = 1 << 16;
+  num_threads = std::max<size_t>(1, std::min<size_t>(std::max(1u, num_threads), file.size() / kMinChunkBytes));
+  std::vector<const char *> bounds{file.data()};
+  for (unsigned t = 1; t < num_threads; ++t) {
+    const char *target = file.data() + t * file.size() / num_threads;
+    if (target <= bounds.back()) continue;
+    const char *newline = static_cast<const char *>(
+        std::memchr(target, '\n', file.data() + file.size() - target));
+    if (!newline) break;
+    bounds.push_back(newline + 1);
+  }
+  bounds.push_back(file.data() + file.size());
+
+  std::vector<ChunkResult> results(bounds.size() - 1);
+  if (results.size() == 1) {
+    parseChunk(bounds[0], bounds[1], options, results[0]);
+  } else {
+    std::vector<std::thread> threads;
+    for (size_t c = 0; c < results.size(); ++c) {
+      threads.emplace_back(parseChunk, bounds[c], bounds[c + 1], std::cref(options), std::ref(results[c]));
+    }
+    for (auto &thread : threads) thread.join();
+  }
+
+  // Merge chunks in file order
+  size_t num_measurements = 0;
+  bool has2D = false, has3D = false;
+  for (const auto &result : results) {
+    if (!result.ok) {
+      LOG(WARNING) << result.error << " in " << filename << ".";
+      return false;
+    }
+    num_measurements += result.measurements.size();
+    data.numPoses = std::max(data.numPoses, result.numPoses);
+    data.numSkippedLines += result.numSkippedLines;
+    has2D |= result.has2D;
+    has3D |= result.has3D;
+  }
+  if (has2D && has3D) {
+    LOG(WARNING) << "File " << filename << " mixes 2D and 3D entries.";
+    return false;
+  }
+  data.dimension = has2D ? 2 : (has3D ? 3 : 0);
+  data.measurements.reserve(num_measurements);
+  for (auto &result : results) {
+    std::move(result.measurements.begin(), result.measurements.end(), std::back_inserter(data.measurements));
+  }
+  if (options.readVertices && data.dimension > 0) {
+    bool has_vertices = false;
+    PoseArray T(data.dimension, data.numPoses);
+    for (const auto &result : results) {
+      for (const auto &vertex : result.vertices) {
+        T.pose(vertex.id) = vertex.T;
+        has_vertices = true;
+      }
+    }
+    if (has_vertices) data.initialGuess.emplace(T);
+  }
+  LOG_IF(INFO, data.numSkippedLines > 0)
+      << "Skipped " << data.numSkippedLines << " lines with unknown types in " << filename << ".";
+  return true;
+}
+
+namespace {
+size_t alignTo8(size_t size) { return (size + 7) / 8 * 8; }
+
+size_t measurementStride(unsigned d) {
+  return sizeof(SnapshotMeasurementRecord) + sizeof(double) * (d * d + d);
+}
+
+// Write to a temporary file first, so that an interrupted write never corrupts an existing file
+bool writeFileAtomically(const std::string &filename, const std::vector<uint8_t> &buffer) {
+  const std::string tmp_filename = filename + ".tmp";
+  {
+    std::ofstream file(tmp_filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      LOG(WARNING) << "Failed to open " << tmp_filename << " for writing.";
+      return false;
+    }
+    file.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+    if (!file.good()) {
+      LOG(WARNING) << "Failed to write " << tmp_filename << ".";
+      return false;
+    }
+  }
+  if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+    LOG(WARNING) << "Failed to rename " << tmp_filename << ": " << std::strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+bool encodeSnapshot(const PoseGraphSnapshot &snapshot, std::vector<uint8_t> &buffer) {
+  const unsigned d = snapshot.d;
+  if (d != 2 && d != 3) {
+    LOG(WARNING) << "Invalid snapshot dimension " << d << ".";
+    return false;
+  }
+  const size_t num_cols = (d + 1) * snapshot.numPoses;
+  if (snapshot.trajectory &&
+      (snapshot.trajectory->rows() != d || static_cast<size_t>(snapshot.trajectory->cols()) != num_cols)) {
+    LOG(WARNING) << "Snapshot trajectory has wrong dimensions.";
+    return false;
+  }
+  const unsigned r = snapshot.X ? snapshot.X->rows() : (snapshot.liftingMatrix ? snapshot.liftingMatrix->rows() : 0);
+  if (snapshot.X && static_cast<size_t>(snapshot.X->cols()) != num_cols) {
+    LOG(WARNING) << "Snapshot iterate has wrong dimensions.";
+    return false;
+  }
+  if (snapshot.liftingMatrix && (snapshot.liftingMatrix->rows() != r || snapshot.liftingMatrix->cols() != d)) {
+    LOG(WARNING) << "Snapshot lifting matrix has wrong dimensions.";
+    return false;
+  }
+
+  // Compute layout
+  SnapshotHeader header{};
+  header.magic = kSnapshotMagic;
+  header.version = kSnapshotVersion;
+  header.d = d;
+  header.agentID = snapshot.agentID;
+  header.r = r;
+  header.numPoses = snapshot.numPoses;
+  header.numMeasurements = snapshot.measurements.size();
+  size_t offset = alignTo8(sizeof(SnapshotHeader));
+  header.measurementsOffset = offset;
+  offset += alignTo8(snapshot.measurements.size() * measurementStride(d));
+  if (snapshot.trajectory) {
+    header.trajectoryOffset = offset;
+    offset += sizeof(double) * d * num_cols;
+  }
+  if (snapshot.X) {
+    header.iterateOffset = offset;
+    offset += sizeof(double) * r * num_cols;
+  }
+  if (snapshot.liftingMatrix) {
+    header.liftingMatrixOffset = offset;
+    offset += sizeof(double) * r * d;
+  }
+  header.fileSize = offset;
+
+  // Serialize
+  buffer.assign(header.fileSize, 0);
+  std::memcpy(buffer.data(), &header, sizeof(header));
+  uint8_t *ptr = buffer.data() + header.measurementsOffset;
+  for (const auto &m : snapshot.measurements) {
+    if (m.R.rows() != d || m.R.cols() != d || m.t.size() != d) {
+      LOG(WARNING) << "Snapshot measurement has wrong dimensions.";
+      return false;
+    }
+    SnapshotMeasurementRecord record{};
+    record.r1 = m.r1;
+    record.p1 = m.p1;
+    record.r2 = m.r2;
+    record.p2 = m.p2;
+    record.kappa = m.kappa;
+    record.tau = m.tau;
+    record.weight = m.weight;
+    record.fixedWeight = m.fixedWeight;
+    std::memcpy(ptr, &record, sizeof(record));
+    ptr += sizeof(record);
+    Eigen::Map<Matrix>(reinterpret_cast<double *>(ptr), d, d) = m.R;
+    ptr += sizeof(double) * d * d;
+    Eigen::Map<Vector>(reinterpret_cast<double *>(ptr), d) = m.t;
+    ptr += sizeof(double) * d;
+  }
+  auto copyMatrix = [&](const Matrix &M, uint64_t section_offset) {
+    std::memcpy(buffer.data() + section_offset, M.data(), sizeof(double) * M.size());
+  };
+  if (snapshot.trajectory) copyMatrix(*snapshot.trajectory, header.trajectoryOffset);
+  if (snapshot.X) copyMatrix(*snapshot.X, header.iterateOffset);
+  if (snapshot.liftingMatrix) copyMatrix(*snapshot.liftingMatrix, header.liftingMatrixOffset);
+  return true;
+}
+}  // namespace
+
+bool writeSnapshot(const std::string &filename, const PoseGraphSnapshot &snapshot) {
+  std::vector<uint8_t> buffer;
+  return encodeSnapshot(snapshot, buffer) && writeFileAtomically(filename, buffer);
+}
+
+SnapshotView::~SnapshotView() {
+  close();
+}
+
+void SnapshotView::close() {
+  if (data_ && owned_) munmap(const_cast<uint8_t *>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+  owned_ = false;
+}
+
+bool SnapshotView::open(const std::string &filename) {
+  close();
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(WARNING) << "Failed to open " << filename << ": " << std::strerror(errno);
+    return false;
+  }
+  struct stat st{};
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+    ::close(fd);
+    LOG(WARNING) << "File " << filename << " is not a valid snapshot.";
+    return false;
+  }
+  void *ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (ptr == MAP_FAILED) {
+    LOG(WARNING) << "Failed to map " << filename << ": " << std::strerror(errno);
+    return false;
+  }
+  data_ = static_cast<const uint8_t *>(ptr);
+  size_ = st.st_size;
+  owned_ = true;
+  if (!validate()) {
+    LOG(WARNING) << "File " << filename << " is not a valid snapshot.";
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool SnapshotView::parse(const uint8_t *data, size_t size) {
+  close();
+  if (size < sizeof(SnapshotHeader) || reinterpret_cast<uintptr_t>(data) % 8 != 0)
+    return false;
+  data_ = data;
+  size_ = size;
+  if (!validate()) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool SnapshotView::validate() const {
+  // Validate header and section bounds. Counts are untrusted, so each one is bounded by the
+  // file size before it is used in a product, and sections are checked against the remaining space.
+  const SnapshotHeader &h = header();
+  if (h.magic != kSnapshotMagic || h.version != kSnapshotVersion || (h.d != 2 && h.d != 3) ||
+      h.fileSize != size_ || h.measurementsOffset == 0)
+    return false;
+  if (h.r == 0 && (h.iterateOffset != 0 || h.liftingMatrixOffset != 0))
+    return false;
+  if (h.numPoses > size_ / (sizeof(double) * (h.d + 1)) || h.r > size_ / sizeof(double))
+    return false;
+  const uint64_t num_cols = (h.d + 1) * h.numPoses;
+  // Check that count elements of the given stride fit in the section starting at offset
+  auto sectionFits = [&](uint64_t offset, uint64_t count, uint64_t stride) {
+    if (offset == 0) return true;
+    if (offset % 8 != 0 || offset < sizeof(SnapshotHeader) || offset > size_) return false;
+    return count <= (size_ - offset) / stride;
+  };
+  return sectionFits(h.measurementsOffset, h.numMeasurements, measurementStride(h.d)) &&
+      sectionFits(h.trajectoryOffset, num_cols, sizeof(double) * h.d) &&
+      sectionFits(h.iterateOffset, num_cols, sizeof(double) * h.r) &&
+      sectionFits(h.liftingMatrixOffset, h.d, sizeof(double) * h.r);
+}
+
+RelativeSEMeasurement SnapshotView::measurement(size_t index) const {
+  CHECK_LT(index, numMeasurements());
+  const unsigned dim = d();
+  const uint8_t *ptr = data_ + header().measurementsOffset + index * measurementStride(dim);
+  SnapshotMeasurementRecord record{};
+  std::memcpy(&record, ptr, sizeof(record));
+  const double *values = reinterpret_cast<const double *>(ptr + sizeof(record));
+  RelativeSEMeasurement m(record.r1, record.r2, record.p1, record.p2,
+                          Eigen::Map<const Matrix>(values, dim, dim),
+                          Eigen::Map<const Vector>(values + dim * dim, dim),
+                          record.kappa, record.tau);
+  m.weight = record.weight;
+  m.fixedWeight = record.fixedWeight;
+  return m;
+}
+
+SnapshotView::ConstMatrixMap SnapshotView::trajectory() const {
+  CHECK(hasTrajectory());
+  return ConstMatrixMap(section(header().trajectoryOffset), d(), (d() + 1) * numPoses());
+}
+
+SnapshotView::ConstMatrixMap SnapshotView::iterate() const {
+  CHECK(hasIterate());
+  return ConstMatrixMap(section(header().iterateOffset), header().r, (d() + 1) * numPoses());
+}
+
+SnapshotView::ConstMatrixMap SnapshotView::liftingMatrix() const {
+  CHECK(hasLiftingMatrix());
+  return ConstMatrixMap(section(header().liftingMatrixOffset), header().r, d());
+}
+
+PoseGraphSnapshot SnapshotView::toSnapshot() const {
+  PoseGraphSnapshot snapshot;
+  snapshot.agentID = header().agentID;
+  snapshot.d = d();
+  snapshot.numPoses = numPoses();
+  snapshot.measurements.reserve(numMeasurements());
+  for (size_t i = 0; i < numMeasurements(); ++i) {
+    snapshot.measurements.push_back(measurement(i));
+  }
+  if (hasTrajectory()) snapshot.trajectory.emplace(trajectory());
+  if (hasIterate()) snapshot.X.emplace(iterate());
+  if (hasLiftingMatrix()) snapshot.liftingMatrix.emplace(liftingMatrix());
+  return snapshot;
+}
+
+bool readSnapshot(const std::string &filename, PoseGraphSnapshot &snapshot) {
+  SnapshotView view;
+  if (!view.open(filename))
+    return false;
+  snapshot = view.toSnapshot();
+  return true;
+}
+
+bool convertG2OToSnapshot(const std::string &g2o_file, const std::string &snapshot_file) {
+  G2OData data;
+  if (!readG2OFile(g2o_file, data, G2OReaderOptions(0, true)))
+    return false;
+  if (data.measurements.empty()) {
+    LOG(WARNING) << "File " << g2o_file << " contains no measurements.";
+    return false;
+  }
+  PoseGraphSnapshot snapshot;
+  snapshot.d = data.dimension;
+  snapshot.numPoses = data.numPoses;
+  snapshot.measurements = std::move(data.measurements);
+  if (data.initialGuess) snapshot.trajectory.emplace(data.initialGuess->getData());
+  return writeSnapshot(snapshot_file, snapshot);
+}
+
+bool convertLogToSnapshot(const std::string &measurements_file,
+                          const std::string &trajectory_file,
+                          const std::string &snapshot_file,
+                          unsigned agent_id) {
+  PoseGraphSnapshot snapshot;
+  snapshot.agentID = agent_id;
+  snapshot.measurements = PGOLogger::loadMeasurements(measurements_file, true);
+  if (snapshot.measurements.empty()) {
+    LOG(WARNING) << "File " << measurements_file << " contains no measurements.";
+    return false;
+  }
+  snapshot.d = snapshot.measurements[0].t.size();
+  for (const auto &m : snapshot.measurements) {
+    if (m.r1 == agent_id) snapshot.numPoses = std::max<size_t>(snapshot.numPoses, m.p1 + 1);
+    if (m.r2 == agent_id) snapshot.numPoses = std::max<size_t>(snapshot.numPoses, m.p2 + 1);
+  }
+  if (!trajectory_file.empty()) {
+    PGOLogger logger("");
+    Matrix T = logger.loadTrajectory(trajectory_file);
+    if (T.rows() != snapshot.d || static_cast<size_t>(T.cols()) != (snapshot.d + 1) * snapshot.numPoses) {
+      LOG(WARNING) << "Trajectory in " << trajectory_file << " does not match the measurements.";
+      return false;
+    }
+    snapshot.trajectory.emplace(T);
+  }
+  return writeSnapshot(snapshot_file, snapshot);
+}
+
+namespace {
+// Auxiliary matrices of a checkpoint, in storage order
+struct CheckpointMatrix {
+  uint8_t flag;
+  std::optional<Matrix> AgentCheckpoint::*member;
+};
+const CheckpointMatrix kCheckpointMatrices[] = {
+    {kCheckpointHasXInit, &AgentCheckpoint::XInit},
+    {kCheckpointHasXPrev, &AgentCheckpoint::XPrev},
+    {kCheckpointHasAcceleration, &AgentCheckpoint::Y},
+    {kCheckpointHasAcceleration, &AgentCheckpoint::V},
+    {kCheckpointHasGlobalAnchor, &AgentCheckpoint::globalAnchor},
+};
+
+size_t checkpointMatrixCols(const CheckpointMatrix &matrix, unsigned d, size_t num_poses) {
+  return matrix.flag == kCheckpointHasGlobalAnchor ? d + 1 : (d + 1) * num_poses;
+}
+}  // namespace
+
+bool writeCheckpoint(const std::string &filename, const AgentCheckpoint &checkpoint) {
+  std::vector<uint8_t> snapshot_buffer;
+  if (!encodeSnapshot(checkpoint.snapshot, snapshot_buffer))
+    return false;
+  if (checkpoint.Y.has_value() != checkpoint.V.has_value()) {
+    LOG(WARNING) << "Checkpoint acceleration state is incomplete.";
+    return false;
+  }
+
+  // Compute layout
+  const unsigned d = checkpoint.snapshot.d;
+  const size_t n = checkpoint.snapshot.numPoses;
+  CheckpointHeader header{};
+  header.magic = kCheckpointMagic;
+  header.version = kCheckpointVersion;
+  header.state = checkpoint.state;
+  header.instanceNumber = checkpoint.instanceNumber;
+  header.iterationNumber = checkpoint.iterationNumber;
+  header.latestWeightUpdateIteration = checkpoint.latestWeightUpdateIteration;
+  header.robustOptInnerIter = checkpoint.robustOptInnerIter;
+  header.weightUpdateCount = checkpoint.weightUpdateCount;
+  header.trajectoryResetCount = checkpoint.trajectoryResetCount;
+  header.gncIteration = checkpoint.gncIteration;
+  header.gncMu = checkpoint.gncMu;
+  header.gamma = checkpoint.gamma;
+  header.alpha = checkpoint.alpha;
+  header.snapshotOffset = alignTo8(sizeof(CheckpointHeader));
+  header.snapshotSize = snapshot_buffer.size();
+  header.auxiliaryOffset = header.snapshotOffset + alignTo8(snapshot_buffer.size());
+  size_t offset = header.auxiliaryOffset;
+  for (const auto &matrix : kCheckpointMatrices) {
+    const auto &M = checkpoint.*matrix.member;
+    if (!M) continue;
+    if (header.r == 0) header.r = M->rows();
+    if (M->rows() != header.r || static_cast<size_t>(M->cols()) != checkpointMatrixCols(matrix, d, n)) {
+      LOG(WARNING) << "Checkpoint matrix has wrong dimensions.";
+      return false;
+    }
+    header.flags |= matrix.flag;
+    offset += sizeof(double) * M->size();
+  }
+  header.numGNCSettledLoopClosures = checkpoint.gncSettledLoopClosures.size();
+  header.numGNCUndecidedLoopClosures = checkpoint.gncUndecidedLoopClosures.size();
+  if (header.numGNCSettledLoopClosures + header.numGNCUndecidedLoopClosures > 0) {
+    header.flags |= kCheckpointHasGNCLoopClosures;
+    offset += sizeof(CheckpointEdgeRecord) *
+        (header.numGNCSettledLoopClosures + header.numGNCUndecidedLoopClosures);
+  }
+  header.fileSize = offset;
+
+  // Serialize
+  std::vector<uint8_t> buffer(header.fileSize, 0);
+  std::memcpy(buffer.data(), &header, sizeof(header));
+  std::memcpy(buffer.data() + header.snapshotOffset, snapshot_buffer.data(), snapshot_buffer.size());
+  uint8_t *ptr = buffer.data() + header.auxiliaryOffset;
+  for (const auto &matrix : kCheckpointMatrices) {
+    const auto &M = checkpoint.*matrix.member;
+    if (!M) continue;
+    std::memcpy(ptr, M->data(), sizeof(double) * M->size());
+    ptr += sizeof(double) * M->size();
+  }
+  for (const auto *edges : {&checkpoint.gncSettledLoopClosures, &checkpoint.gncUndecidedLoopClosures}) {
+    for (const auto &edge : *edges) {
+      const CheckpointEdgeRecord record{edge.src_pose_id.robot_id, edge.src_pose_id.frame_id,
+                                        edge.dst_pose_id.robot_id, edge.dst_pose_id.frame_id};
+      std::memcpy(ptr, &record, sizeof(record));
+      ptr += sizeof(record);
+    }
+  }
+  return writeFileAtomically(filename, buffer);
+}
+
+bool readCheckpoint(const std::string &filename, AgentCheckpoint &checkpoint) {
+  MappedFile file(filename);
+  if (!file.valid())
+    return false;
+  const uint8_t *data = reinterpret_cast<const uint8_t *>(file.data());
+  CheckpointHeader header{};
+  SnapshotView view;
+  bool valid = file.size() >= sizeof(CheckpointHeader);
+  if (valid) {
+    std::memcpy(&header, data, sizeof(header));
+    valid = header.magic == kCheckpointMagic && header.version == kCheckpointVersion &&
+        header.fileSize == file.size() && header.snapshotOffset % 8 == 0 &&
+        header.snapshotOffset >= sizeof(CheckpointHeader) && header.auxiliaryOffset % 8 == 0 &&
+        header.auxiliaryOffset <= header.fileSize && header.snapshotOffset <= header.auxiliaryOffset &&
+        header.snapshotSize <= header.auxiliaryOffset - header.snapshotOffset &&
+        view.parse(data + header.snapshotOffset, header.snapshotSize);
+  }
+  if (valid) {
+    // Each section must fit in the remaining space; sizes are never summed to avoid overflow
+    uint64_t remaining = header.fileSize - header.auxiliaryOffset;
+    auto consume = [&](uint64_t count, uint64_t stride) {
+      valid = valid && (stride == 0 || count <= remaining / stride);
+      if (valid) remaining -= count * stride;
+    };
+    for (const auto &matrix : kCheckpointMatrices) {
+      if (header.flags & matrix.flag)
+        consume(header.r, sizeof(double) * checkpointMatrixCols(matrix, view.d(), view.numPoses()));
+    }
+    if (header.flags & kCheckpointHasGNCLoopClosures) {
+      consume(header.numGNCSettledLoopClosures, sizeof(CheckpointEdgeRecord));
+      consume(header.numGNCUndecidedLoopClosures, sizeof(CheckpointEdgeRecord));
+    } else {
+      valid = valid && header.numGNCSettledLoopClosures == 0 && header.numGNCUndecidedLoopClosures == 0;
+    }
+    valid = valid && remaining == 0;
+  }
+  if (!valid) {
+    LOG(WARNING) << "File " << filename << " is not a valid checkpoint.";
+    return false;
+  }
+
+  checkpoint = AgentCheckpoint();
+  checkpoint.snapshot = view.toSnapshot();
+  checkpoint.state = header.state;
+  checkpoint.instanceNumber = header.instanceNumber;
+  checkpoint.iterationNumber = header.iterationNumber;
+  checkpoint.latestWeightUpdateIteration = header.latestWeightUpdateIteration;
+  checkpoint.robustOptInnerIter = header.robustOptInnerIter;
+  checkpoint.weightUpdateCount = header.weightUpdateCount;
+  checkpoint.trajectoryResetCount = header.trajectoryResetCount;
+  checkpoint.gncIteration = header.gncIteration;
+  checkpoint.gncMu = header.gncMu;
+  checkpoint.gamma = header.gamma;
+  checkpoint.alpha = header.alpha;
+  const double *values = reinterpret_cast<const double *>(data + header.auxiliaryOffset);
+  for (const auto &matrix : kCheckpointMatrices) {
+    if (!(header.flags & matrix.flag)) continue;
+    const size_t cols = checkpointMatrixCols(matrix, view.d(), view.numPoses());
+    (checkpoint.*matrix.member).emplace(Eigen::Map<const Matrix>(values, header.r, cols));
+    values += header.r * cols;
+  }
+  const uint8_t *ptr = reinterpret_cast<const uint8_t *>(values);
+  auto readEdges = [&](uint64_t count, std::vector<EdgeID> &edges) {
+    edges.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+      CheckpointEdgeRecord record{};
+      std::memcpy(&record, ptr, sizeof(record));
+      ptr += sizeof(record);
+      edges.emplace_back(PoseID(record.r1, record.p1), PoseID(record.r2, record.p2));
+    }
+  };
+  readEdges(header.numGNCSettledLoopClosures, checkpoint.gncSettledLoopClosures);
+  readEdges(header.numGNCUndecidedLoopClosures, checkpoint.gncUndecidedLoopClosures);
+  return true;
+}
+
+}  // namespace DPGO
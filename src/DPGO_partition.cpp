@@ -0,0 +1,234 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <DPGO/DPGO_partition.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace DPGO {
+
+std::string PartitionParameters::MethodToString(Method method) {
+  switch (method) {
+    case Method::Contiguous: {
+      return "Contiguous";
+    }
+    case Method::RecursiveBisection: {
+      return "RecursiveBisection";
+    }
+  }
+  return "";
+}
+
+namespace {
+
+/**
+ * @brief Pose graph as undirected edges sorted by their first endpoint, with pose loads
+ */
+struct ChainGraph {
+  // Edges (i, j) with i < j (self loops are dropped)
+  std::vector<std::pair<size_t, size_t>> edges;
+  // Prefix sums of pose loads (size n + 1)
+  std::vector<double> prefixLoad;
+
+  // All measurements must be between poses in [0, numPoses)
+  ChainGraph(const std::vector<RelativeSEMeasurement> &measurements, size_t numPoses) {
+    std::vector<double> degree(numPoses, 0);
+    edges.reserve(measurements.size());
+    for (const auto &m : measurements) {
+      if (m.p1 == m.p2) continue;
+      edges.emplace_back(std::min(m.p1, m.p2), std::max(m.p1, m.p2));
+      degree[m.p1] += 1;
+      degree[m.p2] += 1;
+    }
+    std::sort(edges.begin(), edges.end());
+    prefixLoad.assign(numPoses + 1, 0);
+    for (size_t i = 0; i < numPoses; ++i) prefixLoad[i + 1] = prefixLoad[i] + 1 + 0.5 * degree[i];
+  }
+
+  double load(size_t begin, size_t end) const { return prefixLoad[end] - prefixLoad[begin]; }
+};
+
+/**
+ * @brief Choose the point c in [lo, hi] that splits the poses [begin, end) into [begin, c) and [c, end).
+ * Among points that satisfy the load limits, the point crossed by the fewest edges within
+ * [begin, end) is chosen (ties are broken by balance); if no point satisfies the limits,
+ * the point that violates them the least is chosen.
+ */
+size_t bestCutPoint(const ChainGraph &graph, size_t begin, size_t end, size_t lo, size_t hi,
+                    double maxLeftLoad, double maxRightLoad) {
+  CHECK_LE(lo, hi);
+  // Number of edges crossing each point in [lo, hi], from a difference array
+  std::vector<long> crossings(hi - lo + 2, 0);
+  auto first = std::lower_bound(graph.edges.begin(), graph.edges.end(), std::make_pair(begin, size_t(0)));
+  for (auto it = first; it != graph.edges.end() && it->first < end; ++it) {
+    const size_t i = it->first, j = it->second;
+    if (j >= end) continue;
+    // Edge (i, j) crosses the points i + 1, ..., j
+    const size_t from = std::max(i + 1, lo), to = std::min(j, hi);
+    if (from > to) continue;
+    crossings[from - lo]++;
+    crossings[to - lo + 1]--;
+  }
+  size_t best = lo;
+  bool best_feasible = false;
+  long best_crossings = std::numeric_limits<long>::max();
+  double best_violation = std::numeric_limits<double>::max();
+  long count = 0;
+  for (size_t c = lo; c <= hi; ++c) {
+    count += crossings[c - lo];
+    const double violation = std::max(graph.load(begin, c) / maxLeftLoad, graph.load(c, end) / maxRightLoad);
+    const bool feasible = violation <= 1;
+    if (feasible) {
+      if (!best_feasible || count < best_crossings || (count == best_crossings && violation < best_violation)) {
+        best = c;
+        best_feasible = true;
+        best_crossings = count;
+        best_violation = violation;
+      }
+    } else if (!best_feasible && violation < best_violation) {
+      best = c;
+      best_violation = violation;
+    }
+  }
+  return best;
+}
+
+// Split [begin, end) among the robots firstRobot, ..., firstRobot + numRobots - 1
+void recursiveBisection(const ChainGraph &graph, size_t begin, size_t end, unsigned firstRobot,
+                        unsigned numRobots, double levelTol, std::vector<size_t> &starts) {
+  if (numRobots == 1) {
+    starts[firstRobot] = begin;
+    return;
+  }
+  const unsigned numLeft = numRobots / 2;
+  const unsigned numRight = numRobots - numLeft;
+  const double total = graph.load(begin, end);
+  const double targetLeft = total * numLeft / numRobots;
+  // Every robot keeps at least two poses
+  const size_t cut = bestCutPoint(graph, begin, end, begin + 2 * numLeft, end - 2 * numRight,
+                                  (1 + levelTol) * targetLeft, (1 + levelTol) * (total - targetLeft));
+  recursiveBisection(graph, begin, cut, firstRobot, numLeft, levelTol, starts);
+  recursiveBisection(graph, cut, end, firstRobot + numLeft, numRight, levelTol, starts);
+}
+
+// Move each cut point to the best position between its neighboring cut points
+void refineCutPoints(const ChainGraph &graph, double maxLoad, unsigned numPasses, std::vector<size_t> &starts) {
+  const size_t numRobots = starts.size() - 1;
+  for (unsigned pass = 0; pass < numPasses; ++pass) {
+    bool changed = false;
+    for (size_t robot = 1; robot < numRobots; ++robot) {
+      const size_t begin = starts[robot - 1], end = starts[robot + 1];
+      const size_t cut = bestCutPoint(graph, begin, end, begin + 2, end - 2, maxLoad, maxLoad);
+      if (cut != starts[robot]) {
+        starts[robot] = cut;
+        changed = true;
+      }
+    }
+    if (!changed) break;
+  }
+}
+
+}  // namespace
+
+PoseID PoseGraphPartition::poseID(size_t globalIndex) const {
+  CHECK_LT(globalIndex, starts.back());
+  const unsigned robot = std::upper_bound(starts.begin() + 1, starts.end() - 1, globalIndex) - (starts.begin() + 1);
+  return PoseID(robot, globalIndex - starts[robot]);
+}
+
+size_t PoseGraphPartition::globalIndex(const PoseID &poseID) const {
+  CHECK_LT(poseID.robot_id, numRobots());
+  CHECK_LT(poseID.frame_id, numPoses(poseID.robot_id));
+  return starts[poseID.robot_id] + poseID.frame_id;
+}
+
+bool partitionPoseGraph(const std::vector<RelativeSEMeasurement> &measurements,
+                        size_t numPoses,
+                        unsigned numRobots,
+                        const PartitionParameters &params,
+                        PoseGraphPartition &partition) {
+  if (numRobots == 0 || numPoses < 2 * numRobots) {
+    LOG(WARNING) << "Cannot split " << numPoses << " poses among " << numRobots
+                 << " robots with at least two poses each.";
+    return false;
+  }
+  for (const auto &m : measurements) {
+    if (m.p1 >= numPoses || m.p2 >= numPoses) {
+      LOG(WARNING) << "Measurement between poses " << m.p1 << " and " << m.p2 << " is out of range.";
+      return false;
+    }
+  }
+  std::vector<size_t> starts(numRobots + 1, numPoses);
+  switch (params.method) {
+    case PartitionParameters::Method::Contiguous: {
+      for (unsigned robot = 0; robot < numRobots; ++robot) starts[robot] = robot * (numPoses / numRobots);
+      break;
+    }
+    case PartitionParameters::Method::RecursiveBisection: {
+      const ChainGraph graph(measurements, numPoses);
+      // Split the imbalance tolerance among the levels of recursion
+      const double levels = std::max(1.0, std::ceil(std::log2(numRobots)));
+      recursiveBisection(graph, 0, numPoses, 0, numRobots, params.imbalanceTol / levels, starts);
+      const double maxLoad = (1 + params.imbalanceTol) * graph.load(0, numPoses) / numRobots;
+      refineCutPoints(graph, maxLoad, params.refinementPasses, starts);
+      break;
+    }
+  }
+  return splitPoseGraph(measurements, starts, partition);
+}
+
+bool splitPoseGraph(const std::vector<RelativeSEMeasurement> &measurements,
+                    const std::vector<size_t> &starts,
+                    PoseGraphPartition &partition) {
+  if (starts.size() < 2 || starts.front() != 0) {
+    LOG(WARNING) << "Invalid segment boundaries.";
+    return false;
+  }
+  for (size_t robot = 0; robot + 1 < starts.size(); ++robot) {
+    if (starts[robot + 1] <= starts[robot]) {
+      LOG(WARNING) << "Segment of robot " << robot << " is empty.";
+      return false;
+    }
+  }
+  const size_t numPoses = starts.back();
+  const unsigned numRobots = starts.size() - 1;
+  partition.starts = starts;
+  partition.agents.assign(numRobots, AgentMeasurements());
+  partition.loads.assign(numRobots, 0);
+  partition.numSharedLoopClosures = 0;
+  for (unsigned robot = 0; robot < numRobots; ++robot) partition.loads[robot] = partition.numPoses(robot);
+
+  for (const auto &mIn : measurements) {
+    if (mIn.p1 >= numPoses || mIn.p2 >= numPoses) {
+      LOG(WARNING) << "Measurement between poses " << mIn.p1 << " and " << mIn.p2 << " is out of range.";
+      return false;
+    }
+    const PoseID src = partition.poseID(mIn.p1);
+    const PoseID dst = partition.poseID(mIn.p2);
+    RelativeSEMeasurement m(src.robot_id, dst.robot_id, src.frame_id, dst.frame_id,
+                            mIn.R, mIn.t, mIn.kappa, mIn.tau);
+    m.weight = mIn.weight;
+    m.fixedWeight = mIn.fixedWeight;
+    partition.loads[src.robot_id] += 0.5;
+    partition.loads[dst.robot_id] += 0.5;
+    if (src.robot_id != dst.robot_id) {
+      partition.agents[src.robot_id].sharedLoopClosures.push_back(m);
+      partition.agents[dst.robot_id].sharedLoopClosures.push_back(m);
+      partition.numSharedLoopClosures++;
+    } else if (m.p1 + 1 == m.p2) {
+      partition.agents[src.robot_id].odometry.push_back(m);
+    } else {
+      partition.agents[src.robot_id].privateLoopClosures.push_back(m);
+    }
+  }
+  return true;
+}
+
+}  // namespace DPGO
@@ -7,6 +7,7 @@
 
 #include <DPGO/DPGO_robust.h>
 
+#include <algorithm>
 #include <cmath>
 #include <DPGO/DPGO_utils.h>
 
@@ -97,6 +98,44 @@ double RobustCost::weight(double r) const {
   }
 }
 
+void RobustCost::weights(const Eigen::Ref<const Vector> &residuals, Vector &weights) const {
+  const auto r = residuals.array();
+  weights.resize(residuals.size());
+  switch (mParams.costType) {
+    case RobustCostParameters::Type::L2: {
+      weights.setOnes();
+      break;
+    }
+    case RobustCostParameters::Type::L1: {
+      weights.array() = r.inverse();
+      break;
+    }
+    case RobustCostParameters::Type::Huber: {
+      // Equals 1 below the threshold and threshold / r above
+      weights.array() = mParams.HuberThreshold / r.max(mParams.HuberThreshold);
+      break;
+    }
+    case RobustCostParameters::Type::TLS: {
+      weights.array() = (r < mParams.TLSThreshold).cast<double>();
+      break;
+    }
+    case RobustCostParameters::Type::GM: {
+      weights.array() = (1 + r.square()).square().inverse();
+      break;
+    }
+    case RobustCostParameters::Type::GNC_TLS: {
+      // Eq. (14) of GNC paper: sqrt(barc^2 mu (mu + 1) / r^2) - mu is 0 at the upper bound
+      // and 1 at the lower bound of the squared residual, and is monotone in between
+      const double c = mParams.GNCBarc * std::sqrt(mu * (mu + 1));
+      weights.array() = (c / r - mu).max(0.0).min(1.0);
+      break;
+    }
+    default: {
+      throw std::runtime_error("weight function for selected cost function is not implemented !");
+    }
+  }
+}
+
 void RobustCost::reset() {
   // Initialize the mu parameter in GNC, if used
   switch (mParams.costType) {
@@ -113,7 +152,13 @@ void RobustCost::reset() {
 
 }
 
-void RobustCost::update() {
+void RobustCost::setGNCState(size_t iteration, double muIn) {
+  CHECK_GT(muIn, 0);
+  mGNCIteration = iteration;
+  mu = muIn;
+}
+
+void RobustCost::update(double undecidedRatio) {
   if (mParams.costType != RobustCostParameters::Type::GNC_TLS) return;
 
   mGNCIteration++;
@@ -124,7 +169,12 @@ void RobustCost::update() {
 
   switch (mParams.costType) {
     case RobustCostParameters::Type::GNC_TLS: {
-      mu = mParams.GNCMuStep * mu;
+      double step = mParams.GNCMuStep;
+      if (mParams.GNCAdaptive) {
+        const double settledRatio = 1 - std::min(1.0, std::max(0.0, undecidedRatio));
+        step += (std::max(mParams.GNCMaxMuStep, mParams.GNCMuStep) - mParams.GNCMuStep) * settledRatio;
+      }
+      mu = step * mu;
       break;
     }
     default: {
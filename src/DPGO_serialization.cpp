@@ -0,0 +1,609 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <DPGO/DPGO_serialization.h>
+#include <DPGO/PGOAgent.h>
+#include <glog/logging.h>
+
+#include <cmath>
+#include <cstring>
+
+namespace DPGO {
+
+namespace {
+
+// Size of the robot_id and frame_id fields preceding each pose record
+const size_t kPoseIDBytes = 2 * sizeof(uint32_t);
+
+// Packed layout of an encoded PGOAgentStatus
+struct StatusRecord {
+  uint32_t agentID;
+  uint8_t state;
+  uint8_t readyToTerminate;
+  uint16_t padding;
+  uint32_t instanceNumber;
+  uint32_t iterationNumber;
+  double relativeChange;
+};
+static_assert(sizeof(StatusRecord) == 24, "Unexpected padding in StatusRecord");
+
+// Packed layout of the scalar fields of an encoded RelativeSEMeasurement
+// The record is followed by R (d-by-d, column-major) and t (d-dimensional)
+struct MeasurementRecord {
+  uint32_t r1;
+  uint32_t r2;
+  uint32_t p1;
+  uint32_t p2;
+  double kappa;
+  double tau;
+  double weight;
+  uint8_t fixedWeight;
+  uint8_t padding[7];
+};
+static_assert(sizeof(MeasurementRecord) == 48, "Unexpected padding in MeasurementRecord");
+
+// Coefficients of a rounded pose (at most 3-by-4), stored on the stack
+typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor, 3, 4> CoefficientMatrix;
+
+size_t poseRecordSize(unsigned r, unsigned d, PoseEncoding encoding, bool rounded) {
+  const unsigned rows = rounded ? d : r;
+  return kPoseIDBytes + rows * (d + 1) * scalarSize(encoding);
+}
+
+size_t basisSize(unsigned r, unsigned d, bool rounded) {
+  return rounded ? r * d * sizeof(double) : 0;
+}
+
+void writeScalars(const double *src, size_t num, PoseEncoding encoding, uint8_t *dst) {
+  switch (encoding) {
+    case PoseEncoding::Float64: {
+      std::memcpy(dst, src, num * sizeof(double));
+      break;
+    }
+    case PoseEncoding::Float32: {
+      for (size_t k = 0; k < num; ++k) {
+        const auto value = static_cast<float>(src[k]);
+        std::memcpy(dst + k * sizeof(float), &value, sizeof(float));
+      }
+      break;
+    }
+    case PoseEncoding::Float16: {
+      for (size_t k = 0; k < num; ++k) {
+        const uint16_t value = floatToHalf(static_cast<float>(src[k]));
+        std::memcpy(dst + k * sizeof(uint16_t), &value, sizeof(uint16_t));
+      }
+      break;
+    }
+  }
+}
+
+void readScalars(const uint8_t *src, size_t num, PoseEncoding encoding, double *dst) {
+  switch (encoding) {
+    case PoseEncoding::Float64: {
+      std::memcpy(dst, src, num * sizeof(double));
+      break;
+    }
+    case PoseEncoding::Float32: {
+      for (size_t k = 0; k < num; ++k) {
+        float value;
+        std::memcpy(&value, src + k * sizeof(float), sizeof(float));
+        dst[k] = value;
+      }
+      break;
+    }
+    case PoseEncoding::Float16: {
+      for (size_t k = 0; k < num; ++k) {
+        uint16_t value;
+        std::memcpy(&value, src + k * sizeof(uint16_t), sizeof(uint16_t));
+        dst[k] = halfToFloat(value);
+      }
+      break;
+    }
+  }
+}
+
+size_t measurementRecordSize(unsigned d) {
+  return sizeof(MeasurementRecord) + d * (d + 1) * sizeof(double);
+}
+
+MessageHeader makeHeader(MessageType type, PoseEncoding encoding, unsigned sender,
+                         unsigned r, unsigned d) {
+  MessageHeader header{};
+  header.magic = kMessageMagic;
+  header.version = kMessageVersion;
+  header.type = static_cast<uint8_t>(type);
+  header.encoding = static_cast<uint8_t>(encoding);
+  header.sender = sender;
+  header.count = 0;
+  header.r = r;
+  header.d = d;
+  header.flags = 0;
+  header.payloadBytes = 0;
+  return header;
+}
+
+bool isPoseMessage(const MessageHeader &header) {
+  return header.type == static_cast<uint8_t>(MessageType::PoseDict) ||
+      header.type == static_cast<uint8_t>(MessageType::AuxPoseDict);
+}
+
+}  // namespace
+
+std::string PoseEncodingToString(PoseEncoding encoding) {
+  switch (encoding) {
+    case PoseEncoding::Float64: {
+      return "Float64";
+    }
+    case PoseEncoding::Float32: {
+      return "Float32";
+    }
+    case PoseEncoding::Float16: {
+      return "Float16";
+    }
+  }
+  return "";
+}
+
+size_t scalarSize(PoseEncoding encoding) {
+  switch (encoding) {
+    case PoseEncoding::Float64: {
+      return sizeof(double);
+    }
+    case PoseEncoding::Float32: {
+      return sizeof(float);
+    }
+    case PoseEncoding::Float16: {
+      return sizeof(uint16_t);
+    }
+  }
+  LOG(FATAL) << "Unknown pose encoding: " << static_cast<int>(encoding);
+  return 0;
+}
+
+size_t poseMessageSize(size_t num_poses, unsigned r, unsigned d, PoseEncoding encoding, bool rounded) {
+  return sizeof(MessageHeader) + basisSize(r, d, rounded) + num_poses * poseRecordSize(r, d, encoding, rounded);
+}
+
+uint16_t floatToHalf(float value) {
+  uint32_t x;
+  std::memcpy(&x, &value, sizeof(float));
+  const uint32_t sign = (x >> 16) & 0x8000;
+  const uint32_t float_exponent = (x >> 23) & 0xFF;
+  uint32_t mantissa = x & 0x7FFFFF;
+  // Infinity and NaN
+  if (float_exponent == 0xFF)
+    return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+  const int exponent = static_cast<int>(float_exponent) - 127 + 15;
+  // Overflow
+  if (exponent >= 31)
+    return sign | 0x7C00;
+  // Subnormal half precision numbers (or underflow to zero)
+  if (exponent <= 0) {
+    if (exponent < -10)
+      return sign;
+    mantissa |= 0x800000;
+    const int shift = 14 - exponent;
+    uint32_t half = mantissa >> shift;
+    const uint32_t remainder = mantissa & ((1u << shift) - 1);
+    const uint32_t halfway = 1u << (shift - 1);
+    if (remainder > halfway || (remainder == halfway && (half & 1)))
+      half++;
+    return sign | half;
+  }
+  // Normal numbers, round to nearest even (a carry correctly propagates into the exponent)
+  uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+  const uint32_t remainder = mantissa & 0x1FFF;
+  if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+    half++;
+  return sign | half;
+}
+
+float halfToFloat(uint16_t value) {
+  const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+  const uint32_t exponent = (value >> 10) & 0x1F;
+  const uint32_t mantissa = value & 0x3FF;
+  uint32_t x;
+  if (exponent == 0) {
+    // Zero and subnormal numbers
+    const float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+    return sign ? -magnitude : magnitude;
+  } else if (exponent == 31) {
+    x = sign | 0x7F800000 | (mantissa << 13);
+  } else {
+    x = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+  }
+  float result;
+  std::memcpy(&result, &x, sizeof(float));
+  return result;
+}
+
+Matrix computePoseBasis(const std::vector<const double *> &poses, unsigned r, unsigned d) {
+  CHECK_GE(r, d);
+  Matrix gram = Matrix::Zero(r, r);
+  for (const double *pose : poses) {
+    Eigen::Map<const Matrix> Xi(pose, r, d + 1);
+    gram.noalias() += Xi * Xi.transpose();
+  }
+  // Eigenvalues are sorted in increasing order
+  Eigen::SelfAdjointEigenSolver<Matrix> eig(gram);
+  return eig.eigenvectors().rightCols(d);
+}
+
+bool readMessageHeader(const uint8_t *buffer, size_t size, MessageHeader &header) {
+  if (buffer == nullptr || size < sizeof(MessageHeader)) {
+    LOG(WARNING) << "Message is too short to contain a header.";
+    return false;
+  }
+  std::memcpy(&header, buffer, sizeof(MessageHeader));
+  if (header.magic != kMessageMagic) {
+    LOG(WARNING) << "Message has invalid magic number.";
+    return false;
+  }
+  if (header.version != kMessageVersion) {
+    LOG(WARNING) << "Unsupported message version: " << header.version
+                 << " (expected " << kMessageVersion << ").";
+    return false;
+  }
+  if (size < sizeof(MessageHeader) + header.payloadBytes) {
+    LOG(WARNING) << "Message is truncated: expected " << sizeof(MessageHeader) + header.payloadBytes
+                 << " bytes but received " << size << ".";
+    return false;
+  }
+  return true;
+}
+
+PoseMessageWriter::PoseMessageWriter(uint8_t *buffer, size_t capacity, MessageType type,
+                                     unsigned sender, unsigned r, unsigned d,
+                                     PoseEncoding encoding, const Matrix *basis)
+    : buffer_(buffer),
+      capacity_(capacity),
+      offset_(sizeof(MessageHeader)),
+      count_(0),
+      header_(makeHeader(type, encoding, sender, r, d)) {
+  CHECK(type == MessageType::PoseDict || type == MessageType::AuxPoseDict);
+  CHECK_GE(r, d);
+  CHECK_GE(capacity_, poseMessageSize(0, r, d, encoding, basis != nullptr));
+  if (basis) {
+    CHECK_LE(d, 3);
+    CHECK_EQ(basis->rows(), r);
+    CHECK_EQ(basis->cols(), d);
+    basis_.emplace(*basis);
+    header_.flags |= kMessageFlagRounded;
+    std::memcpy(buffer_ + offset_, basis->data(), r * d * sizeof(double));
+    offset_ += r * d * sizeof(double);
+  }
+}
+
+bool PoseMessageWriter::add(const PoseID &pose_id, const double *pose) {
+  const auto encoding = static_cast<PoseEncoding>(header_.encoding);
+  const unsigned r = header_.r;
+  const unsigned d = header_.d;
+  if (offset_ + poseRecordSize(r, d, encoding, basis_.has_value()) > capacity_) {
+    LOG(WARNING) << "Output buffer is full after " << count_ << " poses.";
+    return false;
+  }
+  const uint32_t ids[2] = {static_cast<uint32_t>(pose_id.robot_id),
+                           static_cast<uint32_t>(pose_id.frame_id)};
+  std::memcpy(buffer_ + offset_, ids, kPoseIDBytes);
+  offset_ += kPoseIDBytes;
+  if (basis_) {
+    Eigen::Map<const Matrix> Xi(pose, r, d + 1);
+    CoefficientMatrix coefficients(d, d + 1);
+    coefficients.noalias() = basis_.value().transpose() * Xi;
+    writeScalars(coefficients.data(), d * (d + 1), encoding, buffer_ + offset_);
+    offset_ += d * (d + 1) * scalarSize(encoding);
+  } else {
+    writeScalars(pose, r * (d + 1), encoding, buffer_ + offset_);
+    offset_ += r * (d + 1) * scalarSize(encoding);
+  }
+  count_++;
+  return true;
+}
+
+size_t PoseMessageWriter::finish() {
+  header_.count = count_;
+  header_.payloadBytes = offset_ - sizeof(MessageHeader);
+  std::memcpy(buffer_, &header_, sizeof(MessageHeader));
+  return offset_;
+}
+
+bool PoseMessageView::parse(const uint8_t *buffer, size_t size) {
+  buffer_ = nullptr;
+  basis_.reset();
+  MessageHeader header{};
+  if (!readMessageHeader(buffer, size, header)) return false;
+  if (!isPoseMessage(header)) {
+    LOG(WARNING) << "Message does not contain poses.";
+    return false;
+  }
+  if (header.encoding > static_cast<uint8_t>(PoseEncoding::Float16)) {
+    LOG(WARNING) << "Unknown pose encoding: " << static_cast<int>(header.encoding);
+    return false;
+  }
+  if (header.r < header.d || ((header.flags & kMessageFlagRounded) && header.d > 3)) {
+    LOG(WARNING) << "Pose message has invalid dimensions.";
+    return false;
+  }
+  const auto encoding = static_cast<PoseEncoding>(header.encoding);
+  const bool rounded = header.flags & kMessageFlagRounded;
+  if (header.payloadBytes != basisSize(header.r, header.d, rounded) +
+      header.count * poseRecordSize(header.r, header.d, encoding, rounded)) {
+    LOG(WARNING) << "Pose message has inconsistent payload size.";
+    return false;
+  }
+  if (rounded) {
+    Matrix basis(header.r, header.d);
+    std::memcpy(basis.data(), buffer + sizeof(MessageHeader), basis.size() * sizeof(double));
+    basis_.emplace(basis);
+  }
+  header_ = header;
+  buffer_ = buffer;
+  return true;
+}
+
+const uint8_t *PoseMessageView::record(size_t index) const {
+  CHECK_NOTNULL(buffer_);
+  CHECK_LT(index, header_.count);
+  const auto encoding = static_cast<PoseEncoding>(header_.encoding);
+  const bool rounded = basis_.has_value();
+  return buffer_ + sizeof(MessageHeader) + basisSize(header_.r, header_.d, rounded) +
+      index * poseRecordSize(header_.r, header_.d, encoding, rounded);
+}
+
+PoseID PoseMessageView::poseID(size_t index) const {
+  uint32_t ids[2];
+  std::memcpy(ids, record(index), kPoseIDBytes);
+  return PoseID(ids[0], ids[1]);
+}
+
+void PoseMessageView::copyPose(size_t index, double *pose) const {
+  const uint8_t *src = record(index) + kPoseIDBytes;
+  const auto encoding = static_cast<PoseEncoding>(header_.encoding);
+  const unsigned r = header_.r;
+  const unsigned d = header_.d;
+  if (basis_) {
+    CoefficientMatrix coefficients(d, d + 1);
+    readScalars(src, d * (d + 1), encoding, coefficients.data());
+    Eigen::Map<Matrix> Xi(pose, r, d + 1);
+    Xi.noalias() = basis_.value() * coefficients;
+  } else {
+    readScalars(src, r * (d + 1), encoding, pose);
+  }
+}
+
+size_t encodePoses(const std::vector<PoseID> &pose_ids,
+                   const std::vector<const double *> &poses,
+                   unsigned sender, unsigned r, unsigned d,
+                   const PoseEncodingParameters &params,
+                   std::vector<uint8_t> &buffer,
+                   MessageType type,
+                   double *max_error) {
+  CHECK_EQ(pose_ids.size(), poses.size());
+  // Candidate encodings ordered from the most compact to the most precise
+  std::vector<std::pair<PoseEncoding, bool>> candidates;
+  for (int e = static_cast<int>(params.encoding); e >= 0; --e) {
+    const auto encoding = static_cast<PoseEncoding>(e);
+    if (params.rounded && r > d)
+      candidates.emplace_back(encoding, true);
+    candidates.emplace_back(encoding, false);
+  }
+  std::optional<Matrix> basis;
+  std::vector<double> decoded(r * (d + 1));
+  for (size_t c = 0; c < candidates.size(); ++c) {
+    const PoseEncoding encoding = candidates[c].first;
+    const bool rounded = candidates[c].second;
+    if (rounded && !basis)
+      basis.emplace(computePoseBasis(poses, r, d));
+    buffer.resize(poseMessageSize(poses.size(), r, d, encoding, rounded));
+    PoseMessageWriter writer(buffer.data(), buffer.size(), type, sender, r, d, encoding,
+                             rounded ? &basis.value() : nullptr);
+    for (size_t i = 0; i < poses.size(); ++i) {
+      writer.add(pose_ids[i], poses[i]);
+    }
+    const size_t bytes = writer.finish();
+    // Full precision encoding is lossless
+    const bool last = (c + 1 == candidates.size());
+    if (last && max_error == nullptr)
+      return bytes;
+    // Check reconstruction error
+    PoseMessageView view;
+    CHECK(view.parse(buffer.data(), bytes));
+    double error = 0;
+    for (size_t i = 0; i < poses.size(); ++i) {
+      view.copyPose(i, decoded.data());
+      for (size_t k = 0; k < decoded.size(); ++k) {
+        // Comparison written such that NaN is treated as an error
+        const double e = std::abs(decoded[k] - poses[i][k]);
+        if (!(e <= error)) error = e;
+      }
+    }
+    if (last || error <= params.maxError) {
+      if (max_error) *max_error = error;
+      return bytes;
+    }
+  }
+  return 0;
+}
+
+size_t encodePoseDict(const PoseDict &poses, unsigned sender,
+                      uint8_t *buffer, size_t capacity,
+                      PoseEncoding encoding, MessageType type) {
+  unsigned r = 0;
+  unsigned d = 0;
+  if (!poses.empty()) {
+    r = poses.begin()->second.r();
+    d = poses.begin()->second.d();
+  }
+  if (capacity < poseMessageSize(poses.size(), r, d, encoding)) {
+    LOG(WARNING) << "Output buffer is too small to encode " << poses.size() << " poses.";
+    return 0;
+  }
+  PoseMessageWriter writer(buffer, capacity, type, sender, r, d, encoding);
+  for (const auto &it : poses) {
+    CHECK_EQ(it.second.r(), r);
+    CHECK_EQ(it.second.d(), d);
+    writer.add(it.first, it.second.poseData(0));
+  }
+  return writer.finish();
+}
+
+size_t encodePoseDict(const PoseDict &poses, unsigned sender,
+                      std::vector<uint8_t> &buffer,
+                      const PoseEncodingParameters &params, MessageType type) {
+  unsigned r = 0;
+  unsigned d = 0;
+  if (!poses.empty()) {
+    r = poses.begin()->second.r();
+    d = poses.begin()->second.d();
+  }
+  std::vector<PoseID> pose_ids;
+  std::vector<const double *> pose_data;
+  pose_ids.reserve(poses.size());
+  pose_data.reserve(poses.size());
+  for (const auto &it : poses) {
+    CHECK_EQ(it.second.r(), r);
+    CHECK_EQ(it.second.d(), d);
+    pose_ids.push_back(it.first);
+    pose_data.push_back(it.second.poseData(0));
+  }
+  return encodePoses(pose_ids, pose_data, sender, r, d, params, buffer, type);
+}
+
+bool decodePoseDict(const uint8_t *buffer, size_t size, PoseDict &poses) {
+  poses.clear();
+  PoseMessageView view;
+  if (!view.parse(buffer, size)) return false;
+  const unsigned r = view.header().r;
+  const unsigned d = view.header().d;
+  for (size_t i = 0; i < view.size(); ++i) {
+    LiftedPose pose(r, d);
+    view.copyPose(i, pose.poseData(0));
+    poses.emplace(view.poseID(i), pose);
+  }
+  return true;
+}
+
+size_t statusMessageSize() {
+  return sizeof(MessageHeader) + sizeof(StatusRecord);
+}
+
+size_t encodeStatus(const PGOAgentStatus &status, uint8_t *buffer, size_t capacity) {
+  if (capacity < statusMessageSize()) {
+    LOG(WARNING) << "Output buffer is too small to encode agent status.";
+    return 0;
+  }
+  MessageHeader header = makeHeader(MessageType::AgentStatus, PoseEncoding::Float64, status.agentID, 0, 0);
+  header.count = 1;
+  header.payloadBytes = sizeof(StatusRecord);
+  StatusRecord record{};
+  record.agentID = status.agentID;
+  record.state = static_cast<uint8_t>(status.state);
+  record.readyToTerminate = status.readyToTerminate ? 1 : 0;
+  record.instanceNumber = status.instanceNumber;
+  record.iterationNumber = status.iterationNumber;
+  record.relativeChange = status.relativeChange;
+  std::memcpy(buffer, &header, sizeof(MessageHeader));
+  std::memcpy(buffer + sizeof(MessageHeader), &record, sizeof(StatusRecord));
+  return statusMessageSize();
+}
+
+bool decodeStatus(const uint8_t *buffer, size_t size, PGOAgentStatus &status) {
+  MessageHeader header{};
+  if (!readMessageHeader(buffer, size, header)) return false;
+  if (header.type != static_cast<uint8_t>(MessageType::AgentStatus) ||
+      header.payloadBytes != sizeof(StatusRecord)) {
+    LOG(WARNING) << "Message does not contain agent status.";
+    return false;
+  }
+  StatusRecord record{};
+  std::memcpy(&record, buffer + sizeof(MessageHeader), sizeof(StatusRecord));
+  if (record.state > PGOAgentState::INITIALIZED) {
+    LOG(WARNING) << "Invalid agent state: " << static_cast<int>(record.state);
+    return false;
+  }
+  status = PGOAgentStatus(record.agentID,
+                          static_cast<PGOAgentState>(record.state),
+                          record.instanceNumber,
+                          record.iterationNumber,
+                          record.readyToTerminate != 0,
+                          record.relativeChange);
+  return true;
+}
+
+size_t measurementsMessageSize(size_t num_measurements, unsigned d) {
+  return sizeof(MessageHeader) + num_measurements * measurementRecordSize(d);
+}
+
+size_t encodeMeasurements(const std::vector<RelativeSEMeasurement> &measurements, unsigned sender,
+                          uint8_t *buffer, size_t capacity) {
+  unsigned d = 0;
+  if (!measurements.empty()) d = measurements[0].R.rows();
+  const size_t total = measurementsMessageSize(measurements.size(), d);
+  if (capacity < total) {
+    LOG(WARNING) << "Output buffer is too small to encode " << measurements.size() << " measurements.";
+    return 0;
+  }
+  MessageHeader header = makeHeader(MessageType::Measurements, PoseEncoding::Float64, sender, d, d);
+  header.count = measurements.size();
+  header.payloadBytes = total - sizeof(MessageHeader);
+  std::memcpy(buffer, &header, sizeof(MessageHeader));
+  uint8_t *dst = buffer + sizeof(MessageHeader);
+  for (const auto &m : measurements) {
+    CHECK_EQ(m.R.rows(), d);
+    CHECK_EQ(m.R.cols(), d);
+    CHECK_EQ(m.t.size(), d);
+    MeasurementRecord record{};
+    record.r1 = m.r1;
+    record.r2 = m.r2;
+    record.p1 = m.p1;
+    record.p2 = m.p2;
+    record.kappa = m.kappa;
+    record.tau = m.tau;
+    record.weight = m.weight;
+    record.fixedWeight = m.fixedWeight ? 1 : 0;
+    std::memcpy(dst, &record, sizeof(MeasurementRecord));
+    dst += sizeof(MeasurementRecord);
+    std::memcpy(dst, m.R.data(), d * d * sizeof(double));
+    dst += d * d * sizeof(double);
+    std::memcpy(dst, m.t.data(), d * sizeof(double));
+    dst += d * sizeof(double);
+  }
+  return total;
+}
+
+bool decodeMeasurements(const uint8_t *buffer, size_t size,
+                        std::vector<RelativeSEMeasurement> &measurements) {
+  measurements.clear();
+  MessageHeader header{};
+  if (!readMessageHeader(buffer, size, header)) return false;
+  const unsigned d = header.d;
+  if (header.type != static_cast<uint8_t>(MessageType::Measurements) ||
+      header.payloadBytes != header.count * measurementRecordSize(d)) {
+    LOG(WARNING) << "Message does not contain valid measurements.";
+    return false;
+  }
+  measurements.reserve(header.count);
+  const uint8_t *src = buffer + sizeof(MessageHeader);
+  for (size_t i = 0; i < header.count; ++i) {
+    MeasurementRecord record{};
+    std::memcpy(&record, src, sizeof(MeasurementRecord));
+    src += sizeof(MeasurementRecord);
+    Matrix R(d, d);
+    Vector t(d);
+    std::memcpy(R.data(), src, d * d * sizeof(double));
+    src += d * d * sizeof(double);
+    std::memcpy(t.data(), src, d * sizeof(double));
+    src += d * sizeof(double);
+    RelativeSEMeasurement m(record.r1, record.r2, record.p1, record.p2, R, t, record.kappa, record.tau);
+    m.weight = record.weight;
+    m.fixedWeight = record.fixedWeight != 0;
+    measurements.push_back(m);
+  }
+  return true;
+}
+
+}  // namespace DPGO
@@ -7,14 +7,22 @@
 
 #include <DPGO/DPGO_solver.h>
 #include <DPGO/DPGO_robust.h>
+#include <DPGO/DPGO_trace.h>
 #include <DPGO/PoseGraph.h>
 #include <DPGO/QuadraticOptimizer.h>
+#include <Eigen/CholmodSupport>
 #include <Eigen/Geometry>
+#include <Eigen/IterativeLinearSolvers>
 #include <Eigen/SPQRSupport>
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <numeric>
 #include <random>
+#include <thread>
 #include <boost/math/distributions/chi_squared.hpp>
 #include <glog/logging.h>
 
@@ -42,6 +50,7 @@ void singleTranslationAveraging(Vector &tOpt,
 void singleRotationAveraging(Matrix &ROpt,
                              const std::vector<Matrix> &RVec,
                              const Vector &kappa) {
+  DPGO_TRACE_ZONE("singleRotationAveraging");
   const int n = (int) RVec.size();
   CHECK(n > 0);
   const auto d = RVec[0].rows();
@@ -61,6 +70,7 @@ void singlePoseAveraging(Matrix &ROpt, Vector &tOpt,
                          const std::vector<Vector> &tVec,
                          const Vector &kappa,
                          const Vector &tau) {
+  DPGO_TRACE_ZONE("singlePoseAveraging");
   CHECK(!RVec.empty());
   CHECK(!tVec.empty());
   CHECK(RVec.size() == tVec.size());
@@ -69,67 +79,237 @@ void singlePoseAveraging(Matrix &ROpt, Vector &tOpt,
   singleRotationAveraging(ROpt, RVec, kappa);
 }
 
-void robustSingleRotationAveraging(Matrix &ROpt,
-                                   std::vector<size_t> &inlierIndices,
-                                   const std::vector<Matrix> &RVec,
-                                   const Vector &kappa,
-                                   double errorThreshold) {
-  const double w_tol = 1e-8;
-  const int n = (int) RVec.size();
-  CHECK(n > 0);
-  Vector kappa_ = Vector::Ones(n);
-  Vector weights_ = Vector::Ones(n);
-  if (kappa.rows() == n) {
-    kappa_ = kappa;
+namespace {
+
+/**
+ * @brief Candidate poses for robust averaging in fixed-size storage. Rotation averaging is
+ * pose averaging that ignores the translations.
+ */
+template <int D>
+struct AveragingCandidates {
+  using Rotation = Eigen::Matrix<double, D, D>;
+  using Translation = Eigen::Matrix<double, D, 1>;
+
+  std::vector<Rotation, Eigen::aligned_allocator<Rotation>> R;
+  std::vector<Translation, Eigen::aligned_allocator<Translation>> t;
+  std::vector<double> kappa;
+  std::vector<double> tau;
+  bool useTranslation = false;
+
+  size_t size() const { return R.size(); }
+
+  double squaredResidual(size_t i, const Rotation &ROpt, const Translation &tOpt) const {
+    double rSq = kappa[i] * (ROpt - R[i]).squaredNorm();
+    if (useTranslation) rSq += tau[i] * (tOpt - t[i]).squaredNorm();
+    return rSq;
   }
-  for (const auto &Ri : RVec) {
-    checkRotationMatrix(Ri);
+
+  // Squared distance between two candidates, which is at most the squared sum of their residuals
+  // with respect to any pose
+  double squaredDistance(size_t i, size_t j) const {
+    double dSq = std::min(kappa[i], kappa[j]) * (R[i] - R[j]).squaredNorm();
+    if (useTranslation) dSq += std::min(tau[i], tau[j]) * (t[i] - t[j]).squaredNorm();
+    return dSq;
   }
-  // Initialize estimate
-  singleRotationAveraging(ROpt, RVec, kappa_);
-  Vector rSqVec = Vector::Zero(n);
-  for (Eigen::Index i = 0; i < n; ++i) {
-    rSqVec(i) = kappa_(i) * (ROpt - RVec[i]).squaredNorm();
+
+  void average(const std::vector<double> &weights, Rotation &ROpt, Translation &tOpt) const {
+    Rotation M = Rotation::Zero();
+    Translation s = Translation::Zero();
+    double w = 0;
+    for (size_t i = 0; i < size(); ++i) {
+      if (weights[i] == 0) continue;
+      M += weights[i] * kappa[i] * R[i];
+      if (useTranslation) {
+        s += weights[i] * tau[i] * t[i];
+        w += weights[i] * tau[i];
+      }
+    }
+    Eigen::JacobiSVD<Rotation> svd(M, Eigen::ComputeFullU | Eigen::ComputeFullV);
+    Rotation U = svd.matrixU();
+    if (U.determinant() * svd.matrixV().determinant() <= 0) U.col(D - 1) *= -1;
+    ROpt = U * svd.matrixV().transpose();
+    tOpt = w > 0 ? Translation(s / w) : Translation::Zero();
   }
+};
+
+/**
+ * @brief Greedy search for the largest set of pairwise consistent candidates, i.e., a large clique
+ * of the graph that connects candidates within the given distance. Each candidate, in decreasing
+ * order of degree, seeds a clique that is grown with its common neighbors in the same order;
+ * seeds whose degree cannot improve the best clique are pruned.
+ * @return indices of the candidates in the clique, sorted in increasing order
+ */
+template <int D>
+std::vector<size_t> largestConsistentSet(const AveragingCandidates<D> &candidates, double maxDistance) {
+  const size_t n = candidates.size();
+  const size_t words = (n + 63) / 64;
+  const double maxDistanceSq = maxDistance * maxDistance;
+  std::vector<uint64_t> adjacency(n * words, 0);
+  std::vector<size_t> degree(n, 0);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = i + 1; j < n; ++j) {
+      if (candidates.squaredDistance(i, j) > maxDistanceSq) continue;
+      adjacency[i * words + j / 64] |= uint64_t(1) << (j % 64);
+      adjacency[j * words + i / 64] |= uint64_t(1) << (i % 64);
+      degree[i]++;
+      degree[j]++;
+    }
+  }
+  std::vector<size_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return degree[a] > degree[b]; });
+
+  std::vector<size_t> best, clique;
+  std::vector<uint64_t> common(words);
+  for (size_t seed : order) {
+    if (degree[seed] + 1 <= best.size()) break;
+    clique.assign(1, seed);
+    std::copy_n(adjacency.begin() + seed * words, words, common.begin());
+    for (size_t v : order) {
+      if (!((common[v / 64] >> (v % 64)) & 1)) continue;
+      clique.push_back(v);
+      for (size_t w = 0; w < words; ++w) common[w] &= adjacency[v * words + w];
+    }
+    if (clique.size() > best.size()) best.swap(clique);
+  }
+  std::sort(best.begin(), best.end());
+  return best;
+}
+
+/**
+ * @brief Robust averaging with GNC, seeded by the largest set of pairwise consistent candidates.
+ * Inliers are within errorThreshold of the solution and hence within 2 * errorThreshold of each
+ * other, so GNC only needs to reweight the consistent set, starting from its average. Candidates
+ * outside the set are readmitted at the end if they are within errorThreshold of the solution.
+ */
+template <int D>
+void robustAveraging(const AveragingCandidates<D> &candidates,
+                     double errorThreshold,
+                     unsigned maxNumIters,
+                     typename AveragingCandidates<D>::Rotation &ROpt,
+                     typename AveragingCandidates<D>::Translation &tOpt,
+                     std::vector<size_t> &inlierIndices) {
+  const double w_tol = 1e-8;
+  const size_t n = candidates.size();
+  const std::vector<size_t> consistent = largestConsistentSet(candidates, 2 * errorThreshold);
+  const auto m = (Eigen::Index) consistent.size();
+  std::vector<double> weights(n, 0);
+  for (size_t i : consistent) weights[i] = 1;
+  candidates.average(weights, ROpt, tOpt);
+
+  Vector residuals(m);
+  Vector gncWeights(m);
+  auto computeResiduals = [&]() {
+    for (Eigen::Index k = 0; k < m; ++k)
+      residuals(k) = std::sqrt(candidates.squaredResidual(consistent[k], ROpt, tOpt));
+  };
+  computeResiduals();
   // Initialize robust cost
-  double barc = errorThreshold;
-  double barcSq = barc * barc;
-  double muInit = barcSq / (2 * rSqVec.maxCoeff() - barcSq);
-  muInit = std::min(muInit, 1e-5);
+  const double barcSq = errorThreshold * errorThreshold;
+  const double rMax = residuals.maxCoeff();
+  const double muInit = barcSq / (2 * rMax * rMax - barcSq);
   // Negative values of initial mu corresponds to small residual errors. In this case skip applying GNC.
   if (muInit > 0) {
     RobustCostParameters params;
     params.costType = RobustCostParameters::Type::GNC_TLS;
-    params.GNCBarc = barc;
-    params.GNCMaxNumIters = 1000;
+    params.GNCBarc = errorThreshold;
+    params.GNCMaxNumIters = maxNumIters;
     params.GNCInitMu = muInit;
     RobustCost cost(params);
-    for (unsigned iter = 0; iter < params.GNCMaxNumIters; ++iter) {
-      // Update solution
-      singleRotationAveraging(ROpt, RVec, kappa_.cwiseProduct(weights_));
+    for (unsigned iter = 0; iter < maxNumIters; ++iter) {
       // Update weight
-      int nc = 0;
-      for (Eigen::Index i = 0; i < n; ++i) {
-        double rSq = kappa_(i) * (ROpt - RVec[i]).squaredNorm();
-        double wi = cost.weight(sqrt(rSq));
-        if (wi < w_tol || wi > 1 - w_tol) {
-          nc++;
-        }
-        weights_(i) = wi;
-      }
-      if (nc == n) {
-        break;
-      }
+      cost.weights(residuals, gncWeights);
+      for (Eigen::Index k = 0; k < m; ++k) weights[consistent[k]] = gncWeights(k);
+      const Eigen::Index nc = (gncWeights.array() < w_tol || gncWeights.array() > 1 - w_tol).count();
+      if (nc == m) break;
       // Update GNC
       cost.update();
+      // Update solution
+      candidates.average(weights, ROpt, tOpt);
+      computeResiduals();
     }
   }
   // Retrieve inliers
   inlierIndices.clear();
-  for (Eigen::Index i = 0; i < n; ++i) {
-    double wi = weights_(i);
-    if (wi > 1 - w_tol) {
+  bool readmitted = false;
+  for (size_t i = 0; i < n; ++i) {
+    if (weights[i] > 1 - w_tol) {
+      inlierIndices.push_back(i);
+    } else if (!std::binary_search(consistent.begin(), consistent.end(), i) &&
+               candidates.squaredResidual(i, ROpt, tOpt) < barcSq) {
       inlierIndices.push_back(i);
+      readmitted = true;
+    }
+  }
+  if (readmitted) {
+    std::fill(weights.begin(), weights.end(), 0);
+    for (size_t i : inlierIndices) weights[i] = 1;
+    candidates.average(weights, ROpt, tOpt);
+  }
+}
+
+template <int D>
+void robustAveraging(const std::vector<Matrix> &RVec,
+                     const std::vector<Vector> *tVec,
+                     const Vector &kappa,
+                     const Vector &tau,
+                     double errorThreshold,
+                     unsigned maxNumIters,
+                     Matrix &ROpt,
+                     Vector *tOpt,
+                     std::vector<size_t> &inlierIndices) {
+  const size_t n = RVec.size();
+  AveragingCandidates<D> candidates;
+  candidates.useTranslation = tVec != nullptr;
+  candidates.R.resize(n);
+  candidates.t.assign(n, AveragingCandidates<D>::Translation::Zero());
+  candidates.kappa.assign(kappa.data(), kappa.data() + n);
+  candidates.tau.assign(n, 0);
+  for (size_t i = 0; i < n; ++i) {
+    CHECK_EQ(RVec[i].rows(), D);
+    candidates.R[i] = RVec[i];
+    if (tVec) {
+      CHECK_EQ((*tVec)[i].rows(), D);
+      candidates.t[i] = (*tVec)[i];
+      candidates.tau[i] = tau(i);
+    }
+  }
+  typename AveragingCandidates<D>::Rotation R;
+  typename AveragingCandidates<D>::Translation t;
+  robustAveraging(candidates, errorThreshold, maxNumIters, R, t, inlierIndices);
+  ROpt = R;
+  if (tOpt) *tOpt = t;
+}
+
+}  // namespace
+
+void robustSingleRotationAveraging(Matrix &ROpt,
+                                   std::vector<size_t> &inlierIndices,
+                                   const std::vector<Matrix> &RVec,
+                                   const Vector &kappa,
+                                   double errorThreshold) {
+  DPGO_TRACE_ZONE("robustSingleRotationAveraging");
+  const int n = (int) RVec.size();
+  CHECK(n > 0);
+  Vector kappa_ = Vector::Ones(n);
+  if (kappa.rows() == n) {
+    kappa_ = kappa;
+  }
+  for (const auto &Ri : RVec) {
+    checkRotationMatrix(Ri);
+  }
+  const unsigned maxNumIters = 1000;
+  switch (RVec[0].rows()) {
+    case 2: {
+      robustAveraging<2>(RVec, nullptr, kappa_, kappa_, errorThreshold, maxNumIters, ROpt, nullptr, inlierIndices);
+      break;
+    }
+    case 3: {
+      robustAveraging<3>(RVec, nullptr, kappa_, kappa_, errorThreshold, maxNumIters, ROpt, nullptr, inlierIndices);
+      break;
+    }
+    default: {
+      LOG(FATAL) << "Robust rotation averaging only supports 2D and 3D rotations.";
     }
   }
 }
@@ -141,13 +321,12 @@ void robustSinglePoseAveraging(Matrix &ROpt, Vector &tOpt,
                                const Vector &kappa,
                                const Vector &tau,
                                double errorThreshold) {
-  const double w_tol = 1e-8;
+  DPGO_TRACE_ZONE("robustSinglePoseAveraging");
   const int n = (int) RVec.size();
   CHECK(n > 0);
   CHECK(tVec.size() == RVec.size());
   Vector kappa_ = 10000 * Vector::Ones(n);
   Vector tau_ = 100 * Vector::Ones(n);
-  Vector weights_ = Vector::Ones(n);
   if (kappa.rows() == n) {
     kappa_ = kappa;
   }
@@ -157,69 +336,104 @@ void robustSinglePoseAveraging(Matrix &ROpt, Vector &tOpt,
   for (const auto &Ri : RVec) {
     checkRotationMatrix(Ri);
   }
-  // Initialize estimate
-  singlePoseAveraging(ROpt,
-                      tOpt,
-                      RVec,
-                      tVec,
-                      kappa_.cwiseProduct(weights_),
-                      tau_.cwiseProduct(weights_));
-  Vector rSqVec = Vector::Zero(n);
-  for (Eigen::Index i = 0; i < n; ++i) {
-    rSqVec(i) = kappa_(i) * (ROpt - RVec[i]).squaredNorm() + tau_(i) * (tOpt - tVec[i]).squaredNorm();
-  }
-  // Initialize robust cost
-  double barc = errorThreshold;
-  double barcSq = barc * barc;
-  double muInit = barcSq / (2 * rSqVec.maxCoeff() - barcSq);
-  muInit = std::min(muInit, 1e-5);
-  // Negative values of initial mu corresponds to small residual errors. In this case skip applying GNC.
-  if (muInit > 0) {
-    RobustCostParameters params;
-    params.costType = RobustCostParameters::Type::GNC_TLS;
-    params.GNCBarc = barc;
-    params.GNCMaxNumIters = 10000;
-    params.GNCInitMu = muInit;
-    RobustCost cost(params);
-    unsigned iter = 0;
-    for (iter = 0; iter < params.GNCMaxNumIters; ++iter) {
-      // Update solution
-      singlePoseAveraging(ROpt,
-                          tOpt,
-                          RVec,
-                          tVec,
-                          kappa_.cwiseProduct(weights_),
-                          tau_.cwiseProduct(weights_));
-      // Update weight
-      int nc = 0;
-      for (Eigen::Index i = 0; i < n; ++i) {
-        double rSq = kappa_(i) * (ROpt - RVec[i]).squaredNorm() + tau_(i) * (tOpt - tVec[i]).squaredNorm();
-        double wi = cost.weight(sqrt(rSq));
-        if (wi < w_tol || wi > 1 - w_tol) {
-          nc++;
-        }
-        weights_(i) = wi;
-      }
-      if (nc == n) {
-        break;
-      }
-      // Update GNC
-      cost.update();
+  const unsigned maxNumIters = 10000;
+  switch (RVec[0].rows()) {
+    case 2: {
+      robustAveraging<2>(RVec, &tVec, kappa_, tau_, errorThreshold, maxNumIters, ROpt, &tOpt, inlierIndices);
+      break;
+    }
+    case 3: {
+      robustAveraging<3>(RVec, &tVec, kappa_, tau_, errorThreshold, maxNumIters, ROpt, &tOpt, inlierIndices);
+      break;
+    }
+    default: {
+      LOG(FATAL) << "Robust pose averaging only supports 2D and 3D poses.";
     }
   }
-  // Retrieve inliers
-  inlierIndices.clear();
-  for (Eigen::Index i = 0; i < n; ++i) {
-    double wi = weights_(i);
-    if (wi > 1 - w_tol) {
-      inlierIndices.push_back(i);
+}
+
+namespace {
+
+/**
+ * @brief Solve the symmetric positive definite system L * X = B with supernodal Cholesky
+ * factorization (InitializationMethod::ChordalCholesky) or conjugate gradient preconditioned
+ * by incomplete Cholesky factorization (InitializationMethod::ChordalCG)
+ * @return false if the factorization fails or the iterations do not converge
+ */
+bool solveNormalEquations(const SparseMatrix &L, const Matrix &B, InitializationMethod method, Matrix &X) {
+  if (method == InitializationMethod::ChordalCG) {
+    Eigen::ConjugateGradient<SparseMatrix, Eigen::Lower | Eigen::Upper, Eigen::IncompleteCholesky<double>> solver;
+    solver.setTolerance(1e-8);
+    solver.compute(L);
+    if (solver.info() != Eigen::Success) {
+      LOG(WARNING) << "Incomplete Cholesky factorization failed.";
+      return false;
     }
+    X = solver.solve(B);
+    if (solver.info() != Eigen::Success) {
+      LOG(WARNING) << "Conjugate gradient did not converge after " << solver.iterations()
+                   << " iterations (error " << solver.error() << ").";
+      return false;
+    }
+    return true;
+  }
+  CholmodSolver solver;
+  solver.setMode(Eigen::CholmodSupernodalLLt);
+  solver.compute(L);
+  if (solver.info() != Eigen::Success) {
+    LOG(WARNING) << "Cholesky factorization failed.";
+    return false;
   }
+  X = solver.solve(B);
+  return solver.info() == Eigen::Success;
 }
 
-PoseArray chordalInitialization(const std::vector<RelativeSEMeasurement> &measurements) {
+}  // namespace
+
+PoseArray chordalInitialization(const std::vector<RelativeSEMeasurement> &measurements,
+                                InitializationMethod method) {
+  DPGO_TRACE_ZONE("chordalInitialization");
   size_t dimension, num_poses;
   get_dimension_and_num_poses(measurements, dimension, num_poses);
+
+  if (method == InitializationMethod::ChordalCholesky || method == InitializationMethod::ChordalCG) {
+    const size_t d = dimension;
+    PoseArray output(dimension, num_poses);
+    output.rotation(0) = Matrix::Identity(d, d);
+    output.translation(0) = Vector::Zero(d);
+    if (num_poses == 1) return output;
+
+    // Recover rotations
+    SparseMatrix LR;
+    Matrix BR, Y;
+    constructRotationNormalEquations(measurements, num_poses, LR, BR);
+    if (!solveNormalEquations(LR, BR, method, Y)) {
+      LOG(WARNING) << "Failed to solve for rotations. Falling back to sparse QR.";
+      return chordalInitialization(measurements, InitializationMethod::Chordal);
+    }
+    Matrix Rchordal(d, d * num_poses);
+    Rchordal.leftCols(d) = Matrix::Identity(d, d);
+    for (size_t i = 1; i < num_poses; i++)
+      Rchordal.block(0, i * d, d, d) = projectToRotationGroup(Y.block((i - 1) * d, 0, d, d).transpose());
+
+    // Recover translations
+    SparseMatrix LT;
+    Matrix BT, T;
+    constructTranslationNormalEquations(measurements, Rchordal, LT, BT);
+    if (!solveNormalEquations(LT, BT, method, T)) {
+      LOG(WARNING) << "Failed to solve for translations. Falling back to sparse QR.";
+      return chordalInitialization(measurements, InitializationMethod::Chordal);
+    }
+
+    for (size_t i = 1; i < num_poses; i++) {
+      output.rotation(i) = Rchordal.block(0, i * d, d, d);
+      output.translation(i) = T.row(i - 1).transpose();
+    }
+    return output;
+  }
+  CHECK(method == InitializationMethod::Chordal)
+      << "Unsupported chordal initialization method: " << InitializationMethodToString(method);
+
   SparseMatrix B1, B2, B3;
   constructBMatrices(measurements, B1, B2, B3);
 
@@ -302,6 +516,146 @@ PoseArray odometryInitialization(
   return T;
 }
 
+namespace {
+
+/**
+ * @brief Disjoint sets of poses with path halving and union by size
+ */
+class DisjointSets {
+ public:
+  explicit DisjointSets(size_t n) : parent_(n), size_(n, 1) {
+    std::iota(parent_.begin(), parent_.end(), 0);
+  }
+  size_t find(size_t x) {
+    while (parent_[x] != x) {
+      parent_[x] = parent_[parent_[x]];
+      x = parent_[x];
+    }
+    return x;
+  }
+  // Return false if a and b are already in the same set
+  bool merge(size_t a, size_t b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) return false;
+    if (size_[a] < size_[b]) std::swap(a, b);
+    parent_[b] = a;
+    size_[a] += size_[b];
+    return true;
+  }
+
+ private:
+  std::vector<size_t> parent_;
+  std::vector<size_t> size_;
+};
+
+// Minimum number of poses per thread when composing the transforms of a BFS level
+constexpr size_t kMinPosesPerThread = 4096;
+
+}  // namespace
+
+PoseArray spanningTreeInitialization(const std::vector<RelativeSEMeasurement> &measurements,
+                                     unsigned numThreads) {
+  DPGO_TRACE_ZONE("spanningTreeInitialization");
+  CHECK(!measurements.empty()) << "Cannot compute spanning tree initialization without measurements.";
+  size_t dimension, num_poses;
+  get_dimension_and_num_poses(measurements, dimension, num_poses);
+  const size_t num_threads = numThreads > 0 ? numThreads : std::max(1u, std::thread::hardware_concurrency());
+
+  // Kruskal's algorithm with measurements sorted by increasing variance
+  std::vector<double> variance(measurements.size());
+  for (size_t e = 0; e < measurements.size(); ++e) {
+    const auto &m = measurements[e];
+    variance[e] = m.weight > 0 ? (1 / m.kappa + 1 / m.tau) / m.weight : std::numeric_limits<double>::infinity();
+  }
+  std::vector<size_t> sorted(measurements.size());
+  std::iota(sorted.begin(), sorted.end(), 0);
+  std::stable_sort(sorted.begin(), sorted.end(), [&](size_t a, size_t b) { return variance[a] < variance[b]; });
+  DisjointSets sets(num_poses);
+  std::vector<size_t> tree_edges;
+  tree_edges.reserve(num_poses - 1);
+  for (size_t e : sorted) {
+    if (tree_edges.size() + 1 == num_poses) break;
+    if (sets.merge(measurements[e].p1, measurements[e].p2)) tree_edges.push_back(e);
+  }
+
+  // Adjacency of the spanning tree (measurement indices) in compressed row format
+  std::vector<size_t> offsets(num_poses + 1, 0);
+  for (size_t e : tree_edges) {
+    offsets[measurements[e].p1 + 1]++;
+    offsets[measurements[e].p2 + 1]++;
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+  std::vector<size_t> adjacency(offsets.back());
+  std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+  for (size_t e : tree_edges) {
+    adjacency[fill[measurements[e].p1]++] = e;
+    adjacency[fill[measurements[e].p2]++] = e;
+  }
+
+  // Compose relative transforms level by level from the root of each component
+  PoseArray T(dimension, num_poses);
+  std::vector<size_t> parent_edge(num_poses);
+  std::vector<bool> visited(num_poses, false);
+  auto compose = [&](size_t child) {
+    const RelativeSEMeasurement &m = measurements[parent_edge[child]];
+    const size_t parent = (m.p2 == child) ? m.p1 : m.p2;
+    const Matrix Rp = T.rotation(parent);
+    const Vector tp = T.translation(parent);
+    if (m.p2 == child) {
+      T.rotation(child) = Rp * m.R;
+      T.translation(child) = tp + Rp * m.t;
+    } else {
+      T.rotation(child) = Rp * m.R.transpose();
+      T.translation(child) = tp - Rp * m.R.transpose() * m.t;
+    }
+  };
+  auto composeRange = [&](const std::vector<size_t> &level, size_t begin, size_t end) {
+    for (size_t k = begin; k < end; ++k) compose(level[k]);
+  };
+
+  size_t num_components = 0;
+  std::vector<size_t> level, next_level;
+  for (size_t root = 0; root < num_poses; ++root) {
+    if (visited[root]) continue;
+    num_components++;
+    visited[root] = true;
+    T.pose(root) = Pose::Identity(dimension).getData();
+    level.assign(1, root);
+    while (!level.empty()) {
+      next_level.clear();
+      for (size_t pose : level) {
+        for (size_t k = offsets[pose]; k < offsets[pose + 1]; ++k) {
+          const size_t e = adjacency[k];
+          const size_t neighbor = (measurements[e].p1 == pose) ? measurements[e].p2 : measurements[e].p1;
+          if (visited[neighbor]) continue;
+          visited[neighbor] = true;
+          parent_edge[neighbor] = e;
+          next_level.push_back(neighbor);
+        }
+      }
+      // Poses in the same level only depend on poses in the previous level
+      const size_t num_workers = std::min(num_threads, next_level.size() / kMinPosesPerThread);
+      if (num_workers <= 1) {
+        composeRange(next_level, 0, next_level.size());
+      } else {
+        std::vector<std::thread> threads;
+        for (size_t w = 0; w < num_workers; ++w) {
+          threads.emplace_back(composeRange, std::cref(next_level),
+                               w * next_level.size() / num_workers,
+                               (w + 1) * next_level.size() / num_workers);
+        }
+        for (auto &thread : threads) thread.join();
+      }
+      level.swap(next_level);
+    }
+  }
+  LOG_IF(WARNING, num_components > 1)
+      << "Measurement graph has " << num_components
+      << " connected components, each initialized in the frame of its first pose.";
+  return T;
+}
+
 PoseArray solvePGO(const std::vector<RelativeSEMeasurement> &measurements,
                    const ROptParameters &params,
                    const PoseArray *T0) {
@@ -332,6 +686,149 @@ PoseArray solvePGO(const std::vector<RelativeSEMeasurement> &measurements,
   return T;
 }
 
+namespace {
+
+// Project the rotation blocks of a lifted trajectory to the Stiefel manifold
+void retractToStiefel(Matrix &Y, unsigned d) {
+  const size_t n = Y.cols() / (d + 1);
+  for (size_t i = 0; i < n; ++i) {
+    Y.block(0, i * (d + 1), Y.rows(), d) = projectToStiefelManifold(Y.block(0, i * (d + 1), Y.rows(), d));
+  }
+}
+
+CertifiedPGOResult riemannianStaircase(const std::vector<RelativeSEMeasurement> &measurements,
+                                       const SparseMatrix &Q,
+                                       unsigned robot_id,
+                                       unsigned d,
+                                       const Matrix &T0,
+                                       const solveCertifiedPGOParams &params,
+                                       unsigned start) {
+  const size_t n = T0.cols() / (d + 1);
+  const unsigned r_min = std::max(params.r_min, d);
+  const unsigned r_max = std::max(params.r_max, r_min);
+  auto cost = [&](const Matrix &Y) { return 0.5 * ((Y * Q).cwiseProduct(Y)).sum(); };
+  CertifiedPGOResult result(d, n);
+  result.start = start;
+  Matrix Y = Matrix::Zero(r_min, T0.cols());
+  Y.topRows(d) = T0;
+  for (unsigned r = r_min; r <= r_max; ++r) {
+    auto pose_graph = std::make_shared<PoseGraph>(robot_id, r, d);
+    pose_graph->setMeasurements(measurements);
+    QuadraticProblem problem(pose_graph);
+    QuadraticOptimizer optimizer(&problem, params.opt_params);
+    Y = optimizer.optimize(Y);
+
+    // Verify global optimality
+    const SparseMatrix S = constructCertificateMatrix(Q, Y, d);
+    Vector v;
+    double curvature = 0;
+    result.certified = verifyCertificateMatrix(S, params.eig_tol, v, curvature);
+    result.curvature = curvature;
+    if (params.verbose) {
+      LOG(INFO) << "[solveCertifiedPGO] Start " << start << ", rank " << r << ": cost " << cost(Y)
+                << (result.certified ? ", certified." : ", not certified (curvature " + std::to_string(curvature) + ").");
+    }
+    if (result.certified || r == r_max || v.size() == 0) break;
+
+    // Escape the saddle point along the direction of negative curvature at the next rank
+    const double f = cost(Y);
+    Matrix YPlus = Matrix::Zero(r + 1, Y.cols());
+    YPlus.topRows(r) = Y;
+    bool escaped = false;
+    for (double alpha = 1; alpha >= params.min_escape_stepsize; alpha /= 2) {
+      Matrix YTest = YPlus;
+      YTest.row(r) = alpha * v.transpose();
+      retractToStiefel(YTest, d);
+      if (cost(YTest) < f) {
+        Y = YTest;
+        escaped = true;
+        break;
+      }
+    }
+    if (!escaped) {
+      LOG(WARNING) << "[solveCertifiedPGO] Start " << start << " failed to escape saddle point at rank " << r << ".";
+      break;
+    }
+  }
+  result.Y = Y;
+  result.rank = Y.rows();
+  result.fRelaxed = cost(Y);
+  result.T.setData(roundSolution(Y, d));
+  result.fRounded = cost(result.T.getData());
+  return result;
+}
+
+}  // namespace
+
+CertifiedPGOResult solveCertifiedPGO(const std::vector<RelativeSEMeasurement> &measurements,
+                                     const solveCertifiedPGOParams &params,
+                                     const PoseArray *T0) {
+  DPGO_TRACE_ZONE("solveCertifiedPGO");
+  CHECK(!measurements.empty()) << "Cannot solve pose graph optimization without measurements.";
+  size_t dimension, num_poses;
+  get_dimension_and_num_poses(measurements, dimension, num_poses);
+  const unsigned robot_id = measurements[0].r1;
+  auto pose_graph = std::make_shared<PoseGraph>(robot_id, dimension, dimension);
+  pose_graph->setMeasurements(measurements);
+  const SparseMatrix Q = pose_graph->quadraticMatrix();
+
+  // Initializations
+  const unsigned num_starts = std::max(1u, params.num_starts);
+  std::vector<Matrix> inits;
+  if (T0) {
+    CHECK_EQ(T0->d(), dimension);
+    CHECK_EQ(T0->n(), num_poses);
+    inits.push_back(T0->getData());
+  } else {
+    inits.push_back(chordalInitialization(measurements).getData());
+  }
+  if (num_starts > 1) inits.push_back(spanningTreeInitialization(measurements).getData());
+  std::mt19937 rng(params.seed);
+  std::normal_distribution<double> normal;
+  while (inits.size() < num_starts) {
+    Matrix T = Matrix::Zero(dimension, (dimension + 1) * num_poses);
+    for (size_t i = 0; i < num_poses; ++i) {
+      Matrix A(dimension, dimension);
+      for (Eigen::Index k = 0; k < A.size(); ++k) A(k) = normal(rng);
+      T.block(0, i * (dimension + 1), dimension, dimension) = projectToRotationGroup(A);
+    }
+    inits.push_back(T);
+  }
+
+  // Solve the initializations in parallel
+  std::vector<CertifiedPGOResult> results(num_starts, CertifiedPGOResult(dimension, num_poses));
+  unsigned num_threads = params.num_threads ? params.num_threads : std::max(1u, std::thread::hardware_concurrency());
+  num_threads = std::min(num_threads, num_starts);
+  std::atomic<unsigned> next_start(0);
+  auto worker = [&]() {
+    for (unsigned s = next_start++; s < num_starts; s = next_start++) {
+      results[s] = riemannianStaircase(measurements, Q, robot_id, dimension, inits[s], params, s);
+    }
+  };
+  if (num_threads == 1) {
+    worker();
+  } else {
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < num_threads; ++t) threads.emplace_back(worker);
+    for (auto &thread : threads) thread.join();
+  }
+
+  size_t best = 0;
+  for (size_t s = 1; s < results.size(); ++s) {
+    if (results[s].certified != results[best].certified) {
+      if (results[s].certified) best = s;
+    } else if (results[s].fRounded < results[best].fRounded) {
+      best = s;
+    }
+  }
+  if (params.verbose) {
+    LOG(INFO) << "[solveCertifiedPGO] Best solution from start " << best << " at rank " << results[best].rank
+              << ": relaxed cost " << results[best].fRelaxed << ", rounded cost " << results[best].fRounded
+              << (results[best].certified ? " (certified)." : " (not certified).");
+  }
+  return results[best];
+}
+
 PoseArray solveRobustPGO(std::vector<RelativeSEMeasurement> &mutable_measurements,
                          const solveRobustPGOParams &params,
                          const PoseArray *T0) {
@@ -341,16 +838,27 @@ PoseArray solveRobustPGO(std::vector<RelativeSEMeasurement> &mutable_measurement
   const int m = (int) mutable_measurements.size();
   // Initialize estimate
   PoseArray T = solvePGO(mutable_measurements, params.opt_params, T0);
-  Vector rSqVec = Vector::Zero(m);
-  for (int i = 0; i < m; ++i) {
-    RelativeSEMeasurement &meas = mutable_measurements[i];
-    meas.weight = 1.0;
-    rSqVec(i) = computeMeasurementError(meas,
-                                        T.rotation(meas.p1),
-                                        T.translation(meas.p1),
-                                        T.rotation(meas.p2),
-                                        T.translation(meas.p2));
-  }
+  // Residuals of the evaluated measurements are computed in batch from the current solution
+  std::vector<int> evaluated(m);
+  std::iota(evaluated.begin(), evaluated.end(), 0);
+  std::vector<RelativeSEMeasurement *> measurement_ptrs;
+  std::vector<const double *> poses1, poses2;
+  Vector residuals, weights;
+  auto computeResiduals = [&]() {
+    measurement_ptrs.clear();
+    poses1.clear();
+    poses2.clear();
+    for (int i : evaluated) {
+      RelativeSEMeasurement &meas = mutable_measurements[i];
+      measurement_ptrs.push_back(&meas);
+      poses1.push_back(T.poseData(meas.p1));
+      poses2.push_back(T.poseData(meas.p2));
+    }
+    computeMeasurementResiduals(measurement_ptrs, poses1, poses2, dimension, residuals);
+  };
+  for (auto &meas : mutable_measurements) meas.weight = 1.0;
+  computeResiduals();
+  Vector rSqVec = residuals.array().square();
   // Initialize robust cost
   CHECK(params.robust_params.costType == RobustCostParameters::Type::GNC_TLS);
   double barc = params.robust_params.GNCBarc;
@@ -366,21 +874,19 @@ PoseArray solveRobustPGO(std::vector<RelativeSEMeasurement> &mutable_measurement
   // Negative values of initial mu corresponds to small residual errors. In this case skip applying GNC.
   if (muInit > 0) {
     RobustCost cost(params_gnc);
+    evaluated.erase(std::remove_if(evaluated.begin(), evaluated.end(),
+                                   [&](int i) { return mutable_measurements[i].fixedWeight; }),
+                    evaluated.end());
     unsigned iter = 0;
     for (iter = 0; iter < params_gnc.GNCMaxNumIters; ++iter) {
       // Update solution
       T = solvePGO(mutable_measurements, params.opt_params, T0);
       // Update weight
-      for (int i = 0; i < m; ++i) {
-        RelativeSEMeasurement &meas = mutable_measurements[i];
-        if (meas.fixedWeight) continue;
-        double rSq = computeMeasurementError(meas,
-                                             T.rotation(meas.p1),
-                                             T.translation(meas.p1),
-                                             T.rotation(meas.p2),
-                                             T.translation(meas.p2));
-        meas.weight = cost.weight(sqrt(rSq));
-        // LOG(INFO) << "Residual:" << sqrt(rSq) << ", weight=" << meas.weight;
+      computeResiduals();
+      cost.weights(residuals, weights);
+      for (size_t k = 0; k < evaluated.size(); ++k) {
+        RelativeSEMeasurement &meas = mutable_measurements[evaluated[k]];
+        meas.weight = weights(k);
       }
       // Compute stats
       int num_inliers = 0;
@@ -404,7 +910,14 @@ PoseArray solveRobustPGO(std::vector<RelativeSEMeasurement> &mutable_measurement
         break;
       }
       // Update GNC
-      cost.update();
+      const double undecided_ratio = (double) num_undecided / (num_inliers + num_outliers + num_undecided);
+      if (cost.isAdaptiveGNC()) {
+        // Freeze measurements whose weights settled
+        evaluated.erase(std::remove_if(evaluated.begin(), evaluated.end(),
+                                       [&](int i) { return cost.isSettled(mutable_measurements[i].weight); }),
+                        evaluated.end());
+      }
+      cost.update(undecided_ratio);
     }
   }
   T = solvePGO(mutable_measurements, params.opt_params, T0);
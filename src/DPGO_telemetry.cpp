@@ -0,0 +1,144 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <DPGO/DPGO_telemetry.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <type_traits>
+
+namespace DPGO {
+
+namespace {
+size_t roundUpToPowerOfTwo(size_t n) {
+  size_t result = 1;
+  while (result < n) result <<= 1;
+  return result;
+}
+
+// Fields in output order, shared by the CSV and JSON writers
+template<typename Visitor>
+void visitFields(const IterationTelemetry &t, Visitor &&visit) {
+  visit("iteration", t.iteration);
+  visit("timestamp_us", t.timestampUs);
+  visit("optimized", static_cast<int>(t.optimized));
+  visit("iteration_ms", t.iterationMs);
+  visit("solve_ms", t.solveMs);
+  visit("construct_Q_ms", t.constructQMs);
+  visit("construct_G_ms", t.constructGMs);
+  visit("construct_precon_ms", t.constructPreconMs);
+  visit("lock_wait_ms", t.lockWaitMs);
+  visit("rtr_iterations", t.RTRIterations);
+  visit("tcg_iterations", t.tCGIterations);
+  visit("tcg_status", t.tCGStatus);
+  visit("cost", t.cost);
+  visit("grad_norm", t.gradNorm);
+  visit("relative_change", t.relativeChange);
+  visit("bytes_sent", t.bytesSent);
+  visit("bytes_received", t.bytesReceived);
+}
+}  // namespace
+
+TelemetryRing::TelemetryRing(size_t capacity)
+    : mask_(roundUpToPowerOfTwo(std::max<size_t>(1, capacity)) - 1),
+      slots_(new Slot[mask_ + 1]) {}
+
+void TelemetryRing::push(const IterationTelemetry &record) {
+  const uint64_t index = head_.load(std::memory_order_relaxed);
+  Slot &slot = slots_[index & mask_];
+  slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.record = record;
+  slot.sequence.store(2 * index + 2, std::memory_order_release);
+  head_.store(index + 1, std::memory_order_release);
+}
+
+bool TelemetryRing::read(uint64_t index, IterationTelemetry &record) const {
+  const Slot &slot = slots_[index & mask_];
+  const uint64_t expected = 2 * index + 2;
+  if (slot.sequence.load(std::memory_order_acquire) != expected)
+    return false;
+  record = slot.record;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot.sequence.load(std::memory_order_relaxed) == expected;
+}
+
+std::vector<IterationTelemetry> TelemetryRing::records(size_t maxRecords) const {
+  const uint64_t head = numRecorded();
+  const uint64_t count = std::min<uint64_t>({head, capacity(), maxRecords});
+  std::vector<IterationTelemetry> result;
+  result.reserve(count);
+  IterationTelemetry record;
+  for (uint64_t index = head - count; index < head; ++index) {
+    if (read(index, record)) result.push_back(record);
+  }
+  return result;
+}
+
+bool TelemetryRing::latest(IterationTelemetry &record) const {
+  const uint64_t head = numRecorded();
+  return head > 0 && read(head - 1, record);
+}
+
+bool TelemetryRing::writeCSV(const std::string &filename, const std::vector<IterationTelemetry> &records) {
+  std::ofstream file(filename);
+  if (!file.is_open()) {
+    LOG(WARNING) << "Cannot write to file " << filename << ".";
+    return false;
+  }
+  file << std::setprecision(std::numeric_limits<double>::max_digits10);
+  const char *separator = "";
+  visitFields(IterationTelemetry(), [&](const char *name, auto) {
+    file << separator << name;
+    separator = ",";
+  });
+  file << "\n";
+  for (const auto &record : records) {
+    separator = "";
+    visitFields(record, [&](const char *, auto value) {
+      file << separator << value;
+      separator = ",";
+    });
+    file << "\n";
+  }
+  return file.good();
+}
+
+bool TelemetryRing::writeJSON(const std::string &filename, const std::vector<IterationTelemetry> &records) {
+  std::ofstream file(filename);
+  if (!file.is_open()) {
+    LOG(WARNING) << "Cannot write to file " << filename << ".";
+    return false;
+  }
+  file << std::setprecision(std::numeric_limits<double>::max_digits10);
+  file << "[";
+  for (size_t k = 0; k < records.size(); ++k) {
+    file << (k == 0 ? "\n  {" : ",\n  {");
+    const char *separator = "";
+    visitFields(records[k], [&](const char *name, auto value) {
+      file << separator << "\"" << name << "\": ";
+      // JSON has no representation of non-finite numbers
+      if constexpr (std::is_floating_point_v<decltype(value)>) {
+        if (!std::isfinite(value)) {
+          file << "null";
+          separator = ", ";
+          return;
+        }
+      }
+      file << value;
+      separator = ", ";
+    });
+    file << "}";
+  }
+  file << "\n]\n";
+  return file.good();
+}
+
+}  // namespace DPGO
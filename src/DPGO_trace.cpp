@@ -0,0 +1,153 @@
+/* ----------------------------------------------------------------------------
+ * Copyright 2020, Massachusetts Institute of Technology, * Cambridge, MA 02139
+ * All Rights Reserved
+ * Authors: Yulun Tian, et al. (see README for the full author list)
+ * See LICENSE for the license information
+ * -------------------------------------------------------------------------- */
+
+#include <DPGO/DPGO_trace.h>
+#include <glog/logging.h>
+
+#include <fstream>
+#include <mutex>
+
+#include <unistd.h>
+
+namespace DPGO {
+
+struct Tracer::Buffer {
+  Buffer(unsigned indexIn, size_t capacity) : index(indexIn), events(capacity) {}
+  const unsigned index;
+  std::vector<TraceEvent> events;
+  // Number of complete events, published by the owning thread
+  std::atomic<size_t> size{0};
+  std::atomic<size_t> dropped{0};
+  std::string name;
+};
+
+struct Tracer::Registry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<Buffer>> buffers;
+  size_t capacity = 1 << 16;
+};
+
+Tracer::Registry &Tracer::registry() {
+  static Registry instance;
+  return instance;
+}
+
+namespace {
+// Escape a string for inclusion in JSON
+std::string escapeJSON(const std::string &str) {
+  std::string result;
+  for (char c : str) {
+    if (c == '"' || c == '\\') result += '\\';
+    if (static_cast<unsigned char>(c) < 0x20) continue;
+    result += c;
+  }
+  return result;
+}
+}  // namespace
+
+std::atomic<bool> Tracer::enabled_{true};
+const std::chrono::steady_clock::time_point Tracer::epoch_ = std::chrono::steady_clock::now();
+
+void Tracer::setEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void Tracer::setBufferCapacity(size_t capacity) {
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  registry().capacity = capacity;
+}
+
+Tracer::Buffer &Tracer::threadBuffer() {
+  thread_local std::shared_ptr<Buffer> buffer;
+  if (!buffer) {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    buffer = std::make_shared<Buffer>(reg.buffers.size(), reg.capacity);
+    reg.buffers.push_back(buffer);
+  }
+  return *buffer;
+}
+
+void Tracer::setThreadName(const std::string &name) {
+  Buffer &buffer = threadBuffer();
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  buffer.name = name;
+}
+
+void Tracer::record(const char *name, int64_t startNs, int64_t endNs) {
+  Buffer &buffer = threadBuffer();
+  const size_t size = buffer.size.load(std::memory_order_relaxed);
+  if (size >= buffer.events.size()) {
+    buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  buffer.events[size] = TraceEvent{name, startNs, endNs - startNs};
+  buffer.size.store(size + 1, std::memory_order_release);
+}
+
+std::vector<std::pair<unsigned, TraceEvent>> Tracer::events() {
+  std::vector<std::pair<unsigned, TraceEvent>> result;
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  for (const auto &buffer_ptr : registry().buffers) {
+    const auto &buffer = *buffer_ptr;
+    const size_t size = buffer.size.load(std::memory_order_acquire);
+    for (size_t k = 0; k < size; ++k) result.emplace_back(buffer.index, buffer.events[k]);
+  }
+  return result;
+}
+
+size_t Tracer::numDropped() {
+  size_t dropped = 0;
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  for (const auto &buffer_ptr : registry().buffers) {
+    dropped += buffer_ptr->dropped.load(std::memory_order_relaxed);
+  }
+  return dropped;
+}
+
+void Tracer::clear() {
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  for (const auto &buffer_ptr : registry().buffers) {
+    buffer_ptr->size.store(0, std::memory_order_release);
+    buffer_ptr->dropped.store(0, std::memory_order_relaxed);
+  }
+}
+
+bool Tracer::writeChromeTrace(const std::string &filename) {
+  std::ofstream file(filename);
+  if (!file.is_open()) {
+    LOG(WARNING) << "Cannot write to file " << filename << ".";
+    return false;
+  }
+  const int pid = getpid();
+  file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  const char *separator = "\n";
+  {
+    // Thread names as metadata events
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    for (const auto &buffer_ptr : registry().buffers) {
+      const auto &buffer = *buffer_ptr;
+      if (buffer.name.empty()) continue;
+      file << separator << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid
+           << ", \"tid\": " << buffer.index << ", \"args\": {\"name\": \"" << escapeJSON(buffer.name) << "\"}}";
+      separator = ",\n";
+    }
+  }
+  // Complete events with timestamps in microseconds
+  char line[256];
+  for (const auto &[tid, event] : events()) {
+    snprintf(line, sizeof(line), "{\"name\": \"%s\", \"ph\": \"X\", \"pid\": %d, \"tid\": %u, "
+                                 "\"ts\": %.3f, \"dur\": %.3f}",
+             event.name, pid, tid, event.startNs * 1e-3, event.durationNs * 1e-3);
+    file << separator << line;
+    separator = ",\n";
+  }
+  file << "\n]}\n";
+  return file.good();
+}
+
+}  // namespace DPGO
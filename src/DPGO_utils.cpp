@@ -9,10 +9,12 @@
 #include <DPGO/DPGO_robust.h>
 #include <Eigen/Geometry>
 #include <Eigen/SPQRSupport>
+#include <Eigen/SparseCholesky>
 #include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <random>
+#include <thread>
 #include <boost/math/distributions/chi_squared.hpp>
 #include <glog/logging.h>
 
@@ -41,6 +43,15 @@ std::string InitializationMethodToString(InitializationMethod method) {
     case InitializationMethod::GNC_TLS: {
       return "GNC_TLS";
     }
+    case InitializationMethod::ChordalCholesky: {
+      return "ChordalCholesky";
+    }
+    case InitializationMethod::ChordalCG: {
+      return "ChordalCG";
+    }
+    case InitializationMethod::SpanningTree: {
+      return "SpanningTree";
+    }
   }
   return "";
 }
@@ -461,6 +472,79 @@ Matrix recoverTranslations(const SparseMatrix &B1, const SparseMatrix &B2,
   return t;
 }
 
+void constructRotationNormalEquations(const std::vector<RelativeSEMeasurement> &measurements,
+                                      size_t num_poses, SparseMatrix &LR, Matrix &BR) {
+  CHECK_GT(num_poses, 1);
+  const size_t d = (!measurements.empty() ? measurements[0].t.size() : 0);
+  const size_t N = d * (num_poses - 1);
+  BR = Matrix::Zero(N, d);
+
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(4 * d * d * measurements.size());
+  // Add the d x d block M at block position (i, j) of the full Laplacian, moving blocks
+  // that multiply the fixed first rotation to the right hand side
+  auto addBlock = [&](size_t i, size_t j, const Matrix &M) {
+    if (i == 0) return;
+    if (j == 0) {
+      BR.block((i - 1) * d, 0, d, d) -= M;
+      return;
+    }
+    for (size_t r = 0; r < d; r++)
+      for (size_t c = 0; c < d; c++)
+        triplets.emplace_back((i - 1) * d + r, (j - 1) * d + c, M(r, c));
+  };
+
+  const Matrix Id = Matrix::Identity(d, d);
+  for (const auto &m : measurements) {
+    CHECK_LT(m.p1, num_poses);
+    CHECK_LT(m.p2, num_poses);
+    if (m.p1 == m.p2) continue;
+    // Residual kappa * || Rj' - Rij' * Ri' ||^2
+    addBlock(m.p1, m.p1, m.kappa * Id);
+    addBlock(m.p2, m.p2, m.kappa * Id);
+    addBlock(m.p1, m.p2, -m.kappa * m.R);
+    addBlock(m.p2, m.p1, -m.kappa * m.R.transpose());
+  }
+
+  LR.resize(N, N);
+  LR.setFromTriplets(triplets.begin(), triplets.end());
+}
+
+void constructTranslationNormalEquations(const std::vector<RelativeSEMeasurement> &measurements,
+                                         const Matrix &R, SparseMatrix &LT, Matrix &BT) {
+  const size_t d = R.rows();
+  const size_t num_poses = R.cols() / d;
+  CHECK_GT(num_poses, 1);
+  BT = Matrix::Zero(num_poses - 1, d);
+
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(4 * measurements.size());
+  for (const auto &m : measurements) {
+    const size_t i = m.p1;
+    const size_t j = m.p2;
+    CHECK_LT(i, num_poses);
+    CHECK_LT(j, num_poses);
+    if (i == j) continue;
+    // Residual tau * || tj - ti - Ri * tij ||^2 with the first translation fixed to zero
+    const Vector v = m.tau * R.block(0, i * d, d, d) * m.t;
+    if (i > 0) {
+      triplets.emplace_back(i - 1, i - 1, m.tau);
+      BT.row(i - 1) -= v.transpose();
+    }
+    if (j > 0) {
+      triplets.emplace_back(j - 1, j - 1, m.tau);
+      BT.row(j - 1) += v.transpose();
+    }
+    if (i > 0 && j > 0) {
+      triplets.emplace_back(i - 1, j - 1, -m.tau);
+      triplets.emplace_back(j - 1, i - 1, -m.tau);
+    }
+  }
+
+  LT.resize(num_poses - 1, num_poses - 1);
+  LT.setFromTriplets(triplets.begin(), triplets.end());
+}
+
 Matrix projectToRotationGroup(const Matrix &M) {
   // Compute the SVD of M
   Eigen::JacobiSVD<Matrix> svd(M, Eigen::ComputeFullU | Eigen::ComputeFullV);
@@ -506,6 +590,140 @@ double computeMeasurementError(const RelativeSEMeasurement &m,
   return m.kappa * rotationErrorSq + m.tau * translationErrorSq;
 }
 
+namespace {
+// Minimum number of measurements per thread when computing residuals in parallel
+constexpr size_t kMinMeasurementsPerThread = 2048;
+// Maximum number of power iterations that refine a direction of negative curvature
+constexpr unsigned kCurvatureRefinementIters = 200;
+}  // namespace
+
+void computeMeasurementResiduals(const std::vector<RelativeSEMeasurement *> &measurements,
+                                 const std::vector<const double *> &poses1,
+                                 const std::vector<const double *> &poses2,
+                                 unsigned r, Vector &residuals, unsigned numThreads) {
+  const size_t m = measurements.size();
+  CHECK_EQ(poses1.size(), m);
+  CHECK_EQ(poses2.size(), m);
+  if (residuals.size() != (Eigen::Index) m)
+    residuals.resize(m);
+  if (m == 0)
+    return;
+  const unsigned d = measurements[0]->t.size();
+  auto computeRange = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const RelativeSEMeasurement &meas = *measurements[i];
+      Eigen::Map<const Matrix> X1(poses1[i], r, d + 1);
+      Eigen::Map<const Matrix> X2(poses2[i], r, d + 1);
+      // Lazy products evaluate the small matrix products inside the norm without heap temporaries
+      const double rotationErrorSq = (X1.leftCols(d).lazyProduct(meas.R) - X2.leftCols(d)).squaredNorm();
+      const double translationErrorSq = (X2.col(d) - X1.col(d) - X1.leftCols(d).lazyProduct(meas.t)).squaredNorm();
+      residuals(i) = std::sqrt(meas.kappa * rotationErrorSq + meas.tau * translationErrorSq);
+    }
+  };
+  const size_t num_threads = numThreads > 0 ? numThreads : std::max(1u, std::thread::hardware_concurrency());
+  const size_t num_workers = std::min(num_threads, m / kMinMeasurementsPerThread);
+  if (num_workers <= 1) {
+    computeRange(0, m);
+  } else {
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < num_workers; ++w) {
+      threads.emplace_back(computeRange, w * m / num_workers, (w + 1) * m / num_workers);
+    }
+    for (auto &thread : threads) thread.join();
+  }
+}
+
+SparseMatrix constructCertificateMatrix(const SparseMatrix &Q, const Matrix &Y, unsigned d) {
+  const size_t k = d + 1;
+  const size_t n = Y.cols() / k;
+  const size_t r = Y.rows();
+  CHECK_EQ((size_t) Y.cols(), k * n);
+  CHECK_EQ((size_t) Q.rows(), k * n);
+  CHECK_EQ(Q.rows(), Q.cols());
+  const Matrix YQ = Y * Q;
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(n * d * d);
+  for (size_t i = 0; i < n; ++i) {
+    const Matrix Lambda = Y.block(0, i * k, r, d).transpose() * YQ.block(0, i * k, r, d);
+    for (unsigned a = 0; a < d; ++a) {
+      for (unsigned b = 0; b < d; ++b) {
+        triplets.emplace_back(i * k + a, i * k + b, 0.5 * (Lambda(a, b) + Lambda(b, a)));
+      }
+    }
+  }
+  SparseMatrix LambdaBlocks(Q.rows(), Q.cols());
+  LambdaBlocks.setFromTriplets(triplets.begin(), triplets.end());
+  return Q - LambdaBlocks;
+}
+
+bool verifyCertificateMatrix(const SparseMatrix &S, double eta, Vector &v, double &curvature) {
+  CHECK_EQ(S.rows(), S.cols());
+  Eigen::SparseMatrix<double> I(S.rows(), S.cols());
+  I.setIdentity();
+  const Eigen::SparseMatrix<double> M = Eigen::SparseMatrix<double>(S) + eta * I;
+  Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> ldlt(M);
+  if (ldlt.info() != Eigen::Success) {
+    LOG(WARNING) << "LDL factorization of the certificate matrix failed.";
+    v.resize(0);
+    curvature = 0;
+    return false;
+  }
+  Eigen::Index k;
+  if (ldlt.vectorD().minCoeff(&k) > 0) return true;
+  // With M = P' L D L' P, the vector v = P' L'^{-1} e_k satisfies v' M v = D_k < 0
+  Vector e = Vector::Zero(S.rows());
+  e(k) = 1;
+  const Vector w = ldlt.matrixU().solve(e);
+  v = ldlt.permutationPinv() * w;
+  v.normalize();
+  curvature = v.dot(S * v);
+  // The pivot direction can have curvature close to -eta even if S has a much more negative eigenvalue.
+  // Power iteration on sigma * I - S, where sigma bounds the spectrum of S, monotonically decreases
+  // the curvature towards the minimum eigenvalue.
+  double sigma = 0;
+  for (Eigen::Index row = 0; row < S.outerSize(); ++row) {
+    double rowSum = 0;
+    for (SparseMatrix::InnerIterator it(S, row); it; ++it) rowSum += std::abs(it.value());
+    sigma = std::max(sigma, rowSum);
+  }
+  for (unsigned iter = 0; iter < kCurvatureRefinementIters; ++iter) {
+    Vector vNext = sigma * v - S * v;
+    vNext.normalize();
+    const double curvatureNext = vNext.dot(S * vNext);
+    if (!(curvatureNext < curvature)) break;
+    const bool converged = curvature - curvatureNext < 1e-6 * std::abs(curvatureNext);
+    v = vNext;
+    curvature = curvatureNext;
+    if (converged) break;
+  }
+  return false;
+}
+
+Matrix roundSolution(const Matrix &Y, unsigned d) {
+  const size_t k = d + 1;
+  const size_t n = Y.cols() / k;
+  const size_t r = Y.rows();
+  CHECK_GE(r, d);
+  CHECK_EQ((size_t) Y.cols(), k * n);
+  Matrix T = Y;
+  if (r > d) {
+    // Project onto the dominant d-dimensional row space of the rotation blocks
+    Matrix R(r, d * n);
+    for (size_t i = 0; i < n; ++i) R.block(0, i * d, r, d) = Y.block(0, i * k, r, d);
+    Eigen::SelfAdjointEigenSolver<Matrix> eig(R * R.transpose());
+    T = eig.eigenvectors().rightCols(d).transpose() * Y;
+  }
+  size_t numPositive = 0;
+  for (size_t i = 0; i < n; ++i) {
+    if (T.block(0, i * k, d, d).determinant() > 0) numPositive++;
+  }
+  if (2 * numPositive < n) T.row(d - 1) *= -1;
+  for (size_t i = 0; i < n; ++i) {
+    T.block(0, i * k, d, d) = projectToRotationGroup(T.block(0, i * k, d, d));
+  }
+  return T;
+}
+
 double chi2inv(double quantile, size_t dof) {
   boost::math::chi_squared_distribution<double> chi2(dof);
   return boost::math::quantile(chi2, quantile);
@@ -7,6 +7,7 @@
 
 #include <DPGO/PGOAgent.h>
 #include <DPGO/DPGO_solver.h>
+#include <DPGO/DPGO_trace.h>
 #include <DPGO/QuadraticOptimizer.h>
 #include <glog/logging.h>
 
@@ -38,10 +39,13 @@ PGOAgent::PGOAgent(unsigned ID, const PGOAgentParameters &params)
       mRobustOptInnerIter(0),
       mWeightUpdateCount(0),
       mTrajectoryResetCount(0),
+      mTelemetry(params.telemetryCapacity),
       mLogger(params.logDirectory),
       gamma(0), alpha(0), Y(X), V(X), XPrev(X) {
   if (mID == 0) setLiftingMatrix(fixedStiefelVariable(d, r));
   mTeamRobotActive.assign(mParams.numRobots, true);
+  neighborPoseStore.reset(r, d);
+  neighborAuxPoseStore.reset(r, d);
 }
 
 PGOAgent::~PGOAgent() {
@@ -114,16 +118,34 @@ bool PGOAgent::getSharedPoseDictWithNeighbor(PoseDict &map, unsigned neighborID)
     return false;
   map.clear();
   lock_guard<mutex> lock(mPosesMutex);
-  std::vector<RelativeSEMeasurement> measurements = mPoseGraph->sharedLoopClosuresWithRobot(neighborID);
-  for (const auto &m : measurements) {
-    if (m.r1 == getID()) {
-      PoseID pose_id(m.r1, m.p1);
-      LiftedPose Xi(X.pose(m.p1));
-      map.emplace(pose_id, Xi);
-    } else if (m.r2 == getID()) {
-      PoseID pose_id(m.r2, m.p2);
-      LiftedPose Xi(X.pose(m.p2));
-      map.emplace(pose_id, Xi);
+  for (const auto frame_id : mPoseGraph->myPublicFrameIDsWithNeighbor(neighborID)) {
+    map.emplace_hint(map.end(), PoseID(getID(), frame_id), LiftedPose(X.pose(frame_id)));
+  }
+  return true;
+}
+
+bool PGOAgent::getSharedPosesWithNeighbors(std::map<unsigned, Matrix> &buffers, bool auxiliary) {
+  if (auxiliary) CHECK(mParams.acceleration);
+  if (mState != PGOAgentState::INITIALIZED)
+    return false;
+  const unsigned pose_size = r * (d + 1);
+  lock_guard<mutex> lock(mPosesMutex);
+  const LiftedPoseArray &source = auxiliary ? Y : X;
+  // Remove buffers of robots that are no longer neighbors
+  for (auto it = buffers.begin(); it != buffers.end();) {
+    if (!mPoseGraph->hasNeighbor(it->first))
+      it = buffers.erase(it);
+    else
+      ++it;
+  }
+  for (const auto neighborID : mPoseGraph->neighborIDs()) {
+    const auto &frame_ids = mPoseGraph->myPublicFrameIDsWithNeighbor(neighborID);
+    Matrix &buffer = buffers[neighborID];
+    buffer.resize(r, frame_ids.size() * (d + 1));
+    double *dst = buffer.data();
+    for (const auto frame_id : frame_ids) {
+      std::copy(source.poseData(frame_id), source.poseData(frame_id) + pose_size, dst);
+      dst += pose_size;
     }
   }
   return true;
@@ -145,22 +167,30 @@ bool PGOAgent::getAuxSharedPoseDict(PoseDict &map) {
   return true;
 }
 
+size_t PGOAgent::encodeSharedPoses(std::vector<uint8_t> &buffer, bool auxiliary) {
+  if (auxiliary) CHECK(mParams.acceleration);
+  if (mState != PGOAgentState::INITIALIZED)
+    return 0;
+  lock_guard<mutex> lock(mPosesMutex);
+  const LiftedPoseArray &source = auxiliary ? Y : X;
+  std::vector<PoseID> pose_ids;
+  std::vector<const double *> poses;
+  for (const auto &pose_id : mPoseGraph->myPublicPoseIDs()) {
+    CHECK_EQ(pose_id.robot_id, getID());
+    pose_ids.push_back(pose_id);
+    poses.push_back(source.poseData(pose_id.frame_id));
+  }
+  return encodePoses(pose_ids, poses, getID(), r, d, mParams.sharedPoseEncoding, buffer,
+                     auxiliary ? MessageType::AuxPoseDict : MessageType::PoseDict);
+}
+
 bool PGOAgent::getAuxSharedPoseDictWithNeighbor(PoseDict &map, unsigned neighborID) {
   if (mState != PGOAgentState::INITIALIZED)
     return false;
   map.clear();
   lock_guard<mutex> lock(mPosesMutex);
-  std::vector<RelativeSEMeasurement> measurements = mPoseGraph->sharedLoopClosuresWithRobot(neighborID);
-  for (const auto &m : measurements) {
-    if (m.r1 == getID()) {
-      PoseID pose_id(m.r1, m.p1);
-      LiftedPose Yi(Y.pose(m.p1));
-      map.emplace(pose_id, Yi);
-    } else if (m.r2 == getID()) {
-      PoseID pose_id(m.r2, m.p2);
-      LiftedPose Yi(Y.pose(m.p2));
-      map.emplace(pose_id, Yi);
-    }
+  for (const auto frame_id : mPoseGraph->myPublicFrameIDsWithNeighbor(neighborID)) {
+    map.emplace_hint(map.end(), PoseID(getID(), frame_id), LiftedPose(Y.pose(frame_id)));
   }
   return true;
 }
@@ -173,6 +203,10 @@ void PGOAgent::setLiftingMatrix(const Matrix &M) {
 
 void PGOAgent::addMeasurement(const RelativeSEMeasurement &factor) {
   if (mState != PGOAgentState::WAIT_FOR_DATA) {
+    if (factor.r1 == mID && factor.r2 == mID && factor.p1 + 1 == num_poses() && factor.p2 == num_poses()) {
+      addOdometry({factor});
+      return;
+    }
     LOG(WARNING)
         << "Robot state is not WAIT_FOR_DATA. Ignore new measurements!";
     return;
@@ -181,6 +215,86 @@ void PGOAgent::addMeasurement(const RelativeSEMeasurement &factor) {
   mPoseGraph->addMeasurement(factor);
 }
 
+namespace {
+// A candidate transform to the world frame is recomputed during initialization only if the neighbor
+// pose it was computed from changed by more than this (in max norm)
+const double kNeighborTransformPoseTol = 1e-6;
+
+/**
+ * @brief Extend a (lifted) trajectory T = [X1 ... Xn] by composing the odometry from its last pose
+ */
+Matrix appendPoses(const Matrix &T, unsigned d, const std::vector<RelativeSEMeasurement> &odometry) {
+  const size_t n = T.cols() / (d + 1);
+  Matrix result(T.rows(), (d + 1) * (n + odometry.size()));
+  result.leftCols(T.cols()) = T;
+  Matrix Tij = Matrix::Identity(d + 1, d + 1);
+  for (size_t k = 0; k < odometry.size(); ++k) {
+    Tij.block(0, 0, d, d) = odometry[k].R;
+    Tij.block(0, d, d, 1) = odometry[k].t;
+    result.middleCols((n + k) * (d + 1), d + 1) = result.middleCols((n + k - 1) * (d + 1), d + 1) * Tij;
+  }
+  return result;
+}
+}  // namespace
+
+bool PGOAgent::addOdometry(const std::vector<RelativeSEMeasurement> &odometry) {
+  if (mState == PGOAgentState::WAIT_FOR_DATA) {
+    LOG(WARNING) << "Robot " << getID() << " is not initialized. Use addMeasurement instead.";
+    return false;
+  }
+  if (odometry.empty())
+    return true;
+
+  // Halt optimization
+  bool optimizationHalted = false;
+  if (isOptimizationRunning()) {
+    optimizationHalted = true;
+    endOptimizationLoop();
+  }
+
+  bool appended;
+  {
+    lock_guard<mutex> tLock(mPosesMutex);
+    lock_guard<mutex> mLock(mMeasurementsMutex);
+    appended = mPoseGraph->appendOdometry(odometry);
+    if (appended) {
+      // Local initialization is composed from its own last pose
+      const PoseArray TLocal = TLocalInit.value();
+      TLocalInit.emplace(dimension(), num_poses());
+      TLocalInit->setData(appendPoses(TLocal.getData(), d, odometry));
+
+      if (mState == PGOAgentState::INITIALIZED) {
+        // New poses are composed from the latest estimate, and shared by all other variables
+        const unsigned n_old = X.n();
+        const Matrix XData = appendPoses(X.getData(), d, odometry);
+        const Matrix XNew = XData.rightCols((d + 1) * odometry.size());
+        auto extend = [&](LiftedPoseArray &Z) {
+          Matrix data(relaxation_rank(), XData.cols());
+          data << Z.getData(), XNew;
+          Z = LiftedPoseArray(relaxation_rank(), dimension(), num_poses());
+          Z.setData(data);
+        };
+        X = LiftedPoseArray(relaxation_rank(), dimension(), num_poses());
+        X.setData(XData);
+        if (XInit.has_value()) extend(XInit.value());
+        if (mParams.acceleration) {
+          extend(Y);
+          extend(V);
+        }
+        if (XPrev.n() == n_old) extend(XPrev);
+        LOG_IF(INFO, mParams.verbose) << "Robot " << getID() << " appends " << num_poses() - n_old
+                                      << " poses to trajectory with length " << n_old;
+      } else {
+        X = LiftedPoseArray(relaxation_rank(), dimension(), num_poses());
+      }
+    }
+  }
+
+  // Restart optimization (whether or not the odometry was accepted) after releasing the locks
+  if (optimizationHalted) startOptimizationLoop();
+  return appended;
+}
+
 void PGOAgent::setMeasurements(
     const std::vector<RelativeSEMeasurement> &inputOdometry,
     const std::vector<RelativeSEMeasurement> &inputPrivateLoopClosures,
@@ -196,6 +310,19 @@ void PGOAgent::setMeasurements(
   mPoseGraph->setMeasurements(measurements);
 }
 
+void PGOAgent::setMeasurements(const std::vector<RelativeSEMeasurement> &measurements) {
+  vector<RelativeSEMeasurement> odometry, privateLoopClosures, sharedLoopClosures;
+  for (const auto &m : measurements) {
+    if (m.r1 != m.r2)
+      sharedLoopClosures.push_back(m);
+    else if (m.p1 + 1 == m.p2)
+      odometry.push_back(m);
+    else
+      privateLoopClosures.push_back(m);
+  }
+  setMeasurements(odometry, privateLoopClosures, sharedLoopClosures);
+}
+
 void PGOAgent::initialize(const PoseArray *TInitPtr) {
   if (mState != PGOAgentState::WAIT_FOR_DATA)
     return;
@@ -225,9 +352,17 @@ void PGOAgent::initialize(const PoseArray *TInitPtr) {
         T = odometryInitialization(mPoseGraph->odometry());
         break;
       }
-      case (InitializationMethod::Chordal): {
-        LOG(INFO) << "Computing local chordal initialization.";
-        T = chordalInitialization(mPoseGraph->localMeasurements());
+      case (InitializationMethod::Chordal):
+      case (InitializationMethod::ChordalCholesky):
+      case (InitializationMethod::ChordalCG): {
+        LOG(INFO) << "Computing local chordal initialization ("
+                  << InitializationMethodToString(mParams.localInitializationMethod) << ").";
+        T = chordalInitialization(mPoseGraph->localMeasurements(), mParams.localInitializationMethod);
+        break;
+      }
+      case (InitializationMethod::SpanningTree): {
+        LOG(INFO) << "Computing local spanning tree initialization.";
+        T = spanningTreeInitialization(mPoseGraph->localMeasurements());
         break;
       }
       case (InitializationMethod::GNC_TLS): {
@@ -287,6 +422,7 @@ void PGOAgent::initialize(const PoseArray *TInitPtr) {
     T_transformed.pose(i) = T0i.pose();
   }
   TLocalInit.emplace(T_transformed);
+  clearNeighborTransformCandidates();
 
   // Update dimension for internal iterate
   X = LiftedPoseArray(relaxation_rank(), dimension(), num_poses());
@@ -324,6 +460,7 @@ void PGOAgent::initializeInGlobalFrame(const Pose &T_world_robot) {
 
   // Clear cache
   clearNeighborPoses();
+  clearNeighborTransformCandidates();
 
   // Apply global transformation to local trajectory estimate
   auto T = TLocalInit.value();
@@ -345,6 +482,9 @@ void PGOAgent::initializeInGlobalFrame(const Pose &T_world_robot) {
     mState = PGOAgentState::INITIALIZED;
   }
 
+  // Neighbors need the new public poses
+  mPublishPublicPosesRequested = true;
+
   // When doing robust optimization,
   // initialize all active and non-fixed edge weights to 1.0
   if (mParams.robustCostParams.costType != RobustCostParameters::Type::L2) {
@@ -373,17 +513,242 @@ void PGOAgent::initializeInGlobalFrame(const Pose &T_world_robot) {
   if (optimizationHalted) startOptimizationLoop();
 }
 
+bool PGOAgent::saveSnapshot(const std::string &filename) {
+  PoseGraphSnapshot snapshot;
+  snapshot.agentID = getID();
+  snapshot.d = dimension();
+  snapshot.numPoses = num_poses();
+  {
+    lock_guard<mutex> mLock(mMeasurementsMutex);
+    snapshot.measurements = mPoseGraph->odometry();
+    const auto privateLoopClosures = mPoseGraph->privateLoopClosures();
+    const auto sharedLoopClosures = mPoseGraph->sharedLoopClosures();
+    snapshot.measurements.insert(snapshot.measurements.end(), privateLoopClosures.begin(), privateLoopClosures.end());
+    snapshot.measurements.insert(snapshot.measurements.end(), sharedLoopClosures.begin(), sharedLoopClosures.end());
+  }
+  if (snapshot.measurements.empty()) {
+    LOG(WARNING) << "Robot " << getID() << " has no measurements to save.";
+    return false;
+  }
+  Matrix T;
+  if (getTrajectoryInLocalFrame(T)) {
+    snapshot.trajectory.emplace(T);
+    lock_guard<mutex> lock(mPosesMutex);
+    snapshot.X.emplace(X.getData());
+  }
+  if (YLift) snapshot.liftingMatrix.emplace(YLift.value());
+  return writeSnapshot(filename, snapshot);
+}
+
+bool PGOAgent::loadSnapshot(const std::string &filename) {
+  CHECK(!isOptimizationRunning());
+  CHECK_EQ(mState, PGOAgentState::WAIT_FOR_DATA);
+  SnapshotView view;
+  if (!view.open(filename))
+    return false;
+  if (view.header().agentID != getID() || view.d() != dimension()) {
+    LOG(WARNING) << "Snapshot " << filename << " belongs to robot " << view.header().agentID
+                 << " with dimension " << view.d() << ".";
+    return false;
+  }
+  if ((view.hasIterate() || view.hasLiftingMatrix()) && view.header().r != relaxation_rank()) {
+    LOG(WARNING) << "Snapshot " << filename << " has relaxation rank " << view.header().r << ".";
+    return false;
+  }
+  vector<RelativeSEMeasurement> measurements;
+  measurements.reserve(view.numMeasurements());
+  for (size_t i = 0; i < view.numMeasurements(); ++i)
+    measurements.push_back(view.measurement(i));
+  setMeasurements(measurements);
+  if (num_poses() != view.numPoses()) {
+    LOG(WARNING) << "Snapshot " << filename << " has inconsistent number of poses.";
+    mPoseGraph = std::make_shared<PoseGraph>(mID, r, d);
+    return false;
+  }
+  if (view.hasLiftingMatrix())
+    setLiftingMatrix(view.liftingMatrix());
+  if (view.hasIterate() && YLift) {
+    // Resume directly from the saved iterate, keeping the saved measurement weights
+    {
+      lock_guard<mutex> lock(mPosesMutex);
+      if (view.hasTrajectory()) {
+        PoseArray T(dimension(), num_poses());
+        T.setData(view.trajectory());
+        TLocalInit.emplace(T);
+        clearNeighborTransformCandidates();
+      }
+      X = LiftedPoseArray(relaxation_rank(), dimension(), num_poses());
+      X.setData(view.iterate());
+      XInit.emplace(X);
+      mState = PGOAgentState::INITIALIZED;
+      mPublishPublicPosesRequested = true;
+    }
+    if (mParams.acceleration)
+      initializeAcceleration();
+    LOG(INFO) << "Robot " << getID() << " resumes from snapshot " << filename << ".";
+    if (mParams.asynchronous)
+      startOptimizationLoop();
+  } else if (view.hasTrajectory()) {
+    PoseArray T(dimension(), num_poses());
+    T.setData(view.trajectory());
+    initialize(&T);
+  }
+  return true;
+}
+
+bool PGOAgent::saveCheckpoint(const std::string &filename) {
+  AgentCheckpoint checkpoint;
+  PoseGraphSnapshot &snapshot = checkpoint.snapshot;
+  snapshot.agentID = getID();
+  snapshot.d = dimension();
+  snapshot.numPoses = num_poses();
+  {
+    // Same locking order as in updateX
+    lock_guard<mutex> tLock(mPosesMutex);
+    lock_guard<mutex> mLock(mMeasurementsMutex);
+    snapshot.measurements = mPoseGraph->measurements();
+    if (snapshot.measurements.empty()) {
+      LOG(WARNING) << "Robot " << getID() << " has no measurements to save.";
+      return false;
+    }
+    if (TLocalInit) snapshot.trajectory.emplace(TLocalInit->getData());
+    if (YLift) snapshot.liftingMatrix.emplace(YLift.value());
+    if (XInit) checkpoint.XInit.emplace(XInit->getData());
+    if (globalAnchor) checkpoint.globalAnchor.emplace(globalAnchor->getData());
+    if (mState == PGOAgentState::INITIALIZED) {
+      snapshot.X.emplace(X.getData());
+      checkpoint.XPrev.emplace(XPrev.getData());
+      if (mParams.acceleration) {
+        checkpoint.Y.emplace(Y.getData());
+        checkpoint.V.emplace(V.getData());
+      }
+    }
+    checkpoint.state = mState;
+    checkpoint.instanceNumber = mInstanceNumber;
+    checkpoint.iterationNumber = mIterationNumber;
+    checkpoint.latestWeightUpdateIteration = mLatestWeightUpdateIteration;
+    checkpoint.robustOptInnerIter = mRobustOptInnerIter;
+    checkpoint.weightUpdateCount = mWeightUpdateCount;
+    checkpoint.trajectoryResetCount = mTrajectoryResetCount;
+    checkpoint.gncIteration = mRobustCost.GNCIteration();
+    checkpoint.gncMu = mRobustCost.GNCMu();
+    checkpoint.gncSettledLoopClosures.assign(mGNCSettledLoopClosures.begin(), mGNCSettledLoopClosures.end());
+    std::sort(checkpoint.gncSettledLoopClosures.begin(), checkpoint.gncSettledLoopClosures.end(), CompareEdgeID());
+    checkpoint.gncUndecidedLoopClosures = mGNCUndecidedLoopClosures;
+    checkpoint.gamma = gamma;
+    checkpoint.alpha = alpha;
+  }
+  return writeCheckpoint(filename, checkpoint);
+}
+
+bool PGOAgent::loadCheckpoint(const std::string &filename) {
+  CHECK(!isOptimizationRunning());
+  CHECK_EQ(mState, PGOAgentState::WAIT_FOR_DATA);
+  AgentCheckpoint checkpoint;
+  if (!readCheckpoint(filename, checkpoint))
+    return false;
+  const PoseGraphSnapshot &snapshot = checkpoint.snapshot;
+  if (snapshot.agentID != getID() || snapshot.d != dimension()) {
+    LOG(WARNING) << "Checkpoint " << filename << " belongs to robot " << snapshot.agentID
+                 << " with dimension " << snapshot.d << ".";
+    return false;
+  }
+  if ((snapshot.X && snapshot.X->rows() != relaxation_rank()) ||
+      (snapshot.liftingMatrix && snapshot.liftingMatrix->rows() != relaxation_rank()) ||
+      (checkpoint.XPrev && checkpoint.XPrev->rows() != relaxation_rank())) {
+    LOG(WARNING) << "Checkpoint " << filename << " has wrong relaxation rank.";
+    return false;
+  }
+  const auto state = static_cast<PGOAgentState>(checkpoint.state);
+  if (state != PGOAgentState::WAIT_FOR_DATA && state != PGOAgentState::WAIT_FOR_INITIALIZATION &&
+      state != PGOAgentState::INITIALIZED) {
+    LOG(WARNING) << "Checkpoint " << filename << " has invalid state " << checkpoint.state << ".";
+    return false;
+  }
+  if ((state == PGOAgentState::INITIALIZED && !(snapshot.X && checkpoint.XPrev)) ||
+      (state != PGOAgentState::WAIT_FOR_DATA && !snapshot.trajectory)) {
+    LOG(WARNING) << "Checkpoint " << filename << " is missing the iterate of an initialized robot.";
+    return false;
+  }
+  setMeasurements(snapshot.measurements);
+  if (num_poses() != snapshot.numPoses) {
+    LOG(WARNING) << "Checkpoint " << filename << " has inconsistent number of poses.";
+    mPoseGraph = std::make_shared<PoseGraph>(mID, r, d);
+    return false;
+  }
+  if (snapshot.liftingMatrix)
+    setLiftingMatrix(snapshot.liftingMatrix.value());
+  {
+    lock_guard<mutex> lock(mPosesMutex);
+    if (snapshot.trajectory) {
+      PoseArray T(dimension(), num_poses());
+      T.setData(snapshot.trajectory.value());
+      TLocalInit.emplace(T);
+      clearNeighborTransformCandidates();
+    }
+    auto liftedPoses = [&](const Matrix &M) {
+      LiftedPoseArray P(relaxation_rank(), dimension(), num_poses());
+      P.setData(M);
+      return P;
+    };
+    if (checkpoint.XInit) XInit.emplace(liftedPoses(checkpoint.XInit.value()));
+    if (checkpoint.globalAnchor) globalAnchor.emplace(checkpoint.globalAnchor.value());
+    if (state == PGOAgentState::INITIALIZED) {
+      X = liftedPoses(snapshot.X.value());
+      XPrev = liftedPoses(checkpoint.XPrev.value());
+      if (checkpoint.Y && checkpoint.V) {
+        Y = liftedPoses(checkpoint.Y.value());
+        V = liftedPoses(checkpoint.V.value());
+      }
+      mPublishPublicPosesRequested = true;
+    }
+    mState = state;
+    mInstanceNumber = checkpoint.instanceNumber;
+    mIterationNumber = checkpoint.iterationNumber;
+    mLatestWeightUpdateIteration = checkpoint.latestWeightUpdateIteration;
+    mRobustOptInnerIter = checkpoint.robustOptInnerIter;
+    mWeightUpdateCount = checkpoint.weightUpdateCount;
+    mTrajectoryResetCount = checkpoint.trajectoryResetCount;
+    if (checkpoint.gncMu > 0)
+      mRobustCost.setGNCState(checkpoint.gncIteration, checkpoint.gncMu);
+    mGNCSettledLoopClosures.clear();
+    mGNCSettledLoopClosures.insert(checkpoint.gncSettledLoopClosures.begin(), checkpoint.gncSettledLoopClosures.end());
+    mGNCUndecidedLoopClosures = checkpoint.gncUndecidedLoopClosures;
+    gamma = checkpoint.gamma;
+    alpha = checkpoint.alpha;
+  }
+  mStatus = PGOAgentStatus(getID(), mState, mInstanceNumber, mIterationNumber, false, 0);
+  if (mState == PGOAgentState::INITIALIZED) {
+    // Acceleration state is not available if the checkpoint is saved without acceleration
+    if (mParams.acceleration && !(checkpoint.Y && checkpoint.V))
+      initializeAcceleration();
+    LOG(INFO) << "Robot " << getID() << " resumes from checkpoint " << filename
+              << " at iteration " << mIterationNumber << ".";
+    if (mParams.asynchronous)
+      startOptimizationLoop();
+  }
+  return true;
+}
+
 bool PGOAgent::iterate(bool doOptimization) {
+  DPGO_TRACE_ZONE("PGOAgent::iterate");
+  const auto iterationStart = SimpleTimer::Tic();
   mIterationNumber++;
+  mIterationTelemetry = IterationTelemetry();
+  mIterationTelemetry.iteration = mIterationNumber;
   if (mParams.robustCostParams.costType != RobustCostParameters::Type::L2) {
     mRobustOptInnerIter++;
   }
 
+  // Process messages from other agents
+  if (mCommunicator)
+    receiveMessages();
+
   // Perform iteration
+  bool success = true;
   if (mState == PGOAgentState::INITIALIZED) {
     // Save current iterate
     XPrev = X;
-    bool success;
     if (mParams.acceleration) {
       updateGamma();
       updateAlpha();
@@ -421,14 +786,34 @@ bool PGOAgent::iterate(bool doOptimization) {
       mStatus.readyToTerminate = readyToTerminate;
     }
 
+    // Log trajectory snapshot (rounding and writing are performed by the logging thread)
+    if (mParams.logData && mParams.logTrajectoryInterval > 0 &&
+        mIterationNumber % mParams.logTrajectoryInterval == 0) {
+      lock_guard<mutex> lock(mPosesMutex);
+      const Matrix anchor = globalAnchor ? globalAnchor->getData() : Matrix(X.pose(0));
+      mLogger.logLiftedTrajectory(dimension(), num_poses(), X.getData(), anchor,
+                                  "trajectory_iteration_" + std::to_string(mIterationNumber) + ".csv");
+    }
+
     // Request to publish public poses
     if (doOptimization || mParams.acceleration)
       mPublishPublicPosesRequested = true;
 
     mPublishAsynchronousRequested = true;
-    return success;
   }
-  return true;
+
+  // Send status and public poses to other agents
+  if (mCommunicator)
+    publishMessages();
+
+  // Record telemetry
+  if (doOptimization && mState == PGOAgentState::INITIALIZED)
+    mIterationTelemetry.relativeChange = mStatus.relativeChange;
+  mIterationTelemetry.iterationMs = SimpleTimer::Toc(iterationStart);
+  mIterationTelemetry.timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  mTelemetry.push(mIterationTelemetry);
+  return success;
 }
 
 void PGOAgent::reset() {
@@ -448,7 +833,7 @@ void PGOAgent::reset() {
     }
 
     // Save solution before rounding
-    writeMatrixToFile(X.getData(), mParams.logDirectory + "X.txt");
+    mLogger.logMatrix(X.getData(), "X.bin");
   }
 
   mInstanceNumber++;
@@ -457,6 +842,8 @@ void PGOAgent::reset() {
   mRobustOptInnerIter = 0;
   mWeightUpdateCount = 0;
   mTrajectoryResetCount = 0;
+  mGNCSettledLoopClosures.clear();
+  mGNCUndecidedLoopClosures.clear();
   mState = PGOAgentState::WAIT_FOR_DATA;
   mStatus = PGOAgentStatus(getID(), mState, mInstanceNumber, mIterationNumber, false, 0);
   mTeamStatus.clear();
@@ -470,6 +857,7 @@ void PGOAgent::reset() {
   // This function will activate all robots in pose graph again
   mPoseGraph->reset();
   clearNeighborPoses();
+  clearNeighborTransformCandidates();
 }
 
 void PGOAgent::startOptimizationLoop() {
@@ -488,6 +876,9 @@ void PGOAgent::runOptimizationLoop() {
   std::random_device rd;  // Will be used to obtain a seed for the random number engine
   std::mt19937 rng(rd());  // Standard mersenne_twister_engine seeded with rd()
   std::exponential_distribution<double> ExponentialDistribution(mParams.asynchronousOptimizationRate);
+#ifdef DPGO_ENABLE_TRACING
+  Tracer::setThreadName("Robot " + std::to_string(getID()) + " optimization");
+#endif
   while (true) {
     iterate(true);
     usleep(1e6 * ExponentialDistribution(rng));
@@ -547,13 +938,11 @@ Pose PGOAgent::computeNeighborTransform(const RelativeSEMeasurement &measurement
   return T_world2_world1;
 }
 
-bool PGOAgent::computeRobustNeighborTransformTwoStage(unsigned int neighborID,
-                                                      const PoseDict &poseDict,
-                                                      Pose *T_world_robot) {
-  std::vector<Matrix> RVec;
-  std::vector<Vector> tVec;
-  // Populate candidate alignments
-  // Each alignment corresponds to a single inter-robot loop closure
+bool PGOAgent::updateNeighborTransformCandidates(unsigned int neighborID, const PoseDict &poseDict) {
+  DPGO_TRACE_ZONE("PGOAgent::updateNeighborTransformCandidates");
+  lock_guard<mutex> lock(mNeighborPosesMutex);
+  bool changed = false;
+  // Each candidate corresponds to a single inter-robot loop closure
   for (const auto &m : mPoseGraph->sharedLoopClosuresWithRobot(neighborID)) {
     PoseID nbr_pose_id;
     nbr_pose_id.robot_id = neighborID;
@@ -562,16 +951,41 @@ bool PGOAgent::computeRobustNeighborTransformTwoStage(unsigned int neighborID,
     else
       nbr_pose_id.frame_id = m.p2;
     const auto &it = poseDict.find(nbr_pose_id);
-    if (it != poseDict.end()) {
-      const auto T = computeNeighborTransform(m, it->second);
-      RVec.emplace_back(T.rotation());
-      tVec.emplace_back(T.translation());
+    if (it == poseDict.end()) continue;
+    const EdgeID edge_id(PoseID(m.r1, m.p1), PoseID(m.r2, m.p2));
+    auto candidate = mNeighborTransformCandidates.find(edge_id);
+    if (candidate != mNeighborTransformCandidates.end() &&
+        (candidate->second.neighborPose - it->second.pose()).lpNorm<Eigen::Infinity>() <= kNeighborTransformPoseTol)
+      continue;
+    NeighborTransformCandidate updated{it->second.pose(), computeNeighborTransform(m, it->second)};
+    if (candidate == mNeighborTransformCandidates.end())
+      mNeighborTransformCandidates.emplace(edge_id, std::move(updated));
+    else
+      candidate->second = std::move(updated);
+    changed = true;
+  }
+  return changed;
+}
+
+void PGOAgent::clearNeighborTransformCandidates() {
+  lock_guard<mutex> lock(mNeighborPosesMutex);
+  mNeighborTransformCandidates.clear();
+}
+
+bool PGOAgent::computeRobustNeighborTransformTwoStage(Pose *T_world_robot) {
+  DPGO_TRACE_ZONE("PGOAgent::computeRobustNeighborTransformTwoStage");
+  std::vector<Matrix> RVec;
+  std::vector<Vector> tVec;
+  {
+    lock_guard<mutex> lock(mNeighborPosesMutex);
+    for (const auto &it : mNeighborTransformCandidates) {
+      RVec.emplace_back(it.second.T_world_robot.rotation());
+      tVec.emplace_back(it.second.T_world_robot.translation());
     }
   }
   if (RVec.empty()) return false;
   int m = (int) RVec.size();
   const Vector kappa = Vector::Ones(m);
-  const Vector tau = Vector::Ones(m);
   Matrix ROpt;
   Vector tOpt;
   std::vector<size_t> inlierIndices;
@@ -580,8 +994,8 @@ bool PGOAgent::computeRobustNeighborTransformTwoStage(unsigned int neighborID,
   double maxRotationError = angular2ChordalSO3(0.5);  // approximately 30 deg
   robustSingleRotationAveraging(ROpt, inlierIndices, RVec, kappa, maxRotationError);
   int inlierSize = (int) inlierIndices.size();
-  printf("Robot %u attempts initialization from neighbor %u: finds %i/%i inliers.\n",
-         getID(), neighborID, inlierSize, m);
+  printf("Robot %u attempts initialization from neighbors: finds %i/%i inliers.\n",
+         getID(), inlierSize, m);
 
   // Return if robust rotation averaging fails to find any inlier
   if (inlierIndices.size() < mParams.robustInitMinInliers) return false;
@@ -601,25 +1015,15 @@ bool PGOAgent::computeRobustNeighborTransformTwoStage(unsigned int neighborID,
   return true;
 }
 
-bool PGOAgent::computeRobustNeighborTransform(unsigned int neighborID,
-                                              const PoseDict &poseDict,
-                                              Pose *T_world_robot) {
+bool PGOAgent::computeRobustNeighborTransform(Pose *T_world_robot) {
+  DPGO_TRACE_ZONE("PGOAgent::computeRobustNeighborTransform");
   std::vector<Matrix> RVec;
   std::vector<Vector> tVec;
-  // Populate candidate alignments
-  // Each alignment corresponds to a single inter-robot loop closure
-  for (const auto &m : mPoseGraph->sharedLoopClosuresWithRobot(neighborID)) {
-    PoseID nbr_pose_id;
-    nbr_pose_id.robot_id = neighborID;
-    if (m.r1 == neighborID)
-      nbr_pose_id.frame_id = m.p1;
-    else
-      nbr_pose_id.frame_id = m.p2;
-    const auto &it = poseDict.find(nbr_pose_id);
-    if (it != poseDict.end()) {
-      const auto T = computeNeighborTransform(m, it->second);
-      RVec.emplace_back(T.rotation());
-      tVec.emplace_back(T.translation());
+  {
+    lock_guard<mutex> lock(mNeighborPosesMutex);
+    for (const auto &it : mNeighborTransformCandidates) {
+      RVec.emplace_back(it.second.T_world_robot.rotation());
+      tVec.emplace_back(it.second.T_world_robot.translation());
     }
   }
   if (RVec.empty()) return false;
@@ -633,8 +1037,8 @@ bool PGOAgent::computeRobustNeighborTransform(unsigned int neighborID,
   std::vector<size_t> inlierIndices;
   robustSinglePoseAveraging(ROpt, tOpt, inlierIndices, RVec, tVec, kappa, tau, cbar);
   int inlierSize = (int) inlierIndices.size();
-  printf("Robot %u attempts initialization from neighbor %u: finds %i/%i inliers.\n",
-         getID(), neighborID, inlierSize, m);
+  printf("Robot %u attempts initialization from neighbors: finds %i/%i inliers.\n",
+         getID(), inlierSize, m);
 
   // Return if fails to identify any inlier
   if (inlierIndices.size() < mParams.robustInitMinInliers) return false;
@@ -656,8 +1060,10 @@ void PGOAgent::updateNeighborPoses(unsigned neighborID, const PoseDict &poseDict
   if (getNeighborStatus(neighborID).state != PGOAgentState::INITIALIZED)
     return;
   if (mState == PGOAgentState::WAIT_FOR_INITIALIZATION) {
+    // Robust averaging only needs to be repeated when the candidates from some neighbor have changed
     Pose T_world_robot(dimension());
-    if (computeRobustNeighborTransformTwoStage(neighborID, poseDict, &T_world_robot)) {
+    if (updateNeighborTransformCandidates(neighborID, poseDict) &&
+        computeRobustNeighborTransformTwoStage(&T_world_robot)) {
       initializeInGlobalFrame(T_world_robot);
     }
   }
@@ -673,7 +1079,7 @@ void PGOAgent::updateNeighborPoses(unsigned neighborID, const PoseDict &poseDict
     CHECK_EQ(var.d(), d);
     if (!mPoseGraph->requireNeighborPose(nID))
       continue;
-    neighborPoseDict[nID] = var;
+    neighborPoseStore.set(nID, var);
   }
 }
 
@@ -697,21 +1103,123 @@ void PGOAgent::updateAuxNeighborPoses(unsigned neighborID, const PoseDict &poseD
     CHECK(var.d() == d);
     if (!mPoseGraph->requireNeighborPose(nID))
       continue;
-    neighborAuxPoseDict[nID] = var;
+    neighborAuxPoseStore.set(nID, var);
+  }
+}
+
+bool PGOAgent::updateNeighborPosesFromBuffer(const uint8_t *buffer, size_t size) {
+  PoseMessageView view;
+  if (!view.parse(buffer, size))
+    return false;
+  const unsigned neighborID = view.header().sender;
+  if (view.header().r != r || view.header().d != d) {
+    LOG(WARNING) << "Received poses with incompatible dimensions from robot " << neighborID << ".";
+    return false;
+  }
+  // Before initialization, fall back to the PoseDict interface which also handles robust initialization
+  if (mState != PGOAgentState::INITIALIZED) {
+    if (view.isAuxiliary())
+      return true;
+    PoseDict poseDict;
+    decodePoseDict(buffer, size, poseDict);
+    updateNeighborPoses(neighborID, poseDict);
+    return true;
+  }
+  if (view.isAuxiliary())
+    CHECK(mParams.acceleration);
+  CHECK(neighborID != mID);
+  if (!hasNeighborStatus(neighborID))
+    return true;
+  if (getNeighborStatus(neighborID).state != PGOAgentState::INITIALIZED)
+    return true;
+  // Decode directly into the local cache
+  lock_guard<mutex> lock(mNeighborPosesMutex);
+  LiftedPoseStore &cache = view.isAuxiliary() ? neighborAuxPoseStore : neighborPoseStore;
+  for (size_t i = 0; i < view.size(); ++i) {
+    const PoseID nID = view.poseID(i);
+    CHECK_EQ(nID.robot_id, neighborID);
+    if (!mPoseGraph->requireNeighborPose(nID))
+      continue;
+    view.copyPose(i, cache.poseData(cache.insert(nID)));
+  }
+  return true;
+}
+
+void PGOAgent::setCommunicator(std::shared_ptr<Communicator> communicator) {
+  CHECK(!isOptimizationRunning());
+  if (communicator)
+    CHECK_LT(getID(), communicator->numAgents());
+  mCommunicator = std::move(communicator);
+}
+
+void PGOAgent::receiveMessages() {
+  DPGO_TRACE_ZONE("PGOAgent::receiveMessages");
+  CHECK(mCommunicator);
+  mCommunicator->receive(getID(), [this](const uint8_t *data, size_t size) {
+    mIterationTelemetry.bytesReceived += size;
+    MessageHeader header{};
+    if (!readMessageHeader(data, size, header))
+      return;
+    if (header.sender == getID())
+      return;
+    switch (static_cast<MessageType>(header.type)) {
+      case MessageType::AgentStatus: {
+        PGOAgentStatus status;
+        if (decodeStatus(data, size, status))
+          setNeighborStatus(status);
+        break;
+      }
+      case MessageType::PoseDict: {
+        updateNeighborPosesFromBuffer(data, size);
+        break;
+      }
+      case MessageType::AuxPoseDict: {
+        if (mParams.acceleration)
+          updateNeighborPosesFromBuffer(data, size);
+        break;
+      }
+      default: {
+        LOG(WARNING) << "Robot " << getID() << " ignores message of type "
+                     << static_cast<int>(header.type) << " from robot " << header.sender << ".";
+        break;
+      }
+    }
+  });
+}
+
+void PGOAgent::publishMessages() {
+  DPGO_TRACE_ZONE("PGOAgent::publishMessages");
+  CHECK(mCommunicator);
+  mMessageBuffer.resize(statusMessageSize());
+  if (encodeStatus(getStatus(), mMessageBuffer.data(), mMessageBuffer.size()) > 0 &&
+      mCommunicator->publish(getID(), mMessageBuffer.data(), statusMessageSize()))
+    mIterationTelemetry.bytesSent += statusMessageSize();
+  if (mState != PGOAgentState::INITIALIZED)
+    return;
+  if (mPublishPublicPosesRequested) {
+    size_t bytes = encodeSharedPoses(mMessageBuffer);
+    if (bytes > 0 && mCommunicator->publish(getID(), mMessageBuffer.data(), bytes))
+      mIterationTelemetry.bytesSent += bytes;
+    if (mParams.acceleration) {
+      bytes = encodeSharedPoses(mMessageBuffer, true);
+      if (bytes > 0 && mCommunicator->publish(getID(), mMessageBuffer.data(), bytes))
+        mIterationTelemetry.bytesSent += bytes;
+    }
+    mPublishPublicPosesRequested = false;
   }
 }
 
 void PGOAgent::clearNeighborPoses() {
   lock_guard<mutex> lock(mNeighborPosesMutex);
-  neighborPoseDict.clear();
-  neighborAuxPoseDict.clear();
+  neighborPoseStore.clear();
+  neighborAuxPoseStore.clear();
 }
 
 void PGOAgent::clearActiveNeighborPoses() {
   lock_guard<mutex> lock(mNeighborPosesMutex);
   for (const auto &pose_id : mPoseGraph->activeNeighborPublicPoseIDs()) {
-    neighborPoseDict.erase(pose_id);
-    neighborAuxPoseDict.erase(pose_id);
+    neighborPoseStore.erase(pose_id);
+    neighborAuxPoseStore.erase(pose_id);
   }
 }
 
@@ -794,14 +1302,12 @@ bool PGOAgent::getNeighborPoseInGlobalFrame(unsigned int neighborID, unsigned in
   if (mState != PGOAgentState::INITIALIZED) return false;
   lock_guard<mutex> lock(mNeighborPosesMutex);
   PoseID nID(neighborID, poseID);
-  if (neighborPoseDict.find(nID) != neighborPoseDict.end()) {
+  const size_t index = neighborPoseStore.find(nID);
+  if (index != LiftedPoseStore::npos) {
     Matrix Ya = Xa.rotation();
     Matrix pa = Xa.translation();
     Matrix t0 = Ya.transpose() * pa;
-    auto Xi = neighborPoseDict.at(nID);
-    CHECK(Xi.r() == r);
-    CHECK(Xi.d() == d);
-    Pose Ti(Ya.transpose() * Xi.pose());
+    Pose Ti(Ya.transpose() * neighborPoseStore.pose(index));
     Ti.translation() -= t0;
     T = Ti.pose();
     return true;
@@ -852,7 +1358,7 @@ bool PGOAgent::shouldTerminate() {
 
   // Do not terminate if not update measurement weights for sufficiently many times
   if (mParams.robustCostParams.costType != RobustCostParameters::Type::L2) {
-    if (mWeightUpdateCount < mParams.robustOptNumWeightUpdates)
+    if (mWeightUpdateCount < mParams.robustOptNumWeightUpdates && !measurementWeightsSettled())
       return false;
   }
 
@@ -936,10 +1442,19 @@ void PGOAgent::updateV() {
 }
 
 bool PGOAgent::updateX(bool doOptimization, bool acceleration) {
+  DPGO_TRACE_ZONE("PGOAgent::updateX");
   // Lock during local optimization
-  unique_lock<mutex> tLock(mPosesMutex);
-  unique_lock<mutex> mLock(mMeasurementsMutex);
-  unique_lock<mutex> nLock(mNeighborPosesMutex);
+  const auto lockStart = SimpleTimer::Tic();
+  unique_lock<mutex> tLock(mPosesMutex, std::defer_lock);
+  unique_lock<mutex> mLock(mMeasurementsMutex, std::defer_lock);
+  unique_lock<mutex> nLock(mNeighborPosesMutex, std::defer_lock);
+  {
+    DPGO_TRACE_ZONE("PGOAgent::updateX/lockWait");
+    tLock.lock();
+    mLock.lock();
+    nLock.lock();
+  }
+  mIterationTelemetry.lockWaitMs += SimpleTimer::Toc(lockStart);
   if (!doOptimization) {
     if (acceleration) {
       X = Y;
@@ -952,12 +1467,15 @@ bool PGOAgent::updateX(bool doOptimization, bool acceleration) {
 
   // Initialize pose graph for optimization
   if (acceleration) {
-    mPoseGraph->setNeighborPoses(neighborAuxPoseDict);
+    mPoseGraph->setNeighborPoses(neighborAuxPoseStore);
   } else {
-    mPoseGraph->setNeighborPoses(neighborPoseDict);
+    mPoseGraph->setNeighborPoses(neighborPoseStore);
   }
+  if (mParams.slidingWindowSize > 0)
+    updateSlidingWindow();
 
   // Skip optimization if cannot construct data matrices for some reason
+  mPoseGraph->clearTimingStatistics();
   if (!mPoseGraph->constructDataMatrices()) {
     LOG(WARNING) << "Robot " << getID() << " cannot construct data matrices... Skip optimization.";
     mLocalOptResult = ROPTResult(false);
@@ -969,21 +1487,27 @@ bool PGOAgent::updateX(bool doOptimization, bool acceleration) {
   QuadraticOptimizer optimizer(&problem, mParams.localOptimizationParams);
   optimizer.setVerbose(mParams.verbose);
 
-  // Starting solution
-  Matrix X0;
-  if (acceleration) {
-    X0 = Y.getData();
-  } else {
-    X0 = X.getData();
+  // Starting solution (poses in the active window)
+  const unsigned windowStart = mPoseGraph->windowStart();
+  const unsigned windowSize = mPoseGraph->numActivePoses();
+  Matrix X0(relaxation_rank(), (dimension() + 1) * windowSize);
+  for (unsigned i = 0; i < windowSize; ++i) {
+    X0.block(0, i * (dimension() + 1), relaxation_rank(), dimension() + 1) =
+        acceleration ? Y.pose(windowStart + i) : X.pose(windowStart + i);
   }
-  CHECK(X0.rows() == relaxation_rank());
-  CHECK(X0.cols() == (dimension() + 1) * num_poses());
 
   // Optimize!
-  X.setData(optimizer.optimize(X0));
+  const Matrix XOpt = optimizer.optimize(X0);
+  if (windowStart == 0) {
+    X.setData(XOpt);
+  } else {
+    for (unsigned i = 0; i < windowSize; ++i)
+      X.pose(windowStart + i) = XOpt.block(0, i * (dimension() + 1), relaxation_rank(), dimension() + 1);
+  }
 
   // Print optimization statistics
   mLocalOptResult = optimizer.getOptResult();
+  recordOptimizationTelemetry();
   if (mParams.verbose) {
     printf("df: %f, init_gradnorm: %f, opt_gradnorm: %f. \n",
            mLocalOptResult.fInit - mLocalOptResult.fOpt,
@@ -994,6 +1518,45 @@ bool PGOAgent::updateX(bool doOptimization, bool acceleration) {
   return true;
 }
 
+void PGOAgent::updateSlidingWindow() {
+  const unsigned n = num_poses();
+  const unsigned oldStart = mPoseGraph->windowStart();
+  const unsigned start = std::max(oldStart, n > mParams.slidingWindowSize ? n - mParams.slidingWindowSize : 0);
+  if (start > oldStart) {
+    LOG_IF(INFO, mParams.verbose) << "Robot " << getID() << " freezes poses " << oldStart << " to " << start - 1;
+    if (mParams.acceleration) {
+      // Keep the auxiliary iterates of frozen poses at the frozen estimates, such that
+      // the accelerated updates leave them unchanged
+      for (unsigned i = oldStart; i < start; ++i) {
+        Y.pose(i) = X.pose(i);
+        V.pose(i) = X.pose(i);
+      }
+    }
+  }
+  mPoseGraph->setWindow(start, X);
+}
+
+void PGOAgent::recordOptimizationTelemetry() {
+  IterationTelemetry &telemetry = mIterationTelemetry;
+  telemetry.optimized = true;
+  telemetry.constructQMs += mPoseGraph->constructQMs();
+  telemetry.constructGMs += mPoseGraph->constructGMs();
+  telemetry.constructPreconMs += mPoseGraph->constructPreconMs();
+  // The preconditioner is constructed lazily during optimization
+  telemetry.solveMs += std::max(0.0, mLocalOptResult.elapsedMs - mPoseGraph->constructPreconMs());
+  telemetry.RTRIterations += mLocalOptResult.numIterations;
+  telemetry.tCGIterations += mLocalOptResult.numInnerIterations;
+  if (mParams.localOptimizationParams.method == ROptParameters::ROptMethod::RTR &&
+      mLocalOptResult.numIterations > 0)
+    telemetry.tCGStatus = static_cast<int>(mLocalOptResult.tCGStatus);
+  telemetry.cost = mLocalOptResult.fOpt;
+  telemetry.gradNorm = mLocalOptResult.gradNormOpt;
+}
+
+bool PGOAgent::measurementWeightsSettled() const {
+  return mRobustCost.isAdaptiveGNC() && mWeightUpdateCount > 0 && mGNCUndecidedLoopClosures.empty();
+}
+
 bool PGOAgent::shouldUpdateMeasurementWeights() const {
   // No need to update weight if using L2 cost
   if (mParams.robustCostParams.costType == RobustCostParameters::Type::L2)
@@ -1004,6 +1567,12 @@ bool PGOAgent::shouldUpdateMeasurementWeights() const {
     return false;
   }
 
+  // With adaptive GNC, stop once the weights of all loop closures have settled
+  if (measurementWeightsSettled()) {
+    LOG_IF(INFO, mParams.verbose) << "All measurement weights settled.";
+    return false;
+  }
+
   // Return true if number of inner iterations exceeds threshold
   if (mRobustOptInnerIter >= mParams.robustOptInnerIters) {
     LOG_IF(INFO, mParams.verbose) << "Exceeds max inner iterations. Update weights.";
@@ -1052,11 +1621,14 @@ void PGOAgent::initializeRobustOptimization() {
   }
   mRobustCost.reset();
   unique_lock<mutex> lock(mMeasurementsMutex);
+  mGNCSettledLoopClosures.clear();
+  mGNCUndecidedLoopClosures.clear();
   for (RelativeSEMeasurement *m : mPoseGraph->activeLoopClosures()) {
     if (!m->fixedWeight) {
       m->weight = 1.0;
     }
   }
+  mPoseGraph->applyWeightChanges();
 }
 
 bool PGOAgent::computeMeasurementResidual(
@@ -1079,22 +1651,22 @@ bool PGOAgent::computeMeasurementResidual(
       Y1 = X.rotation(measurement.p1);
       p1 = X.translation(measurement.p1);
       const PoseID nbrPoseID(measurement.r2, measurement.p2);
-      auto KVpair = neighborPoseDict.find(nbrPoseID);
-      if (KVpair == neighborPoseDict.end()) {
+      const size_t index = neighborPoseStore.find(nbrPoseID);
+      if (index == LiftedPoseStore::npos) {
         return false;
       }
-      Y2 = KVpair->second.rotation();
-      p2 = KVpair->second.translation();
+      Y2 = neighborPoseStore.pose(index).leftCols(d);
+      p2 = neighborPoseStore.pose(index).col(d);
     } else {
       Y2 = X.rotation(measurement.p2);
       p2 = X.translation(measurement.p2);
       const PoseID nbrPoseID(measurement.r1, measurement.p1);
-      auto KVpair = neighborPoseDict.find(nbrPoseID);
-      if (KVpair == neighborPoseDict.end()) {
+      const size_t index = neighborPoseStore.find(nbrPoseID);
+      if (index == LiftedPoseStore::npos) {
         return false;
       }
-      Y1 = KVpair->second.rotation();
-      p1 = KVpair->second.translation();
+      Y1 = neighborPoseStore.pose(index).leftCols(d);
+      p1 = neighborPoseStore.pose(index).col(d);
     }
   }
   *residual = std::sqrt(computeMeasurementError(measurement, Y1, p1, Y2, p2));
@@ -1107,20 +1679,61 @@ void PGOAgent::updateMeasurementWeights() {
     return;
   }
   unique_lock<mutex> lock(mMeasurementsMutex);
-  double residual = 0;
+  // Gather loop closures with the storage of their poses, and evaluate all residuals in one batch
+  mWeightUpdateMeasurements.clear();
+  mWeightUpdatePoses1.clear();
+  mWeightUpdatePoses2.clear();
+  size_t numLoopClosures = 0;
   for (auto &m : mPoseGraph->activeLoopClosures()) {
     if (m->fixedWeight) continue;
-    if (computeMeasurementResidual(*m, &residual)) {
-      m->weight = mRobustCost.weight(residual);
+    numLoopClosures++;
+    if (mGNCSettledLoopClosures.count(EdgeID(PoseID(m->r1, m->p1), PoseID(m->r2, m->p2)))) continue;
+    const double *pose1 = nullptr;
+    const double *pose2 = nullptr;
+    if (m->r1 == getID()) {
+      pose1 = X.poseData(m->p1);
     } else {
+      const size_t index = neighborPoseStore.find(PoseID(m->r1, m->p1));
+      if (index != LiftedPoseStore::npos) pose1 = neighborPoseStore.poseData(index);
+    }
+    if (m->r2 == getID()) {
+      pose2 = X.poseData(m->p2);
+    } else {
+      const size_t index = neighborPoseStore.find(PoseID(m->r2, m->p2));
+      if (index != LiftedPoseStore::npos) pose2 = neighborPoseStore.poseData(index);
+    }
+    if (!pose1 || !pose2) {
       LOG(WARNING) << "Failed to update weight for edge: \n" << *m;
+      continue;
+    }
+    mWeightUpdateMeasurements.push_back(m);
+    mWeightUpdatePoses1.push_back(pose1);
+    mWeightUpdatePoses2.push_back(pose2);
+  }
+  computeMeasurementResiduals(mWeightUpdateMeasurements, mWeightUpdatePoses1, mWeightUpdatePoses2,
+                              relaxation_rank(), mWeightUpdateResiduals);
+  mRobustCost.weights(mWeightUpdateResiduals, mWeightUpdateWeights);
+  mGNCUndecidedLoopClosures.clear();
+  for (size_t i = 0; i < mWeightUpdateMeasurements.size(); ++i) {
+    RelativeSEMeasurement *m = mWeightUpdateMeasurements[i];
+    m->weight = mWeightUpdateWeights(i);
+    const EdgeID edgeID(PoseID(m->r1, m->p1), PoseID(m->r2, m->p2));
+    if (!mRobustCost.isSettled(m->weight)) {
+      mGNCUndecidedLoopClosures.push_back(edgeID);
+    } else if (mRobustCost.isAdaptiveGNC()) {
+      mGNCSettledLoopClosures.insert(edgeID);
     }
   }
+  // Settled loop closures that are no longer evaluated count as decided (same as solveRobustPGO)
+  const double undecidedRatio = numLoopClosures == 0 ? 0.0 :
+                                (double) mGNCUndecidedLoopClosures.size() / numLoopClosures;
+  LOG_IF(INFO, mParams.verbose) << "Robot " << getID() << " updated " << mWeightUpdateMeasurements.size()
+                                << " weights, " << mGNCUndecidedLoopClosures.size() << " undecided.";
   mWeightUpdateCount++;
   mLatestWeightUpdateIteration = iteration_number();
   mRobustOptInnerIter = 0;
-  mPoseGraph->clearDataMatrices();
-  mRobustCost.update();
+  mPoseGraph->applyWeightChanges();
+  mRobustCost.update(undecidedRatio);
   mTeamStatus.clear();
   mStatus.readyToTerminate = false;
   mStatus.relativeChange = 0;
@@ -1141,6 +1754,11 @@ void PGOAgent::updateMeasurementWeights() {
   }
 }
 
+std::vector<EdgeID> PGOAgent::getUndecidedLoopClosures() {
+  unique_lock<mutex> lock(mMeasurementsMutex);
+  return mGNCUndecidedLoopClosures;
+}
+
 bool PGOAgent::setMeasurementWeight(const PoseID &src_ID, const PoseID &dst_ID,
                                     double weight, bool fixed_weight) {
   RelativeSEMeasurement *m = mPoseGraph->findMeasurement(src_ID, dst_ID);
@@ -5,79 +5,229 @@
  * See LICENSE for the license information
  * -------------------------------------------------------------------------- */
 #include <DPGO/PGOLogger.h>
+#include <DPGO/DPGO_utils.h>
 #include <Eigen/Geometry>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <unordered_map>
 #include <utility>
 #include <glog/logging.h>
 
 namespace DPGO {
 
-PGOLogger::PGOLogger(std::string logDir) : logDirectory(std::move(logDir)) {}
+namespace {
+// Row-oriented CSV formatting into a memory buffer, written to file at once
+class CSVWriter {
+ public:
+  explicit CSVWriter(const char *header) : buffer_(header) { buffer_ += '\n'; }
+  template<typename T>
+  CSVWriter &operator<<(T value) {
+    char str[32];
+    auto result = std::to_chars(str, str + sizeof(str), value);
+    buffer_.append(str, result.ptr);
+    buffer_ += ',';
+    return *this;
+  }
+  void endRow() { buffer_.back() = '\n'; }
+  void reserveRows(size_t rows, size_t bytesPerRow) { buffer_.reserve(buffer_.size() + rows * bytesPerRow); }
+  bool write(const std::string &filename) const {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      LOG(WARNING) << "Cannot write to file " << filename << ".";
+      return false;
+    }
+    file.write(buffer_.data(), buffer_.size());
+    return file.good();
+  }
 
-PGOLogger::~PGOLogger() = default;
+ private:
+  std::string buffer_;
+};
 
-void PGOLogger::logMeasurements(std::vector<RelativeSEMeasurement> &measurements, const std::string &filename) {
-  if (measurements.empty()) return;
+double rotationAngle(const Matrix &R) {
+  return std::atan2(R(1, 0), R(0, 0));
+}
+
+void writeTrajectory(unsigned d, unsigned n, const Matrix &T, const std::string &filename) {
+  CSVWriter csv(d == 2 ? "pose_index,theta,tx,ty" : "pose_index,qx,qy,qz,qw,tx,ty,tz");
+  csv.reserveRows(n, 24 * (d + 5));
+  for (size_t i = 0; i < n; ++i) {
+    const Matrix R = T.block(0, i * (d + 1), d, d);
+    const Vector t = T.block(0, i * (d + 1) + d, d, 1);
+    csv << i;
+    if (d == 2) {
+      csv << rotationAngle(R) << t(0) << t(1);
+    } else {
+      const Eigen::Matrix3d R3 = R;
+      Eigen::Quaternion<double> quat(R3);
+      csv << quat.x() << quat.y() << quat.z() << quat.w() << t(0) << t(1) << t(2);
+    }
+    csv.endRow();
+  }
+  csv.write(filename);
+}
+
+// Project a lifted iterate to a trajectory expressed in the frame of the anchor
+Matrix roundLiftedTrajectory(unsigned d, unsigned n, const Matrix &X, const Matrix &anchor) {
+  const Matrix Ra = anchor.block(0, 0, anchor.rows(), d);
+  const Vector t0 = Ra.transpose() * anchor.col(d);
+  Matrix T = Ra.transpose() * X;
+  for (unsigned i = 0; i < n; ++i) {
+    T.block(0, i * (d + 1), d, d) = projectToRotationGroup(T.block(0, i * (d + 1), d, d));
+    T.col(i * (d + 1) + d) -= t0;
+  }
+  return T;
+}
 
-  std::ofstream file;
-  file.open(logDirectory + filename);
-  if (!file.is_open()) return;
-
-  size_t d = measurements[0].R.rows();
-  if (d == 2) return;
-
-  // Insert header row
-  file << "robot_src,pose_src,robot_dst,pose_dst,qx,qy,qz,qw,tx,ty,tz,kappa,tau,is_known_inlier,weight\n";
-
-  for (RelativeSEMeasurement m: measurements) {
-    // Convert rotation matrix to quaternion
-    Eigen::Matrix3d R = m.R;
-    Eigen::Quaternion<double> quat(R);
-    file << m.r1 << ",";
-    file << m.p1 << ",";
-    file << m.r2 << ",";
-    file << m.p2 << ",";
-    file << quat.x() << ",";
-    file << quat.y() << ",";
-    file << quat.z() << ",";
-    file << quat.w() << ",";
-    file << m.t(0) << ",";
-    file << m.t(1) << ",";
-    file << m.t(2) << ",";
-    file << m.kappa << ",";
-    file << m.tau << ",";
-    file << m.fixedWeight << ",";
-    file << m.weight << "\n";
+// Split a CSV line into exactly num_fields numeric fields, return false if the line is malformed
+bool parseCSVLine(const std::string &line, size_t num_fields, std::vector<double> &values) {
+  values.clear();
+  std::istringstream ss(line);
+  std::string token;
+  while (std::getline(ss, token, ',')) {
+    char *end = nullptr;
+    const double value = std::strtod(token.c_str(), &end);
+    if (end == token.c_str() || *end != '\0') return false;
+    values.push_back(value);
+  }
+  return values.size() == num_fields;
+}
+
+size_t countColumns(const std::string &header) {
+  return std::count(header.begin(), header.end(), ',') + 1;
+}
+}  // namespace
+
+PGOLogger::PGOLogger(std::string logDir, size_t queueCapacity)
+    : logDirectory(std::move(logDir)), mQueueCapacity(std::max<size_t>(1, queueCapacity)) {}
+
+PGOLogger::~PGOLogger() {
+  {
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+    mStopRequested = true;
+  }
+  mQueueCondition.notify_all();
+  if (mThread.joinable()) mThread.join();
+}
+
+bool PGOLogger::enqueue(Task task, bool dropIfFull) {
+  std::unique_lock<std::mutex> lock(mQueueMutex);
+  if (!mThread.joinable()) mThread = std::thread(&PGOLogger::run, this);
+  if (mQueue.size() >= mQueueCapacity) {
+    if (dropIfFull) {
+      mNumDropped++;
+      return false;
+    }
+    mQueueCondition.wait(lock, [this] { return mQueue.size() < mQueueCapacity; });
   }
+  mQueue.push_back(std::move(task));
+  lock.unlock();
+  mQueueCondition.notify_all();
+  return true;
+}
 
-  file.close();
+void PGOLogger::run() {
+  std::unique_lock<std::mutex> lock(mQueueMutex);
+  while (true) {
+    mQueueCondition.wait(lock, [this] { return mStopRequested || !mQueue.empty(); });
+    // Pending entries are always written before exiting
+    if (mQueue.empty()) return;
+    Task task = std::move(mQueue.front());
+    mQueue.pop_front();
+    mBusy = true;
+    lock.unlock();
+    mQueueCondition.notify_all();
+    task();
+    lock.lock();
+    mBusy = false;
+    mQueueCondition.notify_all();
+  }
+}
+
+void PGOLogger::flush() {
+  std::unique_lock<std::mutex> lock(mQueueMutex);
+  mQueueCondition.wait(lock, [this] { return mQueue.empty() && !mBusy; });
+}
+
+size_t PGOLogger::numDroppedEntries() const {
+  std::lock_guard<std::mutex> lock(mQueueMutex);
+  return mNumDropped;
+}
+
+void PGOLogger::logMeasurements(const std::vector<RelativeSEMeasurement> &measurements, const std::string &filename) {
+  if (measurements.empty()) return;
+  enqueue([measurements, path = logDirectory + filename]() {
+    const size_t d = measurements[0].R.rows();
+    CSVWriter csv(d == 2 ?
+                  "robot_src,pose_src,robot_dst,pose_dst,theta,tx,ty,kappa,tau,is_known_inlier,weight" :
+                  "robot_src,pose_src,robot_dst,pose_dst,qx,qy,qz,qw,tx,ty,tz,kappa,tau,is_known_inlier,weight");
+    csv.reserveRows(measurements.size(), 24 * (d + 12));
+    for (const RelativeSEMeasurement &m: measurements) {
+      csv << m.r1 << m.p1 << m.r2 << m.p2;
+      if (d == 2) {
+        csv << rotationAngle(m.R) << m.t(0) << m.t(1);
+      } else {
+        // Convert rotation matrix to quaternion
+        const Eigen::Matrix3d R = m.R;
+        Eigen::Quaternion<double> quat(R);
+        csv << quat.x() << quat.y() << quat.z() << quat.w() << m.t(0) << m.t(1) << m.t(2);
+      }
+      csv << m.kappa << m.tau << static_cast<int>(m.fixedWeight) << m.weight;
+      csv.endRow();
+    }
+    csv.write(path);
+  }, false);
 }
 
 void PGOLogger::logTrajectory(unsigned int d, unsigned int n, const Matrix &T, const std::string &filename) {
-  if (d == 2) return;
+  CHECK(d == 2 || d == 3);
   CHECK_EQ(T.rows(), d);
   CHECK_EQ(T.cols(), (d + 1) * n);
-  std::ofstream file;
-  file.open(logDirectory + filename);
-  if (!file.is_open()) return;
+  enqueue([d, n, T, path = logDirectory + filename]() {
+    writeTrajectory(d, n, T, path);
+  }, false);
+}
 
-  // Insert header row
-  file << "pose_index,qx,qy,qz,qw,tx,ty,tz\n";
+bool PGOLogger::logLiftedTrajectory(unsigned d, unsigned n, const Matrix &X, const Matrix &anchor,
+                                    const std::string &filename) {
+  CHECK(d == 2 || d == 3);
+  CHECK_EQ(X.cols(), (d + 1) * n);
+  CHECK_EQ(anchor.rows(), X.rows());
+  CHECK_EQ(anchor.cols(), d + 1);
+  return enqueue([d, n, X, anchor, path = logDirectory + filename]() {
+    writeTrajectory(d, n, roundLiftedTrajectory(d, n, X, anchor), path);
+  }, true);
+}
 
-  for (size_t i = 0; i < n; ++i) {
-    Eigen::Matrix3d R = T.block(0, i * (d + 1), d, d);
-    Eigen::Quaternion<double> quat(R);
-    Matrix t = T.block(0, i * (d + 1) + d, d, 1);
-    file << i << ",";
-    file << quat.x() << ",";
-    file << quat.y() << ",";
-    file << quat.z() << ",";
-    file << quat.w() << ",";
-    file << t(0) << ",";
-    file << t(1) << ",";
-    file << t(2) << "\n";
-  }
+void PGOLogger::logMatrix(const Matrix &M, const std::string &filename) {
+  enqueue([M, path = logDirectory + filename]() {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      LOG(WARNING) << "Cannot write to file " << path << ".";
+      return;
+    }
+    const uint64_t size[2] = {static_cast<uint64_t>(M.rows()), static_cast<uint64_t>(M.cols())};
+    file.write(reinterpret_cast<const char *>(size), sizeof(size));
+    file.write(reinterpret_cast<const char *>(M.data()), sizeof(double) * M.size());
+  }, false);
+}
 
-  file.close();
+Matrix PGOLogger::loadMatrix(const std::string &filename) {
+  std::ifstream file(filename, std::ios::binary);
+  uint64_t size[2];
+  if (!file.read(reinterpret_cast<char *>(size), sizeof(size))) {
+    LOG(WARNING) << "Could not read matrix from " << filename << ".";
+    return Matrix(0, 0);
+  }
+  Matrix M(size[0], size[1]);
+  if (!file.read(reinterpret_cast<char *>(M.data()), sizeof(double) * M.size())) {
+    LOG(WARNING) << "Could not read matrix from " << filename << ".";
+    return Matrix(0, 0);
+  }
+  return M;
 }
 
 Matrix PGOLogger::loadTrajectory(const std::string &filename) {
@@ -89,56 +239,44 @@ Matrix PGOLogger::loadTrajectory(const std::string &filename) {
   }
 
   std::unordered_map<uint32_t, Matrix> Tmap;
-
-  // Scalars that will be populated
-  uint32_t pose_id = 0;
   uint32_t num_poses = 0;
-  double qx, qy, qz, qw;
-  double tx, ty, tz;
-
   std::string line;
-  std::string token;
 
-  // Skip first line (headers)
+  // Infer dimension from the header
   std::getline(infile, line);
+  const unsigned d = countColumns(line) == 4 ? 2 : 3;
 
   // Iterate over remaining lines
+  std::vector<double> values;
   while (std::getline(infile, line)) {
-    std::istringstream ss(line);
+    if (line.empty()) continue;
+    if (!parseCSVLine(line, d == 2 ? 4 : 8, values)) {
+      LOG(WARNING) << "Malformed line in " << filename << ": " << line;
+      return Matrix(0, 0);
+    }
     num_poses++;
-
-    std::getline(ss, token, ',');
-    pose_id = std::stoi(token);
-
-    std::getline(ss, token, ',');
-    qx = std::stod(token);
-    std::getline(ss, token, ',');
-    qy = std::stod(token);
-    std::getline(ss, token, ',');
-    qz = std::stod(token);
-    std::getline(ss, token, ',');
-    qw = std::stod(token);
-    Eigen::Quaternion<double> quat(qw, qx, qy, qz);
-    quat.normalize();
-
-    std::getline(ss, token, ',');
-    tx = std::stod(token);
-    std::getline(ss, token, ',');
-    ty = std::stod(token);
-    std::getline(ss, token, ',');
-    tz = std::stod(token);
-    Eigen::Vector3d tVec;
-    tVec << tx, ty, tz;
-
-    Matrix Ti(3, 4);
-    Ti.block(0, 0, 3, 3) = quat.toRotationMatrix();
-    Ti.block(0, 3, 3, 1) = tVec;
+    const auto pose_id = static_cast<uint32_t>(values[0]);
+    Matrix Ti(d, d + 1);
+    if (d == 2) {
+      Ti.block(0, 0, 2, 2) = Eigen::Rotation2Dd(values[1]).toRotationMatrix();
+      Ti.col(2) << values[2], values[3];
+    } else {
+      Eigen::Quaternion<double> quat(values[4], values[1], values[2], values[3]);
+      quat.normalize();
+      Ti.block(0, 0, 3, 3) = quat.toRotationMatrix();
+      Ti.col(3) << values[5], values[6], values[7];
+    }
     Tmap.emplace(pose_id, Ti);
   }
 
-  Matrix T = Matrix(3, 4 * num_poses);
+  Matrix T = Matrix(d, (d + 1) * num_poses);
   for (unsigned i = 0; i < num_poses; ++i) {
-    T.block(0, 4 * i, 3, 4) = Tmap.at(i);
+    const auto it = Tmap.find(i);
+    if (it == Tmap.end()) {
+      LOG(WARNING) << "Missing pose " << i << " in " << filename << ".";
+      return Matrix(0, 0);
+    }
+    T.block(0, (d + 1) * i, d, d + 1) = it->second;
   }
 
   std::cout << "Loaded " << num_poses << " poses." << std::endl;
@@ -155,67 +293,44 @@ std::vector<RelativeSEMeasurement> PGOLogger::loadMeasurements(const std::string
     return measurements;
   }
 
-  // Scalars that will be filled upon reading each measurement
-  uint32_t robot_src, robot_dst, pose_src, pose_dst;
-  double qx, qy, qz, qw;
-  double tx, ty, tz;
-  double kappa, tau, weight;
-  bool fixed_weight;
-
   std::string line;
-  std::string token;
 
-  // Skip first line (headers)
+  // Infer dimension from the header
   std::getline(infile, line);
+  const unsigned d = countColumns(line) == 11 ? 2 : 3;
 
   // Iterate over remaining lines
+  std::vector<double> values;
   while (std::getline(infile, line)) {
-    std::istringstream ss(line);
-
-    std::getline(ss, token, ',');
-    robot_src = std::stoi(token);
-    std::getline(ss, token, ',');
-    pose_src = std::stoi(token);
-    std::getline(ss, token, ',');
-    robot_dst = std::stoi(token);
-    std::getline(ss, token, ',');
-    pose_dst = std::stoi(token);
-
-    std::getline(ss, token, ',');
-    qx = std::stod(token);
-    std::getline(ss, token, ',');
-    qy = std::stod(token);
-    std::getline(ss, token, ',');
-    qz = std::stod(token);
-    std::getline(ss, token, ',');
-    qw = std::stod(token);
-    Eigen::Quaternion<double> quat(qw, qx, qy, qz);
-    quat.normalize();
-
-    std::getline(ss, token, ',');
-    tx = std::stod(token);
-    std::getline(ss, token, ',');
-    ty = std::stod(token);
-    std::getline(ss, token, ',');
-    tz = std::stod(token);
-    Eigen::Vector3d tVec;
-    tVec << tx, ty, tz;
-
-    std::getline(ss, token, ',');
-    kappa = std::stod(token);
-    std::getline(ss, token, ',');
-    tau = std::stod(token);
-    std::getline(ss, token, ',');
-    fixed_weight = std::stoi(token);
-    std::getline(ss, token, ',');
-    weight = std::stod(token);
-
-    RelativeSEMeasurement m(robot_src, robot_dst, pose_src, pose_dst,
-                            quat.toRotationMatrix(), tVec,
-                            kappa, tau);
-    m.fixedWeight = fixed_weight;
+    if (line.empty()) continue;
+    if (!parseCSVLine(line, d == 2 ? 11 : 15, values)) {
+      LOG(WARNING) << "Malformed line in " << filename << ": " << line;
+      return {};
+    }
+    const auto robot_src = static_cast<uint32_t>(values[0]);
+    const auto pose_src = static_cast<uint32_t>(values[1]);
+    const auto robot_dst = static_cast<uint32_t>(values[2]);
+    const auto pose_dst = static_cast<uint32_t>(values[3]);
+    Matrix R;
+    Vector t(d);
+    size_t k;
+    if (d == 2) {
+      R = Eigen::Rotation2Dd(values[4]).toRotationMatrix();
+      t << values[5], values[6];
+      k = 7;
+    } else {
+      Eigen::Quaternion<double> quat(values[7], values[4], values[5], values[6]);
+      quat.normalize();
+      R = quat.toRotationMatrix();
+      t << values[8], values[9], values[10];
+      k = 11;
+    }
+
+    RelativeSEMeasurement m(robot_src, robot_dst, pose_src, pose_dst, R, t,
+                            values[k], values[k + 1]);
+    m.fixedWeight = values[k + 2] != 0;
     if (load_weight)
-      m.weight = weight;
+      m.weight = values[k + 3];
 
     measurements.push_back(m);
   }
@@ -224,4 +339,4 @@ std::vector<RelativeSEMeasurement> PGOLogger::loadMeasurements(const std::string
   return measurements;
 }
 
-}
\ No newline at end of file
+}
@@ -7,12 +7,20 @@
 
 #include "DPGO/PoseGraph.h"
 #include "DPGO/DPGO_utils.h"
+#include "DPGO/DPGO_trace.h"
 #include <glog/logging.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace DPGO {
 
 PoseGraph::PoseGraph(unsigned int id, unsigned int r, unsigned int d)
     : id_(id), r_(r), d_(d), n_(0), 
+    neighbor_poses_(r, d),
+    precon_outdated_(false),
+    window_start_(0),
+    frozen_poses_(r, d),
     use_inactive_neighbors_(false),
     prior_kappa_(10000),
     prior_tau_(100) {
@@ -34,16 +42,19 @@ void PoseGraph::empty() {
   local_shared_pose_ids_.clear();
   nbr_shared_pose_ids_.clear();
   nbr_robot_ids_.clear();
+  nbr_public_frame_ids_.clear();
   neighbor_active_.clear();
   clearNeighborPoses();
   clearDataMatrices();
   clearPriors();
+  clearWindow();
 }
 
 void PoseGraph::reset() {
   clearNeighborPoses();
   clearDataMatrices();
   clearPriors();
+  clearWindow();
   for (const auto neighbor_id: nbr_robot_ids_) {
     neighbor_active_[neighbor_id] = true;
   }
@@ -80,6 +91,47 @@ void PoseGraph::addMeasurement(const RelativeSEMeasurement &m) {
   }
 }
 
+bool PoseGraph::appendOdometry(const std::vector<RelativeSEMeasurement> &odometry) {
+  if (n_ == 0) {
+    LOG(WARNING) << "Cannot append odometry to an empty pose graph.";
+    return false;
+  }
+  for (size_t k = 0; k < odometry.size(); ++k) {
+    const auto &m = odometry[k];
+    if (m.r1 != id_ || m.r2 != id_ || m.p1 != n_ - 1 + k || m.p2 != m.p1 + 1) {
+      LOG(WARNING) << "Odometry does not extend the trajectory of robot " << id_ << "! \n" << m;
+      return false;
+    }
+  }
+  if (odometry.empty())
+    return true;
+  const unsigned n_old = n_;
+  for (const auto &m : odometry)
+    addOdometry(m);
+
+  // New poses are only connected by the new odometry
+  if (Q_.has_value()) {
+    std::vector<RelativeSEMeasurement> active = odometry;
+    for (auto &m : active) {
+      m.p1 -= window_start_;
+      m.p2 -= window_start_;
+    }
+    SparseMatrix Q = constructConnectionLaplacianSE(active);
+    CHECK_EQ(Q.rows(), (d_ + 1) * numActivePoses());
+    Q_->conservativeResize(Q.rows(), Q.cols());
+    Q_.value() += Q;
+    Q_odometry_weights_.resize(odometry_.size(), std::numeric_limits<double>::quiet_NaN());
+    for (size_t k = 0; k < odometry.size(); ++k)
+      Q_odometry_weights_[odometry_.size() - odometry.size() + k] = odometry[k].weight;
+  }
+  precon_.reset();
+  if (G_.has_value()) {
+    G_->conservativeResize(Eigen::NoChange, (d_ + 1) * numActivePoses());
+    G_->rightCols((d_ + 1) * (n_ - n_old)).setZero();
+  }
+  return true;
+}
+
 void PoseGraph::addOdometry(const RelativeSEMeasurement &factor) {
   // Check for duplicate inter-robot loop closure
   const PoseID src_id(factor.r1, factor.p1);
@@ -97,6 +149,8 @@ void PoseGraph::addOdometry(const RelativeSEMeasurement &factor) {
   odometry_.push_back(factor);
   const EdgeID edge_id(src_id, dst_id);
   edge_id_to_index_.emplace(edge_id, odometry_.size() - 1);
+  if (window_start_ > 0 && factor.p2 >= window_start_)
+    window_odometry_.push_back(odometry_.size() - 1);
 }
 
 void PoseGraph::addPrivateLoopClosure(const RelativeSEMeasurement &factor) {
@@ -115,6 +169,8 @@ void PoseGraph::addPrivateLoopClosure(const RelativeSEMeasurement &factor) {
   private_lcs_.push_back(factor);
   const EdgeID edge_id(src_id, dst_id);
   edge_id_to_index_.emplace(edge_id, private_lcs_.size() - 1);
+  if (window_start_ > 0 && std::max(factor.p1, factor.p2) >= window_start_)
+    window_lcs_.push_back(private_lcs_.size() - 1);
 }
 
 void PoseGraph::addSharedLoopClosure(const RelativeSEMeasurement &factor) {
@@ -133,6 +189,7 @@ void PoseGraph::addSharedLoopClosure(const RelativeSEMeasurement &factor) {
     nbr_shared_pose_ids_.emplace(factor.r2, factor.p2);
     nbr_robot_ids_.insert(factor.r2);
     neighbor_active_[factor.r2] = true;
+    addPublicFrameID(factor.r2, factor.p1);
   } else {
     CHECK(factor.r2 == id_);
     n_ = std::max(n_, (unsigned int) factor.p2 + 1);
@@ -140,6 +197,7 @@ void PoseGraph::addSharedLoopClosure(const RelativeSEMeasurement &factor) {
     nbr_shared_pose_ids_.emplace(factor.r1, factor.p1);
     nbr_robot_ids_.insert(factor.r1);
     neighbor_active_[factor.r1] = true;
+    addPublicFrameID(factor.r1, factor.p2);
   }
 
   shared_lcs_.push_back(factor);
@@ -147,6 +205,21 @@ void PoseGraph::addSharedLoopClosure(const RelativeSEMeasurement &factor) {
   edge_id_to_index_.emplace(edge_id, shared_lcs_.size() - 1);
 }
 
+void PoseGraph::addPublicFrameID(unsigned neighbor_id, unsigned frame_id) {
+  auto &frame_ids = nbr_public_frame_ids_[neighbor_id];
+  auto it = std::lower_bound(frame_ids.begin(), frame_ids.end(), frame_id);
+  if (it == frame_ids.end() || *it != frame_id)
+    frame_ids.insert(it, frame_id);
+}
+
+const std::vector<unsigned> &PoseGraph::myPublicFrameIDsWithNeighbor(unsigned neighbor_id) const {
+  static const std::vector<unsigned> empty_frame_ids;
+  auto it = nbr_public_frame_ids_.find(neighbor_id);
+  if (it == nbr_public_frame_ids_.end())
+    return empty_frame_ids;
+  return it->second;
+}
+
 std::vector<RelativeSEMeasurement> PoseGraph::sharedLoopClosuresWithRobot(unsigned int neighbor_id) const {
   std::vector<RelativeSEMeasurement> result;
   for (const auto &m : shared_lcs_) {
@@ -181,10 +254,84 @@ void PoseGraph::setPrior(unsigned index, const LiftedPose &Xi) {
 }
 
 void PoseGraph::setNeighborPoses(const PoseDict &pose_dict) {
-  neighbor_poses_ = pose_dict;
+  neighbor_poses_.assign(pose_dict);
+  G_.reset();  // Setting neighbor poses requires re-computing linear matrix
+}
+
+void PoseGraph::setNeighborPoses(const LiftedPoseStore &pose_store) {
+  CHECK_EQ(pose_store.r(), r_);
+  CHECK_EQ(pose_store.d(), d_);
+  neighbor_poses_ = pose_store;
   G_.reset();  // Setting neighbor poses requires re-computing linear matrix
 }
 
+void PoseGraph::clearWindow() {
+  window_start_ = 0;
+  window_odometry_.clear();
+  window_lcs_.clear();
+  frozen_poses_.clear();
+}
+
+void PoseGraph::setWindow(unsigned start, const LiftedPoseArray &X) {
+  if (start != window_start_) {
+    CHECK_LT(start, std::max(n_, 1u));
+    window_start_ = start;
+    window_odometry_.clear();
+    window_lcs_.clear();
+    if (window_start_ > 0) {
+      for (size_t k = 0; k < odometry_.size(); ++k) {
+        if (odometry_[k].p2 >= window_start_)
+          window_odometry_.push_back(k);
+      }
+      for (size_t k = 0; k < private_lcs_.size(); ++k) {
+        if (std::max(private_lcs_[k].p1, private_lcs_[k].p2) >= window_start_)
+          window_lcs_.push_back(k);
+      }
+    }
+    clearDataMatrices();
+  }
+  frozen_poses_.clear();
+  G_.reset();  // Frozen poses only affect the linear matrix
+  if (window_start_ == 0)
+    return;
+  CHECK_EQ(X.r(), r_);
+  CHECK_EQ(X.d(), d_);
+  CHECK_EQ(X.n(), n_);
+  std::vector<const RelativeSEMeasurement *> boundary;
+  windowMeasurements(nullptr, boundary);
+  for (const auto *m : boundary) {
+    const unsigned idx = std::min(m->p1, m->p2);
+    frozen_poses_.set(PoseID(id_, idx), LiftedPose(X.pose(idx)));
+  }
+}
+
+void PoseGraph::windowMeasurements(std::vector<RelativeSEMeasurement> *active,
+                                   std::vector<const RelativeSEMeasurement *> &boundary) const {
+  boundary.clear();
+  if (window_start_ == 0) {
+    if (active) {
+      *active = odometry_;
+      active->insert(active->end(), private_lcs_.begin(), private_lcs_.end());
+    }
+    return;
+  }
+  if (active)
+    active->clear();
+  auto add = [&](const RelativeSEMeasurement &m) {
+    if (std::min(m.p1, m.p2) < window_start_) {
+      boundary.push_back(&m);
+    } else if (active) {
+      active->push_back(m);
+      active->back().p1 -= window_start_;
+      active->back().p2 -= window_start_;
+    }
+  };
+  for (size_t k : window_odometry_)
+    add(odometry_[k]);
+  for (size_t k : window_lcs_)
+    add(private_lcs_[k]);
+}
+
 bool PoseGraph::hasNeighbor(unsigned int robot_id) const {
   return nbr_robot_ids_.find(robot_id) != nbr_robot_ids_.end();
 }
@@ -267,7 +414,7 @@ PoseSet PoseGraph::activeNeighborPublicPoseIDs() const {
   PoseSet output;
   for (const auto &pose_id : nbr_shared_pose_ids_) {
     if (isNeighborActive(pose_id.robot_id)) {
-      output.emplace(pose_id);
+      output.insert(pose_id);
     }
   }
   return output;
@@ -352,6 +499,7 @@ const SparseMatrix &PoseGraph::quadraticMatrix() {
 void PoseGraph::clearQuadraticMatrix() {
   Q_.reset();
   precon_.reset();  // Also clear the preconditioner since it depends on Q
+  precon_outdated_ = false;
 }
 
 const Matrix &PoseGraph::linearMatrix() {
@@ -378,13 +526,87 @@ void PoseGraph::clearDataMatrices() {
   clearLinearMatrix();
 }
 
+size_t PoseGraph::applyWeightChanges() {
+  if (!Q_.has_value())
+    return 0;
+  DPGO_TRACE_ZONE("PoseGraph::applyWeightChanges");
+  SparseMatrix &Q = Q_.value();
+  const Eigen::Index nnz = Q.nonZeros();
+  Matrix T = Matrix::Zero(d_ + 1, d_ + 1);
+  Matrix Omega = Matrix::Zero(d_ + 1, d_ + 1);
+  auto addBlock = [&](unsigned row, unsigned col, const Matrix &B) {
+    for (unsigned c = 0; c < d_ + 1; ++c) {
+      for (unsigned r = 0; r < d_ + 1; ++r) {
+        // Skip structural zeros of the homogeneous transformation
+        if (B(r, c) != 0)
+          Q.coeffRef(row * (d_ + 1) + r, col * (d_ + 1) + c) += B(r, c);
+      }
+    }
+  };
+  // Add the change of the cost of measurement m between poses i and j that are in the window
+  auto patch = [&](const RelativeSEMeasurement &m, double &weight, bool has_i, bool has_j) {
+    if (std::isnan(weight) || m.weight == weight)
+      return false;
+    const double dw = m.weight - weight;
+    weight = m.weight;
+    T.block(0, 0, d_, d_) = m.R;
+    T.block(0, d_, d_, 1) = m.t;
+    T(d_, d_) = 1;
+    for (unsigned row = 0; row < d_; ++row) {
+      Omega(row, row) = dw * m.kappa;
+    }
+    Omega(d_, d_) = dw * m.tau;
+    const unsigned i = m.p1 - window_start_;
+    const unsigned j = m.p2 - window_start_;
+    if (has_i)
+      addBlock(i, i, T * Omega * T.transpose());
+    if (has_j)
+      addBlock(j, j, Omega);
+    if (has_i && has_j) {
+      addBlock(i, j, -T * Omega);
+      addBlock(j, i, -Omega * T.transpose());
+    }
+    return true;
+  };
+  size_t num_changed = 0;
+  for (size_t k = 0; k < Q_odometry_weights_.size(); ++k) {
+    const auto &m = odometry_[k];
+    num_changed += patch(m, Q_odometry_weights_[k], m.p1 >= window_start_, m.p2 >= window_start_);
+  }
+  for (size_t k = 0; k < Q_private_lc_weights_.size(); ++k) {
+    const auto &m = private_lcs_[k];
+    num_changed += patch(m, Q_private_lc_weights_[k], m.p1 >= window_start_, m.p2 >= window_start_);
+  }
+  for (size_t k = 0; k < Q_shared_lc_weights_.size(); ++k) {
+    const auto &m = shared_lcs_[k];
+    num_changed += patch(m, Q_shared_lc_weights_[k], m.r1 == id_, m.r2 == id_);
+  }
+  if (num_changed == 0)
+    return 0;
+  G_.reset();  // Weights of shared loop closures and measurements with frozen poses affect G
+  if (Q.nonZeros() != nnz) {
+    // New nonzeros require a new symbolic analysis
+    Q.makeCompressed();
+    precon_.reset();
+    precon_outdated_ = false;
+  } else if (precon_.has_value()) {
+    precon_outdated_ = true;
+  }
+  return num_changed;
+}
+
 bool PoseGraph::constructQ() {
+  DPGO_TRACE_ZONE("PoseGraph::constructQ");
   timer_.tic();
-  std::vector<RelativeSEMeasurement> privateMeasurements = odometry_;
-  privateMeasurements.insert(privateMeasurements.end(), private_lcs_.begin(), private_lcs_.end());
+  const unsigned n = numActivePoses();
+  std::vector<RelativeSEMeasurement> privateMeasurements;
+  std::vector<const RelativeSEMeasurement *> boundaryMeasurements;
+  windowMeasurements(&privateMeasurements, boundaryMeasurements);
 
   // Initialize Q with private measurements
   SparseMatrix QLocal = constructConnectionLaplacianSE(privateMeasurements);
+  if (QLocal.rows() < (d_ + 1) * n)
+    QLocal.conservativeResize((d_ + 1) * n, (d_ + 1) * n);
 
   // Initialize relative SE matrix in homogeneous form
   Matrix T = Matrix::Zero(d_ + 1, d_ + 1);
@@ -393,9 +615,21 @@ bool PoseGraph::constructQ() {
   Matrix Omega = Matrix::Zero(d_ + 1, d_ + 1);
 
   // Shared (inter-robot) measurements only affect the diagonal blocks
-  Matrix QDiagRow(d_ + 1, (d_ + 1) * n_);
+  Matrix QDiagRow(d_ + 1, (d_ + 1) * n);
   QDiagRow.setZero();
 
+  // Record the weights in Q, such that later weight changes can be applied in place
+  const double excluded = std::numeric_limits<double>::quiet_NaN();
+  Q_odometry_weights_.resize(odometry_.size());
+  for (size_t k = 0; k < odometry_.size(); ++k)
+    Q_odometry_weights_[k] = odometry_[k].p2 >= window_start_ ? odometry_[k].weight : excluded;
+  Q_private_lc_weights_.resize(private_lcs_.size());
+  for (size_t k = 0; k < private_lcs_.size(); ++k) {
+    const auto &m = private_lcs_[k];
+    Q_private_lc_weights_[k] = std::max(m.p1, m.p2) >= window_start_ ? m.weight : excluded;
+  }
+  Q_shared_lc_weights_.assign(shared_lcs_.size(), excluded);
+
   // Go through shared loop closures
   for (const auto &m : shared_lcs_) {
     // Set relative SE matrix (homogeneous form)
@@ -413,8 +647,10 @@ bool PoseGraph::constructQ() {
       // First pose belongs to this robot
       // Hence, this is an outgoing edge in the pose graph
       CHECK(m.r2 != id_);
+      if (m.p1 < window_start_)
+        continue;  // Measurements with frozen poses are constant
       const PoseID nID(m.r2, m.p2);
-      bool has_neighbor_pose = (neighbor_poses_.find(nID) != neighbor_poses_.end());
+      bool has_neighbor_pose = neighbor_poses_.contains(nID);
       if (isNeighborActive(m.r2)) {
         // Measurement with active neighbor
         if (!has_neighbor_pose) {
@@ -429,7 +665,8 @@ bool PoseGraph::constructQ() {
         }
       }
       // Modify quadratic cost
-      int idx = (int) m.p1;
+      Q_shared_lc_weights_[&m - shared_lcs_.data()] = m.weight;
+      int idx = (int) (m.p1 - window_start_);
       Matrix W = T * Omega * T.transpose();
       QDiagRow.block(0, idx * (d_ + 1), d_ + 1, d_ + 1) += W;
 
@@ -437,8 +674,10 @@ bool PoseGraph::constructQ() {
       // Second pose belongs to this robot
       // Hence, this is an incoming edge in the pose graph
       CHECK(m.r2 == id_);
+      if (m.p2 < window_start_)
+        continue;  // Measurements with frozen poses are constant
       const PoseID nID(m.r1, m.p1);
-      bool has_neighbor_pose = (neighbor_poses_.find(nID) != neighbor_poses_.end());
+      bool has_neighbor_pose = neighbor_poses_.contains(nID);
       if (isNeighborActive(m.r1)) {
         // Measurement with active neighbor
         if (!has_neighbor_pose) {
@@ -453,14 +692,38 @@ bool PoseGraph::constructQ() {
         }
       }
       // Modify quadratic cost
-      int idx = (int) m.p2;
+      Q_shared_lc_weights_[&m - shared_lcs_.data()] = m.weight;
+      int idx = (int) (m.p2 - window_start_);
+      QDiagRow.block(0, idx * (d_ + 1), d_ + 1, d_ + 1) += Omega;
+    }
+  }
+
+  // Go through measurements between the window and frozen poses
+  for (const auto *m : boundaryMeasurements) {
+    T.block(0, 0, d_, d_) = m->R;
+    T.block(0, d_, d_, 1) = m->t;
+    T(d_, d_) = 1;
+    for (unsigned row = 0; row < d_; ++row) {
+      Omega(row, row) = m->weight * m->kappa;
+    }
+    Omega(d_, d_) = m->weight * m->tau;
+    if (m->p1 >= window_start_) {
+      // Outgoing edge to a frozen pose
+      int idx = (int) (m->p1 - window_start_);
+      Matrix W = T * Omega * T.transpose();
+      QDiagRow.block(0, idx * (d_ + 1), d_ + 1, d_ + 1) += W;
+    } else {
+      // Incoming edge from a frozen pose
+      int idx = (int) (m->p2 - window_start_);
       QDiagRow.block(0, idx * (d_ + 1), d_ + 1, d_ + 1) += Omega;
     }
   }
 
   // Go through priors
   for (const auto &it : priors_) {
-    unsigned idx = it.first;
+    if (it.first < window_start_)
+      continue;
+    unsigned idx = it.first - window_start_;
     for (unsigned row = 0; row < d_; ++row) {
       Omega(row, row) = prior_kappa_;
     }
@@ -470,8 +733,8 @@ bool PoseGraph::constructQ() {
 
   // Convert to a sparse matrix
   std::vector<Eigen::Triplet<double>> tripletList;
-  tripletList.reserve((d_ + 1) * (d_ + 1) * n_);
-  for (unsigned idx = 0; idx < n_; ++idx) {
+  tripletList.reserve((d_ + 1) * (d_ + 1) * n);
+  for (unsigned idx = 0; idx < n; ++idx) {
     unsigned row_base = idx * (d_ + 1);
     unsigned col_base = row_base;
     for (unsigned r = 0; r < d_ + 1; ++r) {
@@ -491,9 +754,10 @@ bool PoseGraph::constructQ() {
 }
 
 bool PoseGraph::constructG() {
+  DPGO_TRACE_ZONE("PoseGraph::constructG");
   timer_.tic();
   unsigned d = d_;
-  Matrix G(r_, (d_ + 1) * n_);
+  Matrix G(r_, (d_ + 1) * numActivePoses());
   G.setZero();
   Matrix T = Matrix::Zero(d + 1, d + 1);
   Matrix Omega = Matrix::Zero(d + 1, d + 1);
@@ -514,9 +778,11 @@ bool PoseGraph::constructG() {
       // First pose belongs to this robot
       // Hence, this is an outgoing edge in the pose graph
       CHECK(m.r2 != id_);
+      if (m.p1 < window_start_)
+        continue;  // Measurements with frozen poses are constant
       const PoseID nID(m.r2, m.p2);
-      auto pair = neighbor_poses_.find(nID);
-      bool has_neighbor_pose = (pair != neighbor_poses_.end());
+      const size_t index = neighbor_poses_.find(nID);
+      bool has_neighbor_pose = (index != LiftedPoseStore::npos);
       if (isNeighborActive(m.r2)) {
         // Measurement with active neighbor
         if (!has_neighbor_pose) {
@@ -530,8 +796,8 @@ bool PoseGraph::constructG() {
           continue;
         }
       }
-      Matrix Xj = pair->second.pose();
-      int idx = (int) m.p1;
+      const auto Xj = neighbor_poses_.pose(index);
+      int idx = (int) (m.p1 - window_start_);
       // Modify linear cost
       Matrix L = -Xj * Omega * T.transpose();
       G.block(0, idx * (d_ + 1), r_, d_ + 1) += L;
@@ -539,9 +805,11 @@ bool PoseGraph::constructG() {
       // Second pose belongs to this robot
       // Hence, this is an incoming edge in the pose graph
       CHECK(m.r2 == id_);
+      if (m.p2 < window_start_)
+        continue;  // Measurements with frozen poses are constant
       const PoseID nID(m.r1, m.p1);
-      auto pair = neighbor_poses_.find(nID);
-      bool has_neighbor_pose = (pair != neighbor_poses_.end());
+      const size_t index = neighbor_poses_.find(nID);
+      bool has_neighbor_pose = (index != LiftedPoseStore::npos);
       if (isNeighborActive(m.r1)) {
         // Measurement with active neighbor
         if (!has_neighbor_pose) {
@@ -555,16 +823,47 @@ bool PoseGraph::constructG() {
           continue;
         }
       }
-      Matrix Xi = pair->second.pose();
-      int idx = (int) m.p2;
+      const auto Xi = neighbor_poses_.pose(index);
+      int idx = (int) (m.p2 - window_start_);
       // Modify linear cost
       Matrix L = -Xi * T * Omega;
       G.block(0, idx * (d_ + 1), r_, d_ + 1) += L;
     }
   }
+  // Go through measurements between the window and frozen poses
+  std::vector<const RelativeSEMeasurement *> boundaryMeasurements;
+  windowMeasurements(nullptr, boundaryMeasurements);
+  for (const auto *m : boundaryMeasurements) {
+    T.block(0, 0, d, d) = m->R;
+    T.block(0, d, d, 1) = m->t;
+    T(d, d) = 1;
+    for (unsigned row = 0; row < d; ++row) {
+      Omega(row, row) = m->weight * m->kappa;
+    }
+    Omega(d, d) = m->weight * m->tau;
+    if (m->p1 >= window_start_) {
+      // Outgoing edge to a frozen pose
+      const size_t index = frozen_poses_.find(PoseID(id_, m->p2));
+      CHECK_NE(index, LiftedPoseStore::npos);
+      const auto Xj = frozen_poses_.pose(index);
+      int idx = (int) (m->p1 - window_start_);
+      Matrix L = -Xj * Omega * T.transpose();
+      G.block(0, idx * (d_ + 1), r_, d_ + 1) += L;
+    } else {
+      // Incoming edge from a frozen pose
+      const size_t index = frozen_poses_.find(PoseID(id_, m->p1));
+      CHECK_NE(index, LiftedPoseStore::npos);
+      const auto Xi = frozen_poses_.pose(index);
+      int idx = (int) (m->p2 - window_start_);
+      Matrix L = -Xi * T * Omega;
+      G.block(0, idx * (d_ + 1), r_, d_ + 1) += L;
+    }
+  }
   // Go through priors
   for (const auto &it : priors_) {
-    unsigned idx = it.first;
+    if (it.first < window_start_)
+      continue;
+    unsigned idx = it.first - window_start_;
     const Matrix &P = it.second.getData();
     for (unsigned row = 0; row < d_; ++row) {
       Omega(row, row) = prior_kappa_;
@@ -580,7 +879,7 @@ bool PoseGraph::constructG() {
 }
 
 bool PoseGraph::hasPreconditioner() {
-  if (!precon_.has_value())
+  if (!precon_.has_value() || precon_outdated_)
     constructPreconditioner();
   return precon_.has_value();
 }
@@ -589,19 +888,32 @@ bool PoseGraph::hasPreconditioner() {
  * @return
  */
 const CholmodSolverPtr & PoseGraph::preconditioner() {
-  if (!precon_.has_value())
+  if (!precon_.has_value() || precon_outdated_)
     constructPreconditioner();
   CHECK(precon_.has_value());
   return precon_.value();
 }
 
 bool PoseGraph::constructPreconditioner() {
+  DPGO_TRACE_ZONE("PoseGraph::constructPreconditioner");
   timer_.tic();
   // Update preconditioner
   SparseMatrix P = quadraticMatrix();
   for (int i = 0; i < P.rows(); ++i) {
     P.coeffRef(i, i) += 1e-1;
   }
+  if (precon_.has_value() && precon_outdated_) {
+    // Only the values of Q changed, so the symbolic analysis is reused
+    precon_outdated_ = false;
+    precon_.value()->factorize(P);
+    if (precon_.value()->info() != Eigen::ComputationInfo::Success) {
+      precon_.reset();
+      return false;
+    }
+    ms_construct_precon_ = timer_.toc();
+    return true;
+  }
+  precon_outdated_ = false;
   auto solver = std::make_shared<CholmodSolver>();
   solver->compute(P);
   if (solver->info() != Eigen::ComputationInfo::Success)
@@ -615,16 +927,19 @@ bool PoseGraph::constructPreconditioner() {
 void PoseGraph::updatePublicPoseIDs() {
   local_shared_pose_ids_.clear();
   nbr_shared_pose_ids_.clear();
+  nbr_public_frame_ids_.clear();
 
   for (const auto& m: shared_lcs_) {
     if (m.r1 == id_) {
       CHECK(m.r2 != id_);
       local_shared_pose_ids_.emplace(m.r1, m.p1);
       nbr_shared_pose_ids_.emplace(m.r2, m.p2);
+      addPublicFrameID(m.r2, m.p1);
     } else {
       CHECK(m.r2 == id_);
       local_shared_pose_ids_.emplace(m.r2, m.p2);
       nbr_shared_pose_ids_.emplace(m.r1, m.p1);
+      addPublicFrameID(m.r1, m.p2);
     }
   }
 }
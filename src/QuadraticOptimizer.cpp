@@ -6,6 +6,7 @@
  * -------------------------------------------------------------------------- */
 
 #include <DPGO/QuadraticOptimizer.h>
+#include <DPGO/DPGO_trace.h>
 #include <glog/logging.h>
 #include <iostream>
 
@@ -24,6 +25,7 @@ QuadraticOptimizer::QuadraticOptimizer(QuadraticProblem *p, ROptParameters param
 QuadraticOptimizer::~QuadraticOptimizer() = default;
 
 Matrix QuadraticOptimizer::optimize(const Matrix &Y) {
+  DPGO_TRACE_ZONE("QuadraticOptimizer::optimize");
   // Compute statistics before optimization
   result_.fInit = problem_->f(Y);
   result_.gradNormInit = problem_->RieGradNorm(Y);
@@ -85,6 +87,8 @@ Matrix QuadraticOptimizer::trustRegion(const Matrix &Yinit) {
       Solver.initial_Delta = radius;
       Solver.maximum_Delta = radius;
       Solver.Run();
+      result_.numIterations += Solver.GetIter();
+      result_.numInnerIterations += Solver.GetnH();
       if (Solver.latestStepAccepted()) {
         break;
       } else if (total_steps > 10) {
@@ -98,6 +102,8 @@ Matrix QuadraticOptimizer::trustRegion(const Matrix &Yinit) {
     }
   } else {
     Solver.Run();
+    result_.numIterations = Solver.GetIter();
+    result_.numInnerIterations = Solver.GetnH();
   }
   // record tCG status
   result_.tCGStatus = Solver.gettCGStatus();
@@ -16,7 +16,7 @@ namespace DPGO {
 
 QuadraticProblem::QuadraticProblem(const std::shared_ptr<PoseGraph> &pose_graph)
     : pose_graph_(pose_graph),
-      M(new LiftedSEManifold(pose_graph_->r(), pose_graph_->d(), pose_graph_->n())) {
+      M(new LiftedSEManifold(pose_graph_->r(), pose_graph_->d(), pose_graph_->numActivePoses())) {
   ROPTLIB::Problem::SetUseGrad(true);
   ROPTLIB::Problem::SetUseHess(true);
   ROPTLIB::Problem::SetDomain(M->getManifold());
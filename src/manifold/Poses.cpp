@@ -8,6 +8,7 @@
 #include "DPGO/manifold/Poses.h"
 #include "DPGO/DPGO_utils.h"
 #include <glog/logging.h>
+#include <algorithm>
 
 namespace DPGO {
 
@@ -72,6 +73,16 @@ Vector LiftedPoseArray::translation(unsigned int index) const {
   return Xi.col(d_);
 }
 
+double *LiftedPoseArray::poseData(unsigned int index) {
+  CHECK_LT(index, n_);
+  return X_.data() + index * r_ * (d_ + 1);
+}
+
+const double *LiftedPoseArray::poseData(unsigned int index) const {
+  CHECK_LT(index, n_);
+  return X_.data() + index * r_ * (d_ + 1);
+}
+
 double LiftedPoseArray::averageTranslationDistance(const LiftedPoseArray &poses1, const LiftedPoseArray &poses2) {
   CHECK_EQ(poses1.d(), poses2.d());
   CHECK_EQ(poses1.n(), poses2.n());
@@ -126,5 +137,97 @@ Matrix Pose::matrix() const {
   return T;
 }
 
+bool PoseSet::insert(const PoseID &pose_id) {
+  const uint64_t key = pose_id.key();
+  auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+  if (it != keys_.end() && *it == key) return false;
+  keys_.insert(it, key);
+  return true;
+}
+
+bool PoseSet::erase(const PoseID &pose_id) {
+  const uint64_t key = pose_id.key();
+  auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+  if (it == keys_.end() || *it != key) return false;
+  keys_.erase(it);
+  return true;
+}
+
+PoseSet::const_iterator PoseSet::find(const PoseID &pose_id) const {
+  const uint64_t key = pose_id.key();
+  auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+  if (it == keys_.end() || *it != key) return end();
+  return const_iterator(it);
+}
+
+void LiftedPoseStore::clear() {
+  keys_.clear();
+  data_.clear();
+}
+
+void LiftedPoseStore::reset(unsigned int r, unsigned int d) {
+  CHECK_GE(r, d);
+  clear();
+  r_ = r;
+  d_ = d;
+}
+
+void LiftedPoseStore::reserve(size_t n) {
+  keys_.reserve(n);
+  data_.reserve(n * stride());
+}
+
+size_t LiftedPoseStore::find(const PoseID &pose_id) const {
+  const uint64_t key = pose_id.key();
+  auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+  if (it == keys_.end() || *it != key) return npos;
+  return it - keys_.begin();
+}
+
+size_t LiftedPoseStore::insert(const PoseID &pose_id) {
+  const uint64_t key = pose_id.key();
+  auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+  const size_t index = it - keys_.begin();
+  if (it != keys_.end() && *it == key) return index;
+  keys_.insert(it, key);
+  data_.insert(data_.begin() + index * stride(), stride(), 0.0);
+  return index;
+}
+
+void LiftedPoseStore::set(const PoseID &pose_id, const LiftedPose &pose) {
+  CHECK_EQ(pose.r(), r_);
+  CHECK_EQ(pose.d(), d_);
+  const size_t index = insert(pose_id);
+  std::copy(pose.poseData(0), pose.poseData(0) + stride(), poseData(index));
+}
+
+bool LiftedPoseStore::erase(const PoseID &pose_id) {
+  const size_t index = find(pose_id);
+  if (index == npos) return false;
+  keys_.erase(keys_.begin() + index);
+  data_.erase(data_.begin() + index * stride(), data_.begin() + (index + 1) * stride());
+  return true;
+}
+
+void LiftedPoseStore::assign(const PoseDict &pose_dict) {
+  clear();
+  reserve(pose_dict.size());
+  // PoseDict is ordered consistently with the packed keys, hence poses can be appended in order
+  for (const auto &it : pose_dict) {
+    CHECK_EQ(it.second.r(), r_);
+    CHECK_EQ(it.second.d(), d_);
+    keys_.push_back(it.first.key());
+    data_.insert(data_.end(), it.second.poseData(0), it.second.poseData(0) + stride());
+  }
+}
+
+PoseDict LiftedPoseStore::toPoseDict() const {
+  PoseDict pose_dict;
+  for (size_t i = 0; i < size(); ++i) {
+    pose_dict.emplace_hint(pose_dict.end(), poseID(i), LiftedPose(Matrix(pose(i))));
+  }
+  return pose_dict;
+}
+
 }
 
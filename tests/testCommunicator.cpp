@@ -0,0 +1,215 @@
+#include <DPGO/Communicator.h>
+#include <DPGO/DPGO_serialization.h>
+#include <DPGO/DPGO_utils.h>
+#include <DPGO/PGOAgent.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+
+using namespace DPGO;
+
+namespace {
+std::vector<uint8_t> makeMessage(size_t size, uint8_t value) {
+  return std::vector<uint8_t>(size, value);
+}
+
+// Check that messages are delivered to all agents except the sender, in order
+void checkBroadcast(Communicator &comm) {
+  auto m1 = makeMessage(10, 1);
+  auto m2 = makeMessage(20, 2);
+  ASSERT_TRUE(comm.publish(0, m1.data(), m1.size()));
+  ASSERT_TRUE(comm.publish(0, m2.data(), m2.size()));
+  std::vector<std::vector<uint8_t>> received;
+  auto callback = [&received](const uint8_t *data, size_t size) {
+    received.emplace_back(data, data + size);
+  };
+  ASSERT_EQ(comm.receive(0, callback), 0);
+  for (unsigned robot = 1; robot < comm.numAgents(); ++robot) {
+    received.clear();
+    ASSERT_EQ(comm.receive(robot, callback), 2);
+    ASSERT_EQ(received[0], m1);
+    ASSERT_EQ(received[1], m2);
+    ASSERT_EQ(comm.receive(robot, callback), 0);
+  }
+}
+}  // namespace
+
+TEST(testDPGO, testInProcessCommunicator) {
+  InProcessCommunicator comm(3, 4);
+  checkBroadcast(comm);
+  // Oldest messages are dropped when inbox is full
+  for (uint8_t i = 0; i < 6; ++i) {
+    auto m = makeMessage(1, i);
+    comm.publish(0, m.data(), m.size());
+  }
+  std::vector<uint8_t> values;
+  comm.receive(1, [&values](const uint8_t *data, size_t size) { values.push_back(data[0]); });
+  ASSERT_EQ(values, std::vector<uint8_t>({2, 3, 4, 5}));
+  ASSERT_EQ(comm.numDropped(), 4);
+}
+
+TEST(testDPGO, testSharedMemoryCommunicator) {
+  const std::string name = "/dpgo_test_" + std::to_string(getpid());
+  SharedMemoryCommunicator owner(name, 3, true, 4, 1024);
+  SharedMemoryCommunicator client(name, 3, false, 4, 1024);
+  checkBroadcast(owner);
+  checkBroadcast(client);
+  // Messages larger than a slot are rejected
+  auto large = makeMessage(2048, 0);
+  ASSERT_FALSE(owner.publish(0, large.data(), large.size()));
+  // Oldest messages are overwritten when the ring is full
+  for (uint8_t i = 0; i < 6; ++i) {
+    auto m = makeMessage(1, i);
+    client.publish(2, m.data(), m.size());
+  }
+  std::vector<uint8_t> values;
+  owner.receive(0, [&values](const uint8_t *data, size_t size) { values.push_back(data[0]); });
+  ASSERT_EQ(values, std::vector<uint8_t>({2, 3, 4, 5}));
+}
+
+TEST(testDPGO, testSharedMemoryCommunicatorOversizedMessage) {
+  const std::string name = "/dpgo_test_oversized_" + std::to_string(getpid());
+  SharedMemoryCommunicator owner(name, 2, true, 4, 64);
+  auto m = makeMessage(16, 0xAB);
+  ASSERT_TRUE(owner.publish(1, m.data(), m.size()));
+  // Corrupt the size prefix of the pending message through a separate mapping
+  int fd = shm_open(name.c_str(), O_RDWR, 0);
+  ASSERT_GE(fd, 0);
+  struct stat st;
+  ASSERT_EQ(fstat(fd, &st), 0);
+  void *addr = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  ASSERT_NE(addr, MAP_FAILED);
+  uint8_t *segment = static_cast<uint8_t *>(addr);
+  uint8_t *payload = std::search(segment, segment + st.st_size, m.begin(), m.end());
+  ASSERT_NE(payload, segment + st.st_size);
+  const uint64_t corrupted_size = 1 << 20;
+  std::memcpy(payload - sizeof(uint64_t), &corrupted_size, sizeof(uint64_t));
+  munmap(addr, st.st_size);
+  // The corrupted message is dropped without invoking the callback
+  size_t num_callbacks = 0;
+  auto callback = [&num_callbacks](const uint8_t *data, size_t size) { num_callbacks++; };
+  ASSERT_EQ(owner.receive(0, callback), 0);
+  ASSERT_EQ(num_callbacks, 0);
+  // Later messages are still delivered
+  ASSERT_TRUE(owner.publish(1, m.data(), m.size()));
+  ASSERT_EQ(owner.receive(0, callback), 1);
+  ASSERT_EQ(num_callbacks, 1);
+}
+
+TEST(testDPGO, testSharedMemoryCommunicatorMultiProcess) {
+  const std::string name = "/dpgo_test_mp_" + std::to_string(getpid());
+  SharedMemoryCommunicator owner(name, 2, true, 8, 1024);
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    // Child process acts as agent 1 and sends its status
+    int code = 1;
+    {
+      SharedMemoryCommunicator client(name, 2, false, 8, 1024);
+      PGOAgentStatus status(1, PGOAgentState::INITIALIZED, 0, 42, true, 0.5);
+      std::vector<uint8_t> buffer(statusMessageSize());
+      encodeStatus(status, buffer.data(), buffer.size());
+      if (client.publish(1, buffer.data(), buffer.size())) code = 0;
+    }
+    _exit(code);
+  }
+  int child_status = 0;
+  ASSERT_EQ(waitpid(pid, &child_status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(child_status));
+  ASSERT_EQ(WEXITSTATUS(child_status), 0);
+  std::vector<PGOAgentStatus> received;
+  owner.receive(0, [&received](const uint8_t *data, size_t size) {
+    PGOAgentStatus status;
+    if (decodeStatus(data, size, status)) received.push_back(status);
+  });
+  ASSERT_EQ(received.size(), 1);
+  ASSERT_EQ(received[0].agentID, 1);
+  ASSERT_EQ(received[0].iterationNumber, 42);
+}
+
+TEST(testDPGO, testSharedMemoryCommunicatorStaleSegment) {
+  const std::string name = "/dpgo_test_stale_" + std::to_string(getpid());
+  // Leave behind an initialized segment whose creator exited without cleaning up
+  pid_t creator = fork();
+  ASSERT_GE(creator, 0);
+  if (creator == 0) {
+    new SharedMemoryCommunicator(name, 2, true, 8, 1024);
+    _exit(0);
+  }
+  ASSERT_EQ(waitpid(creator, nullptr, 0), creator);
+
+  // A client that starts before the new creator must not attach to the stale segment
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    int code = 1;
+    {
+      SharedMemoryCommunicator client(name, 2, false, 8, 1024);
+      auto m = makeMessage(4, 7);
+      if (client.publish(1, m.data(), m.size())) code = 0;
+    }
+    _exit(code);
+  }
+  usleep(100000);
+  SharedMemoryCommunicator owner(name, 2, true, 8, 1024);
+  int child_status = 0;
+  ASSERT_EQ(waitpid(pid, &child_status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(child_status));
+  ASSERT_EQ(WEXITSTATUS(child_status), 0);
+  std::vector<uint8_t> received;
+  ASSERT_EQ(owner.receive(0, [&received](const uint8_t *data, size_t size) {
+    received.assign(data, data + size);
+  }), 1);
+  ASSERT_EQ(received, makeMessage(4, 7));
+}
+
+TEST(testDPGO, testAgentCommunication) {
+  unsigned int d, r;
+  d = 3;
+  r = 3;
+  PGOAgentParameters options(d, r, 2);
+  options.multirobotInitialization = false;
+
+  std::vector<RelativeSEMeasurement> odom0, odom1, shared;
+  odom0.emplace_back(0, 0, 0, 1, Matrix::Identity(d, d), Vector::Zero(d), 1.0, 1.0);
+  odom1.emplace_back(1, 1, 0, 1, Matrix::Identity(d, d), Vector::Zero(d), 1.0, 1.0);
+  shared.emplace_back(0, 1, 1, 0, Matrix::Identity(d, d), Vector::Zero(d), 1.0, 1.0);
+
+  auto comm = std::make_shared<InProcessCommunicator>(2);
+  PGOAgent agent0(0, options);
+  PGOAgent agent1(1, options);
+  agent0.setCommunicator(comm);
+  agent1.setCommunicator(comm);
+  agent0.setMeasurements(odom0, {}, shared);
+  agent1.setMeasurements(odom1, {}, shared);
+  Matrix M = fixedStiefelVariable(d, r);
+  agent0.setLiftingMatrix(M);
+  agent1.setLiftingMatrix(M);
+  agent0.initialize();
+  agent1.initialize();
+  Matrix anchor = Matrix::Zero(r, d + 1);
+  anchor.block(0, 0, r, d) = M;
+  agent0.setGlobalAnchor(anchor);
+  agent1.setGlobalAnchor(anchor);
+
+  // Status and public poses are exchanged automatically during iterations
+  agent0.iterate(false);
+  agent1.iterate(false);
+  agent0.iterate(false);
+  ASSERT_TRUE(agent0.hasNeighborStatus(1));
+  ASSERT_TRUE(agent1.hasNeighborStatus(0));
+  Matrix T0, T1;
+  ASSERT_TRUE(agent1.getPoseInGlobalFrame(0, T1));
+  ASSERT_TRUE(agent0.getNeighborPoseInGlobalFrame(1, 0, T0));
+  ASSERT_LE((T0 - T1).norm(), 1e-8);
+}
@@ -0,0 +1,21 @@
+#ifndef DPGO_TESTHELPERS_H
+#define DPGO_TESTHELPERS_H
+
+#include <DPGO/manifold/Poses.h>
+#include <Eigen/Geometry>
+
+namespace DPGO {
+
+/**
+ * @brief Random 3D pose with uniformly distributed rotation and translation in [-1, 1]^3
+ */
+inline Pose randomPose() {
+  Pose T(3);
+  T.rotation() = Eigen::Quaterniond::UnitRandom().toRotationMatrix();
+  T.translation() = Eigen::Vector3d::Random();
+  return T;
+}
+
+}  // namespace DPGO
+
+#endif
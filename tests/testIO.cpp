@@ -0,0 +1,483 @@
+#include <DPGO/DPGO_io.h>
+#include <DPGO/DPGO_utils.h>
+#include <DPGO/PGOAgent.h>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+
+using namespace DPGO;
+
+namespace {
+std::string writeTempFile(const std::string &content) {
+  char name[] = "/tmp/dpgo_test_XXXXXX";
+  int fd = mkstemp(name);
+  EXPECT_GE(fd, 0);
+  close(fd);
+  std::ofstream file(name);
+  file << content;
+  return name;
+}
+
+void expectSameMeasurements(const std::vector<RelativeSEMeasurement> &a,
+                            const std::vector<RelativeSEMeasurement> &b) {
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t k = 0; k < a.size(); ++k) {
+    ASSERT_EQ(a[k].p1, b[k].p1);
+    ASSERT_EQ(a[k].p2, b[k].p2);
+    ASSERT_LE((a[k].R - b[k].R).norm(), 1e-12);
+    ASSERT_LE((a[k].t - b[k].t).norm(), 1e-12);
+    ASSERT_NEAR(a[k].kappa, b[k].kappa, 1e-9 * a[k].kappa);
+    ASSERT_NEAR(a[k].tau, b[k].tau, 1e-9 * a[k].tau);
+    ASSERT_EQ(a[k].fixedWeight, b[k].fixedWeight);
+    ASSERT_EQ(a[k].weight, b[k].weight);
+  }
+}
+
+// Exposes measurement weight updates of robust optimization
+class RobustPGOAgent : public PGOAgent {
+ public:
+  using PGOAgent::PGOAgent;
+  using PGOAgent::updateMeasurementWeights;
+  using PGOAgent::shouldUpdateMeasurementWeights;
+};
+}  // namespace
+
+TEST(testDPGO, testReadG2O2D) {
+  std::string content =
+      "VERTEX_SE2 0 0 0 0\n"
+      "VERTEX_SE2 1 1.5 -2 0.3\n"
+      "EDGE_SE2 0 1 1 0 0.1 50 0 0 50 0 100\n"
+      "EDGE_SE2 1 2 1.0e0 0.5 -0.2 20 1 0 30 0 200\r\n"
+      "EDGE_SE2 0 2 2 0.5 -0.1 10 0 0 10 0 10";
+  std::string filename = writeTempFile(content);
+  size_t num_poses;
+  auto expected = read_g2o_file(filename, num_poses);
+
+  for (unsigned threads : {1u, 4u}) {
+    G2OData data;
+    ASSERT_TRUE(readG2OFile(filename, data, G2OReaderOptions(threads, true)));
+    ASSERT_EQ(data.dimension, 2);
+    ASSERT_EQ(data.numPoses, num_poses);
+    expectSameMeasurements(data.measurements, expected);
+    ASSERT_TRUE(data.initialGuess.has_value());
+    ASSERT_EQ(data.initialGuess->n(), 3);
+    ASSERT_LE((data.initialGuess->translation(1) - Eigen::Vector2d(1.5, -2)).norm(), 1e-12);
+    // Pose without vertex entry is identity
+    ASSERT_LE((data.initialGuess->rotation(2) - Matrix::Identity(2, 2)).norm(), 1e-12);
+  }
+  std::remove(filename.c_str());
+}
+
+TEST(testDPGO, testReadG2OUnknownTypes) {
+  std::string content =
+      "VERTEX_SE3:QUAT 0 0 0 0 0 0 0 1\n"
+      "VERTEX_XY 5 1 2\n"
+      "# comment\n"
+      "\n"
+      "EDGE_SE3:QUAT 0 1 1 2 3 0 0 0 1 "
+      "10 0 0 0 0 0 10 0 0 0 0 10 0 0 0 100 0 0 100 0 100\n"
+      "EDGE_SE2_XY 0 5 1 2 1 0 1\n"
+      "FIX 0\n";
+  std::string filename = writeTempFile(content);
+  G2OData data;
+  ASSERT_TRUE(readG2OFile(filename, data));
+  ASSERT_EQ(data.dimension, 3);
+  ASSERT_EQ(data.numPoses, 2);
+  ASSERT_EQ(data.measurements.size(), 1);
+  ASSERT_EQ(data.numSkippedLines, 3);
+  ASSERT_FALSE(data.initialGuess.has_value());
+  ASSERT_NEAR(data.measurements[0].tau, 10, 1e-9);
+  ASSERT_NEAR(data.measurements[0].kappa, 50, 1e-9);
+  ASSERT_TRUE(data.measurements[0].fixedWeight);
+
+  // Unknown types are rejected on request
+  ASSERT_FALSE(readG2OFile(filename, data, G2OReaderOptions(0, false, false)));
+  std::remove(filename.c_str());
+
+  // Malformed entries and missing files are reported
+  filename = writeTempFile("EDGE_SE2 0 1 1 0\n");
+  ASSERT_FALSE(readG2OFile(filename, data));
+  std::remove(filename.c_str());
+  ASSERT_FALSE(readG2OFile("/nonexistent/file.g2o", data));
+}
+
+TEST(testDPGO, testReadG2OParallel) {
+  // Large enough file to be split into multiple chunks
+  std::string content;
+  for (unsigned k = 0; k < 5000; ++k) {
+    content += "EDGE_SE2 " + std::to_string(k) + " " + std::to_string(k + 1) +
+        " 1 0.25 0.01 50 0 0 50 0 100\n";
+    if (k % 10 == 0)
+      content += "EDGE_SE2 " + std::to_string(k) + " " + std::to_string(k + 7) +
+          " 3 -0.5 0.2 20 0 0 20 0 40\n";
+  }
+  std::string filename = writeTempFile(content);
+  size_t num_poses;
+  auto expected = read_g2o_file(filename, num_poses);
+  G2OData data;
+  ASSERT_TRUE(readG2OFile(filename, data, G2OReaderOptions(8)));
+  ASSERT_EQ(data.numPoses, num_poses);
+  expectSameMeasurements(data.measurements, expected);
+  std::remove(filename.c_str());
+}
+
+TEST(testDPGO, testSnapshotRoundTrip) {
+  unsigned d = 3, r = 5, n = 4;
+  PoseGraphSnapshot snapshot;
+  snapshot.agentID = 2;
+  snapshot.d = d;
+  snapshot.numPoses = n;
+  for (unsigned i = 0; i + 1 < n; ++i) {
+    RelativeSEMeasurement m(2, 2, i, i + 1, randomStiefelVariable(d, d), Vector::Random(d), 10, 100);
+    m.fixedWeight = true;
+    snapshot.measurements.push_back(m);
+  }
+  RelativeSEMeasurement lc(2, 1, 0, 7, randomStiefelVariable(d, d), Vector::Random(d), 5, 50);
+  lc.weight = 0.25;
+  snapshot.measurements.push_back(lc);
+  snapshot.trajectory.emplace(Matrix::Random(d, (d + 1) * n));
+  snapshot.X.emplace(Matrix::Random(r, (d + 1) * n));
+  snapshot.liftingMatrix.emplace(fixedStiefelVariable(d, r));
+  std::string filename = writeTempFile("");
+  ASSERT_TRUE(writeSnapshot(filename, snapshot));
+
+  SnapshotView view;
+  ASSERT_TRUE(view.open(filename));
+  ASSERT_EQ(view.header().agentID, 2);
+  ASSERT_EQ(view.numPoses(), n);
+  ASSERT_EQ((view.iterate() - snapshot.X.value()).norm(), 0);
+  ASSERT_EQ((view.trajectory() - snapshot.trajectory.value()).norm(), 0);
+  ASSERT_EQ((view.liftingMatrix() - snapshot.liftingMatrix.value()).norm(), 0);
+
+  PoseGraphSnapshot loaded;
+  ASSERT_TRUE(readSnapshot(filename, loaded));
+  ASSERT_EQ(loaded.measurements.size(), snapshot.measurements.size());
+  for (size_t k = 0; k < loaded.measurements.size(); ++k) {
+    const auto &a = loaded.measurements[k];
+    const auto &b = snapshot.measurements[k];
+    ASSERT_EQ(a.r1, b.r1);
+    ASSERT_EQ(a.r2, b.r2);
+    ASSERT_EQ(a.p1, b.p1);
+    ASSERT_EQ(a.p2, b.p2);
+    ASSERT_EQ((a.R - b.R).norm(), 0);
+    ASSERT_EQ((a.t - b.t).norm(), 0);
+    ASSERT_EQ(a.kappa, b.kappa);
+    ASSERT_EQ(a.tau, b.tau);
+    ASSERT_EQ(a.weight, b.weight);
+    ASSERT_EQ(a.fixedWeight, b.fixedWeight);
+  }
+
+  // Truncated file is rejected
+  view.close();
+  ASSERT_EQ(truncate(filename.c_str(), 100), 0);
+  ASSERT_FALSE(view.open(filename));
+  std::remove(filename.c_str());
+}
+
+TEST(testDPGO, testSnapshotHugeCounts) {
+  unsigned d = 3, r = 5, n = 4;
+  PoseGraphSnapshot snapshot;
+  snapshot.d = d;
+  snapshot.numPoses = n;
+  snapshot.measurements.emplace_back(0, 0, 0, 1, randomStiefelVariable(d, d), Vector::Random(d), 10, 100);
+  snapshot.X.emplace(Matrix::Random(r, (d + 1) * n));
+  std::string filename = writeTempFile("");
+  ASSERT_TRUE(writeSnapshot(filename, snapshot));
+  SnapshotView view;
+  ASSERT_TRUE(view.open(filename));
+  const SnapshotHeader valid = view.header();
+  view.close();
+
+  // Header fields whose products or sums overflow 64 bits are rejected
+  auto expectRejected = [&](const std::function<void(SnapshotHeader &)> &corrupt) {
+    SnapshotHeader header = valid;
+    corrupt(header);
+    std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.close();
+    ASSERT_FALSE(view.open(filename));
+  };
+  expectRejected([](SnapshotHeader &h) { h.numMeasurements = uint64_t(1) << 60; });
+  expectRejected([](SnapshotHeader &h) { h.numPoses = uint64_t(1) << 61; });
+  expectRejected([](SnapshotHeader &h) { h.iterateOffset = ~uint64_t(7); });
+  std::remove(filename.c_str());
+}
+
+TEST(testDPGO, testSnapshotFromG2O) {
+  std::string content =
+      "VERTEX_SE2 0 0 0 0\n"
+      "VERTEX_SE2 1 1 0 0\n"
+      "VERTEX_SE2 2 2 0 0\n"
+      "EDGE_SE2 0 1 1 0 0 50 0 0 50 0 100\n"
+      "EDGE_SE2 1 2 1 0 0 50 0 0 50 0 100\n"
+      "EDGE_SE2 0 2 2 0 0 50 0 0 50 0 100\n";
+  std::string g2o_file = writeTempFile(content);
+  std::string snapshot_file = writeTempFile("");
+  ASSERT_TRUE(convertG2OToSnapshot(g2o_file, snapshot_file));
+  PoseGraphSnapshot snapshot;
+  ASSERT_TRUE(readSnapshot(snapshot_file, snapshot));
+  ASSERT_EQ(snapshot.d, 2);
+  ASSERT_EQ(snapshot.numPoses, 3);
+  ASSERT_EQ(snapshot.measurements.size(), 3);
+  ASSERT_TRUE(snapshot.trajectory.has_value());
+  ASSERT_FALSE(snapshot.X.has_value());
+  ASSERT_NEAR((*snapshot.trajectory)(0, 8), 2, 1e-12);
+  std::remove(g2o_file.c_str());
+  std::remove(snapshot_file.c_str());
+}
+
+TEST(testDPGO, testAgentSnapshot) {
+  unsigned d = 3, r = 5;
+  PGOAgentParameters options(d, r, 1);
+  std::vector<RelativeSEMeasurement> odometry, private_loop_closures;
+  for (unsigned i = 0; i < 4; ++i) {
+    odometry.emplace_back(0, 0, i, i + 1, Matrix::Identity(d, d), Vector::Ones(d), 1.0, 1.0);
+    odometry.back().fixedWeight = true;
+  }
+  private_loop_closures.emplace_back(0, 0, 0, 4, Matrix::Identity(d, d), 4 * Vector::Ones(d), 1.0, 1.0);
+  private_loop_closures.back().weight = 0.5;
+  PGOAgent agent(0, options);
+  agent.setMeasurements(odometry, private_loop_closures, {});
+  agent.initialize();
+  ASSERT_EQ(agent.getStatus().state, PGOAgentState::INITIALIZED);
+  std::string filename = writeTempFile("");
+  ASSERT_TRUE(agent.saveSnapshot(filename));
+
+  PGOAgent resumed(0, options);
+  ASSERT_TRUE(resumed.loadSnapshot(filename));
+  ASSERT_EQ(resumed.getStatus().state, PGOAgentState::INITIALIZED);
+  ASSERT_EQ(resumed.num_poses(), agent.num_poses());
+  Matrix X0, X1;
+  agent.getX(X0);
+  resumed.getX(X1);
+  ASSERT_EQ((X0 - X1).norm(), 0);
+  PoseGraphSnapshot snapshot;
+  ASSERT_TRUE(readSnapshot(filename, snapshot));
+  ASSERT_EQ(snapshot.measurements.size(), 5);
+  ASSERT_EQ(snapshot.measurements.back().weight, 0.5);
+
+  // Snapshot of another robot is rejected
+  PGOAgent other(1, options);
+  ASSERT_FALSE(other.loadSnapshot(filename));
+  std::remove(filename.c_str());
+}
+
+TEST(testDPGO, testAgentCheckpoint) {
+  unsigned d = 3, r = 5, n = 10;
+  RobustCostParameters cost_params(RobustCostParameters::Type::GNC_TLS);
+  PGOAgentParameters options(d, r, 1, ROptParameters(), true, 30, cost_params, 10, 0, 2);
+  std::vector<RelativeSEMeasurement> odometry, private_loop_closures;
+  for (unsigned i = 0; i + 1 < n; ++i) {
+    odometry.emplace_back(0, 0, i, i + 1, Matrix::Identity(d, d), Vector::Ones(d), 1.0, 1.0);
+    odometry.back().fixedWeight = true;
+  }
+  private_loop_closures.emplace_back(0, 0, 0, 5, Matrix::Identity(d, d), 5 * Vector::Ones(d), 1.0, 1.0);
+  // Outlier
+  private_loop_closures.emplace_back(0, 0, 2, 8, Matrix::Identity(d, d), -10 * Vector::Ones(d), 1.0, 1.0);
+  RobustPGOAgent agent(0, options);
+  agent.setMeasurements(odometry, private_loop_closures, {});
+  agent.initialize();
+  for (unsigned iter = 0; iter < 5; ++iter) {
+    agent.iterate(true);
+    agent.updateMeasurementWeights();
+  }
+  std::string filename = writeTempFile("");
+  ASSERT_TRUE(agent.saveCheckpoint(filename));
+
+  AgentCheckpoint checkpoint;
+  ASSERT_TRUE(readCheckpoint(filename, checkpoint));
+  ASSERT_EQ(checkpoint.iterationNumber, 5);
+  ASSERT_GT(checkpoint.weightUpdateCount, 0);
+  ASSERT_GT(checkpoint.gncIteration, 0);
+  ASSERT_TRUE(checkpoint.Y.has_value());
+  ASSERT_TRUE(checkpoint.XInit.has_value());
+
+  RobustPGOAgent resumed(0, options);
+  ASSERT_TRUE(resumed.loadCheckpoint(filename));
+  ASSERT_EQ(resumed.getStatus().state, PGOAgentState::INITIALIZED);
+  ASSERT_EQ(resumed.iteration_number(), agent.iteration_number());
+  ASSERT_EQ(resumed.instance_number(), agent.instance_number());
+
+  // Both agents continue identically
+  for (unsigned iter = 0; iter < 3; ++iter) {
+    agent.iterate(true);
+    agent.updateMeasurementWeights();
+    resumed.iterate(true);
+    resumed.updateMeasurementWeights();
+    Matrix X0, X1;
+    agent.getX(X0);
+    resumed.getX(X1);
+    ASSERT_LE((X0 - X1).norm(), 1e-10);
+  }
+  ASSERT_TRUE(agent.saveCheckpoint(filename));
+  AgentCheckpoint expected;
+  ASSERT_TRUE(readCheckpoint(filename, expected));
+  ASSERT_TRUE(resumed.saveCheckpoint(filename));
+  ASSERT_TRUE(readCheckpoint(filename, checkpoint));
+  ASSERT_EQ(checkpoint.gncIteration, expected.gncIteration);
+  ASSERT_EQ(checkpoint.gncMu, expected.gncMu);
+  ASSERT_EQ(checkpoint.weightUpdateCount, expected.weightUpdateCount);
+  expectSameMeasurements(checkpoint.snapshot.measurements, expected.snapshot.measurements);
+
+  // Snapshot files are not checkpoints
+  ASSERT_TRUE(agent.saveSnapshot(filename));
+  PGOAgent other(0, options);
+  ASSERT_FALSE(other.loadCheckpoint(filename));
+  std::remove(filename.c_str());
+}
+
+TEST(testDPGO, testAgentCheckpointAdaptiveGNC) {
+  unsigned d = 3, r = 5, n = 10;
+  RobustCostParameters cost_params(RobustCostParameters::Type::GNC_TLS);
+  cost_params.GNCAdaptive = true;
+  PGOAgentParameters options(d, r, 1, ROptParameters(), true, 30, cost_params, 10, 0, 0);
+  std::vector<RelativeSEMeasurement> odometry, private_loop_closures;
+  for (unsigned i = 0; i + 1 < n; ++i) {
+    odometry.emplace_back(0, 0, i, i + 1, Matrix::Identity(d, d), Vector::Ones(d), 1.0, 1.0);
+    odometry.back().fixedWeight = true;
+  }
+  private_loop_closures.emplace_back(0, 0, 0, 5, Matrix::Identity(d, d), 5 * Vector::Ones(d), 1.0, 1.0);
+  // Outlier
+  private_loop_closures.emplace_back(0, 0, 2, 8, Matrix::Identity(d, d), -10 * Vector::Ones(d), 1.0, 1.0);
+  RobustPGOAgent agent(0, options);
+  agent.setMeasurements(odometry, private_loop_closures, {});
+  agent.initialize();
+  agent.iterate(true);
+  agent.updateMeasurementWeights();
+  // Save in the middle of GNC, with the inlier settled and the outlier undecided
+  ASSERT_EQ(agent.getUndecidedLoopClosures().size(), 1);
+  ASSERT_TRUE(agent.shouldUpdateMeasurementWeights());
+  std::string filename = writeTempFile("");
+  ASSERT_TRUE(agent.saveCheckpoint(filename));
+
+  AgentCheckpoint checkpoint;
+  ASSERT_TRUE(readCheckpoint(filename, checkpoint));
+  ASSERT_EQ(checkpoint.gncSettledLoopClosures.size(), 1);
+  ASSERT_TRUE(checkpoint.gncSettledLoopClosures[0] == EdgeID(PoseID(0, 0), PoseID(0, 5)));
+  ASSERT_EQ(checkpoint.gncUndecidedLoopClosures.size(), 1);
+  ASSERT_TRUE(checkpoint.gncUndecidedLoopClosures[0] == EdgeID(PoseID(0, 2), PoseID(0, 8)));
+
+  // The resumed agent continues GNC instead of treating all weights as settled
+  RobustPGOAgent resumed(0, options);
+  ASSERT_TRUE(resumed.loadCheckpoint(filename));
+  ASSERT_TRUE(resumed.getUndecidedLoopClosures() == agent.getUndecidedLoopClosures());
+  ASSERT_TRUE(resumed.shouldUpdateMeasurementWeights());
+  for (unsigned iter = 0; iter < 3; ++iter) {
+    agent.iterate(true);
+    agent.updateMeasurementWeights();
+    resumed.iterate(true);
+    resumed.updateMeasurementWeights();
+    ASSERT_TRUE(resumed.getUndecidedLoopClosures() == agent.getUndecidedLoopClosures());
+    ASSERT_EQ(resumed.shouldUpdateMeasurementWeights(), agent.shouldUpdateMeasurementWeights());
+  }
+  AgentCheckpoint expected;
+  ASSERT_TRUE(agent.saveCheckpoint(filename));
+  ASSERT_TRUE(readCheckpoint(filename, expected));
+  ASSERT_TRUE(resumed.saveCheckpoint(filename));
+  ASSERT_TRUE(readCheckpoint(filename, checkpoint));
+  ASSERT_TRUE(checkpoint.gncSettledLoopClosures == expected.gncSettledLoopClosures);
+  ASSERT_EQ(checkpoint.gncMu, expected.gncMu);
+  expectSameMeasurements(checkpoint.snapshot.measurements, expected.snapshot.measurements);
+  std::remove(filename.c_str());
+}
+
+TEST(testDPGO, testCheckpointCorruptHeader) {
+  unsigned d = 3, r = 5, n = 4;
+  AgentCheckpoint checkpoint;
+  checkpoint.snapshot.d = d;
+  checkpoint.snapshot.numPoses = n;
+  checkpoint.snapshot.measurements.emplace_back(0, 0, 0, 1, randomStiefelVariable(d, d), Vector::Random(d), 10, 100);
+  checkpoint.XInit.emplace(Matrix::Random(r, (d + 1) * n));
+  std::string filename = writeTempFile("");
+  ASSERT_TRUE(writeCheckpoint(filename, checkpoint));
+  AgentCheckpoint loaded;
+  ASSERT_TRUE(readCheckpoint(filename, loaded));
+  CheckpointHeader valid{};
+  {
+    std::ifstream file(filename, std::ios::binary);
+    file.read(reinterpret_cast<char *>(&valid), sizeof(valid));
+  }
+
+  // Header fields whose products or sums overflow 64 bits are rejected
+  auto expectRejected = [&](const std::function<void(CheckpointHeader &)> &corrupt) {
+    CheckpointHeader header = valid;
+    corrupt(header);
+    std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.close();
+    ASSERT_FALSE(readCheckpoint(filename, loaded));
+  };
+  expectRejected([](CheckpointHeader &h) { h.snapshotOffset = ~uint64_t(7); });
+  expectRejected([](CheckpointHeader &h) { h.snapshotSize = ~uint64_t(0) - h.snapshotOffset + 1; });
+  expectRejected([](CheckpointHeader &h) { h.r = ~uint32_t(0); });
+  std::remove(filename.c_str());
+}
+
+TEST(testDPGO, testLoggerRoundTrip) {
+  char dir[] = "/tmp/dpgo_log_XXXXXX";
+  ASSERT_NE(mkdtemp(dir), nullptr);
+  const std::string log_dir = std::string(dir) + "/";
+  for (unsigned d : {2u, 3u}) {
+    unsigned n = 5, r = 5;
+    PoseArray T(d, n);
+    std::vector<RelativeSEMeasurement> measurements;
+    for (unsigned i = 0; i < n; ++i) {
+      T.rotation(i) = projectToRotationGroup(Matrix::Random(d, d));
+      T.translation(i) = Vector::Random(d);
+      RelativeSEMeasurement m(1, 2, i, i + 1, projectToRotationGroup(Matrix::Random(d, d)), Vector::Random(d), 10, 100);
+      m.weight = 0.5 + 0.1 * i;
+      m.fixedWeight = (i == 0);
+      measurements.push_back(m);
+    }
+    T.rotation(0) = Matrix::Identity(d, d);
+    T.translation(0) = Vector::Zero(d);
+    const Matrix YLift = fixedStiefelVariable(d, r);
+    const Matrix X = YLift * T.getData();
+    {
+      PGOLogger logger(log_dir, 2);
+      logger.logTrajectory(d, n, T.getData(), "trajectory.csv");
+      logger.logMeasurements(measurements, "measurements.csv");
+      logger.logMatrix(X, "X.bin");
+      logger.flush();
+      // Rounding in the frame of the first pose recovers the trajectory
+      ASSERT_TRUE(logger.logLiftedTrajectory(d, n, X, X.block(0, 0, r, d + 1), "trajectory_iteration.csv"));
+    }
+    PGOLogger logger(log_dir);
+    ASSERT_LE((logger.loadTrajectory("trajectory.csv") - T.getData()).norm(), 1e-10);
+    ASSERT_LE((logger.loadTrajectory("trajectory_iteration.csv") - T.getData()).norm(), 1e-10);
+    ASSERT_EQ((PGOLogger::loadMatrix(log_dir + "X.bin") - X).norm(), 0);
+    auto loaded = PGOLogger::loadMeasurements(log_dir + "measurements.csv", true);
+    expectSameMeasurements(loaded, measurements);
+  }
+  std::filesystem::remove_all(dir);
+}
+
+TEST(testDPGO, testLoggerMalformedInput) {
+  // Wrong number of fields
+  std::string filename = writeTempFile("pose_index,theta,tx,ty\n0,0,0,0\n1,0,0\n");
+  PGOLogger logger("");
+  ASSERT_EQ(logger.loadTrajectory(filename).size(), 0);
+  std::remove(filename.c_str());
+  // Non-numeric field
+  filename = writeTempFile("pose_index,theta,tx,ty\n0,0,abc,0\n");
+  ASSERT_EQ(logger.loadTrajectory(filename).size(), 0);
+  std::remove(filename.c_str());
+  // Missing pose index
+  filename = writeTempFile("pose_index,theta,tx,ty\n0,0,0,0\n2,0,0,0\n");
+  ASSERT_EQ(logger.loadTrajectory(filename).size(), 0);
+  std::remove(filename.c_str());
+  filename = writeTempFile("robot_src,pose_src,robot_dst,pose_dst,theta,tx,ty,kappa,tau,is_known_inlier,weight\n"
+                           "0,0,0,1,0,1,0,100,100,1\n");
+  ASSERT_TRUE(PGOLogger::loadMeasurements(filename).empty());
+  std::remove(filename.c_str());
+  filename = writeTempFile("robot_src,pose_src,robot_dst,pose_dst,theta,tx,ty,kappa,tau,is_known_inlier,weight\n"
+                           "0,0,0,1,0,1,0,100,100,1,1\n");
+  ASSERT_EQ(PGOLogger::loadMeasurements(filename).size(), 1);
+  std::remove(filename.c_str());
+}
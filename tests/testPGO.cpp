@@ -8,6 +8,7 @@
 #include <random>
 
 #include "gtest/gtest.h"
+#include "testHelpers.h"
 
 using namespace DPGO;
 
@@ -127,6 +128,130 @@ TEST(testDPGO, testRobustSinglePoseAveraging) {
   }
 }
 
+TEST(testDPGO, testRobustSinglePoseAveragingLarge) {
+  // Many noisy inliers among many more outliers, in 2D and 3D
+  std::mt19937 rng(3);
+  std::normal_distribution<double> noise(0, 1e-3);
+  std::uniform_real_distribution<double> uniform(-M_PI, M_PI);
+  const double gnc_barc = RobustCost::computeErrorThresholdAtQuantile(0.9, 3);
+  const int numInliers = 100;
+  const int numCandidates = 500;
+  for (int d : {2, 3}) {
+    const Vector kappa = 10000 * Vector::Ones(numCandidates);
+    const Vector tau = 100 * Vector::Ones(numCandidates);
+    auto randomRotation = [&]() -> Matrix {
+      if (d == 2) return Eigen::Rotation2Dd(uniform(rng)).toRotationMatrix();
+      return Eigen::Quaterniond::UnitRandom().toRotationMatrix();
+    };
+    const Matrix RTrue = randomRotation();
+    const Vector tTrue = Vector::Random(d);
+    std::vector<Matrix> RVec;
+    std::vector<Vector> tVec;
+    for (int i = 0; i < numInliers; ++i) {
+      Matrix R = RTrue;
+      R.col(0) += noise(rng) * RTrue.col(1);
+      RVec.emplace_back(projectToRotationGroup(R));
+      tVec.emplace_back(tTrue + Vector::Constant(d, noise(rng)));
+    }
+    while ((int) RVec.size() < numCandidates) {
+      Matrix RRand = randomRotation();
+      Vector tRand = Vector::Random(d);
+      double rSq = kappa(0) * (RTrue - RRand).squaredNorm() + tau(0) * (tTrue - tRand).squaredNorm();
+      if (std::sqrt(rSq) > 1.2 * gnc_barc) {
+        RVec.emplace_back(RRand);
+        tVec.emplace_back(tRand);
+      }
+    }
+    Matrix ROpt;
+    Vector tOpt;
+    std::vector<size_t> inlierIndices;
+    robustSinglePoseAveraging(ROpt, tOpt, inlierIndices, RVec, tVec, kappa, tau, gnc_barc);
+    checkRotationMatrix(ROpt);
+    ASSERT_LE((ROpt - RTrue).norm(), 1e-3);
+    ASSERT_LE((tOpt - tTrue).norm(), 1e-3);
+    ASSERT_EQ(inlierIndices.size(), numInliers);
+    for (int i = 0; i < numInliers; ++i) {
+      ASSERT_EQ(inlierIndices[i], i);
+    }
+  }
+}
+
+TEST(testDPGO, testSolveCertifiedPGO) {
+  const unsigned d = 3;
+  const unsigned n = 10;
+  // Noise-free pose graph with loop closures, whose ground truth is certified to be globally optimal
+  std::vector<Pose> poses;
+  for (unsigned i = 0; i < n; ++i) poses.push_back(randomPose());
+  std::vector<RelativeSEMeasurement> measurements;
+  auto addMeasurement = [&](unsigned i, unsigned j) {
+    const Pose Tij = poses[i].inverse() * poses[j];
+    measurements.emplace_back(0, 0, i, j, Tij.rotation(), Tij.translation(), 2.0, 3.0);
+  };
+  for (unsigned i = 0; i + 1 < n; ++i) addMeasurement(i, i + 1);
+  addMeasurement(0, 5);
+  addMeasurement(3, 9);
+  PoseArray T0(d, n);
+  for (unsigned i = 0; i < n; ++i) T0.pose(i) = poses[i].pose();
+
+  solveCertifiedPGOParams params;
+  params.num_starts = 3;
+  params.num_threads = 3;
+  params.r_max = 5;
+  const CertifiedPGOResult result = solveCertifiedPGO(measurements, params, &T0);
+  ASSERT_TRUE(result.certified);
+  ASSERT_EQ(result.rank, d);
+  ASSERT_LT(result.start, 2);
+  ASSERT_NEAR(result.fRelaxed, 0, 1e-8);
+  ASSERT_NEAR(result.fRounded, 0, 1e-8);
+  for (const auto &m : measurements) {
+    const Pose T1(result.T.pose(m.p1));
+    const Pose T2(result.T.pose(m.p2));
+    const Pose T12 = T1.inverse() * T2;
+    ASSERT_LE((T12.rotation() - m.R).norm(), 1e-6);
+    ASSERT_LE((T12.translation() - m.t).norm(), 1e-6);
+  }
+}
+
+TEST(testDPGO, testSolveCertifiedPGOStaircase) {
+  const unsigned d = 3;
+  const unsigned n = 8;
+  // Cycle of identity measurements
+  std::vector<RelativeSEMeasurement> measurements;
+  for (unsigned i = 0; i < n; ++i)
+    measurements.emplace_back(0, 0, i, (i + 1) % n, Matrix::Identity(d, d), Vector::Zero(d), 10.0, 1.0);
+  // Rotations that wind once around the z axis form a first-order critical point with positive cost,
+  // which is not certified at rank d and where the local solver makes no progress
+  PoseArray T0(d, n);
+  for (unsigned i = 0; i < n; ++i) {
+    T0.rotation(i) = Eigen::AngleAxisd(2 * M_PI * i / n, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+    T0.translation(i) = Vector::Zero(d);
+  }
+  PoseGraph pose_graph(0, d, d);
+  pose_graph.setMeasurements(measurements);
+  const SparseMatrix Q = pose_graph.quadraticMatrix();
+  const double f0 = 0.5 * ((T0.getData() * Q).cwiseProduct(T0.getData())).sum();
+  ASSERT_GT(f0, 1);
+  Vector v;
+  double curvature = 0;
+  ASSERT_FALSE(verifyCertificateMatrix(constructCertificateMatrix(Q, T0.getData(), d), 1e-5, v, curvature));
+
+  // The staircase escapes the saddle at a higher rank and certifies the global minimum
+  solveCertifiedPGOParams params;
+  params.r_min = d;
+  params.r_max = d + 3;
+  const CertifiedPGOResult result = solveCertifiedPGO(measurements, params, &T0);
+  ASSERT_TRUE(result.certified);
+  ASSERT_GT(result.rank, d);
+  ASSERT_EQ(result.Y.rows(), result.rank);
+  ASSERT_GE(result.curvature, -params.eig_tol);
+  ASSERT_TRUE(verifyCertificateMatrix(constructCertificateMatrix(Q, result.Y, d), params.eig_tol, v, curvature));
+  ASSERT_LT(result.fRelaxed, 1e-6 * f0);
+  ASSERT_LT(result.fRounded, 1e-6 * f0);
+  for (unsigned i = 1; i < n; ++i) {
+    const Pose T01 = Pose(result.T.pose(0)).inverse() * Pose(result.T.pose(i));
+    ASSERT_LE((T01.rotation() - Matrix::Identity(d, d)).norm(), 1e-3);
+  }
+}
 
 TEST(testDPGO, testPrior) {
   size_t dimension = 3;
@@ -269,4 +394,137 @@ TEST(testDPGO, testRobustPGO) {
         CHECK_NEAR(m.weight, 0, 1e-6);
     }
   }
-}
\ No newline at end of file
+}
+
+TEST(testDPGO, testRobustPGOAdaptive) {
+  const unsigned n = 20;
+  std::vector<Pose> poses_gt;
+  for (unsigned i = 0; i < n; ++i) poses_gt.push_back(randomPose());
+  auto makeMeasurement = [&](unsigned i, unsigned j, bool fixedWeight) {
+    const Pose Tij = poses_gt[i].inverse() * poses_gt[j];
+    RelativeSEMeasurement m(0, 0, i, j, Tij.rotation(), Tij.translation(), 10000, 100);
+    m.fixedWeight = fixedWeight;
+    return m;
+  };
+  // Trusted odometry, inlier loop closures (i, i + 5) and outlier loop closures (i, i + 10)
+  std::vector<RelativeSEMeasurement> measurements;
+  for (unsigned i = 0; i + 1 < n; ++i) measurements.push_back(makeMeasurement(i, i + 1, true));
+  for (unsigned i = 0; i + 5 < n; i += 2) measurements.push_back(makeMeasurement(i, i + 5, false));
+  for (unsigned i = 1; i + 10 < n; i += 3) {
+    RelativeSEMeasurement m = makeMeasurement(i, i + 10, false);
+    const Pose TOutlier = randomPose();
+    m.R = TOutlier.rotation();
+    m.t = 10 * TOutlier.translation();
+    measurements.push_back(m);
+  }
+  auto pose_graph = std::make_shared<PoseGraph>(0, 3, 3);
+  pose_graph->setMeasurements(measurements);
+  PoseArray TOdom = odometryInitialization(pose_graph->odometry());
+
+  solveRobustPGOParams params;
+  params.verbose = false;
+  params.opt_params.verbose = false;
+  params.opt_params.gradnorm_tol = 1e-1;
+  params.opt_params.RTR_iterations = 50;
+  params.robust_params.GNCBarc = 7.0;
+  params.robust_params.GNCAdaptive = true;
+  auto mutable_measurements = measurements;
+  solveRobustPGO(mutable_measurements, params, &TOdom);
+  // Adaptive GNC classifies every loop closure correctly
+  for (size_t k = 0; k < measurements.size(); ++k) {
+    const auto &m = mutable_measurements[k];
+    if (m.fixedWeight) continue;
+    if (m.p2 == m.p1 + 5)
+      ASSERT_NEAR(m.weight, 1, 1e-6);
+    else
+      ASSERT_NEAR(m.weight, 0, 1e-6);
+  }
+}
+
+TEST(testDPGO, testChordalInitializationMethods) {
+  int n = 50;
+  std::vector<Pose> poses_gt;
+  for (int i = 0; i < n; ++i) {
+    Pose Ti = randomPose();
+    poses_gt.push_back(Ti);
+  }
+  // Noiseless odometry and loop closures
+  std::vector<RelativeSEMeasurement> measurements;
+  for (int i = 0; i < n; ++i) {
+    for (int j : {i + 1, i + 7}) {
+      if (j >= n) continue;
+      Pose Tij = poses_gt[i].inverse() * poses_gt[j];
+      measurements.emplace_back(0, 0, i, j, Tij.rotation(), Tij.translation(), 100.0, 10.0);
+    }
+  }
+  for (auto method : {InitializationMethod::Chordal,
+                      InitializationMethod::ChordalCholesky,
+                      InitializationMethod::ChordalCG}) {
+    PoseArray T = chordalInitialization(measurements, method);
+    ASSERT_EQ(T.n(), n);
+    // The estimate is expressed in the frame of the first pose
+    for (int i = 0; i < n; ++i) {
+      Pose Ti(T.pose(i));
+      Pose Ti_gt = poses_gt[0].inverse() * poses_gt[i];
+      ASSERT_LE((Ti.rotation() - Ti_gt.rotation()).norm(), 1e-6) << InitializationMethodToString(method);
+      ASSERT_LE((Ti.translation() - Ti_gt.translation()).norm(), 1e-6) << InitializationMethodToString(method);
+    }
+  }
+}
+
+TEST(testDPGO, testSpanningTreeInitialization) {
+  int n = 30;
+  std::vector<Pose> poses_gt;
+  for (int i = 0; i < n; ++i) {
+    Pose Ti = randomPose();
+    poses_gt.push_back(Ti);
+  }
+  auto makeMeasurement = [&](const Pose &Ti, const Pose &Tj, int i, int j, double kappa, double tau) {
+    Pose Tij = Ti.inverse() * Tj;
+    return RelativeSEMeasurement(0, 0, i, j, Tij.rotation(), Tij.translation(), kappa, tau);
+  };
+  // Odometry with a missing segment between poses 9 and 10, bridged by (reversed) loop closures
+  std::vector<RelativeSEMeasurement> measurements;
+  for (int i = 0; i + 1 < n; ++i) {
+    if (i == 9) continue;
+    measurements.push_back(makeMeasurement(poses_gt[i], poses_gt[i + 1], i, i + 1, 100, 10));
+  }
+  measurements.push_back(makeMeasurement(poses_gt[12], poses_gt[5], 12, 5, 100, 10));
+  measurements.push_back(makeMeasurement(poses_gt[25], poses_gt[2], 25, 2, 100, 10));
+  // Imprecise outlier parallel to a precise odometry edge
+  Pose TOutlier = randomPose();
+  measurements.push_back(makeMeasurement(poses_gt[3], TOutlier, 3, 4, 1, 0.1));
+
+  for (unsigned numThreads : {1, 4}) {
+    PoseArray T = spanningTreeInitialization(measurements, numThreads);
+    ASSERT_EQ(T.n(), n);
+    for (int i = 0; i < n; ++i) {
+      Pose Ti(T.pose(i));
+      Pose Ti_gt = poses_gt[0].inverse() * poses_gt[i];
+      ASSERT_LE((Ti.rotation() - Ti_gt.rotation()).norm(), 1e-6);
+      ASSERT_LE((Ti.translation() - Ti_gt.translation()).norm(), 1e-6);
+    }
+  }
+}
+
+TEST(testDPGO, testSpanningTreeInitializationWideLevels) {
+  // Star graph whose leaves are composed in parallel
+  int d = 2;
+  int n = 20001;
+  Matrix R = Eigen::Rotation2Dd(0.3).toRotationMatrix();
+  std::vector<RelativeSEMeasurement> measurements;
+  for (int i = 1; i < n; ++i) {
+    Vector t = Vector::Constant(d, i);
+    if (i % 2)
+      measurements.emplace_back(0, 0, 0, i, R, t, 1.0, 1.0);
+    else
+      measurements.emplace_back(0, 0, i, 0, R.transpose(), -R.transpose() * t, 1.0, 1.0);
+  }
+  PoseArray T1 = spanningTreeInitialization(measurements, 1);
+  PoseArray T4 = spanningTreeInitialization(measurements, 4);
+  ASSERT_LE((T1.getData() - T4.getData()).norm(), 1e-12);
+  for (int i = 1; i < n; ++i) {
+    ASSERT_LE((T4.rotation(i) - R).norm(), 1e-9);
+    ASSERT_LE((T4.translation(i) - Vector::Constant(d, i)).norm(), 1e-9);
+  }
+}
@@ -0,0 +1,122 @@
+#include <DPGO/DPGO_partition.h>
+
+#include "gtest/gtest.h"
+
+using namespace DPGO;
+
+namespace {
+RelativeSEMeasurement makeMeasurement(size_t p1, size_t p2) {
+  return RelativeSEMeasurement(0, 0, p1, p2, Matrix::Identity(3, 3), Vector::Zero(3), 1.0, 1.0);
+}
+
+// Odometry chain with loop closures (i, i + 3) inside each of the given clusters of poses
+std::vector<RelativeSEMeasurement> clusteredChain(const std::vector<size_t> &clusterStarts, size_t numPoses) {
+  std::vector<RelativeSEMeasurement> measurements;
+  for (size_t i = 0; i + 1 < numPoses; ++i) measurements.push_back(makeMeasurement(i, i + 1));
+  for (size_t c = 0; c < clusterStarts.size(); ++c) {
+    const size_t end = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : numPoses;
+    for (size_t i = clusterStarts[c]; i + 3 < end; ++i) measurements.push_back(makeMeasurement(i, i + 3));
+  }
+  return measurements;
+}
+
+void checkPartition(const PoseGraphPartition &partition, const std::vector<RelativeSEMeasurement> &measurements,
+                    size_t numPoses, unsigned numRobots) {
+  ASSERT_EQ(partition.numRobots(), numRobots);
+  ASSERT_EQ(partition.starts.front(), 0);
+  ASSERT_EQ(partition.starts.back(), numPoses);
+  size_t numMeasurements = 0;
+  size_t numShared = 0;
+  for (unsigned robot = 0; robot < numRobots; ++robot) {
+    ASSERT_GE(partition.numPoses(robot), 2);
+    const auto &agent = partition.agents[robot];
+    // Odometry forms a chain over the poses of the robot
+    ASSERT_EQ(agent.odometry.size(), partition.numPoses(robot) - 1);
+    for (size_t k = 0; k < agent.odometry.size(); ++k) {
+      ASSERT_EQ(agent.odometry[k].r1, robot);
+      ASSERT_EQ(agent.odometry[k].p1, k);
+      ASSERT_EQ(agent.odometry[k].p2, k + 1);
+    }
+    for (const auto &m : agent.privateLoopClosures) {
+      ASSERT_EQ(m.r1, robot);
+      ASSERT_EQ(m.r2, robot);
+      ASSERT_LT(m.p2, partition.numPoses(robot));
+    }
+    for (const auto &m : agent.sharedLoopClosures) {
+      ASSERT_NE(m.r1, m.r2);
+      ASSERT_TRUE(m.r1 == robot || m.r2 == robot);
+      ASSERT_EQ(partition.poseID(partition.globalIndex(PoseID(m.r1, m.p1))), PoseID(m.r1, m.p1));
+    }
+    numMeasurements += agent.odometry.size() + agent.privateLoopClosures.size();
+    numShared += agent.sharedLoopClosures.size();
+  }
+  ASSERT_EQ(numShared, 2 * partition.numSharedLoopClosures);
+  ASSERT_EQ(numMeasurements + partition.numSharedLoopClosures, measurements.size());
+}
+}  // namespace
+
+TEST(testDPGO, testPartitionContiguous) {
+  const size_t n = 23;
+  const auto measurements = clusteredChain({0}, n);
+  PoseGraphPartition partition;
+  ASSERT_TRUE(partitionPoseGraph(measurements, n, 4,
+                                 PartitionParameters(PartitionParameters::Method::Contiguous), partition));
+  checkPartition(partition, measurements, n, 4);
+  ASSERT_EQ(partition.starts, std::vector<size_t>({0, 5, 10, 15, 23}));
+  ASSERT_EQ(partition.poseID(12), PoseID(2, 2));
+  ASSERT_EQ(partition.globalIndex(PoseID(3, 7)), 22);
+}
+
+TEST(testDPGO, testPartitionBisection) {
+  // Two clusters of loop closures split at pose 18
+  const size_t n = 40;
+  const auto measurements = clusteredChain({0, 18}, n);
+  PoseGraphPartition contiguous, bisection;
+  ASSERT_TRUE(partitionPoseGraph(measurements, n, 2,
+                                 PartitionParameters(PartitionParameters::Method::Contiguous), contiguous));
+  ASSERT_TRUE(partitionPoseGraph(measurements, n, 2,
+                                 PartitionParameters(PartitionParameters::Method::RecursiveBisection, 0.2),
+                                 bisection));
+  checkPartition(bisection, measurements, n, 2);
+  ASSERT_EQ(bisection.starts[1], 18);
+  // Only the odometry between the clusters is shared
+  ASSERT_EQ(bisection.numSharedLoopClosures, 1);
+  ASSERT_EQ(contiguous.numSharedLoopClosures, 3);
+}
+
+TEST(testDPGO, testPartitionBalance) {
+  const size_t n = 200;
+  const auto measurements = clusteredChain({0, 13, 50, 71, 90, 140, 151, 177}, n);
+  const double tol = 0.15;
+  for (unsigned numRobots : {2, 3, 5, 8}) {
+    PoseGraphPartition contiguous, bisection;
+    ASSERT_TRUE(partitionPoseGraph(measurements, n, numRobots,
+                                   PartitionParameters(PartitionParameters::Method::Contiguous), contiguous));
+    ASSERT_TRUE(partitionPoseGraph(measurements, n, numRobots,
+                                   PartitionParameters(PartitionParameters::Method::RecursiveBisection, tol),
+                                   bisection));
+    checkPartition(bisection, measurements, n, numRobots);
+    ASSERT_LE(bisection.numSharedLoopClosures, contiguous.numSharedLoopClosures);
+    double total = 0;
+    for (double load : bisection.loads) total += load;
+    for (double load : bisection.loads) ASSERT_LE(load, (1 + tol) * total / numRobots + 1e-9);
+  }
+}
+
+TEST(testDPGO, testPartitionInvalid) {
+  const auto measurements = clusteredChain({0}, 7);
+  PoseGraphPartition partition;
+  ASSERT_FALSE(partitionPoseGraph(measurements, 7, 4, PartitionParameters(), partition));
+  ASSERT_FALSE(splitPoseGraph(measurements, {0, 4, 4, 7}, partition));
+  ASSERT_FALSE(splitPoseGraph(measurements, {0, 4, 6}, partition));
+  ASSERT_TRUE(splitPoseGraph(measurements, {0, 4, 7}, partition));
+  checkPartition(partition, measurements, 7, 2);
+  // Measurements that reference poses out of range are rejected by all methods
+  auto outOfRange = measurements;
+  outOfRange.push_back(makeMeasurement(2, 100));
+  for (auto method : {PartitionParameters::Method::Contiguous, PartitionParameters::Method::RecursiveBisection}) {
+    PartitionParameters params;
+    params.method = method;
+    ASSERT_FALSE(partitionPoseGraph(outOfRange, 7, 2, params, partition));
+  }
+}
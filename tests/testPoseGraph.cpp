@@ -0,0 +1,450 @@
+#include <DPGO/PoseGraph.h>
+#include <DPGO/PGOAgent.h>
+#include <DPGO/DPGO_utils.h>
+#include <cmath>
+#include <iostream>
+
+#include "gtest/gtest.h"
+#include "testHelpers.h"
+
+using namespace DPGO;
+
+namespace {
+RelativeSEMeasurement identityMeasurement(unsigned r1, unsigned r2, unsigned p1, unsigned p2, unsigned d) {
+  return RelativeSEMeasurement(r1, r2, p1, p2, Matrix::Identity(d, d), Vector::Zero(d), 1.0, 1.0);
+}
+
+RelativeSEMeasurement randomMeasurement(unsigned r1, unsigned r2, unsigned p1, unsigned p2) {
+  return RelativeSEMeasurement(r1, r2, p1, p2, Eigen::Quaterniond::UnitRandom().toRotationMatrix(),
+                               Eigen::Vector3d::Random(), 2.0, 3.0);
+}
+
+// Exposes the robust cost and measurement weights of an agent
+class RobustTestAgent : public PGOAgent {
+ public:
+  using PGOAgent::PGOAgent;
+  using PGOAgent::updateMeasurementWeights;
+  using PGOAgent::setMeasurementWeight;
+  double GNCMu() const { return mRobustCost.GNCMu(); }
+  double weight(unsigned p1, unsigned p2) { return mPoseGraph->findMeasurement(PoseID(0, p1), PoseID(0, p2))->weight; }
+};
+}  // namespace
+
+TEST(testDPGO, testPublicFrameIDIndex) {
+  unsigned d = 3;
+  PoseGraph pose_graph(0, d, d);
+  std::vector<RelativeSEMeasurement> measurements;
+  for (unsigned i = 0; i < 5; ++i) {
+    measurements.push_back(identityMeasurement(0, 0, i, i + 1, d));
+  }
+  measurements.push_back(identityMeasurement(0, 1, 4, 0, d));
+  measurements.push_back(identityMeasurement(2, 0, 1, 2, d));
+  measurements.push_back(identityMeasurement(0, 1, 1, 3, d));
+  measurements.push_back(identityMeasurement(1, 0, 5, 4, d));  // Pose 4 is shared twice with robot 1
+  pose_graph.setMeasurements(measurements);
+
+  ASSERT_EQ(pose_graph.myPublicFrameIDsWithNeighbor(1), std::vector<unsigned>({1, 4}));
+  ASSERT_EQ(pose_graph.myPublicFrameIDsWithNeighbor(2), std::vector<unsigned>({2}));
+  ASSERT_TRUE(pose_graph.myPublicFrameIDsWithNeighbor(3).empty());
+
+  pose_graph.empty();
+  ASSERT_TRUE(pose_graph.myPublicFrameIDsWithNeighbor(1).empty());
+}
+
+TEST(testDPGO, testSharedPosesWithNeighbors) {
+  unsigned d = 3;
+  unsigned r = 5;
+  PGOAgentParameters options(d, r, 3);
+  options.multirobotInitialization = false;
+  std::vector<RelativeSEMeasurement> odometry, shared;
+  for (unsigned i = 0; i < 5; ++i) {
+    odometry.push_back(identityMeasurement(0, 0, i, i + 1, d));
+  }
+  shared.push_back(identityMeasurement(0, 1, 4, 0, d));
+  shared.push_back(identityMeasurement(2, 0, 1, 2, d));
+  shared.push_back(identityMeasurement(0, 1, 1, 3, d));
+
+  PGOAgent agent(0, options);
+  agent.setMeasurements(odometry, {}, shared);
+  agent.initialize();
+  Matrix X = Matrix::Random(r, 6 * (d + 1));
+  agent.setX(X);
+
+  std::map<unsigned, Matrix> buffers;
+  ASSERT_TRUE(agent.getSharedPosesWithNeighbors(buffers));
+  ASSERT_EQ(buffers.size(), 2);
+  for (unsigned neighbor : {1, 2}) {
+    PoseDict poses;
+    ASSERT_TRUE(agent.getSharedPoseDictWithNeighbor(poses, neighbor));
+    const auto &frame_ids = agent.getPublicFrameIDsWithNeighbor(neighbor);
+    ASSERT_EQ(poses.size(), frame_ids.size());
+    ASSERT_EQ(buffers[neighbor].cols(), frame_ids.size() * (d + 1));
+    for (size_t k = 0; k < frame_ids.size(); ++k) {
+      const Matrix expected = X.block(0, frame_ids[k] * (d + 1), r, d + 1);
+      ASSERT_LE((buffers[neighbor].block(0, k * (d + 1), r, d + 1) - expected).norm(), 1e-12);
+      ASSERT_LE((poses.at(PoseID(0, frame_ids[k])).pose() - expected).norm(), 1e-12);
+    }
+  }
+}
+
+TEST(testDPGO, testAppendOdometry) {
+  unsigned d = 3;
+  unsigned r = 5;
+  std::vector<RelativeSEMeasurement> measurements;
+  for (unsigned i = 0; i < 8; ++i) {
+    Pose Tij = randomPose();
+    measurements.emplace_back(0, 0, i, i + 1, Tij.rotation(), Tij.translation(), 2.0, 3.0);
+  }
+  measurements.push_back(identityMeasurement(0, 0, 0, 4, d));
+  PoseGraph pose_graph(0, r, d);
+  pose_graph.setMeasurements(std::vector<RelativeSEMeasurement>(measurements.begin(), measurements.begin() + 5));
+  pose_graph.addMeasurement(measurements.back());
+  ASSERT_TRUE(pose_graph.constructDataMatrices());
+  ASSERT_EQ(pose_graph.n(), 6);
+
+  // Odometry must start from the last pose
+  ASSERT_FALSE(pose_graph.appendOdometry({measurements[6]}));
+  ASSERT_FALSE(pose_graph.appendOdometry({measurements[5], measurements[7]}));
+  ASSERT_TRUE(pose_graph.appendOdometry({measurements[5], measurements[6], measurements[7]}));
+  ASSERT_EQ(pose_graph.n(), 9);
+  ASSERT_EQ(pose_graph.numOdometry(), 8);
+
+  PoseGraph expected(0, r, d);
+  expected.setMeasurements(measurements);
+  ASSERT_TRUE(expected.constructDataMatrices());
+  const SparseMatrix Q = pose_graph.quadraticMatrix();
+  ASSERT_EQ(Q.rows(), expected.quadraticMatrix().rows());
+  ASSERT_LE((Matrix(Q) - Matrix(expected.quadraticMatrix())).norm(), 1e-12);
+  ASSERT_EQ(pose_graph.linearMatrix().cols(), 9 * (d + 1));
+  ASSERT_LE((pose_graph.linearMatrix() - expected.linearMatrix()).norm(), 1e-12);
+}
+
+TEST(testDPGO, testAgentAddOdometry) {
+  unsigned d = 3;
+  unsigned r = 5;
+  PGOAgentParameters options(d, r, 1);
+  options.acceleration = true;
+  std::vector<RelativeSEMeasurement> odometry;
+  for (unsigned i = 0; i < 5; ++i) {
+    odometry.push_back(identityMeasurement(0, 0, i, i + 1, d));
+  }
+  PGOAgent agent(0, options);
+  agent.setMeasurements(odometry, {}, {});
+  agent.initialize();
+  ASSERT_EQ(agent.getStatus().state, PGOAgentState::INITIALIZED);
+  Matrix X0;
+  agent.getX(X0);
+
+  // New odometry extends the trajectory from the latest estimate
+  Pose Tij = randomPose();
+  agent.addMeasurement(RelativeSEMeasurement(0, 0, 5, 6, Tij.rotation(), Tij.translation(), 1.0, 1.0));
+  ASSERT_EQ(agent.num_poses(), 7);
+  ASSERT_FALSE(agent.addOdometry({identityMeasurement(0, 0, 3, 4, d)}));
+  ASSERT_TRUE(agent.addOdometry({identityMeasurement(0, 0, 6, 7, d), identityMeasurement(0, 0, 7, 8, d)}));
+  ASSERT_EQ(agent.num_poses(), 9);
+
+  Matrix X;
+  agent.getX(X);
+  ASSERT_EQ(X.cols(), 9 * (d + 1));
+  ASSERT_LE((X.leftCols(X0.cols()) - X0).norm(), 1e-12);
+  const Matrix X5 = X.middleCols(5 * (d + 1), d + 1);
+  const Matrix X6 = X.middleCols(6 * (d + 1), d + 1);
+  ASSERT_LE((X6.leftCols(d) - X5.leftCols(d) * Tij.rotation()).norm(), 1e-12);
+  ASSERT_LE((X6.col(d) - X5.col(d) - X5.leftCols(d) * Tij.translation()).norm(), 1e-12);
+  ASSERT_LE((X.middleCols(8 * (d + 1), d + 1) - X6).norm(), 1e-12);
+
+  // The initial guess and acceleration variables are extended as well
+  ASSERT_TRUE(agent.iterate(true));
+  agent.setXToInitialGuess();
+  agent.getX(X);
+  ASSERT_EQ(X.cols(), 9 * (d + 1));
+  Matrix T;
+  ASSERT_TRUE(agent.getTrajectoryInLocalFrame(T));
+  ASSERT_EQ(T.cols(), 9 * (d + 1));
+}
+
+TEST(testDPGO, testPoseGraphWindow) {
+  unsigned d = 3;
+  unsigned r = 5;
+  unsigned n = 10;
+  std::vector<RelativeSEMeasurement> measurements;
+  for (unsigned i = 0; i + 1 < n; ++i) {
+    Pose Tij = randomPose();
+    measurements.emplace_back(0, 0, i, i + 1, Tij.rotation(), Tij.translation(), 2.0, 3.0);
+  }
+  for (const auto &lc : std::vector<std::pair<unsigned, unsigned>>{{1, 7}, {8, 2}, {3, 5}, {0, 2}}) {
+    Pose Tij = randomPose();
+    measurements.emplace_back(0, 0, lc.first, lc.second, Tij.rotation(), Tij.translation(), 5.0, 1.0);
+  }
+  measurements.push_back(identityMeasurement(0, 1, 3, 0, d));
+  measurements.push_back(identityMeasurement(1, 0, 1, 8, d));
+  PoseDict neighbor_poses;
+  neighbor_poses[PoseID(1, 0)] = LiftedPose(Matrix::Random(r, d + 1));
+  neighbor_poses[PoseID(1, 1)] = LiftedPose(Matrix::Random(r, d + 1));
+
+  LiftedPoseArray X(r, d, n);
+  X.setData(Matrix::Random(r, (d + 1) * n));
+  PoseGraph full(0, r, d);
+  full.setMeasurements(measurements);
+  full.setNeighborPoses(neighbor_poses);
+  ASSERT_TRUE(full.constructDataMatrices());
+  const Matrix Q = Matrix(full.quadraticMatrix());
+  const Matrix EG = X.getData() * full.quadraticMatrix() + full.linearMatrix();
+
+  // Optimizing over the window with frozen poses is equivalent to optimizing the full
+  // problem over the poses in the window
+  const unsigned start = 4;
+  const unsigned cols = (d + 1) * (n - start);
+  PoseGraph window(0, r, d);
+  window.setMeasurements(measurements);
+  window.setNeighborPoses(neighbor_poses);
+  window.setWindow(start, X);
+  ASSERT_EQ(window.windowStart(), start);
+  ASSERT_EQ(window.numActivePoses(), n - start);
+  ASSERT_TRUE(window.constructDataMatrices());
+  ASSERT_EQ(window.quadraticMatrix().rows(), cols);
+  ASSERT_EQ(window.linearMatrix().cols(), cols);
+  ASSERT_LE((Matrix(window.quadraticMatrix()) - Q.bottomRightCorner(cols, cols)).norm(), 1e-10);
+  const Matrix EGWindow = X.getData().rightCols(cols) * window.quadraticMatrix() + window.linearMatrix();
+  ASSERT_LE((EGWindow - EG.rightCols(cols)).norm(), 1e-10);
+
+  // Odometry appended to a window is equivalent to constructing the window from scratch
+  Pose Tij = randomPose();
+  const RelativeSEMeasurement odom(0, 0, n - 1, n, Tij.rotation(), Tij.translation(), 2.0, 3.0);
+  ASSERT_TRUE(window.appendOdometry({odom}));
+  measurements.push_back(odom);
+  PoseGraph expected(0, r, d);
+  expected.setMeasurements(measurements);
+  expected.setNeighborPoses(neighbor_poses);
+  Matrix XNewData(r, (d + 1) * (n + 1));
+  XNewData << X.getData(), Matrix::Random(r, d + 1);
+  LiftedPoseArray XNew(r, d, n + 1);
+  XNew.setData(XNewData);
+  expected.setWindow(start, XNew);
+  ASSERT_TRUE(expected.constructDataMatrices());
+  ASSERT_LE((Matrix(window.quadraticMatrix()) - Matrix(expected.quadraticMatrix())).norm(), 1e-10);
+  ASSERT_LE((window.linearMatrix() - expected.linearMatrix()).norm(), 1e-10);
+
+  // Moving the window back to the first pose recovers the full problem
+  window.setWindow(0, XNew);
+  ASSERT_EQ(window.numActivePoses(), n + 1);
+  ASSERT_TRUE(window.constructDataMatrices());
+  ASSERT_EQ(window.quadraticMatrix().rows(), (d + 1) * (n + 1));
+}
+
+TEST(testDPGO, testAgentSlidingWindow) {
+  unsigned d = 3;
+  unsigned r = 5;
+  unsigned n = 10;
+  for (bool acceleration : {false, true}) {
+    PGOAgentParameters options(d, r, 1);
+    options.acceleration = acceleration;
+    options.slidingWindowSize = 4;
+    std::vector<RelativeSEMeasurement> odometry, privateLoopClosures;
+    for (unsigned i = 0; i + 1 < n; ++i) {
+      odometry.push_back(identityMeasurement(0, 0, i, i + 1, d));
+    }
+    // Loop closure between the window and a frozen pose that disagrees with odometry
+    Pose Tij(d);
+    Tij.translation() = Eigen::Vector3d(1, 2, 3);
+    privateLoopClosures.emplace_back(0, 0, 2, 8, Tij.rotation(), Tij.translation(), 1.0, 1.0);
+    PGOAgent agent(0, options);
+    agent.setMeasurements(odometry, privateLoopClosures, {});
+    agent.initialize();
+    ASSERT_EQ(agent.getStatus().state, PGOAgentState::INITIALIZED);
+    Matrix X0;
+    agent.getX(X0);
+    for (unsigned iter = 0; iter < 5; ++iter) ASSERT_TRUE(agent.iterate(true));
+
+    // Only the last poses are optimized
+    Matrix X;
+    agent.getX(X);
+    const unsigned cols = (d + 1) * (n - options.slidingWindowSize);
+    ASSERT_LE((X.leftCols(cols) - X0.leftCols(cols)).norm(), 1e-12);
+    ASSERT_GT((X.rightCols(X.cols() - cols) - X0.rightCols(X.cols() - cols)).norm(), 1e-3);
+
+    // The window follows new odometry
+    ASSERT_TRUE(agent.addOdometry({identityMeasurement(0, 0, n - 1, n, d)}));
+    agent.getX(X0);
+    ASSERT_TRUE(agent.iterate(true));
+    agent.getX(X);
+    const unsigned newCols = (d + 1) * (n + 1 - options.slidingWindowSize);
+    ASSERT_LE((X.leftCols(newCols) - X0.leftCols(newCols)).norm(), 1e-12);
+  }
+}
+
+TEST(testDPGO, testApplyWeightChanges) {
+  unsigned d = 3;
+  unsigned r = 5;
+  unsigned n = 10;
+  std::vector<RelativeSEMeasurement> measurements;
+  for (unsigned i = 0; i + 1 < n; ++i) measurements.push_back(randomMeasurement(0, 0, i, i + 1));
+  measurements.push_back(randomMeasurement(0, 0, 1, 7));
+  measurements.push_back(randomMeasurement(0, 0, 8, 2));
+  measurements.push_back(randomMeasurement(0, 0, 5, 9));
+  measurements.push_back(randomMeasurement(0, 1, 3, 0));
+  measurements.push_back(randomMeasurement(1, 0, 1, 8));
+  PoseDict neighbor_poses;
+  neighbor_poses[PoseID(1, 0)] = LiftedPose(Matrix::Random(r, d + 1));
+  neighbor_poses[PoseID(1, 1)] = LiftedPose(Matrix::Random(r, d + 1));
+  LiftedPoseArray X(r, d, n);
+  X.setData(Matrix::Random(r, (d + 1) * n));
+
+  for (unsigned start : {0, 4}) {
+    PoseGraph pose_graph(0, r, d);
+    pose_graph.setMeasurements(measurements);
+    pose_graph.setNeighborPoses(neighbor_poses);
+    pose_graph.setWindow(start, X);
+    ASSERT_TRUE(pose_graph.constructDataMatrices());
+    ASSERT_TRUE(pose_graph.hasPreconditioner());
+    ASSERT_EQ(pose_graph.applyWeightChanges(), 0);
+
+    // Change the weights of all loop closures (including the one among frozen poses)
+    std::vector<RelativeSEMeasurement> weighted = measurements;
+    double weight = 0.9;
+    for (auto *m : pose_graph.allLoopClosures()) {
+      m->weight = weight;
+      for (auto &w : weighted) {
+        if (w.r1 == m->r1 && w.p1 == m->p1 && w.r2 == m->r2 && w.p2 == m->p2) w.weight = weight;
+      }
+      weight -= 0.2;
+    }
+    ASSERT_EQ(pose_graph.applyWeightChanges(), start == 0 ? 5 : 4);
+    ASSERT_TRUE(pose_graph.constructDataMatrices());
+    ASSERT_TRUE(pose_graph.hasPreconditioner());
+
+    PoseGraph expected(0, r, d);
+    expected.setMeasurements(weighted);
+    expected.setNeighborPoses(neighbor_poses);
+    expected.setWindow(start, X);
+    ASSERT_TRUE(expected.constructDataMatrices());
+    ASSERT_EQ(pose_graph.quadraticMatrix().nonZeros(), expected.quadraticMatrix().nonZeros());
+    ASSERT_LE((Matrix(pose_graph.quadraticMatrix()) - Matrix(expected.quadraticMatrix())).norm(), 1e-10);
+    ASSERT_LE((pose_graph.linearMatrix() - expected.linearMatrix()).norm(), 1e-10);
+  }
+}
+
+TEST(testDPGO, testAgentAdaptiveGNC) {
+  unsigned d = 3, r = 5, n = 10;
+  const double barc = 5;
+  // Ground truth poses (I, i * 1) with trusted odometry
+  PoseArray T(d, n);
+  std::vector<RelativeSEMeasurement> odometry, loop_closures;
+  for (unsigned i = 0; i < n; ++i) {
+    T.rotation(i) = Matrix::Identity(d, d);
+    T.translation(i) = i * Vector::Ones(d);
+  }
+  for (unsigned i = 0; i + 1 < n; ++i) {
+    odometry.emplace_back(0, 0, i, i + 1, Matrix::Identity(d, d), Vector::Ones(d), 1.0, 1.0);
+    odometry.back().fixedWeight = true;
+  }
+  // Inliers
+  for (unsigned i = 0; i < 6; ++i)
+    loop_closures.emplace_back(0, 0, i, i + 3, Matrix::Identity(d, d), 3 * Vector::Ones(d), 1.0, 1.0);
+  // Outlier
+  loop_closures.emplace_back(0, 0, 2, 8, Matrix::Identity(d, d), -10 * Vector::Ones(d), 1.0, 1.0);
+  // Residual equal to barc, whose TLS weight sqrt(mu^2 + mu) - mu never settles
+  Vector t = 5 * Vector::Ones(d);
+  t(0) += barc;
+  loop_closures.emplace_back(0, 0, 1, 6, Matrix::Identity(d, d), t, 1.0, 1.0);
+
+  RobustCostParameters cost_params(RobustCostParameters::Type::GNC_TLS);
+  cost_params.GNCBarc = barc;
+  cost_params.GNCInitMu = 1;
+  cost_params.GNCMuStep = 1.4;
+  cost_params.GNCMaxMuStep = 4;
+  std::vector<double> mu;
+  for (bool adaptive : {false, true}) {
+    cost_params.GNCAdaptive = adaptive;
+    PGOAgentParameters options(d, r, 1, ROptParameters(), false, 30, cost_params);
+    RobustTestAgent agent(0, options);
+    agent.setMeasurements(odometry, loop_closures, {});
+    agent.initialize(&T);
+    ASSERT_EQ(agent.getStatus().state, PGOAgentState::INITIALIZED);
+
+    agent.updateMeasurementWeights();
+    ASSERT_EQ(agent.weight(0, 3), 1);
+    ASSERT_EQ(agent.weight(2, 8), 0);
+    ASSERT_NEAR(agent.weight(1, 6), std::sqrt(2) - 1, 1e-10);
+    ASSERT_EQ(agent.getUndecidedLoopClosures().size(), 1);
+
+    // Settled loop closures are frozen under adaptive GNC
+    ASSERT_TRUE(agent.setMeasurementWeight(PoseID(0, 0), PoseID(0, 3), 0.5));
+    agent.updateMeasurementWeights();
+    ASSERT_EQ(agent.weight(0, 3), adaptive ? 0.5 : 1);
+    ASSERT_EQ(agent.getUndecidedLoopClosures().size(), 1);
+    mu.push_back(agent.GNCMu());
+  }
+  // With 1 of 8 loop closures undecided, the adaptive step is 1.4 + (4 - 1.4) * 7 / 8 in both updates
+  ASSERT_NEAR(mu[0], 1.4 * 1.4, 1e-10);
+  ASSERT_NEAR(mu[1], 3.675 * 3.675, 1e-10);
+}
+
+TEST(testDPGO, testAgentInitializationFromNeighbors) {
+  unsigned d = 3;
+  unsigned r = 5;
+  const unsigned numPoses = 3;
+  // Ground truth poses of three robots in the world frame (the frame of the first pose of robot 0)
+  std::vector<std::vector<Pose>> poses(3);
+  for (auto &robot_poses : poses) {
+    for (unsigned i = 0; i < numPoses; ++i) {
+      Pose T = randomPose();
+      robot_poses.push_back(T);
+    }
+  }
+  poses[0][0] = Pose(d);
+  auto measurement = [&](unsigned r1, unsigned p1, unsigned r2, unsigned p2) {
+    const Pose Tij = poses[r1][p1].inverse() * poses[r2][p2];
+    return RelativeSEMeasurement(r1, r2, p1, p2, Tij.rotation(), Tij.translation(), 2.0, 3.0);
+  };
+  // Robot 1 shares two loop closures with robot 0. Robot 2 shares one loop closure with each of
+  // robots 0 and 1, and can only initialize by fusing the candidate transforms from both.
+  std::vector<RelativeSEMeasurement> shared01{measurement(0, 2, 1, 1), measurement(0, 0, 1, 2)};
+  std::vector<RelativeSEMeasurement> shared02{measurement(0, 1, 2, 0)};
+  std::vector<RelativeSEMeasurement> shared12{measurement(2, 2, 1, 0)};
+
+  PGOAgentParameters options(d, r, 3);
+  const Matrix YLift = Matrix::Identity(r, d);
+  std::vector<std::unique_ptr<PGOAgent>> agents;
+  for (unsigned robot = 0; robot < 3; ++robot) {
+    std::vector<RelativeSEMeasurement> odometry, shared;
+    for (unsigned i = 0; i + 1 < numPoses; ++i) odometry.push_back(measurement(robot, i, robot, i + 1));
+    for (const auto *lcs : {&shared01, &shared02, &shared12}) {
+      for (const auto &m : *lcs) {
+        if (m.r1 == robot || m.r2 == robot) shared.push_back(m);
+      }
+    }
+    agents.emplace_back(std::make_unique<PGOAgent>(robot, options));
+    agents[robot]->setLiftingMatrix(YLift);
+    agents[robot]->setMeasurements(odometry, {}, shared);
+    // Local trajectory initialization in an arbitrary frame
+    Pose T_local_world = randomPose();
+    PoseArray TInit(d, numPoses);
+    for (unsigned i = 0; i < numPoses; ++i) TInit.pose(i) = (T_local_world * poses[robot][i]).pose();
+    agents[robot]->initialize(&TInit);
+  }
+  ASSERT_EQ(agents[0]->getStatus().state, PGOAgentState::INITIALIZED);
+  auto sendPoses = [&](unsigned from, unsigned to) {
+    agents[to]->setNeighborStatus(agents[from]->getStatus());
+    PoseDict pose_dict;
+    ASSERT_TRUE(agents[from]->getSharedPoseDictWithNeighbor(pose_dict, to));
+    agents[to]->updateNeighborPoses(from, pose_dict);
+  };
+  sendPoses(0, 1);
+  ASSERT_EQ(agents[1]->getStatus().state, PGOAgentState::INITIALIZED);
+  sendPoses(0, 2);
+  ASSERT_EQ(agents[2]->getStatus().state, PGOAgentState::WAIT_FOR_INITIALIZATION);
+  sendPoses(0, 2);
+  ASSERT_EQ(agents[2]->getStatus().state, PGOAgentState::WAIT_FOR_INITIALIZATION);
+  sendPoses(1, 2);
+  ASSERT_EQ(agents[2]->getStatus().state, PGOAgentState::INITIALIZED);
+
+  for (unsigned robot : {1, 2}) {
+    Matrix X;
+    ASSERT_TRUE(agents[robot]->getX(X));
+    for (unsigned i = 0; i < numPoses; ++i) {
+      const Matrix Ti = YLift.transpose() * X.block(0, i * (d + 1), r, d + 1);
+      ASSERT_LE((Ti - poses[robot][i].pose()).norm(), 1e-6);
+    }
+  }
+}
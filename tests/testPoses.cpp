@@ -79,4 +79,78 @@ TEST(testDPGO, testPoseMultiplication) {
     auto T = T1 * T2;
     ASSERT_LE((T1.matrix() * T2.matrix() - T.matrix()).norm(), 1e-6);
   }
-}
\ No newline at end of file
+}
+TEST(testDPGO, testPoseSet) {
+  PoseSet poses;
+  ASSERT_TRUE(poses.emplace(1, 5));
+  ASSERT_TRUE(poses.emplace(0, 7));
+  ASSERT_TRUE(poses.emplace(1, 2));
+  ASSERT_FALSE(poses.emplace(0, 7));
+  ASSERT_EQ(poses.size(), 3);
+  // Iteration follows the ordering of ComparePoseID
+  std::vector<PoseID> expected{PoseID(0, 7), PoseID(1, 2), PoseID(1, 5)};
+  size_t i = 0;
+  for (const auto &pose_id : poses) {
+    ASSERT_TRUE(pose_id == expected[i++]);
+  }
+  ASSERT_EQ(poses.count(PoseID(1, 2)), 1);
+  ASSERT_TRUE(poses.find(PoseID(2, 2)) == poses.end());
+  ASSERT_TRUE(poses.erase(PoseID(1, 2)));
+  ASSERT_FALSE(poses.erase(PoseID(1, 2)));
+  ASSERT_EQ(poses.count(PoseID(1, 2)), 0);
+}
+
+TEST(testDPGO, testLiftedPoseStore) {
+  int r = 5;
+  int d = 3;
+  PoseDict dict;
+  for (unsigned robot = 0; robot < 3; ++robot) {
+    for (unsigned frame = 0; frame < 10; frame += 3) {
+      LiftedPose Xi(r, d);
+      Xi.rotation() = randomStiefelVariable(d, r);
+      Xi.translation() = Vector::Random(r);
+      dict.emplace(PoseID(robot, frame), Xi);
+    }
+  }
+  // Conversion from and to PoseDict
+  LiftedPoseStore store(r, d);
+  store.assign(dict);
+  ASSERT_EQ(store.size(), dict.size());
+  for (const auto &it : dict) {
+    size_t index = store.find(it.first);
+    ASSERT_NE(index, LiftedPoseStore::npos);
+    ASSERT_TRUE(store.poseID(index) == it.first);
+    ASSERT_EQ((store.pose(index) - it.second.pose()).norm(), 0);
+  }
+  PoseDict dict2 = store.toPoseDict();
+  ASSERT_EQ(dict2.size(), dict.size());
+  for (const auto &it : dict) {
+    ASSERT_EQ((dict2.at(it.first).getData() - it.second.getData()).norm(), 0);
+  }
+
+  // Insertion in the middle preserves the existing poses
+  LiftedPose Xnew(r, d);
+  Xnew.translation() = Vector::Ones(r);
+  store.set(PoseID(1, 1), Xnew);
+  ASSERT_EQ(store.size(), dict.size() + 1);
+  ASSERT_EQ((store.pose(store.find(PoseID(1, 1))) - Xnew.pose()).norm(), 0);
+  for (const auto &it : dict) {
+    ASSERT_EQ((store.pose(store.find(it.first)) - it.second.pose()).norm(), 0);
+  }
+  // Overwrite an existing pose
+  store.set(PoseID(0, 0), Xnew);
+  ASSERT_EQ(store.size(), dict.size() + 1);
+  ASSERT_EQ((store.pose(store.find(PoseID(0, 0))) - Xnew.pose()).norm(), 0);
+
+  // Removal
+  ASSERT_TRUE(store.erase(PoseID(1, 1)));
+  ASSERT_FALSE(store.erase(PoseID(1, 1)));
+  ASSERT_FALSE(store.contains(PoseID(1, 1)));
+  ASSERT_EQ((store.pose(store.find(PoseID(2, 9))) - dict.at(PoseID(2, 9)).pose()).norm(), 0);
+
+  // Copies are independent
+  LiftedPoseStore copy(r, d);
+  copy = store;
+  copy.pose(0).setZero();
+  ASSERT_GT(store.pose(0).norm(), 0);
+}
@@ -0,0 +1,238 @@
+#include <DPGO/DPGO_serialization.h>
+#include <DPGO/DPGO_utils.h>
+#include <DPGO/PGOAgent.h>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include "gtest/gtest.h"
+
+using namespace DPGO;
+
+namespace {
+PoseDict randomPoseDict(unsigned robot_id, unsigned num_poses, unsigned r, unsigned d) {
+  PoseDict poses;
+  for (unsigned i = 0; i < num_poses; ++i) {
+    LiftedPose Xi(r, d);
+    Xi.rotation() = randomStiefelVariable(d, r);
+    Xi.translation() = Vector::Random(r);
+    poses.emplace(PoseID(robot_id, 2 * i), Xi);
+  }
+  return poses;
+}
+}  // namespace
+
+TEST(testDPGO, testSerializePoseDict) {
+  unsigned r = 5;
+  unsigned d = 3;
+  PoseDict poses = randomPoseDict(1, 10, r, d);
+  std::vector<uint8_t> buffer;
+  size_t bytes = encodePoseDict(poses, 1, buffer);
+  ASSERT_EQ(bytes, poseMessageSize(10, r, d));
+  ASSERT_EQ(bytes, buffer.size());
+
+  PoseDict decoded;
+  ASSERT_TRUE(decodePoseDict(buffer.data(), bytes, decoded));
+  ASSERT_EQ(decoded.size(), poses.size());
+  for (const auto &it : poses) {
+    ASSERT_EQ(decoded.count(it.first), 1);
+    ASSERT_EQ((decoded.at(it.first).getData() - it.second.getData()).norm(), 0);
+  }
+
+  // Single precision encoding is lossy but accurate to float epsilon
+  bytes = encodePoseDict(poses, 1, buffer, PoseEncoding::Float32);
+  ASSERT_LT(bytes, poseMessageSize(10, r, d));
+  ASSERT_TRUE(decodePoseDict(buffer.data(), bytes, decoded));
+  for (const auto &it : poses) {
+    ASSERT_LE((decoded.at(it.first).getData() - it.second.getData()).cwiseAbs().maxCoeff(), 1e-6);
+  }
+}
+
+TEST(testDPGO, testSerializePoseDictInvalid) {
+  PoseDict poses = randomPoseDict(0, 3, 3, 3);
+  std::vector<uint8_t> buffer;
+  size_t bytes = encodePoseDict(poses, 0, buffer);
+  PoseDict decoded;
+  // Truncated message
+  ASSERT_FALSE(decodePoseDict(buffer.data(), bytes - 1, decoded));
+  // Buffer too small for encoding
+  ASSERT_EQ(encodePoseDict(poses, 0, buffer.data(), bytes - 1), 0);
+  // Mismatched wire format version
+  MessageHeader header;
+  std::memcpy(&header, buffer.data(), sizeof(MessageHeader));
+  header.version = kMessageVersion - 1;
+  std::memcpy(buffer.data(), &header, sizeof(MessageHeader));
+  ASSERT_FALSE(decodePoseDict(buffer.data(), bytes, decoded));
+  header.version = kMessageVersion;
+  std::memcpy(buffer.data(), &header, sizeof(MessageHeader));
+  ASSERT_TRUE(decodePoseDict(buffer.data(), bytes, decoded));
+  // Invalid magic number
+  buffer[0] ^= 0xFF;
+  ASSERT_FALSE(decodePoseDict(buffer.data(), bytes, decoded));
+  // Wrong message type
+  std::vector<uint8_t> status_buffer(statusMessageSize());
+  encodeStatus(PGOAgentStatus(0), status_buffer.data(), status_buffer.size());
+  ASSERT_FALSE(decodePoseDict(status_buffer.data(), status_buffer.size(), decoded));
+}
+
+TEST(testDPGO, testHalfPrecision) {
+  for (float value : {0.0f, 1.0f, -2.5f, 0.1f, 1e-5f, 65504.0f, -3.14159f}) {
+    float decoded = halfToFloat(floatToHalf(value));
+    ASSERT_LE(std::abs(decoded - value), std::abs(value) * 1e-3 + 1e-7);
+  }
+  ASSERT_TRUE(std::isinf(halfToFloat(floatToHalf(1e6f))));
+  ASSERT_EQ(halfToFloat(floatToHalf(1e-10f)), 0.0f);
+}
+
+TEST(testDPGO, testSerializeRoundedPoses) {
+  unsigned r = 5;
+  unsigned d = 3;
+  // Rank-deficient poses Xi = U * Ti
+  Matrix U = randomStiefelVariable(d, r);
+  PoseDict poses;
+  for (unsigned i = 0; i < 10; ++i) {
+    Matrix Ti(d, d + 1);
+    Ti.block(0, 0, d, d) = randomStiefelVariable(d, d);
+    Ti.col(d) = Vector::Random(d);
+    poses.emplace(PoseID(0, i), LiftedPose(U * Ti));
+  }
+  PoseEncodingParameters params(PoseEncoding::Float64, true, 1e-10);
+  std::vector<uint8_t> buffer;
+  size_t bytes = encodePoseDict(poses, 0, buffer, params);
+  ASSERT_EQ(bytes, poseMessageSize(10, r, d, PoseEncoding::Float64, true));
+  PoseMessageView view;
+  ASSERT_TRUE(view.parse(buffer.data(), bytes));
+  ASSERT_TRUE(view.isRounded());
+  PoseDict decoded;
+  ASSERT_TRUE(decodePoseDict(buffer.data(), bytes, decoded));
+  for (const auto &it : poses) {
+    ASSERT_LE((decoded.at(it.first).getData() - it.second.getData()).norm(), 1e-10);
+  }
+
+  // Full rank poses cannot be rounded within the error bound
+  poses = randomPoseDict(0, 10, r, d);
+  bytes = encodePoseDict(poses, 0, buffer, params);
+  ASSERT_TRUE(view.parse(buffer.data(), bytes));
+  ASSERT_FALSE(view.isRounded());
+  ASSERT_TRUE(decodePoseDict(buffer.data(), bytes, decoded));
+  for (const auto &it : poses) {
+    ASSERT_LE((decoded.at(it.first).getData() - it.second.getData()).norm(), 1e-10);
+  }
+}
+
+TEST(testDPGO, testSerializeErrorBound) {
+  unsigned r = 5;
+  unsigned d = 3;
+  PoseDict poses = randomPoseDict(0, 10, r, d);
+  std::vector<uint8_t> buffer;
+  PoseMessageView view;
+  // Half precision satisfies a loose error bound
+  PoseEncodingParameters params(PoseEncoding::Float16, false, 1e-2);
+  size_t bytes = encodePoseDict(poses, 0, buffer, params);
+  ASSERT_TRUE(view.parse(buffer.data(), bytes));
+  ASSERT_EQ(view.header().encoding, static_cast<uint8_t>(PoseEncoding::Float16));
+  // Large translations lose too much precision in half precision, fall back to single precision
+  for (auto &it : poses) {
+    it.second.translation() *= 1e3;
+  }
+  bytes = encodePoseDict(poses, 0, buffer, params);
+  ASSERT_TRUE(view.parse(buffer.data(), bytes));
+  ASSERT_EQ(view.header().encoding, static_cast<uint8_t>(PoseEncoding::Float32));
+  PoseDict decoded;
+  ASSERT_TRUE(decodePoseDict(buffer.data(), bytes, decoded));
+  for (const auto &it : poses) {
+    ASSERT_LE((decoded.at(it.first).getData() - it.second.getData()).cwiseAbs().maxCoeff(), 1e-2);
+  }
+}
+
+TEST(testDPGO, testSerializeStatus) {
+  PGOAgentStatus status(3, PGOAgentState::INITIALIZED, 2, 100, true, 0.25);
+  std::vector<uint8_t> buffer(statusMessageSize());
+  ASSERT_EQ(encodeStatus(status, buffer.data(), buffer.size()), statusMessageSize());
+  PGOAgentStatus decoded;
+  ASSERT_TRUE(decodeStatus(buffer.data(), buffer.size(), decoded));
+  ASSERT_EQ(decoded.agentID, status.agentID);
+  ASSERT_EQ(decoded.state, status.state);
+  ASSERT_EQ(decoded.instanceNumber, status.instanceNumber);
+  ASSERT_EQ(decoded.iterationNumber, status.iterationNumber);
+  ASSERT_EQ(decoded.readyToTerminate, status.readyToTerminate);
+  ASSERT_EQ(decoded.relativeChange, status.relativeChange);
+}
+
+TEST(testDPGO, testSerializeMeasurements) {
+  unsigned d = 3;
+  std::vector<RelativeSEMeasurement> measurements;
+  for (unsigned i = 0; i < 5; ++i) {
+    RelativeSEMeasurement m(0, 1, i, i + 1, randomStiefelVariable(d, d), Vector::Random(d), 10.0 + i, 1.0 + i);
+    m.weight = 0.1 * i;
+    m.fixedWeight = (i % 2 == 0);
+    measurements.push_back(m);
+  }
+  std::vector<uint8_t> buffer(measurementsMessageSize(measurements.size(), d));
+  ASSERT_EQ(encodeMeasurements(measurements, 0, buffer.data(), buffer.size()), buffer.size());
+  std::vector<RelativeSEMeasurement> decoded;
+  ASSERT_TRUE(decodeMeasurements(buffer.data(), buffer.size(), decoded));
+  ASSERT_EQ(decoded.size(), measurements.size());
+  for (size_t i = 0; i < measurements.size(); ++i) {
+    ASSERT_EQ(decoded[i].r1, measurements[i].r1);
+    ASSERT_EQ(decoded[i].r2, measurements[i].r2);
+    ASSERT_EQ(decoded[i].p1, measurements[i].p1);
+    ASSERT_EQ(decoded[i].p2, measurements[i].p2);
+    ASSERT_EQ((decoded[i].R - measurements[i].R).norm(), 0);
+    ASSERT_EQ((decoded[i].t - measurements[i].t).norm(), 0);
+    ASSERT_EQ(decoded[i].kappa, measurements[i].kappa);
+    ASSERT_EQ(decoded[i].tau, measurements[i].tau);
+    ASSERT_EQ(decoded[i].weight, measurements[i].weight);
+    ASSERT_EQ(decoded[i].fixedWeight, measurements[i].fixedWeight);
+  }
+}
+
+TEST(testDPGO, testAgentSharedPoseMessages) {
+  unsigned int d, r;
+  d = 3;
+  r = 3;
+  PGOAgentParameters options(d, r, 2);
+  options.multirobotInitialization = false;
+
+  // Robot 0 and robot 1 each own two poses connected by odometry, and share one loop closure
+  std::vector<RelativeSEMeasurement> odom0, odom1, shared;
+  odom0.emplace_back(0, 0, 0, 1, Matrix::Identity(d, d), Vector::Zero(d), 1.0, 1.0);
+  odom1.emplace_back(1, 1, 0, 1, Matrix::Identity(d, d), Vector::Zero(d), 1.0, 1.0);
+  shared.emplace_back(0, 1, 1, 0, Matrix::Identity(d, d), Vector::Zero(d), 1.0, 1.0);
+  shared[0].fixedWeight = true;
+
+  PGOAgent agent0(0, options);
+  PGOAgent agent1(1, options);
+  agent0.setMeasurements(odom0, {}, shared);
+  agent1.setMeasurements(odom1, {}, shared);
+  Matrix M = fixedStiefelVariable(d, r);
+  agent0.setLiftingMatrix(M);
+  agent1.setLiftingMatrix(M);
+  agent0.initialize();
+  agent1.initialize();
+  agent0.setNeighborStatus(agent1.getStatus());
+  agent1.setNeighborStatus(agent0.getStatus());
+
+  // Binary message must carry the same content as getSharedPoseDict
+  std::vector<uint8_t> buffer;
+  size_t bytes = agent0.encodeSharedPoses(buffer);
+  ASSERT_GT(bytes, 0);
+  PoseDict expected, decoded;
+  ASSERT_TRUE(agent0.getSharedPoseDict(expected));
+  ASSERT_TRUE(decodePoseDict(buffer.data(), bytes, decoded));
+  ASSERT_EQ(decoded.size(), expected.size());
+  for (const auto &it : expected) {
+    ASSERT_EQ((decoded.at(it.first).getData() - it.second.getData()).norm(), 0);
+  }
+
+  // Neighbor decodes the message directly into its local cache
+  ASSERT_TRUE(agent1.updateNeighborPosesFromBuffer(buffer.data(), bytes));
+  Matrix anchor = Matrix::Zero(r, d + 1);
+  anchor.block(0, 0, r, d) = M;
+  agent0.setGlobalAnchor(anchor);
+  agent1.setGlobalAnchor(anchor);
+  Matrix T0, T1;
+  ASSERT_TRUE(agent0.getPoseInGlobalFrame(1, T0));
+  ASSERT_TRUE(agent1.getNeighborPoseInGlobalFrame(0, 1, T1));
+  ASSERT_LE((T0 - T1).norm(), 1e-8);
+}
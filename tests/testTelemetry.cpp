@@ -0,0 +1,142 @@
+#include <DPGO/Communicator.h>
+#include <DPGO/DPGO_telemetry.h>
+#include <DPGO/DPGO_utils.h>
+#include <DPGO/PGOAgent.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+using namespace DPGO;
+
+namespace {
+IterationTelemetry makeRecord(unsigned iteration) {
+  IterationTelemetry record;
+  record.iteration = iteration;
+  record.cost = 2.0 * iteration;
+  record.bytesSent = 3 * iteration;
+  return record;
+}
+
+std::string readFile(const std::string &filename) {
+  std::ifstream file(filename);
+  std::stringstream ss;
+  ss << file.rdbuf();
+  return ss.str();
+}
+}  // namespace
+
+TEST(testDPGO, testTelemetryRing) {
+  TelemetryRing ring(5);
+  ASSERT_EQ(ring.capacity(), 8);
+  IterationTelemetry record;
+  ASSERT_FALSE(ring.latest(record));
+  ASSERT_TRUE(ring.records().empty());
+
+  for (unsigned k = 1; k <= 20; ++k) ring.push(makeRecord(k));
+  ASSERT_EQ(ring.numRecorded(), 20);
+  ASSERT_TRUE(ring.latest(record));
+  ASSERT_EQ(record.iteration, 20);
+
+  // Only the most recent records are kept, from oldest to newest
+  auto records = ring.records();
+  ASSERT_EQ(records.size(), 8);
+  for (unsigned k = 0; k < records.size(); ++k) ASSERT_EQ(records[k].iteration, 13 + k);
+  records = ring.records(3);
+  ASSERT_EQ(records.size(), 3);
+  ASSERT_EQ(records.front().iteration, 18);
+}
+
+TEST(testDPGO, testTelemetryRingConcurrentReader) {
+  TelemetryRing ring(16);
+  const unsigned num_records = 200000;
+  std::atomic<bool> done{false};
+  std::atomic<bool> consistent{true};
+  std::thread reader([&]() {
+    while (!done) {
+      unsigned previous = 0;
+      for (const auto &record : ring.records()) {
+        // Records are never torn and always ordered
+        if (record.cost != 2.0 * record.iteration || record.bytesSent != 3 * record.iteration ||
+            record.iteration <= previous)
+          consistent = false;
+        previous = record.iteration;
+      }
+    }
+  });
+  for (unsigned k = 1; k <= num_records; ++k) ring.push(makeRecord(k));
+  done = true;
+  reader.join();
+  ASSERT_TRUE(consistent);
+  ASSERT_EQ(ring.records().back().iteration, num_records);
+}
+
+TEST(testDPGO, testTelemetryDump) {
+  std::vector<IterationTelemetry> records{makeRecord(1), makeRecord(2)};
+  records[1].gradNorm = std::nan("");
+  const std::string csv_file = "/tmp/dpgo_telemetry_test.csv";
+  const std::string json_file = "/tmp/dpgo_telemetry_test.json";
+  ASSERT_TRUE(TelemetryRing::writeCSV(csv_file, records));
+  ASSERT_TRUE(TelemetryRing::writeJSON(json_file, records));
+
+  std::string csv = readFile(csv_file);
+  ASSERT_EQ(std::count(csv.begin(), csv.end(), '\n'), 3);
+  ASSERT_EQ(csv.rfind("iteration,timestamp_us,optimized,", 0), 0);
+  std::string json = readFile(json_file);
+  ASSERT_NE(json.find("\"iteration\": 2"), std::string::npos);
+  ASSERT_NE(json.find("\"grad_norm\": null"), std::string::npos);
+  ASSERT_EQ(json.front(), '[');
+  std::remove(csv_file.c_str());
+  std::remove(json_file.c_str());
+}
+
+TEST(testDPGO, testAgentTelemetry) {
+  unsigned int d = 3, r = 3;
+  PGOAgentParameters options(d, r, 2);
+  options.multirobotInitialization = false;
+  options.telemetryCapacity = 4;
+
+  std::vector<RelativeSEMeasurement> odom0, odom1, shared;
+  odom0.emplace_back(0, 0, 0, 1, Matrix::Identity(d, d), Vector::Zero(d), 1.0, 1.0);
+  odom1.emplace_back(1, 1, 0, 1, Matrix::Identity(d, d), Vector::Zero(d), 1.0, 1.0);
+  shared.emplace_back(0, 1, 1, 0, Matrix::Identity(d, d), Vector::Zero(d), 1.0, 1.0);
+
+  auto comm = std::make_shared<InProcessCommunicator>(2);
+  PGOAgent agent0(0, options);
+  PGOAgent agent1(1, options);
+  agent0.setCommunicator(comm);
+  agent1.setCommunicator(comm);
+  agent0.setMeasurements(odom0, {}, shared);
+  agent1.setMeasurements(odom1, {}, shared);
+  Matrix M = fixedStiefelVariable(d, r);
+  agent0.setLiftingMatrix(M);
+  agent1.setLiftingMatrix(M);
+  agent0.initialize();
+  agent1.initialize();
+
+  agent0.iterate(false);
+  agent1.iterate(true);
+  for (unsigned k = 0; k < 5; ++k) agent0.iterate(true);
+
+  // One record per iteration, up to the ring capacity
+  ASSERT_EQ(agent0.telemetry().numRecorded(), 6);
+  auto records = agent0.telemetry().records();
+  ASSERT_EQ(records.size(), 4);
+  ASSERT_EQ(records.back().iteration, agent0.iteration_number());
+  IterationTelemetry record;
+  ASSERT_TRUE(agent1.telemetry().latest(record));
+  ASSERT_EQ(record.iteration, 1);
+  ASSERT_TRUE(record.optimized);
+  ASSERT_GT(record.bytesSent, 0);
+  ASSERT_GE(record.iterationMs, record.solveMs);
+  // Agent 1 receives the messages published by agent 0 in its first iteration
+  ASSERT_GT(record.bytesReceived, 0);
+  ASSERT_TRUE(agent0.telemetry().latest(record));
+  ASSERT_TRUE(record.optimized);
+  ASSERT_GE(record.lockWaitMs, 0);
+}
@@ -0,0 +1,86 @@
+#include <DPGO/DPGO_trace.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+using namespace DPGO;
+
+namespace {
+size_t countEvents(const std::vector<std::pair<unsigned, TraceEvent>> &events, const char *name) {
+  return std::count_if(events.begin(), events.end(), [&](const std::pair<unsigned, TraceEvent> &e) {
+    return std::strcmp(e.second.name, name) == 0;
+  });
+}
+}  // namespace
+
+TEST(testDPGO, testTraceZones) {
+  Tracer::clear();
+  {
+    TraceZone outer("outer");
+    for (unsigned k = 0; k < 3; ++k) {
+      TraceZone inner("inner");
+    }
+  }
+  Tracer::setEnabled(false);
+  {
+    TraceZone disabled("disabled");
+  }
+  Tracer::setEnabled(true);
+
+  auto events = Tracer::events();
+  ASSERT_EQ(countEvents(events, "outer"), 1);
+  ASSERT_EQ(countEvents(events, "inner"), 3);
+  ASSERT_EQ(countEvents(events, "disabled"), 0);
+  // Zones are recorded on exit: the outer zone contains all inner zones
+  const TraceEvent &outer = events.back().second;
+  ASSERT_STREQ(outer.name, "outer");
+  for (const auto &[tid, event] : events) {
+    ASSERT_EQ(tid, events.back().first);
+    ASSERT_GE(event.durationNs, 0);
+    ASSERT_GE(event.startNs, outer.startNs);
+    ASSERT_LE(event.startNs + event.durationNs, outer.startNs + outer.durationNs);
+  }
+  Tracer::clear();
+  ASSERT_TRUE(Tracer::events().empty());
+}
+
+TEST(testDPGO, testTraceMultipleThreads) {
+  Tracer::clear();
+  Tracer::setBufferCapacity(10);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < 4; ++t) {
+    threads.emplace_back([t]() {
+      Tracer::setThreadName("worker " + std::to_string(t));
+      for (unsigned k = 0; k < 15; ++k) {
+        TraceZone zone("work");
+      }
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  Tracer::setBufferCapacity(1 << 16);
+
+  // Each thread keeps its first 10 events and drops the rest
+  auto events = Tracer::events();
+  ASSERT_EQ(countEvents(events, "work"), 40);
+  ASSERT_EQ(Tracer::numDropped(), 20);
+
+  const std::string filename = "/tmp/dpgo_trace_test.json";
+  ASSERT_TRUE(Tracer::writeChromeTrace(filename));
+  std::ifstream file(filename);
+  std::stringstream ss;
+  ss << file.rdbuf();
+  const std::string json = ss.str();
+  ASSERT_EQ(json.rfind("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [", 0), 0);
+  ASSERT_NE(json.find("\"args\": {\"name\": \"worker 3\"}"), std::string::npos);
+  size_t numComplete = 0;
+  for (size_t pos = json.find("\"ph\": \"X\""); pos != std::string::npos; pos = json.find("\"ph\": \"X\"", pos + 1))
+    numComplete++;
+  ASSERT_EQ(numComplete, 40);
+  std::remove(filename.c_str());
+  Tracer::clear();
+}
@@ -69,3 +69,123 @@ TEST(testDPGO, testChi2Inv) {
   double q = (double) count / numTrials;
   ASSERT_LE(abs(q - quantile), 0.01);
 }
+
+TEST(testDPGO, testMeasurementResiduals) {
+  const unsigned d = 3;
+  const unsigned r = 5;
+  const unsigned n = 100;
+  LiftedPoseArray X(r, d, n);
+  X.setData(Matrix::Random(r, (d + 1) * n));
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<unsigned> index(0, n - 1);
+  for (size_t numMeasurements : {0, 10, 5000}) {
+    std::vector<RelativeSEMeasurement> measurements;
+    for (size_t k = 0; k < numMeasurements; ++k) {
+      Matrix R = Eigen::Quaterniond::UnitRandom().toRotationMatrix();
+      measurements.emplace_back(0, 0, index(rng), index(rng), R, Vector::Random(d), 2.0, 0.5);
+    }
+    std::vector<RelativeSEMeasurement *> ptrs;
+    std::vector<const double *> poses1, poses2;
+    for (auto &m : measurements) {
+      ptrs.push_back(&m);
+      poses1.push_back(X.poseData(m.p1));
+      poses2.push_back(X.poseData(m.p2));
+    }
+    // Large batches are split among threads
+    Vector residuals;
+    computeMeasurementResiduals(ptrs, poses1, poses2, r, residuals, 4);
+    ASSERT_EQ(residuals.size(), numMeasurements);
+    for (size_t k = 0; k < numMeasurements; ++k) {
+      const auto &m = measurements[k];
+      const double expected = std::sqrt(computeMeasurementError(m, X.rotation(m.p1), X.translation(m.p1),
+                                                                X.rotation(m.p2), X.translation(m.p2)));
+      ASSERT_NEAR(residuals(k), expected, 1e-10);
+    }
+  }
+}
+
+TEST(testDPGO, testAdaptiveGNC) {
+  RobustCostParameters params(RobustCostParameters::Type::GNC_TLS);
+  params.GNCInitMu = 1;
+  params.GNCMuStep = 1.5;
+  params.GNCMaxMuStep = 3.5;
+  RobustCost fixed(params);
+  fixed.update(0.0);
+  ASSERT_NEAR(fixed.GNCMu(), 1.5, 1e-12);
+
+  params.GNCAdaptive = true;
+  RobustCost adaptive(params);
+  ASSERT_TRUE(adaptive.isAdaptiveGNC());
+  // The step grows as fewer weights are undecided
+  adaptive.update(1.0);
+  ASSERT_NEAR(adaptive.GNCMu(), 1.5, 1e-12);
+  adaptive.update(0.5);
+  ASSERT_NEAR(adaptive.GNCMu(), 1.5 * 2.5, 1e-12);
+  adaptive.update(0.0);
+  ASSERT_NEAR(adaptive.GNCMu(), 1.5 * 2.5 * 3.5, 1e-12);
+
+  ASSERT_TRUE(adaptive.isSettled(0));
+  ASSERT_TRUE(adaptive.isSettled(1));
+  ASSERT_FALSE(adaptive.isSettled(0.5));
+}
+
+TEST(testDPGO, testRobustCostWeights) {
+  // Residuals on both sides of every threshold, including exact thresholds
+  const int n = 1001;
+  Vector residuals = 40 * Vector::LinSpaced(n, 1e-3, 1).array().square();
+  residuals(0) = 3;
+  residuals(1) = 10;
+  for (auto type : {RobustCostParameters::Type::L2, RobustCostParameters::Type::L1,
+                    RobustCostParameters::Type::Huber, RobustCostParameters::Type::TLS,
+                    RobustCostParameters::Type::GM, RobustCostParameters::Type::GNC_TLS}) {
+    RobustCostParameters params(type);
+    params.GNCInitMu = 0.05;
+    RobustCost cost(params);
+    for (unsigned update = 0; update < 5; ++update) {
+      Vector weights;
+      cost.weights(residuals, weights);
+      ASSERT_EQ(weights.size(), n);
+      for (int i = 0; i < n; ++i) {
+        ASSERT_NEAR(weights(i), cost.weight(residuals(i)), 1e-12)
+            << RobustCostParameters::robustCostName(type) << ", residual " << residuals(i);
+      }
+      cost.update();
+    }
+  }
+}
+
+TEST(testDPGO, testVerifyCertificateMatrix) {
+  const int N = 40;
+  const Matrix B = Matrix::Random(N, N / 2);
+  const Matrix PSD = B * B.transpose();
+  Vector v;
+  double curvature = 0;
+  ASSERT_TRUE(verifyCertificateMatrix(PSD.sparseView(), 1e-8, v, curvature));
+
+  const double minEigenvalue = Eigen::SelfAdjointEigenSolver<Matrix>(PSD).eigenvalues()(0);
+  const SparseMatrix S = (PSD - (minEigenvalue + 0.1) * Matrix::Identity(N, N)).sparseView();
+  ASSERT_FALSE(verifyCertificateMatrix(S, 1e-8, v, curvature));
+  ASSERT_EQ(v.size(), N);
+  ASSERT_NEAR(v.norm(), 1, 1e-12);
+  ASSERT_LT(curvature, 0);
+  ASSERT_NEAR(curvature, v.dot(S * v), 1e-10);
+}
+
+TEST(testDPGO, testRoundSolution) {
+  const unsigned d = 3;
+  const unsigned r = 5;
+  const unsigned n = 6;
+  Matrix T(d, (d + 1) * n);
+  for (unsigned i = 0; i < n; ++i) {
+    T.block(0, i * (d + 1), d, d) = Eigen::Quaterniond::UnitRandom().toRotationMatrix();
+    T.col(i * (d + 1) + d) = Eigen::Vector3d::Random();
+  }
+  const Matrix YLift = projectToStiefelManifold(Matrix::Random(r, d));
+  const Matrix TRounded = roundSolution(YLift * T, d);
+  ASSERT_EQ(TRounded.rows(), d);
+  ASSERT_EQ(TRounded.cols(), (d + 1) * n);
+  // The rounded trajectory equals the original one up to a global rotation
+  const Matrix R = TRounded.block(0, 0, d, d) * T.block(0, 0, d, d).transpose();
+  checkRotationMatrix(R);
+  ASSERT_LE((R * T - TRounded).norm(), 1e-8);
+}